@@ -164,12 +164,15 @@ namespace AudioCommon
 
 	void StartAudioDump()
 	{
-		std::string audio_file_name_dtk = File::GetUserPath(D_DUMPAUDIO_IDX) + "dtkdump.wav";
-		std::string audio_file_name_dsp = File::GetUserPath(D_DUMPAUDIO_IDX) + "dspdump.wav";
+		const bool flac = SConfig::GetInstance().m_DumpAudioFLAC;
+		const WaveFileWriter::Format format = flac ? WaveFileWriter::FORMAT_FLAC : WaveFileWriter::FORMAT_WAV;
+		const std::string extension = flac ? ".flac" : ".wav";
+		std::string audio_file_name_dtk = File::GetUserPath(D_DUMPAUDIO_IDX) + "dtkdump" + extension;
+		std::string audio_file_name_dsp = File::GetUserPath(D_DUMPAUDIO_IDX) + "dspdump" + extension;
 		File::CreateFullPath(audio_file_name_dtk);
 		File::CreateFullPath(audio_file_name_dsp);
-		g_sound_stream->GetMixer()->StartLogDTKAudio(audio_file_name_dtk);
-		g_sound_stream->GetMixer()->StartLogDSPAudio(audio_file_name_dsp);
+		g_sound_stream->GetMixer()->StartLogDTKAudio(audio_file_name_dtk, format);
+		g_sound_stream->GetMixer()->StartLogDSPAudio(audio_file_name_dsp, format);
 		s_audio_dump_start = true;
 	}
 
@@ -16,6 +16,7 @@
 
 #include "AudioCommon/DPL2Decoder.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
 
 #ifndef M_PI
@@ -25,6 +26,13 @@
 #define M_SQRT1_2 0.70710678118654752440
 #endif
 
+enum
+{
+	LFE_TAPS = 256,
+	// Samples which are decoded before the LFE filter runs over all of them
+	BLOCK_SIZE = 256,
+};
+
 static int olddelay = -1;
 static unsigned int oldfreq = 0;
 static unsigned int dlbuflen;
@@ -33,56 +41,52 @@ static float l_fwr, r_fwr, lpr_fwr, lmr_fwr;
 static std::vector<float> fwrbuf_l, fwrbuf_r;
 static float adapt_l_gain, adapt_r_gain, adapt_lpr_gain, adapt_lmr_gain;
 static std::vector<float> lf, rf, lr, rr, cf, cr;
-static float LFE_buf[256];
-static unsigned int lfe_pos;
-static float *filter_coefs_lfe;
-static unsigned int len125;
-
-template<class T, class _ftype_t>
-static _ftype_t DotProduct(int count, const T *buf, const _ftype_t *coefficients)
+// The last LFE_TAPS - 1 inputs of the LFE filter, followed by those of the current block
+static float lfe_history[LFE_TAPS - 1 + BLOCK_SIZE];
+// The taps of the LFE filter, in the order of the history
+static float lfe_coefs[LFE_TAPS];
+
+// Filters count samples of the history, out[i] being the dot product of the
+// taps with the LFE_TAPS samples which start at history[i].
+static void FilterLFE(const float* history, int count, float* out)
 {
-	int i;
-	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
-
-	// Unrolled loop
-	for (i = 0; (i + 3) < count; i += 4)
+	int i = 0;
+#ifdef _M_X86
+	// Eight outputs at a time, with the taps split in four interleaved sums to
+	// keep the additions independent
+	for (; i + 8 <= count; i += 8)
 	{
-		sum0 += buf[i + 0] * coefficients[i + 0];
-		sum1 += buf[i + 1] * coefficients[i + 1];
-		sum2 += buf[i + 2] * coefficients[i + 2];
-		sum3 += buf[i + 3] * coefficients[i + 3];
-	}
-
-	// Epilogue of unrolled loop
-	for (; i < count; i++)
-		sum0 += buf[i] * coefficients[i];
+		__m128 sums[8];
+		for (__m128& sum : sums)
+			sum = _mm_setzero_ps();
 
-	return sum0 + sum1 + sum2 + sum3;
-}
-
-template<class T>
-static T FIRFilter(const T *buf, int pos, int len, int count, const float *coefficients)
-{
-	int count1, count2;
+		const float* x = &history[i];
+		for (int tap = 0; tap < LFE_TAPS; tap += 4)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				const __m128 coef = _mm_set1_ps(lfe_coefs[tap + j]);
+				sums[j] = _mm_add_ps(sums[j], _mm_mul_ps(coef, _mm_loadu_ps(&x[tap + j])));
+				sums[j + 4] = _mm_add_ps(sums[j + 4], _mm_mul_ps(coef, _mm_loadu_ps(&x[tap + j + 4])));
+			}
+		}
 
-	if (pos >= count)
-	{
-		pos -= count;
-		count1 = count; count2 = 0;
+		_mm_storeu_ps(&out[i], _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3])));
+		_mm_storeu_ps(&out[i + 4], _mm_add_ps(_mm_add_ps(sums[4], sums[5]), _mm_add_ps(sums[6], sums[7])));
 	}
-	else
+#endif
+	for (; i < count; i++)
 	{
-		count2 = pos;
-		count1 = count - pos;
-		pos = len - count1;
+		float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+		for (int tap = 0; tap < LFE_TAPS; tap += 4)
+		{
+			sum0 += history[i + tap + 0] * lfe_coefs[tap + 0];
+			sum1 += history[i + tap + 1] * lfe_coefs[tap + 1];
+			sum2 += history[i + tap + 2] * lfe_coefs[tap + 2];
+			sum3 += history[i + tap + 3] * lfe_coefs[tap + 3];
+		}
+		out[i] = sum0 + sum1 + sum2 + sum3;
 	}
-
-	// high part of window
-	const T *ptr = &buf[pos];
-
-	float r1 = DotProduct(count1, ptr, coefficients); coefficients += count1;
-	float r2 = DotProduct(count2, buf, coefficients);
-	return T(r1 + r2);
 }
 
 /*
@@ -188,33 +192,27 @@ static void OnSeek()
 	std::fill(rr.begin(), rr.end(), 0.0f);
 	std::fill(cf.begin(), cf.end(), 0.0f);
 	std::fill(cr.begin(), cr.end(), 0.0f);
-	lfe_pos = 0;
-	memset(LFE_buf, 0, sizeof(LFE_buf));
+	memset(lfe_history, 0, sizeof(lfe_history));
 }
 
 static void Done()
 {
 	OnSeek();
-
-	if (filter_coefs_lfe)
-	{
-		free(filter_coefs_lfe);
-	}
-
-	filter_coefs_lfe = nullptr;
 }
 
-static float* CalculateCoefficients125HzLowpass(int rate)
+static void CalculateCoefficients125HzLowpass(int rate)
 {
-	len125 = 256;
+	unsigned int len = LFE_TAPS;
 	float f = 125.0f / (rate / 2);
-	float *coeffs = DesignFIR(&len125, &f, 0);
+	float *coeffs = DesignFIR(&len, &f, 0);
 	static const float M3_01DB = 0.7071067812f;
-	for (unsigned int i = 0; i < len125; i++)
+	// The first tap has always been applied to the newest sample, and the
+	// other ones to the rest of the window, oldest first
+	for (unsigned int i = 0; i < LFE_TAPS; i++)
 	{
-		coeffs[i] *= M3_01DB;
+		lfe_coefs[i] = coeffs[(i + 1) % LFE_TAPS] * M3_01DB;
 	}
-	return coeffs;
+	free(coeffs);
 }
 
 static float PassiveLock(float x)
@@ -334,9 +332,7 @@ void DPL2Decode(float *samples, int numsamples, float *out)
 		rr.resize(dlbuflen);
 		cf.resize(dlbuflen);
 		cr.resize(dlbuflen);
-		filter_coefs_lfe = CalculateCoefficients125HzLowpass(fmt_freq);
-		lfe_pos = 0;
-		memset(LFE_buf, 0, sizeof(LFE_buf));
+		CalculateCoefficients125HzLowpass(fmt_freq);
 	}
 
 	float *in = samples; // Input audio data
@@ -344,46 +340,54 @@ void DPL2Decode(float *samples, int numsamples, float *out)
 
 	while (in < end)
 	{
-		const int k = cyc_pos;
-
-		const int fwr_pos = (k + FWRDURATION) % dlbuflen;
-		/* Update the full wave rectified total amplitude */
-		/* Input matrix decoder */
-		l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
-		r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
-		lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
-		lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
-
-		/* Matrix encoded 2 channel sources */
-		fwrbuf_l[k] = in[0];
-		fwrbuf_r[k] = in[1];
-		MatrixDecode(in, k, 0, 1, true, dlbuflen,
-			l_fwr, r_fwr,
-			lpr_fwr, lmr_fwr,
-			&adapt_l_gain, &adapt_r_gain,
-			&adapt_lpr_gain, &adapt_lmr_gain,
-			&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
-
-		out[cur + 0] = lf[k];
-		out[cur + 1] = rf[k];
-		out[cur + 2] = cf[k];
-		LFE_buf[lfe_pos] = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
-		out[cur + 3] = FIRFilter(LFE_buf, lfe_pos, len125, len125, filter_coefs_lfe);
-		lfe_pos++;
-		if (lfe_pos == len125)
-		{
-			lfe_pos = 0;
-		}
-		out[cur + 4] = lr[k];
-		out[cur + 5] = rr[k];
-		// Next sample...
-		in += 2;
-		cur += 6;
-		cyc_pos--;
-		if (cyc_pos < 0)
+		const int block = std::min<int>(BLOCK_SIZE, (int)(end - in) / 2);
+		float* lfe_in = &lfe_history[LFE_TAPS - 1];
+		float* block_out = &out[cur];
+
+		for (int i = 0; i < block; i++)
 		{
-			cyc_pos += dlbuflen;
+			const int k = cyc_pos;
+
+			const int fwr_pos = (k + FWRDURATION) % dlbuflen;
+			/* Update the full wave rectified total amplitude */
+			/* Input matrix decoder */
+			l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
+			r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
+			lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
+			lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
+
+			/* Matrix encoded 2 channel sources */
+			fwrbuf_l[k] = in[0];
+			fwrbuf_r[k] = in[1];
+			MatrixDecode(in, k, 0, 1, true, dlbuflen,
+				l_fwr, r_fwr,
+				lpr_fwr, lmr_fwr,
+				&adapt_l_gain, &adapt_r_gain,
+				&adapt_lpr_gain, &adapt_lmr_gain,
+				&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
+
+			out[cur + 0] = lf[k];
+			out[cur + 1] = rf[k];
+			out[cur + 2] = cf[k];
+			// Filtered once the whole block is decoded
+			lfe_in[i] = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
+			out[cur + 4] = lr[k];
+			out[cur + 5] = rr[k];
+			// Next sample...
+			in += 2;
+			cur += 6;
+			cyc_pos--;
+			if (cyc_pos < 0)
+			{
+				cyc_pos += dlbuflen;
+			}
 		}
+
+		float lfe_out[BLOCK_SIZE];
+		FilterLFE(lfe_history, block, lfe_out);
+		for (int i = 0; i < block; i++)
+			block_out[i * 6 + 3] = lfe_out[i];
+		memmove(lfe_history, &lfe_history[block], (LFE_TAPS - 1) * sizeof(float));
 	}
 }
 
@@ -391,5 +395,4 @@ void DPL2Reset()
 {
 	olddelay = -1;
 	oldfreq = 0;
-	filter_coefs_lfe = nullptr;
 }
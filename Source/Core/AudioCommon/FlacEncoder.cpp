@@ -0,0 +1,412 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "AudioCommon/FlacEncoder.h"
+#include "Common/CommonTypes.h"
+
+enum
+{
+	MAX_ORDER = 4,
+	MAX_PARTITION_ORDER = 8,
+	// Larger parameters need the 5-bit parameter coding method
+	MAX_RICE_PARAMETER = 14,
+};
+
+enum ChannelAssignment
+{
+	CHANNELS_INDEPENDENT = 1,
+	CHANNELS_LEFT_SIDE = 8,
+	CHANNELS_RIGHT_SIDE = 9,
+	CHANNELS_MID_SIDE = 10,
+};
+
+namespace
+{
+struct SubframePlan
+{
+	enum Type
+	{
+		CONSTANT = 0,
+		VERBATIM = 1,
+		FIXED = 8,
+	};
+
+	Type type;
+	u32 order;
+	u32 partition_order;
+	u32 rice_parameters[1 << MAX_PARTITION_ORDER];
+	u64 bits;
+};
+
+class BitWriter
+{
+public:
+	explicit BitWriter(std::vector<u8>* out) : m_out(out), m_buffer(0), m_bits(0) {}
+
+	// Writes the low bits (at most 32) of value, most significant first
+	void Write(u32 value, u32 bits)
+	{
+		m_buffer = (m_buffer << bits) | (value & (u32)((1ULL << bits) - 1));
+		m_bits += bits;
+		while (m_bits >= 8)
+		{
+			m_bits -= 8;
+			m_out->push_back((u8)(m_buffer >> m_bits));
+		}
+	}
+
+	void WriteRice(u32 value, u32 parameter)
+	{
+		u32 quotient = value >> parameter;
+		for (; quotient >= 32; quotient -= 32)
+			Write(0, 32);
+		Write(1, quotient + 1);
+		Write(value, parameter);
+	}
+
+	void Align()
+	{
+		if (m_bits)
+			Write(0, 8 - m_bits);
+	}
+
+private:
+	std::vector<u8>* m_out;
+	u64 m_buffer;
+	u32 m_bits;
+};
+}
+
+static u8 CRC8(const u8* data, size_t size)
+{
+	u32 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = ((crc << 1) ^ ((crc & 0x80) ? 0x07 : 0)) & 0xFF;
+	}
+	return crc;
+}
+
+static u16 CRC16(const u8* data, size_t size)
+{
+	u32 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i] << 8;
+		for (int bit = 0; bit < 8; bit++)
+			crc = ((crc << 1) ^ ((crc & 0x8000) ? 0x8005 : 0)) & 0xFFFF;
+	}
+	return crc;
+}
+
+// Maps signed residuals to unsigned ones, 0, -1, 1, -2, 2...
+static u32 Fold(s32 value)
+{
+	return ((u32)value << 1) ^ (u32)(value >> 31);
+}
+
+// The residual of the fixed predictor of the given order, from sample order on
+static void ComputeResidual(const s32* x, u32 n, u32 order, s32* residual)
+{
+	switch (order)
+	{
+	case 0:
+		for (u32 i = 0; i < n; i++)
+			residual[i] = x[i];
+		break;
+	case 1:
+		for (u32 i = 1; i < n; i++)
+			residual[i] = x[i] - x[i - 1];
+		break;
+	case 2:
+		for (u32 i = 2; i < n; i++)
+			residual[i] = x[i] - 2 * x[i - 1] + x[i - 2];
+		break;
+	case 3:
+		for (u32 i = 3; i < n; i++)
+			residual[i] = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+		break;
+	case 4:
+		for (u32 i = 4; i < n; i++)
+			residual[i] = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+		break;
+	}
+}
+
+// Picks the partition order and the Rice parameters which code the residual
+// in the fewest bits, and returns that number of bits
+static u64 PlanResidual(const s32* residual, u32 n, u32 order, SubframePlan* plan)
+{
+	u32 folded[FlacEncoder::BLOCK_SIZE];
+	for (u32 i = order; i < n; i++)
+		folded[i] = Fold(residual[i]);
+
+	u64 best_bits = ~0ULL;
+	u32 parameters[1 << MAX_PARTITION_ORDER];
+	for (u32 partition_order = 0; partition_order <= MAX_PARTITION_ORDER; partition_order++)
+	{
+		// Every partition must hold the same number of samples, minus the warm-up
+		// samples for the first one
+		const u32 partition_size = n >> partition_order;
+		if ((partition_size << partition_order) != n || partition_size <= order)
+			break;
+
+		u64 bits = 0;
+		for (u32 partition = 0; partition < (1u << partition_order); partition++)
+		{
+			const u32 start = partition ? partition * partition_size : order;
+			const u32 end = (partition + 1) * partition_size;
+
+			u64 sum = 0;
+			for (u32 i = start; i < end; i++)
+				sum += folded[i];
+
+			// The parameter for which the mean is close to the middle of the
+			// codes with a one bit quotient
+			const u64 count = end - start;
+			u32 parameter = 0;
+			while (parameter < MAX_RICE_PARAMETER && (count << (parameter + 1)) < sum)
+				parameter++;
+
+			u64 quotients = 0;
+			for (u32 i = start; i < end; i++)
+				quotients += folded[i] >> parameter;
+
+			parameters[partition] = parameter;
+			bits += 4 + count * (parameter + 1) + quotients;
+		}
+
+		if (bits < best_bits)
+		{
+			best_bits = bits;
+			plan->partition_order = partition_order;
+			std::copy(parameters, parameters + (1 << partition_order), plan->rice_parameters);
+		}
+	}
+
+	// Coding method and partition order
+	return 2 + 4 + best_bits;
+}
+
+static void PlanSubframe(const s32* x, u32 n, u32 bps, SubframePlan* plan)
+{
+	// The header of every subframe takes a byte
+	if (std::all_of(x + 1, x + n, [&](s32 sample) { return sample == x[0]; }))
+	{
+		plan->type = SubframePlan::CONSTANT;
+		plan->bits = 8 + bps;
+		return;
+	}
+
+	plan->type = SubframePlan::VERBATIM;
+	plan->bits = 8 + (u64)n * bps;
+	if (n <= MAX_ORDER)
+		return;
+
+	// The predictor which leaves the smallest residual usually codes best
+	s32 residual[FlacEncoder::BLOCK_SIZE];
+	u64 best_sum = ~0ULL;
+	u32 best_order = 0;
+	for (u32 order = 0; order <= MAX_ORDER; order++)
+	{
+		ComputeResidual(x, n, order, residual);
+
+		u64 sum = 0;
+		for (u32 i = MAX_ORDER; i < n; i++)
+			sum += std::abs(residual[i]);
+		if (sum < best_sum)
+		{
+			best_sum = sum;
+			best_order = order;
+		}
+	}
+
+	SubframePlan fixed;
+	fixed.type = SubframePlan::FIXED;
+	fixed.order = best_order;
+	ComputeResidual(x, n, best_order, residual);
+	fixed.bits = 8 + best_order * bps + PlanResidual(residual, n, best_order, &fixed);
+	if (fixed.bits < plan->bits)
+		*plan = fixed;
+}
+
+static void WriteSubframe(BitWriter* writer, const s32* x, u32 n, u32 bps, const SubframePlan& plan)
+{
+	// Zero padding bit, type and no wasted bits
+	writer->Write(plan.type == SubframePlan::FIXED ? plan.type | plan.order : plan.type, 7);
+	writer->Write(0, 1);
+
+	switch (plan.type)
+	{
+	case SubframePlan::CONSTANT:
+		writer->Write(x[0], bps);
+		break;
+
+	case SubframePlan::VERBATIM:
+		for (u32 i = 0; i < n; i++)
+			writer->Write(x[i], bps);
+		break;
+
+	case SubframePlan::FIXED:
+	{
+		for (u32 i = 0; i < plan.order; i++)
+			writer->Write(x[i], bps);
+
+		s32 residual[FlacEncoder::BLOCK_SIZE];
+		ComputeResidual(x, n, plan.order, residual);
+
+		// Rice coding with 4-bit parameters
+		writer->Write(0, 2);
+		writer->Write(plan.partition_order, 4);
+
+		const u32 partition_size = n >> plan.partition_order;
+		for (u32 partition = 0; partition < (1u << plan.partition_order); partition++)
+		{
+			const u32 parameter = plan.rice_parameters[partition];
+			writer->Write(parameter, 4);
+
+			const u32 start = partition ? partition * partition_size : plan.order;
+			for (u32 i = start; i < (partition + 1) * partition_size; i++)
+				writer->WriteRice(Fold(residual[i]), parameter);
+		}
+		break;
+	}
+	}
+}
+
+FlacEncoder::FlacEncoder(u32 sample_rate)
+	: m_sample_rate(sample_rate)
+	, m_frame_number(0)
+	, m_sample_count(0)
+	, m_min_frame_size(0)
+	, m_max_frame_size(0)
+{
+}
+
+std::vector<u8> FlacEncoder::GetHeader() const
+{
+	std::vector<u8> header = { 'f', 'L', 'a', 'C' };
+	BitWriter writer(&header);
+
+	// The only metadata block, STREAMINFO
+	writer.Write(1, 1);
+	writer.Write(0, 7);
+	writer.Write(HEADER_SIZE - 8, 24);
+
+	writer.Write(BLOCK_SIZE, 16);
+	writer.Write(BLOCK_SIZE, 16);
+	writer.Write(m_min_frame_size, 24);
+	writer.Write(m_max_frame_size, 24);
+	writer.Write(m_sample_rate, 20);
+	writer.Write(2 - 1, 3);
+	writer.Write(16 - 1, 5);
+	writer.Write((u32)(m_sample_count >> 32), 4);
+	writer.Write((u32)m_sample_count, 32);
+	// No MD5 signature
+	for (int i = 0; i < 4; i++)
+		writer.Write(0, 32);
+
+	return header;
+}
+
+void FlacEncoder::EncodeFrame(const s16* samples, u32 count, std::vector<u8>* out)
+{
+	s32 left[BLOCK_SIZE], right[BLOCK_SIZE], mid[BLOCK_SIZE], side[BLOCK_SIZE];
+	for (u32 i = 0; i < count; i++)
+	{
+		left[i] = samples[2 * i];
+		right[i] = samples[2 * i + 1];
+		mid[i] = (left[i] + right[i]) >> 1;
+		side[i] = left[i] - right[i];
+	}
+
+	// The side channel needs an extra bit
+	SubframePlan left_plan, right_plan, mid_plan, side_plan;
+	PlanSubframe(left, count, 16, &left_plan);
+	PlanSubframe(right, count, 16, &right_plan);
+	PlanSubframe(mid, count, 16, &mid_plan);
+	PlanSubframe(side, count, 17, &side_plan);
+
+	ChannelAssignment assignment = CHANNELS_INDEPENDENT;
+	u64 bits = left_plan.bits + right_plan.bits;
+	if (left_plan.bits + side_plan.bits < bits)
+	{
+		assignment = CHANNELS_LEFT_SIDE;
+		bits = left_plan.bits + side_plan.bits;
+	}
+	if (right_plan.bits + side_plan.bits < bits)
+	{
+		assignment = CHANNELS_RIGHT_SIDE;
+		bits = right_plan.bits + side_plan.bits;
+	}
+	if (mid_plan.bits + side_plan.bits < bits)
+		assignment = CHANNELS_MID_SIDE;
+
+	const size_t start = out->size();
+	BitWriter writer(out);
+
+	// Frame header: sync code, fixed block size, block size (4096 or given at the end),
+	// sample rate of the stream information, channels and 16 bits per sample
+	writer.Write(0x3FFE, 14);
+	writer.Write(0, 2);
+	writer.Write(count == BLOCK_SIZE ? 12 : 7, 4);
+	writer.Write(0, 4);
+	writer.Write(assignment, 4);
+	writer.Write(4, 3);
+	writer.Write(0, 1);
+
+	// The frame number, coded like UTF-8
+	if (m_frame_number < 0x80)
+	{
+		writer.Write(m_frame_number, 8);
+	}
+	else
+	{
+		u32 extra_bytes = 1;
+		while (m_frame_number >> (6 * extra_bytes + 6 - extra_bytes))
+			extra_bytes++;
+		writer.Write((0xFF00 >> (extra_bytes + 1)) | (m_frame_number >> (6 * extra_bytes)), 8);
+		while (extra_bytes--)
+			writer.Write(0x80 | ((m_frame_number >> (6 * extra_bytes)) & 0x3F), 8);
+	}
+
+	if (count != BLOCK_SIZE)
+		writer.Write(count - 1, 16);
+	writer.Write(CRC8(&(*out)[start], out->size() - start), 8);
+
+	switch (assignment)
+	{
+	case CHANNELS_INDEPENDENT:
+		WriteSubframe(&writer, left, count, 16, left_plan);
+		WriteSubframe(&writer, right, count, 16, right_plan);
+		break;
+	case CHANNELS_LEFT_SIDE:
+		WriteSubframe(&writer, left, count, 16, left_plan);
+		WriteSubframe(&writer, side, count, 17, side_plan);
+		break;
+	case CHANNELS_RIGHT_SIDE:
+		WriteSubframe(&writer, side, count, 17, side_plan);
+		WriteSubframe(&writer, right, count, 16, right_plan);
+		break;
+	case CHANNELS_MID_SIDE:
+		WriteSubframe(&writer, mid, count, 16, mid_plan);
+		WriteSubframe(&writer, side, count, 17, side_plan);
+		break;
+	}
+
+	writer.Align();
+	writer.Write(CRC16(&(*out)[start], out->size() - start), 16);
+
+	const u32 frame_size = (u32)(out->size() - start);
+	m_min_frame_size = m_frame_number ? std::min(m_min_frame_size, frame_size) : frame_size;
+	m_max_frame_size = std::max(m_max_frame_size, frame_size);
+	m_frame_number++;
+	m_sample_count += count;
+}
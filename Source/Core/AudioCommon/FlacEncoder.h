@@ -0,0 +1,46 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// ---------------------------------------------------------------------------------
+// Class: FlacEncoder
+// Description: Encodes 16-bit stereo audio into a FLAC stream. Only the fixed
+// predictors and Rice coded residuals are used, which compresses game audio
+// nearly as well as the LPC of the reference encoder at a fraction of the cost.
+// Write GetHeader() first, then the frames given by EncodeFrame. Once all the
+// samples are encoded, GetHeader() returns a header with the final stream
+// information, to be written over the first one.
+// ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "Common/CommonTypes.h"
+
+class FlacEncoder
+{
+public:
+	enum
+	{
+		// Sample pairs per frame, except the last one
+		BLOCK_SIZE = 4096,
+		HEADER_SIZE = 42,
+	};
+
+	explicit FlacEncoder(u32 sample_rate);
+
+	std::vector<u8> GetHeader() const;
+
+	// Appends a frame with count sample pairs (at most BLOCK_SIZE), given
+	// interleaved left/right in host byte order, to out
+	void EncodeFrame(const s16* samples, u32 count, std::vector<u8>* out);
+
+	u64 GetSampleCount() const { return m_sample_count; }
+
+private:
+	u32 m_sample_rate;
+	u32 m_frame_number;
+	u64 m_sample_count;
+	u32 m_min_frame_size;
+	u32 m_max_frame_size;
+};
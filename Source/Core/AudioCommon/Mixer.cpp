@@ -2,11 +2,14 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
-#include "Common/CPUDetect.h"
+#include "Common/CommonFuncs.h"
+#include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
@@ -16,19 +19,122 @@
 // UGLINESS
 #include "Core/PowerPC/PowerPC.h"
 
-#if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
-#include <tmmintrin.h>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
 #endif
 
+#define SINC_PHASES (1 << SINC_PHASE_BITS)
+
+// Coefficients of the sinc filter for every fractional position, in 2.14
+// fixed point. They are stored for pairs of taps as c0 c1 c0 c1, matching the
+// left and right samples of two pairs once these are deinterleaved.
+static short s_sinc_coeffs[SINC_PHASES][SINC_TAPS * 2];
+
+// The output sample of a fractional position lies between taps
+// SINC_TAPS / 2 - 1 and SINC_TAPS / 2. The cutoff is a bit below the Nyquist
+// frequency of the input, and the filter is windowed with a Blackman window.
+static void InitSincCoeffs()
+{
+	const double cutoff = 0.9;
+	const double half_width = SINC_TAPS / 2;
+
+	for (int phase = 0; phase < SINC_PHASES; phase++)
+	{
+		double coeffs[SINC_TAPS];
+		double sum = 0.0;
+		for (int tap = 0; tap < SINC_TAPS; tap++)
+		{
+			double x = tap - (SINC_TAPS / 2 - 1) - (double)phase / SINC_PHASES;
+			double sinc = x == 0.0 ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+			double window = 0.42 + 0.5 * cos(M_PI * x / half_width) + 0.08 * cos(2.0 * M_PI * x / half_width);
+			coeffs[tap] = sinc * window;
+			sum += coeffs[tap];
+		}
+
+		// Normalize, and put the rounding error on the center tap, so that the
+		// filter passes constant signals unchanged.
+		int total = 0;
+		short fixed[SINC_TAPS];
+		for (int tap = 0; tap < SINC_TAPS; tap++)
+		{
+			fixed[tap] = (short)lround(coeffs[tap] / sum * 16384.0);
+			total += fixed[tap];
+		}
+		fixed[SINC_TAPS / 2 - 1 + (phase >= SINC_PHASES / 2)] += 16384 - total;
+
+		for (int tap = 0; tap < SINC_TAPS; tap += 2)
+		{
+			s_sinc_coeffs[phase][tap * 2 + 0] = fixed[tap];
+			s_sinc_coeffs[phase][tap * 2 + 1] = fixed[tap + 1];
+			s_sinc_coeffs[phase][tap * 2 + 2] = fixed[tap];
+			s_sinc_coeffs[phase][tap * 2 + 3] = fixed[tap + 1];
+		}
+	}
+}
+
+void SincInterpolateGeneric(const short* src, u32 frac, int* left, int* right)
+{
+	const short* coeffs = s_sinc_coeffs[frac >> (16 - SINC_PHASE_BITS)];
+	int l = 0, r = 0;
+	for (int tap = 0; tap < SINC_TAPS; tap++)
+	{
+		int coeff = coeffs[(tap & ~1) * 2 + (tap & 1)];
+		l += src[tap * 2] * coeff;
+		r += src[tap * 2 + 1] * coeff;
+	}
+	*left = l >> 14;
+	*right = r >> 14;
+}
+
+void SincInterpolate(const short* src, u32 frac, int* left, int* right)
+{
+#ifdef _M_X86
+	const short* coeffs = s_sinc_coeffs[frac >> (16 - SINC_PHASE_BITS)];
+	__m128i sum = _mm_setzero_si128();
+	for (int i = 0; i < SINC_TAPS * 2; i += 8)
+	{
+		// l0 r0 l1 r1 l2 r2 l3 r3 -> l0 l1 r0 r1 l2 l3 r2 r3
+		__m128i pairs = _mm_loadu_si128((const __m128i*)&src[i]);
+		pairs = _mm_shufflelo_epi16(pairs, _MM_SHUFFLE(3, 1, 2, 0));
+		pairs = _mm_shufflehi_epi16(pairs, _MM_SHUFFLE(3, 1, 2, 0));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(pairs, _mm_loadu_si128((const __m128i*)&coeffs[i])));
+	}
+	// l r l r -> l r
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	*left = _mm_cvtsi128_si32(sum) >> 14;
+	*right = _mm_cvtsi128_si32(_mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 1, 1, 1))) >> 14;
+#else
+	SincInterpolateGeneric(src, frac, left, right);
+#endif
+}
+
+// Copies big endian samples, swapping them to host order.
+static void SwapSamples(short* dst, const short* src, u32 count)
+{
+	u32 i = 0;
+#ifdef _M_X86
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&src[i]);
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+	}
+#endif
+	for (; i < count; i++)
+		dst[i] = Common::swap16(src[i]);
+}
+
 CMixer::CMixer(unsigned int BackendSampleRate)
-	: m_dma_mixer(this, 32000)
-	, m_streaming_mixer(this, 48000)
-	, m_wiimote_speaker_mixer(this, 3000)
+	: m_dma_mixer(this, 32000, "DMA")
+	, m_streaming_mixer(this, 48000, "Streaming")
+	, m_wiimote_speaker_mixer(this, 3000, "Wiimote speaker")
 	, m_sampleRate(BackendSampleRate)
 	, m_log_dtk_audio(false)
 	, m_log_dsp_audio(false)
 	, m_speed(0)
 {
+	static const bool sinc_coeffs_initialized = (InitSincCoeffs(), true);
+	(void)sinc_coeffs_initialized;
+
 	INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized");
 }
 
@@ -69,34 +175,74 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 	s32 lvolume = m_LVolume.load();
 	s32 rvolume = m_RVolume.load();
 
-	// TODO: consider a higher-quality resampling algorithm.
-	for (; currentSample < numSamples * 2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample += 2)
+	const u32 buffered = ((indexW - indexR) & INDEX_MASK) / 2;
+
+	const bool sinc = SConfig::GetInstance().m_SincResampling;
+	if (sinc)
+	{
+		// The filter reads SINC_TAPS pairs from indexR on, which delays the
+		// output by SINC_TAPS / 2 - 1 pairs compared to linear interpolation.
+		for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) >= SINC_TAPS * 2; currentSample += 2)
+		{
+			int sampleL, sampleR;
+			SincInterpolate(&m_buffer[indexR & INDEX_MASK], m_frac, &sampleL, &sampleR);
+			m_sinc_last_left = MathUtil::Clamp(sampleL, -32768, 32767);
+			m_sinc_last_right = MathUtil::Clamp(sampleR, -32768, 32767);
+
+			sampleL = (sampleL * lvolume) >> 8;
+			sampleL += samples[currentSample + 1];
+			samples[currentSample + 1] = MathUtil::Clamp(sampleL, -32767, 32767);
+
+			sampleR = (sampleR * rvolume) >> 8;
+			sampleR += samples[currentSample];
+			samples[currentSample] = MathUtil::Clamp(sampleR, -32767, 32767);
+
+			m_frac += ratio;
+			indexR += 2 * (u16)(m_frac >> 16);
+			m_frac &= 0xffff;
+		}
+	}
+	else
 	{
-		u32 indexR2 = indexR + 2; //next sample
-
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
-		sampleL = (sampleL * lvolume) >> 8;
-		sampleL += samples[currentSample + 1];
-		samples[currentSample + 1] = MathUtil::Clamp(sampleL, -32767, 32767);
-
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
-		sampleR = (sampleR * rvolume) >> 8;
-		sampleR += samples[currentSample];
-		samples[currentSample] = MathUtil::Clamp(sampleR, -32767, 32767);
-
-		m_frac += ratio;
-		indexR += 2 * (u16)(m_frac >> 16);
-		m_frac &= 0xffff;
+		for (; currentSample < numSamples * 2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample += 2)
+		{
+			u32 indexR2 = indexR + 2; //next sample
+
+			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
+			s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
+			int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
+			sampleL = (sampleL * lvolume) >> 8;
+			sampleL += samples[currentSample + 1];
+			samples[currentSample + 1] = MathUtil::Clamp(sampleL, -32767, 32767);
+
+			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
+			s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
+			int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
+			sampleR = (sampleR * rvolume) >> 8;
+			sampleR += samples[currentSample];
+			samples[currentSample] = MathUtil::Clamp(sampleR, -32767, 32767);
+
+			m_frac += ratio;
+			indexR += 2 * (u16)(m_frac >> 16);
+			m_frac &= 0xffff;
+		}
 	}
 
-	// Padding
+	UpdateStats(buffered, indexW, numSamples - currentSample / 2, numSamples);
+
+	// Padding, with the last sample pair which was output. The sinc filter
+	// lags behind indexR, so it repeats its own last output instead.
 	short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
+	if (sinc)
+	{
+		s[0] = m_sinc_last_right;
+		s[1] = m_sinc_last_left;
+	}
+	else
+	{
+		s[0] = m_buffer[(indexR - 1) & INDEX_MASK];
+		s[1] = m_buffer[(indexR - 2) & INDEX_MASK];
+	}
 	s[0] = (s[0] * rvolume) >> 8;
 	s[1] = (s[1] * lvolume) >> 8;
 	for (; currentSample < numSamples * 2; currentSample += 2)
@@ -147,17 +293,21 @@ void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_sampl
 
 	// AyuanX: Actual re-sampling work has been moved to sound thread
 	// to alleviate the workload on main thread
-	// and we simply store raw data here to make fast mem copy
-	int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0)
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
-		memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
-	}
-	else
-	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
-	}
+	// and we simply store raw data here to make fast mem copy.
+	// The samples are big endian, and swapped to host order once here rather
+	// than every time the sound thread reads them.
+	u32 start = indexW & INDEX_MASK;
+	u32 count = num_samples * 2;
+	u32 first = std::min(count, MAX_SAMPLES * 2 - start);
+	SwapSamples(&m_buffer[start], samples, first);
+	SwapSamples(&m_buffer[0], samples + first, count - first);
+
+	// Repeat what was written to the start of the buffer past its end, so
+	// that the sinc filter can read across the wrap.
+	if (start < SINC_TAPS * 2)
+		memcpy(&m_buffer[MAX_SAMPLES * 2 + start], &m_buffer[start], (std::min(start + first, (u32)SINC_TAPS * 2) - start) * sizeof(short));
+	if (first < count)
+		memcpy(&m_buffer[MAX_SAMPLES * 2], &m_buffer[0], std::min(count - first, (u32)SINC_TAPS * 2) * sizeof(short));
 
 	m_indexW.fetch_add(num_samples * 2);
 }
@@ -214,12 +364,12 @@ void CMixer::SetWiimoteSpeakerVolume(unsigned int lvolume, unsigned int rvolume)
 	m_wiimote_speaker_mixer.SetVolume(lvolume, rvolume);
 }
 
-void CMixer::StartLogDTKAudio(const std::string& filename)
+void CMixer::StartLogDTKAudio(const std::string& filename, WaveFileWriter::Format format)
 {
 	if (!m_log_dtk_audio)
 	{
 		m_log_dtk_audio = true;
-		m_wave_writer_dtk.Start(filename, 48000);
+		m_wave_writer_dtk.Start(filename, 48000, format);
 		m_wave_writer_dtk.SetSkipSilence(false);
 		NOTICE_LOG(AUDIO, "Starting DTK Audio logging");
 	}
@@ -243,12 +393,12 @@ void CMixer::StopLogDTKAudio()
 	}
 }
 
-void CMixer::StartLogDSPAudio(const std::string& filename)
+void CMixer::StartLogDSPAudio(const std::string& filename, WaveFileWriter::Format format)
 {
 	if (!m_log_dsp_audio)
 	{
 		m_log_dsp_audio = true;
-		m_wave_writer_dsp.Start(filename, 32000);
+		m_wave_writer_dsp.Start(filename, 32000, format);
 		m_wave_writer_dsp.SetSkipSilence(false);
 		NOTICE_LOG(AUDIO, "Starting DSP Audio logging");
 	}
@@ -282,3 +432,34 @@ void CMixer::MixerFifo::SetVolume(unsigned int lvolume, unsigned int rvolume)
 	m_LVolume.store(lvolume + (lvolume >> 7));
 	m_RVolume.store(rvolume + (rvolume >> 7));
 }
+
+// Executed from sound stream thread
+void CMixer::MixerFifo::UpdateStats(u32 buffered, u32 indexW, u32 padded, u32 mixed)
+{
+	if (m_report_samples == 0 || buffered < m_min_buffered)
+		m_min_buffered = buffered;
+
+	// Only fifos which are being fed can run out of samples.
+	if (padded && indexW != m_last_indexW)
+	{
+		m_report_underruns++;
+		m_report_padded += padded;
+	}
+	m_last_indexW = indexW;
+
+	// Report to the log once per second of output, if samples came in.
+	m_report_samples += mixed;
+	if (m_report_samples < m_mixer->m_sampleRate)
+		return;
+
+	if (indexW != m_report_indexW)
+	{
+		INFO_LOG(AUDIO, "%s fifo: %u sample pairs buffered, at least %u (%.1f ms), %u underruns padded with %u sample pairs",
+			m_name, buffered, m_min_buffered, m_min_buffered * 1000.0f / m_input_sample_rate,
+			m_report_underruns, m_report_padded);
+	}
+	m_report_samples = 0;
+	m_report_underruns = 0;
+	m_report_padded = 0;
+	m_report_indexW = indexW;
+}
@@ -9,6 +9,7 @@
 #include <mutex>
 
 #include "AudioCommon/WaveFile.h"
+#include "Common/CommonTypes.h"
 
 // 16 bit Stereo
 #define MAX_SAMPLES     (1024 * 2) // 64ms
@@ -19,6 +20,16 @@
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+// Windowed-sinc resampling, optionally used instead of linear interpolation
+#define SINC_TAPS       16   // sample pairs the filter is made from
+#define SINC_PHASE_BITS 8    // log2 of the number of fractional positions
+
+// Filters SINC_TAPS interleaved sample pairs starting at src, for a fractional position in
+// 16 bit fixed point. The coefficients are set up by the first CMixer.
+void SincInterpolate(const short* src, u32 frac, int* left, int* right);
+// The same without SIMD, which SincInterpolate uses on other architectures
+void SincInterpolateGeneric(const short* src, u32 frac, int* left, int* right);
+
 class CMixer
 {
 public:
@@ -39,10 +50,10 @@ public:
 	void SetStreamingVolume(unsigned int lvolume, unsigned int rvolume);
 	void SetWiimoteSpeakerVolume(unsigned int lvolume, unsigned int rvolume);
 
-	void StartLogDTKAudio(const std::string& filename);
+	void StartLogDTKAudio(const std::string& filename, WaveFileWriter::Format format = WaveFileWriter::FORMAT_WAV);
 	void StopLogDTKAudio();
 
-	void StartLogDSPAudio(const std::string& filename);
+	void StartLogDSPAudio(const std::string& filename, WaveFileWriter::Format format = WaveFileWriter::FORMAT_WAV);
 	void StopLogDSPAudio();
 
 	float GetCurrentSpeed() const { return m_speed.load(); }
@@ -51,15 +62,24 @@ public:
 protected:
 	class MixerFifo {
 	public:
-		MixerFifo(CMixer *mixer, unsigned sample_rate)
+		MixerFifo(CMixer *mixer, unsigned sample_rate, const char* name)
 			: m_mixer(mixer)
 			, m_input_sample_rate(sample_rate)
+			, m_name(name)
 			, m_indexW(0)
 			, m_indexR(0)
 			, m_LVolume(256)
 			, m_RVolume(256)
 			, m_numLeftI(0.0f)
 			, m_frac(0)
+			, m_sinc_last_left(0)
+			, m_sinc_last_right(0)
+			, m_min_buffered(0)
+			, m_last_indexW(0)
+			, m_report_samples(0)
+			, m_report_underruns(0)
+			, m_report_padded(0)
+			, m_report_indexW(0)
 		{
 			memset(m_buffer, 0, sizeof(m_buffer));
 		}
@@ -68,9 +88,14 @@ protected:
 		void SetInputSampleRate(unsigned int rate);
 		void SetVolume(unsigned int lvolume, unsigned int rvolume);
 	private:
+		void UpdateStats(u32 buffered, u32 indexW, u32 padded, u32 mixed);
+
 		CMixer *m_mixer;
 		unsigned m_input_sample_rate;
-		short m_buffer[MAX_SAMPLES * 2];
+		const char* m_name;
+		// Samples are stored in host byte order. The first SINC_TAPS pairs are
+		// repeated past the end, so the sinc filter can read across the wrap.
+		short m_buffer[MAX_SAMPLES * 2 + SINC_TAPS * 2];
 		std::atomic<u32> m_indexW;
 		std::atomic<u32> m_indexR;
 		// Volume ranges from 0-256
@@ -78,6 +103,18 @@ protected:
 		std::atomic<s32> m_RVolume;
 		float m_numLeftI;
 		u32 m_frac;
+		// The last pair output by the sinc filter, before the volume
+		s16 m_sinc_last_left;
+		s16 m_sinc_last_right;
+
+		// Fill statistics, reported to the log once per second of output.
+		// Only underruns of fifos which are being fed are counted.
+		u32 m_min_buffered;
+		u32 m_last_indexW;
+		u32 m_report_samples;
+		u32 m_report_underruns;
+		u32 m_report_padded;
+		u32 m_report_indexW;
 	};
 	MixerFifo m_dma_mixer;
 	MixerFifo m_streaming_mixer;
@@ -2,149 +2,277 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <string>
 
+#include "AudioCommon/FlacEncoder.h"
 #include "AudioCommon/WaveFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Thread.h"
 #include "Common/Logging/Log.h"
 #include "Core/ConfigManager.h"
 
-enum { BUF_SIZE = 32*1024 };
+enum
+{
+	// Sample pairs, about 2.7 seconds at 48 kHz
+	QUEUE_SIZE = 128 * 1024,
+	QUEUE_MASK = QUEUE_SIZE - 1,
+	// The writer thread writes to the file once it has at least this many bytes
+	OUTPUT_BATCH_SIZE = 256 * 1024,
+};
 
 WaveFileWriter::WaveFileWriter():
-	skip_silence(false),
-	audio_size(0),
-	conv_buffer(nullptr)
+	m_format(FORMAT_WAV),
+	m_skip_silence(false),
+	m_audio_size(0),
+	m_queue_write(0),
+	m_queue_read(0),
+	m_dropped(0)
 {
 }
 
 WaveFileWriter::~WaveFileWriter()
 {
-	delete[] conv_buffer;
 	Stop();
 }
 
-bool WaveFileWriter::Start(const std::string& filename, unsigned int HLESampleRate)
+bool WaveFileWriter::Start(const std::string& filename, unsigned int HLESampleRate, Format format)
 {
-	if (!conv_buffer)
-		conv_buffer = new short[BUF_SIZE];
-
 	// Check if the file is already open
-	if (file)
+	if (m_file)
 	{
 		PanicAlertT("The file %s was already open, the file header will not be written.", filename.c_str());
 		return false;
 	}
 
-	file.Open(filename, "wb");
-	if (!file)
+	m_file.Open(filename, "wb");
+	if (!m_file)
 	{
 		PanicAlertT("The file %s could not be opened for writing. Please check if it's already opened by another program.", filename.c_str());
 		return false;
 	}
 
-	audio_size = 0;
-
-	// -----------------
-	// Write file header
-	// -----------------
-	Write4("RIFF");
-	Write(100 * 1000 * 1000);  // write big value in case the file gets truncated
-	Write4("WAVE");
-	Write4("fmt ");
-
-	Write(16);  // size of fmt block
-	Write(0x00020001); //two channels, uncompressed
+	m_format = format;
+	m_audio_size = 0;
 
-	const u32 sample_rate = HLESampleRate;
-	Write(sample_rate);
-	Write(sample_rate * 2 * 2); //two channels, 16bit
-
-	Write(0x00100004);
-	Write4("data");
-	Write(100 * 1000 * 1000 - 32);
+	if (format == FORMAT_FLAC)
+	{
+		m_encoder.reset(new FlacEncoder(HLESampleRate));
+		const std::vector<u8> header = m_encoder->GetHeader();
+		m_file.WriteBytes(header.data(), header.size());
+		m_block.clear();
+	}
+	else
+	{
+		// -----------------
+		// Write file header
+		// -----------------
+		Write4("RIFF");
+		Write(100 * 1000 * 1000);  // write big value in case the file gets truncated
+		Write4("WAVE");
+		Write4("fmt ");
+
+		Write(16);  // size of fmt block
+		Write(0x00020001); //two channels, uncompressed
+
+		const u32 sample_rate = HLESampleRate;
+		Write(sample_rate);
+		Write(sample_rate * 2 * 2); //two channels, 16bit
+
+		Write(0x00100004);
+		Write4("data");
+		Write(100 * 1000 * 1000 - 32);
+
+		// We are now at offset 44
+		if (m_file.Tell() != 44)
+			PanicAlert("Wrong offset: %lld", (long long)m_file.Tell());
+	}
 
-	// We are now at offset 44
-	if (file.Tell() != 44)
-		PanicAlert("Wrong offset: %lld", (long long)file.Tell());
+	if (!m_queue)
+		m_queue.reset(new s16[QUEUE_SIZE * 2]);
+	m_queue_write.store(0);
+	m_queue_read.store(0);
+	m_dropped.store(0);
+	m_output.clear();
+	m_stop_event.Reset();
+	m_thread = std::thread(&WaveFileWriter::WriterThread, this);
 
 	return true;
 }
 
 void WaveFileWriter::Stop()
 {
-	// u32 file_size = (u32)ftello(file);
-	file.Seek(4, SEEK_SET);
-	Write(audio_size + 36);
+	if (!m_thread.joinable())
+		return;
 
-	file.Seek(40, SEEK_SET);
-	Write(audio_size);
+	// The thread writes out everything which was queued before it exits
+	m_stop_event.Set();
+	m_thread.join();
 
-	file.Close();
+	if (m_format == FORMAT_FLAC)
+	{
+		if (!m_block.empty())
+			m_encoder->EncodeFrame(m_block.data(), (u32)m_block.size() / 2, &m_output);
+		FlushOutput();
+
+		// Now that the length of the stream is known
+		const std::vector<u8> header = m_encoder->GetHeader();
+		m_file.Seek(0, SEEK_SET);
+		m_file.WriteBytes(header.data(), header.size());
+		m_encoder.reset();
+	}
+	else
+	{
+		FlushOutput();
+
+		m_file.Seek(4, SEEK_SET);
+		Write(m_audio_size + 36);
+
+		m_file.Seek(40, SEEK_SET);
+		Write(m_audio_size);
+	}
+
+	m_file.Close();
 }
 
 void WaveFileWriter::Write(u32 value)
 {
-	file.WriteArray(&value, 1);
+	m_file.WriteArray(&value, 1);
 }
 
 void WaveFileWriter::Write4(const char *ptr)
 {
-	file.WriteBytes(ptr, 4);
+	m_file.WriteBytes(ptr, 4);
 }
 
-void WaveFileWriter::AddStereoSamples(const short *sample_data, u32 count)
+s16* WaveFileWriter::BeginQueueWrite(u32 count)
 {
-	if (!file)
+	if (!m_thread.joinable())
+	{
 		PanicAlertT("WaveFileWriter - file not open.");
+		return nullptr;
+	}
 
-	if (skip_silence)
+	const u32 write = m_queue_write.load(std::memory_order_relaxed);
+	const u32 read = m_queue_read.load(std::memory_order_acquire);
+	if (QUEUE_SIZE - (write - read) < count)
 	{
-		bool all_zero = true;
+		m_dropped.fetch_add(count, std::memory_order_relaxed);
+		return nullptr;
+	}
 
-		for (u32 i = 0; i < count * 2; i++)
-		{
-			if (sample_data[i])
-				all_zero = false;
-		}
+	return m_queue.get();
+}
+
+void WaveFileWriter::EndQueueWrite(u32 count)
+{
+	m_queue_write.fetch_add(count, std::memory_order_release);
+	m_audio_size += count * 4;
+}
+
+bool WaveFileWriter::IsSilence(const short* sample_data, u32 count) const
+{
+	return m_skip_silence && std::all_of(sample_data, sample_data + count * 2, [](short sample) { return sample == 0; });
+}
 
-		if (all_zero)
-			return;
+void WaveFileWriter::AddStereoSamples(const short *sample_data, u32 count)
+{
+	if (IsSilence(sample_data, count))
+		return;
+
+	s16* queue = BeginQueueWrite(count);
+	if (!queue)
+		return;
+
+	const u32 write = m_queue_write.load(std::memory_order_relaxed);
+	for (u32 i = 0; i < count; i++)
+	{
+		s16* dst = &queue[((write + i) & QUEUE_MASK) * 2];
+		dst[0] = sample_data[2 * i];
+		dst[1] = sample_data[2 * i + 1];
 	}
 
-	file.WriteBytes(sample_data, count * 4);
-	audio_size += count * 4;
+	EndQueueWrite(count);
 }
 
 void WaveFileWriter::AddStereoSamplesBE(const short *sample_data, u32 count)
 {
-	if (!file)
-		PanicAlertT("WaveFileWriter - file not open.");
+	if (IsSilence(sample_data, count))
+		return;
 
-	if (count > BUF_SIZE * 2)
-		PanicAlert("WaveFileWriter - buffer too small (count = %u).", count);
+	s16* queue = BeginQueueWrite(count);
+	if (!queue)
+		return;
 
-	if (skip_silence)
+	const u32 write = m_queue_write.load(std::memory_order_relaxed);
+	for (u32 i = 0; i < count; i++)
 	{
-		bool all_zero = true;
+		//Flip the audio channels from RL to LR
+		s16* dst = &queue[((write + i) & QUEUE_MASK) * 2];
+		dst[0] = Common::swap16((u16)sample_data[2 * i + 1]);
+		dst[1] = Common::swap16((u16)sample_data[2 * i]);
+	}
+
+	EndQueueWrite(count);
+}
 
-		for (u32 i = 0; i < count * 2; i++)
+void WaveFileWriter::WriterThread()
+{
+	Common::SetCurrentThreadName("Audio dump writer");
+
+	bool stopping = false;
+	while (!stopping)
+	{
+		// The thread polls the queue, so that adding samples never needs a lock
+		stopping = m_stop_event.WaitFor(std::chrono::milliseconds(100));
+
+		const u32 write = m_queue_write.load(std::memory_order_acquire);
+		u32 read = m_queue_read.load(std::memory_order_relaxed);
+		while (read != write)
 		{
-			if (sample_data[i])
-				all_zero = false;
+			const u32 start = read & QUEUE_MASK;
+			const u32 count = std::min(write - read, QUEUE_SIZE - start);
+			EncodeSamples(&m_queue[start * 2], count);
+			read += count;
 		}
+		m_queue_read.store(read, std::memory_order_release);
+
+		const u32 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped)
+			WARN_LOG(AUDIO, "Audio dump: %u samples were dropped, as the queue was full", dropped);
 
-		if (all_zero)
-			return;
+		if (m_output.size() >= OUTPUT_BATCH_SIZE)
+			FlushOutput();
 	}
+}
 
-	for (u32 i = 0; i < count; i++)
+void WaveFileWriter::EncodeSamples(const s16* samples, u32 count)
+{
+	if (m_format == FORMAT_WAV)
 	{
-		//Flip the audio channels from RL to LR
-		conv_buffer[2 * i] = Common::swap16((u16)sample_data[2 * i + 1]);
-		conv_buffer[2 * i + 1] = Common::swap16((u16)sample_data[2 * i]);
+		const u8* bytes = (const u8*)samples;
+		m_output.insert(m_output.end(), bytes, bytes + count * 4);
+		return;
+	}
+
+	while (count)
+	{
+		const u32 block_count = std::min<u32>(count, FlacEncoder::BLOCK_SIZE - (u32)m_block.size() / 2);
+		m_block.insert(m_block.end(), samples, samples + block_count * 2);
+		samples += block_count * 2;
+		count -= block_count;
+
+		if (m_block.size() == FlacEncoder::BLOCK_SIZE * 2)
+		{
+			m_encoder->EncodeFrame(m_block.data(), FlacEncoder::BLOCK_SIZE, &m_output);
+			m_block.clear();
+		}
 	}
+}
 
-	file.WriteBytes(conv_buffer, count * 4);
-	audio_size += count * 4;
+void WaveFileWriter::FlushOutput()
+{
+	m_file.WriteBytes(m_output.data(), m_output.size());
+	m_output.clear();
 }
@@ -5,40 +5,80 @@
 // ---------------------------------------------------------------------------------
 // Class: WaveFileWriter
 // Description: Simple utility class to make it easy to write long 16-bit stereo
-// audio streams to disk.
+// audio streams to disk, as WAV or as FLAC.
 // Use Start() to start recording to a file, and AddStereoSamples to add wave data.
-// The float variant will convert from -1.0-1.0 range and clamp.
 // Alternatively, AddSamplesBE for big endian wave data.
+// The samples are only queued, a thread of the writer encodes them and writes
+// them to the file in large batches, so that the emulation never waits for the
+// disk. If the queue overflows, the samples which do not fit are dropped.
 // If Stop is not called when it destructs, the destructor will call Stop().
 // ---------------------------------------------------------------------------------
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
+
 #include "Common/CommonTypes.h"
+#include "Common/Event.h"
 #include "Common/FileUtil.h"
 #include "Common/NonCopyable.h"
 
+class FlacEncoder;
+
 class WaveFileWriter : NonCopyable
 {
 public:
+	enum Format
+	{
+		FORMAT_WAV,
+		FORMAT_FLAC,
+	};
+
 	WaveFileWriter();
 	~WaveFileWriter();
 
-	bool Start(const std::string& filename, unsigned int HLESampleRate);
+	bool Start(const std::string& filename, unsigned int HLESampleRate, Format format = FORMAT_WAV);
 	void Stop();
 
-	void SetSkipSilence(bool skip) { skip_silence = skip; }
+	void SetSkipSilence(bool skip) { m_skip_silence = skip; }
 
 	void AddStereoSamples(const short *sample_data, u32 count);
 	void AddStereoSamplesBE(const short *sample_data, u32 count);  // big endian
-	u32 GetAudioSize() const { return audio_size; }
+	u32 GetAudioSize() const { return m_audio_size; }
 
 private:
-	File::IOFile file;
-	bool skip_silence;
-	u32 audio_size;
-	short* conv_buffer;
+	// Reserves room for count sample pairs in the queue, returns nullptr if it is full
+	s16* BeginQueueWrite(u32 count);
+	void EndQueueWrite(u32 count);
+	bool IsSilence(const short* sample_data, u32 count) const;
+
+	void WriterThread();
+	void EncodeSamples(const s16* samples, u32 count);
+	void FlushOutput();
 	void Write(u32 value);
 	void Write4(const char* ptr);
+
+	File::IOFile m_file;
+	Format m_format;
+	bool m_skip_silence;
+	u32 m_audio_size;
+
+	// Sample pairs in host byte order, written by the emulation and read by the
+	// writer thread
+	std::unique_ptr<s16[]> m_queue;
+	std::atomic<u32> m_queue_write;
+	std::atomic<u32> m_queue_read;
+	std::atomic<u32> m_dropped;
+
+	std::thread m_thread;
+	Common::Event m_stop_event;
+
+	// Only used by the writer thread
+	std::vector<u8> m_output;
+	std::unique_ptr<FlacEncoder> m_encoder;
+	std::vector<s16> m_block;
 };
@@ -4,10 +4,54 @@
 
 #include <array>
 #include <cstdlib>
+#include <cstring>
 
 #include "Common/GL/GLInterface/EGL.h"
 #include "Common/Logging/Log.h"
 
+// Offscreen context sharing objects with a cInterfaceEGL one, see CreateSharedContext()
+class cInterfaceEGLShared final : public cInterfaceBase
+{
+public:
+	cInterfaceEGLShared(EGLDisplay dpy, EGLContext ctx, EGLSurface surf, EGLenum api)
+		: m_dpy(dpy), m_ctx(ctx), m_surf(surf), m_api(api)
+	{
+	}
+
+	void* GetFuncAddress(const std::string& name) override
+	{
+		return (void*)eglGetProcAddress(name.c_str());
+	}
+
+	bool MakeCurrent() override
+	{
+		// The bound client API is per thread state
+		eglBindAPI(m_api);
+		return eglMakeCurrent(m_dpy, m_surf, m_surf, m_ctx);
+	}
+
+	bool ClearCurrent() override
+	{
+		return eglMakeCurrent(m_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	}
+
+	void Shutdown() override
+	{
+		if (m_ctx != EGL_NO_CONTEXT)
+			eglDestroyContext(m_dpy, m_ctx);
+		if (m_surf != EGL_NO_SURFACE)
+			eglDestroySurface(m_dpy, m_surf);
+		m_ctx = EGL_NO_CONTEXT;
+		m_surf = EGL_NO_SURFACE;
+	}
+
+private:
+	EGLDisplay m_dpy;
+	EGLContext m_ctx;
+	EGLSurface m_surf;
+	EGLenum m_api;
+};
+
 // Show the current FPS
 void cInterfaceEGL::Swap()
 {
@@ -180,6 +224,9 @@ bool cInterfaceEGL::Create(void *window_handle, bool core)
 	s = eglQueryString(egl_dpy, EGL_CLIENT_APIS);
 	INFO_LOG(VIDEO, "EGL_CLIENT_APIS = %s\n", s);
 
+	m_config = config;
+	m_ctx_attribs.assign(std::begin(ctx_attribs), std::end(ctx_attribs));
+
 	egl_ctx = eglCreateContext(egl_dpy, config, EGL_NO_CONTEXT, ctx_attribs );
 	if (!egl_ctx)
 	{
@@ -197,6 +244,34 @@ bool cInterfaceEGL::Create(void *window_handle, bool core)
 	return true;
 }
 
+std::unique_ptr<cInterfaceBase> cInterfaceEGL::CreateSharedContext()
+{
+	EGLContext ctx = eglCreateContext(egl_dpy, m_config, egl_ctx, &m_ctx_attribs[0]);
+	if (!ctx)
+	{
+		ERROR_LOG(VIDEO, "Unable to create a shared EGL context.");
+		return nullptr;
+	}
+
+	// Without EGL_KHR_surfaceless_context the context needs some surface to be made current
+	EGLSurface surf = EGL_NO_SURFACE;
+	const char* extensions = eglQueryString(egl_dpy, EGL_EXTENSIONS);
+	if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surf = eglCreatePbufferSurface(egl_dpy, m_config, pbuffer_attribs);
+		if (surf == EGL_NO_SURFACE)
+		{
+			ERROR_LOG(VIDEO, "Unable to create a pbuffer for the shared EGL context.");
+			eglDestroyContext(egl_dpy, ctx);
+			return nullptr;
+		}
+	}
+
+	EGLenum api = s_opengl_mode == MODE_OPENGL ? EGL_OPENGL_API : EGL_OPENGL_ES_API;
+	return std::make_unique<cInterfaceEGLShared>(egl_dpy, ctx, surf, api);
+}
+
 bool cInterfaceEGL::MakeCurrent()
 {
 	return eglMakeCurrent(egl_dpy, egl_surf, egl_surf, egl_ctx);
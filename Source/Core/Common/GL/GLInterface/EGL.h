@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
 #include <EGL/egl.h>
 
 #include "Common/GL/GLInterfaceBase.h"
@@ -16,6 +18,8 @@ protected:
 	EGLSurface egl_surf;
 	EGLContext egl_ctx;
 	EGLDisplay egl_dpy;
+	EGLConfig m_config;
+	std::vector<EGLint> m_ctx_attribs;
 
 	virtual EGLDisplay OpenDisplay() = 0;
 	virtual EGLNativeWindowType InitializePlatform(EGLNativeWindowType host_window, EGLConfig config) = 0;
@@ -26,6 +30,7 @@ public:
 	void SetMode(u32 mode) { s_opengl_mode = mode; }
 	void* GetFuncAddress(const std::string& name);
 	bool Create(void *window_handle, bool core);
+	std::unique_ptr<cInterfaceBase> CreateSharedContext();
 	bool MakeCurrent();
 	bool ClearCurrent();
 	void Shutdown();
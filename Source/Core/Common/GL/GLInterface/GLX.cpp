@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <iterator>
 #include <string>
 
 #include "Common/GL/GLInterface/GLX.h"
@@ -110,6 +111,7 @@ bool cInterfaceGLX::Create(void *window_handle, bool core)
 	{
 		ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs);
 		XSync(dpy, False);
+		m_attribs.assign(std::begin(context_attribs), std::end(context_attribs));
 	}
 	if (core && (!ctx || s_glxError))
 	{
@@ -124,6 +126,7 @@ bool cInterfaceGLX::Create(void *window_handle, bool core)
 		s_glxError = false;
 		ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs_33);
 		XSync(dpy, False);
+		m_attribs.assign(std::begin(context_attribs_33), std::end(context_attribs_33));
 
 	}
 	if (!ctx || s_glxError)
@@ -137,6 +140,7 @@ bool cInterfaceGLX::Create(void *window_handle, bool core)
 		s_glxError = false;
 		ctx = glXCreateContextAttribs(dpy, fbconfig, 0, True, context_attribs_legacy);
 		XSync(dpy, False);
+		m_attribs.clear();
 
 	}
 	if (!ctx || s_glxError)
@@ -166,8 +170,39 @@ bool cInterfaceGLX::Create(void *window_handle, bool core)
 	return true;
 }
 
+std::unique_ptr<cInterfaceBase> cInterfaceGLX::CreateSharedContext()
+{
+	// Only GL 3.0+ contexts may be made current without a drawable (GLX_ARB_create_context)
+	if (m_attribs.empty())
+		return nullptr;
+
+	auto shared = std::make_unique<cInterfaceGLX>();
+	shared->dpy = dpy;
+	shared->win = None;
+	shared->fbconfig = fbconfig;
+	shared->m_attribs = m_attribs;
+	shared->m_is_shared = true;
+
+	s_glxError = false;
+	XErrorHandler oldHandler = XSetErrorHandler(&ctxErrorHandler);
+	shared->ctx = glXCreateContextAttribs(dpy, fbconfig, ctx, True, &m_attribs[0]);
+	XSync(dpy, False);
+	XSetErrorHandler(oldHandler);
+
+	if (!shared->ctx || s_glxError)
+	{
+		ERROR_LOG(VIDEO, "Unable to create a shared GL context.");
+		return nullptr;
+	}
+
+	return std::move(shared);
+}
+
 bool cInterfaceGLX::MakeCurrent()
 {
+	if (m_is_shared)
+		return glXMakeContextCurrent(dpy, None, None, ctx);
+
 	bool success = glXMakeCurrent(dpy, win, ctx);
 	if (success)
 	{
@@ -186,6 +221,15 @@ bool cInterfaceGLX::ClearCurrent()
 // Close backend
 void cInterfaceGLX::Shutdown()
 {
+	if (m_is_shared)
+	{
+		// The display connection belongs to the main context
+		if (ctx)
+			glXDestroyContext(dpy, ctx);
+		ctx = nullptr;
+		return;
+	}
+
 	XWindow.DestroyXWindow();
 	if (ctx)
 	{
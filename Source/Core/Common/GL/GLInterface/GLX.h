@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
 #include <GL/glx.h>
 
 #include "Common/GL/GLInterfaceBase.h"
@@ -18,12 +20,15 @@ private:
 	Window win;
 	GLXContext ctx;
 	GLXFBConfig fbconfig;
+	std::vector<int> m_attribs; // attributes ctx has been created with, empty for legacy contexts
+	bool m_is_shared = false;
 public:
 	friend class cX11Window;
 	void SwapInterval(int Interval) override;
 	void Swap() override;
 	void* GetFuncAddress(const std::string& name) override;
 	bool Create(void *window_handle, bool core) override;
+	std::unique_ptr<cInterfaceBase> CreateSharedContext() override;
 	bool MakeCurrent() override;
 	bool ClearCurrent() override;
 	void Shutdown() override;
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "Common/CommonTypes.h"
@@ -30,6 +31,10 @@ public:
 	virtual u32 GetMode() { return s_opengl_mode; }
 	virtual void* GetFuncAddress(const std::string& name) { return nullptr; }
 	virtual bool Create(void *window_handle, bool core = true) { return true; }
+	// Creates a context sharing its objects with this one, for use on another thread.
+	// It isn't bound to any window, so it can't present anything.
+	// Returns nullptr if this isn't supported.
+	virtual std::unique_ptr<cInterfaceBase> CreateSharedContext() { return nullptr; }
 	virtual bool MakeCurrent() { return true; }
 	virtual bool ClearCurrent() { return true; }
 	virtual void Shutdown() {}
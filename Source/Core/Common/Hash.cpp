@@ -10,6 +10,9 @@
 #include "Common/Intrinsics.h"
 
 static u64 (*ptrHashFunction)(const u8 *src, u32 len, u32 samples) = &GetMurmurHash3;
+static u64 (*ptrFullHashFunction)(const u8 *src, u32 len, u32 samples) = &GetMurmurHash3;
+// Full hashes of smaller buffers use ptrHashFunction
+static u32 s_full_hash_min_len = 0;
 
 // uint32_t
 // WARNING - may read one more byte!
@@ -576,12 +579,188 @@ u64 GetHashHiresTexture(const u8 *src, u32 len, u32 samples)
 }
 #endif
 
+// Wide-lane hash, modelled after the accumulate loop of XXH3.
+// Eight independent 64-bit accumulators consume the input in 64 byte stripes. Every lane
+// adds the 32x32->64 bit product of the two halves of its keyed input word, as well as the
+// raw input word of its neighbouring lane. The accumulators are scrambled after every
+// block of stripes and merged at the end. There are no dependencies between the lanes
+// inside a stripe, so the AVX2 version below processes four of them per instruction and
+// produces the same hashes as this portable version.
+// Like the other texture hashes, samples limits the number of stripes that are read.
+static const u32 WIDE_HASH_STRIPE_SIZE = 64;
+static const u32 WIDE_HASH_STRIPES_PER_BLOCK = 16;
+static const u64 WIDE_HASH_PRIME32 = 0x9E3779B1;
+static const u64 WIDE_HASH_PRIME64 = 0x9E3779B185EBCA87;
+
+alignas(32) static const u64 s_wide_hash_key[8] = {
+	0xbe4ba423396cfeb8, 0x1cad21f72c81017c, 0xdb979083e96dd4de, 0x1f67b3b7a4a44072,
+	0x78e5c0cc4ee679cb, 0x2172ffcc7dd05a82, 0x8e2443f7744608b8, 0x4c263a81e69035e0,
+};
+
+alignas(32) static const u64 s_wide_hash_scramble_key[8] = {
+	0xcb00c391bb52283c, 0xa32e531b8b65d088, 0x4ef90da297486471, 0xd8acdea946ef1938,
+	0x3f349ce33f76faa8, 0x1d4f0bc7c7bbdcf9, 0x3159b4cd4be0518a, 0x647378d9c97e9fc8,
+};
+
+static u32 WideHashStep(u32 num_stripes, u32 samples)
+{
+	u32 step = num_stripes;
+	if (samples == 0)
+		samples = std::max(step, 1u);
+	step = step / samples;
+	return std::max(step, 1u);
+}
+
+static u64 WideHashFinalize(const u64 acc[8], u32 len)
+{
+	u64 h = len * WIDE_HASH_PRIME64;
+	for (int i = 0; i < 8; ++i)
+	{
+		u64 k = acc[i] ^ s_wide_hash_key[i];
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccd;
+		k ^= k >> 33;
+		h = _rotl64(h ^ k, 27) * WIDE_HASH_PRIME64;
+	}
+
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53;
+	h ^= h >> 33;
+	return h;
+}
+
+static inline void WideHashAccumulate(u64 acc[8], const u8* stripe)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		u64 data;
+		std::memcpy(&data, stripe + i * 8, sizeof(data));
+		const u64 keyed = data ^ s_wide_hash_key[i];
+		acc[i ^ 1] += data;
+		acc[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+	}
+}
+
+static inline void WideHashScramble(u64 acc[8])
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= s_wide_hash_scramble_key[i];
+		acc[i] *= WIDE_HASH_PRIME32;
+	}
+}
+
+u64 GetWideHash64(const u8 *src, u32 len, u32 samples)
+{
+	u64 acc[8] = {
+		WIDE_HASH_PRIME32, WIDE_HASH_PRIME64, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+		0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+	};
+
+	const u32 num_stripes = len / WIDE_HASH_STRIPE_SIZE;
+	const u32 step = WideHashStep(num_stripes, samples);
+	u32 stripes_in_block = 0;
+	for (u32 i = 0; i < num_stripes; i += step)
+	{
+		WideHashAccumulate(acc, src + i * WIDE_HASH_STRIPE_SIZE);
+		if (++stripes_in_block == WIDE_HASH_STRIPES_PER_BLOCK)
+		{
+			WideHashScramble(acc);
+			stripes_in_block = 0;
+		}
+	}
+
+	if (len % WIDE_HASH_STRIPE_SIZE)
+	{
+		u8 tail[WIDE_HASH_STRIPE_SIZE] = {};
+		std::memcpy(tail, src + num_stripes * WIDE_HASH_STRIPE_SIZE, len % WIDE_HASH_STRIPE_SIZE);
+		WideHashAccumulate(acc, tail);
+	}
+
+	return WideHashFinalize(acc, len);
+}
+
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+#ifdef _MSC_VER
+#define WIDE_HASH_AVX2_TARGET
+#else
+#define WIDE_HASH_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+// Same as GetWideHash64, but four lanes at a time. Only call this if cpu_info.bAVX2 is set.
+WIDE_HASH_AVX2_TARGET
+u64 GetWideHash64AVX2(const u8 *src, u32 len, u32 samples)
+{
+	alignas(32) u64 acc[8] = {
+		WIDE_HASH_PRIME32, WIDE_HASH_PRIME64, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+		0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+	};
+
+	const __m256i key_lo = _mm256_load_si256((const __m256i*)&s_wide_hash_key[0]);
+	const __m256i key_hi = _mm256_load_si256((const __m256i*)&s_wide_hash_key[4]);
+	const __m256i scramble_lo = _mm256_load_si256((const __m256i*)&s_wide_hash_scramble_key[0]);
+	const __m256i scramble_hi = _mm256_load_si256((const __m256i*)&s_wide_hash_scramble_key[4]);
+	const __m256i prime = _mm256_set1_epi64x(WIDE_HASH_PRIME32);
+	__m256i acc_lo = _mm256_load_si256((const __m256i*)&acc[0]);
+	__m256i acc_hi = _mm256_load_si256((const __m256i*)&acc[4]);
+
+	const u32 num_stripes = len / WIDE_HASH_STRIPE_SIZE;
+	const u32 step = WideHashStep(num_stripes, samples);
+	u32 stripes_in_block = 0;
+	for (u32 i = 0; i < num_stripes; i += step)
+	{
+		const u8* stripe = src + i * WIDE_HASH_STRIPE_SIZE;
+		const __m256i data_lo = _mm256_loadu_si256((const __m256i*)stripe);
+		const __m256i data_hi = _mm256_loadu_si256((const __m256i*)(stripe + 32));
+		const __m256i keyed_lo = _mm256_xor_si256(data_lo, key_lo);
+		const __m256i keyed_hi = _mm256_xor_si256(data_hi, key_hi);
+		// acc[i] += lo32(keyed[i]) * hi32(keyed[i]) + data[i ^ 1]
+		acc_lo = _mm256_add_epi64(acc_lo, _mm256_mul_epu32(keyed_lo, _mm256_srli_epi64(keyed_lo, 32)));
+		acc_hi = _mm256_add_epi64(acc_hi, _mm256_mul_epu32(keyed_hi, _mm256_srli_epi64(keyed_hi, 32)));
+		acc_lo = _mm256_add_epi64(acc_lo, _mm256_shuffle_epi32(data_lo, _MM_SHUFFLE(1, 0, 3, 2)));
+		acc_hi = _mm256_add_epi64(acc_hi, _mm256_shuffle_epi32(data_hi, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		if (++stripes_in_block == WIDE_HASH_STRIPES_PER_BLOCK)
+		{
+			// acc = (acc ^ (acc >> 47) ^ scramble_key) * PRIME32, with the 64x32 bit
+			// multiplication split into two 32x32->64 bit ones.
+			acc_lo = _mm256_xor_si256(_mm256_xor_si256(acc_lo, _mm256_srli_epi64(acc_lo, 47)), scramble_lo);
+			acc_hi = _mm256_xor_si256(_mm256_xor_si256(acc_hi, _mm256_srli_epi64(acc_hi, 47)), scramble_hi);
+			acc_lo = _mm256_add_epi64(_mm256_mul_epu32(acc_lo, prime),
+				_mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(acc_lo, 32), prime), 32));
+			acc_hi = _mm256_add_epi64(_mm256_mul_epu32(acc_hi, prime),
+				_mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(acc_hi, 32), prime), 32));
+			stripes_in_block = 0;
+		}
+	}
+
+	_mm256_store_si256((__m256i*)&acc[0], acc_lo);
+	_mm256_store_si256((__m256i*)&acc[4], acc_hi);
+
+	if (len % WIDE_HASH_STRIPE_SIZE)
+	{
+		u8 tail[WIDE_HASH_STRIPE_SIZE] = {};
+		std::memcpy(tail, src + num_stripes * WIDE_HASH_STRIPE_SIZE, len % WIDE_HASH_STRIPE_SIZE);
+		WideHashAccumulate(acc, tail);
+	}
+
+	return WideHashFinalize(acc, len);
+}
+#endif
+
 u64 GetHash64(const u8 *src, u32 len, u32 samples)
 {
+	// The wide hash reads whole stripes per sample, which only pays off when hashing everything
+	if (samples == 0 && len >= s_full_hash_min_len)
+		return ptrFullHashFunction(src, len, samples);
 	return ptrHashFunction(src, len, samples);
 }
 
 // sets the hash function used for the texture cache
+// These hashes are only ever compared against hashes from the same run, so the fastest
+// function available may be picked here. Anything that ends up in file names (texture
+// dumps, custom textures) has to use GetHashHiresTexture instead, which never changes.
 void SetHash64Function()
 {
 #if _M_SSE >= 0x402
@@ -600,6 +779,19 @@ void SetHash64Function()
 	{
 		ptrHashFunction = &GetMurmurHash3;
 	}
+
+	ptrFullHashFunction = ptrHashFunction;
+	s_full_hash_min_len = 0;
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+	if (cpu_info.bAVX2) // avx2 wide-lane version
+	{
+		ptrFullHashFunction = &GetWideHash64AVX2;
+		// CRC32 is about twice as fast on buffers of a few hundred bytes, and they break
+		// even at 1-2 KiB (see dolphin-micro-bench hash)
+		if (ptrHashFunction == &GetCRC32)
+			s_full_hash_min_len = 2048;
+	}
+#endif
 }
 
 
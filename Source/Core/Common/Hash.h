@@ -14,5 +14,9 @@ u32 HashEctor(const u8* ptr, int length);            // JUNK. DO NOT USE FOR NEW
 u64 GetCRC32(const u8 *src, u32 len, u32 samples);   // SSE4.2 version of CRC32
 u64 GetHashHiresTexture(const u8 *src, u32 len, u32 samples = 0);
 u64 GetMurmurHash3(const u8 *src, u32 len, u32 samples);
+u64 GetWideHash64(const u8 *src, u32 len, u32 samples);
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+u64 GetWideHash64AVX2(const u8 *src, u32 len, u32 samples); // same hashes as GetWideHash64
+#endif
 u64 GetHash64(const u8 *src, u32 len, u32 samples);
 void SetHash64Function();
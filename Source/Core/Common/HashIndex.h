@@ -0,0 +1,247 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+// Per-object bookkeeping for a HashIndex. An object that can be part of several
+// indices at the same time needs one of these for each of them.
+template <typename Key, typename T>
+struct HashIndexLink
+{
+	Key key = 0;
+	T* prev = nullptr;
+	T* next = nullptr;
+	bool linked = false;
+
+	bool IsLinked() const { return linked; }
+};
+
+// An intrusive multimap from an integral key to objects of type T.
+//
+// Keys are stored in an open-addressed table (linear probing), every table slot
+// pointing to an intrusive doubly linked chain of all objects sharing that key.
+// Objects of one key are kept in insertion order, like std::multimap does.
+// Neither insertions nor removals allocate anything apart from growing the table.
+//
+// Removing objects never moves other slots around (tombstones are used instead),
+// so ForEach() callbacks may remove the object they have been passed.
+template <typename Key, typename T, HashIndexLink<Key, T> T::*Link>
+class HashIndex
+{
+	static_assert(std::is_integral<Key>::value, "HashIndex only supports integral keys");
+
+public:
+	HashIndex() : m_slots(INITIAL_CAPACITY) {}
+
+	// Appends the object to the chain for the given key.
+	void Insert(Key key, T* item)
+	{
+		if ((m_used + m_deleted + 1) * 2 > m_slots.size())
+			Rehash();
+
+		Slot& slot = m_slots[FindInsertSlot(key)];
+		if (slot.state != SLOT_OCCUPIED)
+		{
+			if (slot.state == SLOT_DELETED)
+				m_deleted--;
+			m_used++;
+			slot.state = SLOT_OCCUPIED;
+			slot.key = key;
+			slot.head = nullptr;
+			slot.tail = nullptr;
+		}
+
+		HashIndexLink<Key, T>& link = item->*Link;
+		link.key = key;
+		link.prev = slot.tail;
+		link.next = nullptr;
+		link.linked = true;
+		if (slot.tail)
+			(slot.tail->*Link).next = item;
+		else
+			slot.head = item;
+		slot.tail = item;
+		m_size++;
+	}
+
+	// Removes the object from the index. It must currently be linked into it.
+	void Erase(T* item)
+	{
+		HashIndexLink<Key, T>& link = item->*Link;
+		Slot& slot = m_slots[FindSlot(link.key)];
+
+		if (link.prev)
+			(link.prev->*Link).next = link.next;
+		else
+			slot.head = link.next;
+		if (link.next)
+			(link.next->*Link).prev = link.prev;
+		else
+			slot.tail = link.prev;
+
+		link.prev = nullptr;
+		link.next = nullptr;
+		link.linked = false;
+		m_size--;
+
+		if (!slot.head)
+		{
+			slot.state = SLOT_DELETED;
+			m_used--;
+			m_deleted++;
+		}
+	}
+
+	// Returns the first object inserted with the given key, or nullptr.
+	// Use Next() to walk over the other objects with the same key.
+	T* Find(Key key) const
+	{
+		size_t index = FindSlot(key);
+		return index == NOT_FOUND ? nullptr : m_slots[index].head;
+	}
+
+	static T* Next(const T* item)
+	{
+		return (item->*Link).next;
+	}
+
+	// Calls func for every object. func may erase the object it has been passed
+	// from this index, but must neither insert nor erase any other object.
+	template <typename Func>
+	void ForEach(Func func)
+	{
+		for (size_t i = 0; i < m_slots.size(); ++i)
+		{
+			if (m_slots[i].state != SLOT_OCCUPIED)
+				continue;
+
+			T* item = m_slots[i].head;
+			while (item)
+			{
+				T* next = (item->*Link).next;
+				func(item);
+				item = next;
+			}
+		}
+	}
+
+	// Forgets about all objects without touching them, so they may already be deleted.
+	void Clear()
+	{
+		m_slots.assign(INITIAL_CAPACITY, Slot());
+		m_size = 0;
+		m_used = 0;
+		m_deleted = 0;
+	}
+
+	size_t Size() const { return m_size; }
+	bool Empty() const { return m_size == 0; }
+
+private:
+	enum SlotState : u8
+	{
+		SLOT_EMPTY,
+		SLOT_OCCUPIED,
+		SLOT_DELETED,
+	};
+
+	struct Slot
+	{
+		Key key = 0;
+		SlotState state = SLOT_EMPTY;
+		T* head = nullptr;
+		T* tail = nullptr;
+	};
+
+	static const size_t INITIAL_CAPACITY = 64;
+	static const size_t NOT_FOUND = ~static_cast<size_t>(0);
+
+	// Texture addresses and similar keys tend to only differ in a few bits, so
+	// mix them properly before using them as a table index (MurmurHash3 finalizer).
+	static size_t Mix(Key key)
+	{
+		u64 h = static_cast<u64>(key);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return static_cast<size_t>(h);
+	}
+
+	size_t FindSlot(Key key) const
+	{
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = Mix(key) & mask; ; i = (i + 1) & mask)
+		{
+			const Slot& slot = m_slots[i];
+			if (slot.state == SLOT_EMPTY)
+				return NOT_FOUND;
+			if (slot.state == SLOT_OCCUPIED && slot.key == key)
+				return i;
+		}
+	}
+
+	// Returns the slot already holding the key, or the first free one it can be put in.
+	size_t FindInsertSlot(Key key) const
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t first_deleted = NOT_FOUND;
+		for (size_t i = Mix(key) & mask; ; i = (i + 1) & mask)
+		{
+			const Slot& slot = m_slots[i];
+			if (slot.state == SLOT_EMPTY)
+				return first_deleted != NOT_FOUND ? first_deleted : i;
+			if (slot.state == SLOT_DELETED)
+			{
+				if (first_deleted == NOT_FOUND)
+					first_deleted = i;
+			}
+			else if (slot.key == key)
+			{
+				return i;
+			}
+		}
+	}
+
+	// Grows the table if it is getting full, otherwise only drops the tombstones.
+	void Rehash()
+	{
+		size_t capacity = m_slots.size();
+		while ((m_used + 1) * 2 > capacity / 2)
+			capacity *= 2;
+
+		std::vector<Slot> old_slots(capacity);
+		old_slots.swap(m_slots);
+		m_deleted = 0;
+
+		const size_t mask = capacity - 1;
+		for (const Slot& old_slot : old_slots)
+		{
+			if (old_slot.state != SLOT_OCCUPIED)
+				continue;
+
+			size_t i = Mix(old_slot.key) & mask;
+			while (m_slots[i].state != SLOT_EMPTY)
+				i = (i + 1) & mask;
+			m_slots[i] = old_slot;
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size = 0;    // number of objects
+	size_t m_used = 0;    // number of occupied slots (distinct keys)
+	size_t m_deleted = 0; // number of tombstones
+};
+
+}  // namespace Common
@@ -1783,27 +1783,15 @@ void XEmitter::PSLLDQ(X64Reg reg, int shift)
 }
 
 
-// WARNING not REX compatible
 void XEmitter::PSRAW(X64Reg reg, int shift)
 {
-	if (reg > 7)
-		PanicAlert("The PSRAW-emitter does not support regs above 7");
-	Write8(0x66);
-	Write8(0x0f);
-	Write8(0x71);
-	Write8(0xE0 | reg);
+	WriteSSEOp(0x66, 0x71, (X64Reg)4, R(reg));
 	Write8(shift);
 }
 
-// WARNING not REX compatible
 void XEmitter::PSRAD(X64Reg reg, int shift)
 {
-	if (reg > 7)
-		PanicAlert("The PSRAD-emitter does not support regs above 7");
-	Write8(0x66);
-	Write8(0x0f);
-	Write8(0x72);
-	Write8(0xE0 | reg);
+	WriteSSEOp(0x66, 0x72, (X64Reg)4, R(reg));
 	Write8(shift);
 }
 
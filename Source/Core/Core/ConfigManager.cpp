@@ -44,7 +44,7 @@ SConfig::SConfig()
   bRunCompareServer(false), bRunCompareClient(false),
   bMMU(false), bDCBZOFF(false),
   iBBDumpPort(0),
-  bFastDiscSpeed(false), bSyncGPU(false),
+  bFastDiscSpeed(false), bSyncGPU(false), bGPUConvertThread(false),
   SelectedLanguage(0), bOverrideGCLanguage(false), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -263,6 +263,7 @@ void SConfig::SaveCoreSettings(IniFile& ini)
 	core->Set("OverclockEnable", m_OCEnable);
 	core->Set("GFXBackend", m_strVideoBackend);
 	core->Set("GPUDeterminismMode", m_strGPUDeterminismMode);
+	core->Set("GPUConvertThread", bGPUConvertThread);
 	core->Set("GameCubeAdapter", m_GameCubeAdapter);
 	core->Set("AdapterRumble", m_AdapterRumble);
 	core->Set("PerfMapDir", m_perfDir);
@@ -285,10 +286,15 @@ void SConfig::SaveDSPSettings(IniFile& ini)
 
 	dsp->Set("EnableJIT", m_DSPEnableJIT);
 	dsp->Set("DumpAudio", m_DumpAudio);
+	dsp->Set("DumpAudioFLAC", m_DumpAudioFLAC);
 	dsp->Set("DumpUCode", m_DumpUCode);
 	dsp->Set("Backend", sBackend);
 	dsp->Set("Volume", m_Volume);
 	dsp->Set("CaptureLog", m_DSPCaptureLog);
+	dsp->Set("HLEParallelVoices", m_DSPHLEParallelVoices);
+	dsp->Set("HLECapture", m_DSPHLECapture);
+	dsp->Set("SincResampling", m_SincResampling);
+	dsp->Set("LLESliceCycles", m_DSPLLESliceCycles);
 }
 
 void SConfig::SaveInputSettings(IniFile& ini)
@@ -524,6 +530,7 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("FrameSkip",                 &m_FrameSkip,                                   0);
 	core->Get("GFXBackend",                &m_strVideoBackend, "");
 	core->Get("GPUDeterminismMode",        &m_strGPUDeterminismMode, "auto");
+	core->Get("GPUConvertThread",          &bGPUConvertThread, false);
 	core->Get("GameCubeAdapter",           &m_GameCubeAdapter,                             false);
 	core->Get("AdapterRumble",             &m_AdapterRumble,                               true);
 	core->Get("PerfMapDir",                &m_perfDir, "");
@@ -546,6 +553,7 @@ void SConfig::LoadDSPSettings(IniFile& ini)
 
 	dsp->Get("EnableJIT", &m_DSPEnableJIT, true);
 	dsp->Get("DumpAudio", &m_DumpAudio, false);
+	dsp->Get("DumpAudioFLAC", &m_DumpAudioFLAC, false);
 	dsp->Get("DumpUCode", &m_DumpUCode, false);
 #if defined __linux__ && HAVE_ALSA
 	dsp->Get("Backend", &sBackend, BACKEND_ALSA);
@@ -560,6 +568,10 @@ void SConfig::LoadDSPSettings(IniFile& ini)
 #endif
 	dsp->Get("Volume", &m_Volume, 100);
 	dsp->Get("CaptureLog", &m_DSPCaptureLog, false);
+	dsp->Get("HLEParallelVoices", &m_DSPHLEParallelVoices, false);
+	dsp->Get("HLECapture", &m_DSPHLECapture, false);
+	dsp->Get("SincResampling", &m_SincResampling, false);
+	dsp->Get("LLESliceCycles", &m_DSPLLESliceCycles, 12600);
 
 	m_IsMuted = false;
 }
@@ -604,6 +616,7 @@ void SConfig::LoadDefaults()
 	bDCBZOFF = false;
 	iBBDumpPort = -1;
 	bSyncGPU = false;
+	bGPUConvertThread = false;
 	bFastDiscSpeed = false;
 	bEnableMemcardSdWriting = true;
 	SelectedLanguage = 0;
@@ -153,6 +153,8 @@ struct SConfig : NonCopyable
 
 	// set based on the string version
 	GPUDeterminismMode m_GPUDeterminismMode;
+	// With a deterministic GPU thread, load vertices on another thread ahead of it
+	bool bGPUConvertThread;
 
 	// files
 	std::string m_strFilename;
@@ -255,7 +257,12 @@ struct SConfig : NonCopyable
 	// DSP settings
 	bool m_DSPEnableJIT;
 	bool m_DSPCaptureLog;
+	bool m_DSPHLEParallelVoices;
+	bool m_DSPHLECapture;
+	bool m_SincResampling;
+	int m_DSPLLESliceCycles;
 	bool m_DumpAudio;
+	bool m_DumpAudioFLAC;
 	bool m_IsMuted;
 	bool m_DumpUCode;
 	int m_Volume;
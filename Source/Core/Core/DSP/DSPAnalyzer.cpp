@@ -3,8 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <string>
 
+#include "Common/StringUtil.h"
 #include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPMemoryMap.h"
 #include "Core/DSP/DSPTables.h"
@@ -67,6 +70,67 @@ static void Reset()
 	code_flags.fill(0);
 }
 
+// Checks for a loop which reads the high half of a mailbox until its top bit
+// changes, in any of the forms the ucodes use:
+//   LRS/LR $AC.M, @DMBH/@CMBH
+//   ANDF/ANDCF $AC.M, #0x8000
+//   JLZ/JLNZ <start>
+// Returns the mail flags for the loop, or 0 if there is no such loop at
+// start_addr. Unless any_target is set, the jump has to go back to the read.
+static u8 FindMailWait(int start_addr, bool any_target)
+{
+	int addr = start_addr;
+	UDSPInstruction inst = dsp_imem_read(addr);
+	u16 reg, mbox_addr;
+	if ((inst & 0xf800) == 0x2000)
+	{
+		// LRS $(0x18+D), @M
+		reg = 0x18 + ((inst >> 8) & 0x7);
+		mbox_addr = 0xff00 | (inst & 0xff);
+		addr += 1;
+	}
+	else if ((inst & 0xffe0) == 0x00c0)
+	{
+		// LR $D, @M
+		reg = inst & 0x1f;
+		mbox_addr = dsp_imem_read(addr + 1);
+		addr += 2;
+	}
+	else
+	{
+		return 0;
+	}
+
+	if (mbox_addr != (0xff00 | DSP_DMBH) && mbox_addr != (0xff00 | DSP_CMBH))
+		return 0;
+	if (reg != DSP_REG_ACM0 && reg != DSP_REG_ACM1)
+		return 0;
+
+	// ANDF/ANDCF of the top bit, on the same register
+	inst = dsp_imem_read(addr);
+	if ((inst & 0xfeff) != 0x02a0 && (inst & 0xfeff) != 0x02c0)
+		return 0;
+	if (((inst & 0x0100) ? DSP_REG_ACM1 : DSP_REG_ACM0) != reg || dsp_imem_read(addr + 1) != 0x8000)
+		return 0;
+	const bool andcf = (inst & 0xfeff) == 0x02c0;
+	addr += 2;
+
+	inst = dsp_imem_read(addr);
+	if (inst != 0x029c && inst != 0x029d)
+		return 0;
+	if (!any_target && dsp_imem_read(addr + 1) != start_addr)
+		return 0;
+	const bool jlz = inst == 0x029d;
+
+	// ANDCF sets LZ when the bit is set, ANDF when it is clear.
+	const bool loops_while_set = andcf == jlz;
+	if (mbox_addr == (0xff00 | DSP_CMBH) && !loops_while_set)
+		return CODE_WAIT_CPU_MAIL;
+	if (mbox_addr == (0xff00 | DSP_DMBH) && loops_while_set)
+		return CODE_WAIT_DSP_MAIL;
+	return 0;
+}
+
 static void AnalyzeRange(int start_addr, int end_addr)
 {
 	// First we run an extremely simplified version of a disassembler to find
@@ -145,18 +209,53 @@ static void AnalyzeRange(int start_addr, int end_addr)
 			if (found)
 			{
 				INFO_LOG(DSPLLE, "Idle skip location found at %02x (sigNum:%d)", addr, s+1);
-				code_flags[addr] |= CODE_IDLE_SKIP;
+				code_flags[addr] |= CODE_IDLE_SKIP | FindMailWait(addr, true);
 			}
 		}
 	}
+
+	// Mail wait loops which none of the signatures cover.
+	for (int addr = start_addr; addr < end_addr; addr++)
+	{
+		if (!(code_flags[addr] & CODE_START_OF_INST) || (code_flags[addr] & CODE_IDLE_SKIP))
+			continue;
+
+		u8 mail_flags = FindMailWait(addr, false);
+		if (mail_flags)
+		{
+			INFO_LOG(DSPLLE, "Mail wait loop found at %02x", addr);
+			code_flags[addr] |= CODE_IDLE_SKIP | mail_flags;
+		}
+	}
 	INFO_LOG(DSPLLE, "Finished analysis.");
 }
 
+static void ReportIdleSkips()
+{
+	std::string sites;
+	int count = 0;
+	for (int addr = 0; addr < ISPACE; addr++)
+	{
+		if (!(code_flags[addr] & CODE_IDLE_SKIP))
+			continue;
+
+		const char* kind = "other";
+		if (code_flags[addr] & CODE_WAIT_CPU_MAIL)
+			kind = "cpu mail";
+		else if (code_flags[addr] & CODE_WAIT_DSP_MAIL)
+			kind = "dsp mail";
+		sites += StringFromFormat(" %04x (%s)", addr, kind);
+		count++;
+	}
+	NOTICE_LOG(DSPLLE, "Ucode %08x: %d idle skip locations:%s", g_dsp.iram_crc, count, sites.c_str());
+}
+
 void Analyze()
 {
 	Reset();
 	AnalyzeRange(0x0000, 0x1000);  // IRAM
 	AnalyzeRange(0x8000, 0x9000);  // IROM
+	ReportIdleSkips();
 }
 
 }  // namespace
@@ -23,6 +23,10 @@ enum
 	CODE_LOOP_END      = 8,
 	CODE_UPDATE_SR     = 16,
 	CODE_CHECK_INT     = 32,
+	// Set on idle skip locations which poll a mailbox, telling which mail
+	// they wait for: mail from the CPU, or the CPU reading the DSP's mail.
+	CODE_WAIT_CPU_MAIL = 64,
+	CODE_WAIT_DSP_MAIL = 128,
 };
 
 // Easy to query array covering the whole of instruction memory.
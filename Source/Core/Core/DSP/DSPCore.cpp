@@ -294,6 +294,23 @@ int DSPCore_RunCycles(int cycles)
 	return cycles;
 }
 
+// Mail wait loops are only skipped while their mail is missing, which also
+// makes them safe to skip on the DSP thread. Other idle loops wait for
+// something which can't be checked here, so they can only be skipped when
+// the CPU doesn't run at the same time.
+bool DSPCore_IsIdleSkip(u16 addr)
+{
+	const u8 flags = DSPAnalyzer::code_flags[addr];
+	if (!(flags & DSPAnalyzer::CODE_IDLE_SKIP))
+		return false;
+
+	if (flags & DSPAnalyzer::CODE_WAIT_CPU_MAIL)
+		return !(gdsp_mbox_peek(MAILBOX_CPU) & 0x80000000);
+	if (flags & DSPAnalyzer::CODE_WAIT_DSP_MAIL)
+		return (gdsp_mbox_peek(MAILBOX_DSP) & 0x80000000) != 0;
+	return !DSPHost::OnThread();
+}
+
 void DSPCore_SetState(DSPCoreState new_state)
 {
 	core_state = new_state;
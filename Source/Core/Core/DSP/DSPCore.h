@@ -355,6 +355,9 @@ enum DSPCoreState
 
 int DSPCore_RunCycles(int cycles);
 
+// Whether the DSP may give up the rest of its time slice at an idle skip location.
+bool DSPCore_IsIdleSkip(u16 addr);
+
 // These are meant to be called from the UI thread.
 void DSPCore_SetState(DSPCoreState new_state);
 DSPCoreState DSPCore_GetState();
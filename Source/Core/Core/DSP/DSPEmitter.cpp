@@ -8,6 +8,7 @@
 #include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPEmitter.h"
 #include "Core/DSP/DSPHost.h"
+#include "Core/DSP/DSPHWInterface.h"
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPMemoryMap.h"
 
@@ -263,21 +264,24 @@ void DSPEmitter::Compile(u16 start_addr)
 			// end of each block and in this order
 			DSPJitRegCache c(gpr);
 			HandleLoop();
+
+			// Carry on with the block if the loop is done, or if the active loop
+			// does not end here.
+			CMP(16, M(&g_dsp.pc), Imm16(compilePC));
+			FixupBranch rLoopDone = J_CC(CC_E, true);
+
+			if (!(DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP))
+				WriteLoopBackEdge(entryPoint);
+
 			gpr.SaveRegs();
-			if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
-			{
-				MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
-			}
-			else
-			{
-				MOV(16, R(EAX), Imm16(blockSize[start_addr]));
-			}
+			WriteBlockCycles();
 			JMP(returnDispatcher, true);
 			gpr.LoadRegs(false);
 			gpr.FlushRegs(c,false);
 
 			SetJumpTarget(rLoopAddressExit);
 			SetJumpTarget(rLoopCounterExit);
+			SetJumpTarget(rLoopDone);
 		}
 
 		if (opcode->branch)
@@ -298,14 +302,7 @@ void DSPEmitter::Compile(u16 start_addr)
 				DSPJitRegCache c(gpr);
 				//don't update g_dsp.pc -- the branch insn already did
 				gpr.SaveRegs();
-				if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
-				{
-					MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
-				}
-				else
-				{
-					MOV(16, R(EAX), Imm16(blockSize[start_addr]));
-				}
+				WriteBlockCycles();
 				JMP(returnDispatcher, true);
 				gpr.LoadRegs(false);
 				gpr.FlushRegs(c,false);
@@ -324,6 +321,9 @@ void DSPEmitter::Compile(u16 start_addr)
 	if (fixup_pc)
 	{
 		MOV(16, M(&(g_dsp.pc)), Imm16(compilePC));
+
+		// The block was cut off, so it goes on with the next one.
+		WriteBlockLink(compilePC);
 	}
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
@@ -361,15 +361,79 @@ void DSPEmitter::Compile(u16 start_addr)
 	}
 
 	gpr.SaveRegs();
-	if (!DSPHost::OnThread() && DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP)
+	WriteBlockCycles();
+	JMP(returnDispatcher, true);
+}
+
+// Puts the number of cycles the block took into EAX. Idle skip blocks use up
+// the rest of the time slice instead, while the DSP has nothing to do.
+void DSPEmitter::WriteBlockCycles()
+{
+	const u8 flags = DSPAnalyzer::code_flags[startAddr];
+	if (flags & (DSPAnalyzer::CODE_WAIT_CPU_MAIL | DSPAnalyzer::CODE_WAIT_DSP_MAIL))
+	{
+		// Same as DSPCore_IsIdleSkip: only skip while the mail is missing.
+		const bool cpu_mail = (flags & DSPAnalyzer::CODE_WAIT_CPU_MAIL) != 0;
+		MOV(16, R(EAX), Imm16(blockSize[startAddr]));
+		TEST(32, M(&g_dsp.mbox[cpu_mail ? MAILBOX_CPU : MAILBOX_DSP]), Imm32(0x80000000));
+		FixupBranch notIdle = J_CC(cpu_mail ? CC_NZ : CC_Z);
+		MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
+		SetJumpTarget(notIdle);
+	}
+	else if (!DSPHost::OnThread() && flags & DSPAnalyzer::CODE_IDLE_SKIP)
 	{
 		MOV(16, R(EAX), Imm16(DSP_IDLE_SKIP_CYCLES));
 	}
 	else
 	{
-		MOV(16, R(EAX), Imm16(blockSize[start_addr]));
+		MOV(16, R(EAX), Imm16(blockSize[startAddr]));
 	}
-	JMP(returnDispatcher, true);
+}
+
+// When a loop goes back to the start of the block, run the next iteration
+// straight away, as long as the dispatcher would also have run the block
+// again. The cycles of the last iteration are taken off here instead.
+void DSPEmitter::WriteLoopBackEdge(const u8* entryPoint)
+{
+	CMP(16, M(&g_dsp.pc), Imm16(startAddr));
+	FixupBranch notLoopStart = J_CC(CC_NE, true);
+
+	CMP(16, M(&cyclesLeft), Imm16(blockSize[startAddr]));
+	FixupBranch notEnoughCycles = J_CC(CC_BE, true);
+
+	TEST(8, M(&g_dsp.cr), Imm8(CR_HALT));
+	FixupBranch halted = J_CC(CC_NZ, true);
+
+	FixupBranch exceptionExit;
+	if (DSPHost::OnThread())
+	{
+		CMP(8, M(const_cast<bool*>(&g_dsp.external_interrupt_waiting)), Imm8(0));
+		exceptionExit = J_CC(CC_NE, true);
+	}
+
+	// The block may have been thrown away by a DMA to IRAM in the loop.
+	MOV(64, R(RCX), ImmPtr(&blocks[startAddr]));
+	MOV(64, R(RAX), ImmPtr(entryPoint));
+	CMP(64, R(RAX), MatR(RCX));
+	FixupBranch recompiled = J_CC(CC_NE, true);
+
+	SUB(16, M(&cyclesLeft), Imm16(blockSize[startAddr]));
+	// Jumping past the register loads at the start of the block saves the
+	// dispatcher round trip and reloading the accumulators, but the other
+	// cached registers still have to be written back.
+	DSPJitRegCache c(gpr);
+	gpr.FlushRegs();
+	JMP(blockLinkEntry, true);
+	gpr.FlushRegs(c, false);
+
+	SetJumpTarget(notLoopStart);
+	SetJumpTarget(notEnoughCycles);
+	SetJumpTarget(halted);
+	if (DSPHost::OnThread())
+	{
+		SetJumpTarget(exceptionExit);
+	}
+	SetJumpTarget(recompiled);
 }
 
 const u8 *DSPEmitter::CompileStub()
@@ -49,6 +49,11 @@ public:
 	void clrCompileSR(u16 bit);
 	void checkExceptions(u32 retval);
 
+	// Block linking
+	void WriteBlockLink(u16 dest);
+	void WriteLoopBackEdge(const u8* entryPoint);
+	void WriteBlockCycles();
+
 	// Memory helper functions
 	void increment_addr_reg(int reg);
 	void decrement_addr_reg(int reg);
@@ -98,6 +98,11 @@ int RunCyclesThread(int cycles)
 		cycles--;
 		if (cycles < 0)
 			return 0;
+
+		// Back at the start of a loop polling for mail which isn't there yet,
+		// so skip to the next time slice.
+		if (DSPCore_IsIdleSkip(g_dsp.pc))
+			return 0;
 	}
 }
 
@@ -134,7 +139,7 @@ int RunCyclesDebug(int cycles)
 				return cycles;
 			}
 			// Idle skipping.
-			if (DSPAnalyzer::code_flags[g_dsp.pc] & DSPAnalyzer::CODE_IDLE_SKIP)
+			if (DSPCore_IsIdleSkip(g_dsp.pc))
 				return 0;
 			Step();
 			cycles--;
@@ -184,7 +189,7 @@ int RunCycles(int cycles)
 			if (g_dsp.cr & CR_HALT)
 				return 0;
 			// Idle skipping.
-			if (DSPAnalyzer::code_flags[g_dsp.pc] & DSPAnalyzer::CODE_IDLE_SKIP)
+			if (DSPCore_IsIdleSkip(g_dsp.pc))
 				return 0;
 			Step();
 			cycles--;
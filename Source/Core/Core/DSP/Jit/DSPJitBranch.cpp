@@ -4,6 +4,7 @@
 
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPEmitter.h"
+#include "Core/DSP/DSPHost.h"
 #include "Core/DSP/DSPMemoryMap.h"
 #include "Core/DSP/DSPStacks.h"
 
@@ -77,54 +78,57 @@ static void WriteBranchExit(DSPEmitter& emitter)
 {
 	DSPJitRegCache c(emitter.gpr);
 	emitter.gpr.SaveRegs();
-	if (DSPAnalyzer::code_flags[emitter.startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
-	{
-		emitter.MOV(16, R(EAX), Imm16(0x1000));
-	}
-	else
-	{
-		emitter.MOV(16, R(EAX), Imm16(emitter.blockSize[emitter.startAddr]));
-	}
+	emitter.WriteBlockCycles();
 	emitter.JMP(emitter.returnDispatcher, true);
 	emitter.gpr.LoadRegs(false);
 	emitter.gpr.FlushRegs(c,false);
 }
 
-static void WriteBlockLink(DSPEmitter& emitter, u16 dest)
+// Jump directly to the block at <dest> if it has already been compiled and
+// there are enough cycles left to execute it.
+void DSPEmitter::WriteBlockLink(u16 dest)
 {
-	// Jump directly to the called block if it has already been compiled.
-	if (!(dest >= emitter.startAddr && dest <= emitter.compilePC))
+	// Branches into the block being compiled can't be linked, and idle skip
+	// blocks have to go back to the dispatcher to give up their time slice.
+	if (dest >= startAddr && dest < compilePC)
+		return;
+	if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+		return;
+
+	if (blockLinks[dest] != nullptr)
+	{
+		// The linked block starts after its register loads, with everything
+		// but the accumulators in memory.
+		gpr.FlushRegs();
+		// Check if we have enough cycles to execute the next block
+		MOV(16, R(ECX), M(&cyclesLeft));
+		CMP(16, R(ECX), Imm16(blockSize[startAddr] + blockSize[dest]));
+		FixupBranch notEnoughCycles = J_CC(CC_BE);
+
+		SUB(16, R(ECX), Imm16(blockSize[startAddr]));
+		MOV(16, M(&cyclesLeft), R(ECX));
+		JMP(blockLinks[dest], true);
+		SetJumpTarget(notEnoughCycles);
+	}
+	else if (blocks[dest] == (DSPCompiledCode)stubEntryPoint)
 	{
-		if (emitter.blockLinks[dest] != nullptr )
-		{
-			emitter.gpr.FlushRegs();
-			// Check if we have enough cycles to execute the next block
-			emitter.MOV(16, R(ECX), M(&cyclesLeft));
-			emitter.CMP(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr] + emitter.blockSize[dest]));
-			FixupBranch notEnoughCycles = emitter.J_CC(CC_BE);
-
-			emitter.SUB(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr]));
-			emitter.MOV(16, M(&cyclesLeft), R(ECX));
-			emitter.JMP(emitter.blockLinks[dest], true);
-			emitter.SetJumpTarget(notEnoughCycles);
-		}
-		else
-		{
-			// The destination has not been compiled yet.  Add it to the list
-			// of blocks that this block is waiting on.
-			emitter.unresolvedJumps[emitter.startAddr].push_back(dest);
-		}
+		// The destination has not been compiled yet.  Add it to the list
+		// of blocks that this block is waiting on.
+		unresolvedJumps[startAddr].push_back(dest);
 	}
+	// Otherwise the destination is compiled, but waits on other blocks
+	// itself, maybe on this one. Blocks waiting on each other would be
+	// compiled over and over by CompileCurrent, so this exit goes through
+	// the dispatcher instead.
 }
 
 static void r_jcc(const UDSPInstruction opc, DSPEmitter& emitter)
 {
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
+	// The destination is static, so attempt to link block. For conditional
+	// branches, this is only reached when the branch is taken.
+	emitter.WriteBlockLink(dest);
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
 	WriteBranchExit(emitter);
 }
@@ -166,11 +170,10 @@ static void r_call(const UDSPInstruction opc, DSPEmitter& emitter)
 	emitter.MOV(16, R(DX), Imm16(emitter.compilePC + 2));
 	emitter.dsp_reg_store_stack(DSP_STACK_C);
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
+	// The destination is static, so attempt to link block. For conditional
+	// branches, this is only reached when the branch is taken.
+	emitter.WriteBlockLink(dest);
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
 	WriteBranchExit(emitter);
 }
@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "Common/ChunkFile.h"
+#include "Common/FileUtil.h"
 #include "Common/IniFile.h"
 #include "Common/StringUtil.h"
 #include "Common/Logging/LogManager.h"
@@ -15,6 +16,7 @@
 #include "Core/HW/SystemTimers.h"
 #include "Core/HW/VideoInterface.h"
 #include "Core/HW/DSPHLE/DSPHLE.h"
+#include "Core/HW/DSPHLE/HLECapture.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 
 DSPHLE::DSPHLE()
@@ -29,6 +31,10 @@ bool DSPHLE::Initialize(bool bWii, bool bDSPThread)
 	m_bHalt = false;
 	m_bAssertInt = false;
 
+	// Captures start from the ROM ucode, so that they can be replayed from scratch
+	if (SConfig::GetInstance().m_DSPHLECapture)
+		HLECapture::StartCapture(File::GetUserPath(D_DUMPDSP_IDX) + "dsphle.cap");
+
 	SetUCode(UCODE_ROM);
 	m_DSPControl.DSPHalt = 1;
 	m_DSPControl.DSPInit = 1;
@@ -44,6 +50,8 @@ void DSPHLE::DSP_StopSoundStream()
 
 void DSPHLE::Shutdown()
 {
+	HLECapture::Stop();
+
 	delete m_pUCode;
 	m_pUCode = nullptr;
 }
@@ -52,6 +60,9 @@ void DSPHLE::DSP_Update(int cycles)
 {
 	if (m_pUCode != nullptr)
 		m_pUCode->Update();
+
+	if (HLECapture::IsActive())
+		HLECapture::RecordUpdate();
 }
 
 u32 DSPHLE::DSP_UpdateRate()
@@ -66,7 +77,17 @@ void DSPHLE::SendMailToDSP(u32 _uMail)
 	if (m_pUCode != nullptr)
 	{
 		DEBUG_LOG(DSP_MAIL, "CPU writes 0x%08x", _uMail);
-		m_pUCode->HandleMail(_uMail);
+
+		if (HLECapture::IsActive())
+		{
+			HLECapture::BeginEvent();
+			m_pUCode->HandleMail(_uMail);
+			HLECapture::EndEvent(HLECapture::RECORD_MAIL, _uMail);
+		}
+		else
+		{
+			m_pUCode->HandleMail(_uMail);
+		}
 	}
 }
 
@@ -115,6 +136,13 @@ void DSPHLE::DoState(PointerWrap &p)
 		return;
 	}
 
+	// A capture can only be replayed from the start
+	if (p.GetMode() == PointerWrap::MODE_READ && HLECapture::IsActive())
+	{
+		WARN_LOG(DSPHLE, "Loading a state ends the HLE capture");
+		HLECapture::Stop();
+	}
+
 	p.DoPOD(m_DSPControl);
 	p.DoPOD(m_dspState);
 
@@ -187,7 +215,12 @@ unsigned short DSPHLE::DSP_ReadMailBoxLow(bool _CPUMailbox)
 	}
 	else
 	{
-		return AccessMailHandler().ReadDSPMailboxLow();
+		const bool has_mail = !m_MailHandler.IsEmpty();
+		const u16 high = m_MailHandler.ReadDSPMailboxHigh();
+		const u16 low = m_MailHandler.ReadDSPMailboxLow();
+		if (has_mail && HLECapture::IsActive())
+			HLECapture::RecordReadMail(((u32)high << 16) | low);
+		return low;
 	}
 }
 
@@ -223,6 +256,10 @@ u16 DSPHLE::DSP_WriteControlRegister(unsigned short _Value)
 {
 	DSP::UDSPControl Temp(_Value);
 
+	const bool reset = Temp.DSPReset || Temp.DSPInit == 0;
+	if (reset && HLECapture::IsActive())
+		HLECapture::BeginEvent();
+
 	if (Temp.DSPReset)
 	{
 		SetUCode(UCODE_ROM);
@@ -235,6 +272,9 @@ u16 DSPHLE::DSP_WriteControlRegister(unsigned short _Value)
 		Temp.DSPInitCode = 0;
 	}
 
+	if (reset && HLECapture::IsActive())
+		HLECapture::EndEvent(HLECapture::RECORD_CONTROL, _Value);
+
 	m_DSPControl.Hex = Temp.Hex;
 	return m_DSPControl.Hex;
 }
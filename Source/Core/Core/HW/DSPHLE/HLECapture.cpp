@@ -0,0 +1,264 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/MemoryUtil.h"
+#include "Common/Logging/Log.h"
+
+#include "Core/ConfigManager.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/HLECapture.h"
+
+namespace HLECapture
+{
+
+bool g_active;
+
+namespace
+{
+struct TrackedRegion
+{
+	u8* memory;
+	// The contents of the blocks as the ucodes last saw them
+	u8* shadow;
+	u32 size;
+	// The last event which used each block, 0 if the block was never used
+	std::vector<u32> last_use;
+};
+}
+
+static TrackedRegion s_regions[NUM_REGIONS];
+// Blocks are stored as (region << 24) | block
+static std::vector<u32> s_used_blocks;
+static std::vector<u32> s_event_blocks;
+static u32 s_event;
+static u32 s_pending_updates;
+static u64 s_last_hash;
+static bool s_wii;
+static File::IOFile s_file;
+
+static void SetupRegion(Region region, u8* memory, u32 size)
+{
+	TrackedRegion& r = s_regions[region];
+	r.memory = memory;
+	r.size = size;
+	r.shadow = memory ? (u8*)AllocateMemoryPages(size) : nullptr;
+	r.last_use.assign(memory ? size >> BLOCK_SHIFT : 0, 0);
+}
+
+static void Start()
+{
+	const bool wii = s_wii = SConfig::GetInstance().bWii;
+
+	// The shadow copies start out empty, like the memory of a replay
+	SetupRegion(REGION_RAM, Memory::m_pRAM, Memory::RAM_SIZE);
+	SetupRegion(REGION_EXRAM, wii ? Memory::m_pEXRAM : nullptr, Memory::EXRAM_SIZE);
+	SetupRegion(REGION_ARAM, wii ? nullptr : DSP::GetARAMPtr(), DSP::ARAM_SIZE);
+
+	s_used_blocks.clear();
+	s_event_blocks.clear();
+	s_event = 1;
+	s_pending_updates = 0;
+	s_last_hash = 0;
+	g_active = true;
+}
+
+static void FlushUpdates()
+{
+	if (!s_pending_updates)
+		return;
+
+	const u8 type = RECORD_UPDATE;
+	s_file.WriteArray(&type, 1);
+	s_file.WriteArray(&s_pending_updates, 1);
+	s_pending_updates = 0;
+}
+
+// Copies a block to its shadow, returns whether it had changed
+static bool SyncBlock(u32 ref)
+{
+	TrackedRegion& r = s_regions[ref >> 24];
+	const u32 offset = (ref & 0xFFFFFF) << BLOCK_SHIFT;
+	if (!memcmp(r.memory + offset, r.shadow + offset, BLOCK_SIZE))
+		return false;
+
+	memcpy(r.shadow + offset, r.memory + offset, BLOCK_SIZE);
+	return true;
+}
+
+static void WriteBlock(u32 ref)
+{
+	if (!s_file.IsOpen())
+		return;
+
+	FlushUpdates();
+
+	const u8 type = RECORD_MEMORY;
+	const u8 region = ref >> 24;
+	const u32 block = ref & 0xFFFFFF;
+	s_file.WriteArray(&type, 1);
+	s_file.WriteArray(&region, 1);
+	s_file.WriteArray(&block, 1);
+	s_file.WriteBytes(s_regions[region].memory + (block << BLOCK_SHIFT), BLOCK_SIZE);
+}
+
+static void Track(Region region, u32 offset, u32 size)
+{
+	TrackedRegion& r = s_regions[region];
+	if (!r.memory || !size || offset >= r.size)
+		return;
+
+	const u32 first = offset >> BLOCK_SHIFT;
+	const u32 last = (std::min<u64>((u64)offset + size, r.size) - 1) >> BLOCK_SHIFT;
+	for (u32 block = first; block <= last; block++)
+	{
+		u32& last_use = r.last_use[block];
+		if (last_use == s_event)
+			continue;
+
+		const u32 ref = (region << 24) | block;
+		if (!last_use)
+		{
+			// Recorded now, before the ucode gets a chance to change it
+			s_used_blocks.push_back(ref);
+			if (SyncBlock(ref))
+				WriteBlock(ref);
+		}
+		last_use = s_event;
+		s_event_blocks.push_back(ref);
+	}
+}
+
+bool StartCapture(const std::string& filename)
+{
+	if (!s_file.Open(filename, "wb"))
+	{
+		ERROR_LOG(DSPHLE, "Could not open %s to capture the HLE ucodes", filename.c_str());
+		return false;
+	}
+
+	const CaptureHeader header = {
+		CAPTURE_MAGIC, CAPTURE_VERSION, SConfig::GetInstance().bWii ? (u32)FLAG_WII : 0, BLOCK_SIZE
+	};
+	s_file.WriteArray(&header, 1);
+
+	Start();
+	NOTICE_LOG(DSPHLE, "Capturing the HLE ucodes to %s", filename.c_str());
+	return true;
+}
+
+void StartTracking()
+{
+	Start();
+}
+
+void Stop()
+{
+	if (!g_active)
+		return;
+
+	g_active = false;
+	if (s_file.IsOpen())
+	{
+		FlushUpdates();
+		s_file.Close();
+	}
+
+	for (TrackedRegion& r : s_regions)
+	{
+		if (r.shadow)
+			FreeMemoryPages(r.shadow, r.size);
+		r = TrackedRegion();
+	}
+	std::vector<u32>().swap(s_used_blocks);
+	std::vector<u32>().swap(s_event_blocks);
+}
+
+void BeginEvent()
+{
+	s_event++;
+	s_event_blocks.clear();
+
+	// The CPU may have changed any of the blocks since the ucodes last saw them
+	for (u32 ref : s_used_blocks)
+	{
+		if (SyncBlock(ref))
+			WriteBlock(ref);
+	}
+}
+
+void EndEvent(RecordType type, u32 value)
+{
+	u64 hash = 0;
+	for (u32 ref : s_event_blocks)
+	{
+		if (!SyncBlock(ref))
+			continue;
+
+		const TrackedRegion& r = s_regions[ref >> 24];
+		const u8* data = r.memory + ((ref & 0xFFFFFF) << BLOCK_SHIFT);
+		hash = ((hash + ref) * 0x100000001B3ULL) ^ GetMurmurHash3(data, BLOCK_SIZE, 0);
+	}
+	s_event_blocks.clear();
+	s_last_hash = hash;
+
+	if (s_file.IsOpen())
+	{
+		FlushUpdates();
+
+		const u8 record = type;
+		s_file.WriteArray(&record, 1);
+		s_file.WriteArray(&value, 1);
+		s_file.WriteArray(&hash, 1);
+	}
+}
+
+u64 GetLastEventHash()
+{
+	return s_last_hash;
+}
+
+void RecordUpdate()
+{
+	if (s_file.IsOpen())
+		s_pending_updates++;
+}
+
+void RecordReadMail(u32 mail)
+{
+	if (!s_file.IsOpen())
+		return;
+
+	FlushUpdates();
+
+	const u8 type = RECORD_READ_MAIL;
+	s_file.WriteArray(&type, 1);
+	s_file.WriteArray(&mail, 1);
+}
+
+void TrackMemory(u32 address, u32 size)
+{
+	if (address & 0x10000000)
+		Track(REGION_EXRAM, address & Memory::EXRAM_MASK, size);
+	else
+		Track(REGION_RAM, address & Memory::RAM_MASK, size);
+}
+
+void TrackARAM(u32 address, u32 size)
+{
+	// On the Wii, the DSP reads MEM1 or MEM2 instead, see DSP::ReadARAM
+	if (s_wii)
+		TrackMemory(address, size);
+	else
+		Track(REGION_ARAM, address & DSP::ARAM_MASK, size);
+}
+
+}  // namespace HLECapture
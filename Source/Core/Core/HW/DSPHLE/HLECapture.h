@@ -0,0 +1,108 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Records what the CPU asks of the HLE ucodes, so that it can be replayed later without the
+// rest of the emulator (see dolphin-dsp-bench).
+//
+// A capture starts when the DSP is initialized, with the ROM ucode and empty memory, and
+// holds a stream of records:
+//  - the mails written by the CPU, the control register writes which reset the DSP, the
+//    updates and the mails the CPU read back,
+//  - the blocks of RAM, EXRAM and ARAM which the ucodes use, whenever they have changed
+//    since the ucodes last saw them.
+// The ucodes report the memory they are about to access (see HLEMemory_Get_Pointer). Once
+// a block has been used, it is compared before every mail, as the CPU may change it at
+// any time. Every mail and reset also records a hash of the blocks the ucode changed, so
+// a replay can check that it produces the same output.
+
+#pragma once
+
+#include <string>
+
+#include "Common/CommonTypes.h"
+
+namespace HLECapture
+{
+
+enum
+{
+	CAPTURE_MAGIC = 0x43484C44, // "DLHC"
+	CAPTURE_VERSION = 1,
+
+	BLOCK_SHIFT = 10,
+	BLOCK_SIZE = 1 << BLOCK_SHIFT,
+};
+
+enum Flags
+{
+	FLAG_WII = 1,
+};
+
+enum Region
+{
+	REGION_RAM,
+	REGION_EXRAM,
+	REGION_ARAM,
+	NUM_REGIONS
+};
+
+// Every record starts with one of these bytes. The payloads are stored in host byte order.
+enum RecordType
+{
+	RECORD_MEMORY = 1,  // u8 region, u32 block, BLOCK_SIZE bytes of data
+	RECORD_MAIL,        // u32 mail, u64 hash of the blocks changed by the ucode
+	RECORD_CONTROL,     // u32 value written to the control register, u64 hash
+	RECORD_UPDATE,      // u32 number of consecutive updates
+	RECORD_READ_MAIL,   // u32 mail read by the CPU
+};
+
+struct CaptureHeader
+{
+	u32 magic;
+	u32 version;
+	u32 flags;
+	u32 block_size;
+};
+
+extern bool g_active;
+
+inline bool IsActive()
+{
+	return g_active;
+}
+
+// Records everything the ucodes do to a file
+bool StartCapture(const std::string& filename);
+// Only tracks the memory used by the ucodes, to compute the hashes of a replay
+void StartTracking();
+void Stop();
+
+// Called by DSPHLE around the mails and resets, which may change the ucode state
+void BeginEvent();
+void EndEvent(RecordType type, u32 value);
+// The hash of the blocks changed during the last mail or reset
+u64 GetLastEventHash();
+
+// Called by DSPHLE for the events which only depend on the ucode state
+void RecordUpdate();
+void RecordReadMail(u32 mail);
+
+void TrackMemory(u32 address, u32 size);
+void TrackARAM(u32 address, u32 size);
+
+// To be called before a ucode accesses size bytes of RAM or EXRAM at address
+inline void UseMemory(u32 address, u32 size)
+{
+	if (g_active)
+		TrackMemory(address, size);
+}
+
+// To be called before a ucode accesses ARAM, with an address as given to DSP::ReadARAM
+inline void UseARAM(u32 address, u32 size)
+{
+	if (g_active)
+		TrackARAM(address, size);
+}
+
+}  // namespace HLECapture
@@ -2,9 +2,13 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common/CommonFuncs.h"
 #include "Common/FileUtil.h"
 #include "Common/MathUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/HW/DSP.h"
@@ -13,19 +17,29 @@
 #define AX_GC
 #include "Core/HW/DSPHLE/UCodes/AXVoice.h"
 
+static const u32 MAX_VOICE_THREADS = 4;
+static const u32 MAX_MIX_BUFFERS = 20;
+
+// Waking up the voice threads doesn't pay off for fewer voices
+static const u32 MIN_PARALLEL_VOICES = 4;
+
 AXUCode::AXUCode(DSPHLE* dsphle, u32 crc)
 	: UCodeInterface(dsphle, crc)
 	, m_cmdlist_size(0)
+	, m_next_is_cmdlist(false)
+	, m_next_cmdlist_size(0)
 {
 	WARN_LOG(DSPHLE, "Instantiating AXUCode: crc=%08x", crc);
 	m_mail_handler.PushMail(DSP_INIT);
 	DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
 
 	LoadResamplingCoefficients();
+	StartVoiceWorkers();
 }
 
 AXUCode::~AXUCode()
 {
+	StopVoiceWorkers();
 	m_mail_handler.Clear();
 }
 
@@ -66,6 +80,114 @@ void AXUCode::LoadResamplingCoefficients()
 	m_coeffs_available = true;
 }
 
+void AXUCode::StartVoiceWorkers()
+{
+	u32 num_threads = std::min(std::thread::hardware_concurrency(), MAX_VOICE_THREADS);
+
+	// Captures track memory on this thread only
+	if (!SConfig::GetInstance().m_DSPHLEParallelVoices || HLECapture::IsActive())
+		num_threads = 1;
+
+	StartVoiceWorkers(num_threads);
+}
+
+void AXUCode::StartVoiceWorkers(u32 num_threads)
+{
+	m_voice_job = nullptr;
+	m_voice_workers_quit.store(false);
+
+	if (num_threads < 2)
+		return;
+
+	m_voice_samples.resize(num_threads);
+	for (u32 i = 1; i < num_threads; ++i)
+	{
+		m_voice_workers.push_back(std::make_unique<VoiceWorker>());
+		VoiceWorker* worker = m_voice_workers.back().get();
+		worker->thread = std::thread(&AXUCode::VoiceWorkerThread, this, worker, i);
+	}
+}
+
+void AXUCode::StopVoiceWorkers()
+{
+	m_voice_workers_quit.store(true);
+	for (auto& worker : m_voice_workers)
+	{
+		worker->start_event.Set();
+		worker->thread.join();
+	}
+	m_voice_workers.clear();
+}
+
+void AXUCode::VoiceWorkerThread(VoiceWorker* worker, u32 index)
+{
+	Common::SetCurrentThreadName(StringFromFormat("AX voices %u", index).c_str());
+
+	while (true)
+	{
+		worker->start_event.Wait();
+		if (m_voice_workers_quit.load())
+			break;
+
+		(*m_voice_job)(index);
+		worker->done_event.Set();
+	}
+}
+
+void AXUCode::MixVoices(u32 num_voices, int* const* buffers, const u32* buffer_sizes, u32 num_buffers,
+                        const std::function<void(u32, int* const*)>& process)
+{
+	if (m_voice_workers.empty() || num_voices < MIN_PARALLEL_VOICES)
+	{
+		for (u32 voice = 0; voice < num_voices; ++voice)
+			process(voice, buffers);
+		return;
+	}
+
+	u32 total_size = 0;
+	for (u32 i = 0; i < num_buffers; ++i)
+		total_size += buffer_sizes[i];
+
+	std::atomic<u32> next_voice(0);
+	const std::function<void(u32)> job = [&](u32 thread)
+	{
+		std::vector<int>& samples = m_voice_samples[thread];
+		samples.assign(total_size, 0);
+
+		int* thread_buffers[MAX_MIX_BUFFERS];
+		int* ptr = samples.data();
+		for (u32 i = 0; i < num_buffers; ++i)
+		{
+			thread_buffers[i] = ptr;
+			ptr += buffer_sizes[i];
+		}
+
+		u32 voice;
+		while ((voice = next_voice++) < num_voices)
+			process(voice, thread_buffers);
+	};
+
+	m_voice_job = &job;
+	for (auto& worker : m_voice_workers)
+		worker->start_event.Set();
+
+	job(0);
+
+	for (auto& worker : m_voice_workers)
+		worker->done_event.Wait();
+	m_voice_job = nullptr;
+
+	for (const auto& samples : m_voice_samples)
+	{
+		const int* src = samples.data();
+		for (u32 i = 0; i < num_buffers; ++i)
+		{
+			for (u32 j = 0; j < buffer_sizes[i]; ++j)
+				buffers[i][j] += *src++;
+		}
+	}
+}
+
 void AXUCode::SignalWorkEnd()
 {
 	// Signal end of processing
@@ -250,6 +372,15 @@ void AXUCode::HandleCommandList()
 	}
 }
 
+// Size of the update list of a PB, two words per update
+static u32 GetUpdatesSize(const AXPB& pb)
+{
+	u32 count = 0;
+	for (u16 num_updates : pb.updates.num_updates)
+		count += num_updates;
+	return count * 2 * sizeof (u16);
+}
+
 void AXUCode::ApplyUpdatesForMs(int curr_ms, u16* pb, u16* num_updates, u16* updates)
 {
 	u32 start_idx = 0;
@@ -366,7 +497,7 @@ void AXUCode::DownloadAndMixWithVolume(u32 addr, u16 vol_main, u16 vol_auxa, u16
 
 	for (u32 i = 0; i < 3; ++i)
 	{
-		int* ptr = (int*)HLEMemory_Get_Pointer(addr);
+		int* ptr = (int*)HLEMemory_Get_Pointer(addr, 3 * 5 * 32 * sizeof (int));
 		u16 volume = volumes[i];
 		for (u32 j = 0; j < 3; ++j)
 		{
@@ -387,39 +518,73 @@ void AXUCode::ProcessPBList(u32 pb_addr)
 	// 32KHz to 48KHz, but AX always process at 32KHz.
 	const u32 spms = 32;
 
-	AXPB pb;
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround
+	}};
 
-	while (pb_addr)
+	auto process_pb = [&](AXPB& pb, AXBuffers voice_buffers)
 	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround
-		}};
-
-		if (!ReadPB(pb_addr, pb))
-			break;
-
 		u32 updates_addr = HILO_TO_32(pb.updates.data);
-		u16* updates = (u16*)HLEMemory_Get_Pointer(updates_addr);
+		u16* updates = (u16*)HLEMemory_Get_Pointer(updates_addr, GetUpdatesSize(pb));
 
 		for (int curr_ms = 0; curr_ms < 5; ++curr_ms)
 		{
 			ApplyUpdatesForMs(curr_ms, (u16*)&pb, pb.updates.num_updates, updates);
 
-			ProcessVoice(pb, buffers, spms, ConvertMixerControl(pb.mixer_control),
+			ProcessVoice(pb, voice_buffers, spms, ConvertMixerControl(pb.mixer_control),
 			             m_coeffs_available ? m_coeffs : nullptr);
 
 			// Forward the buffers
-			for (size_t i = 0; i < ArraySize(buffers.ptrs); ++i)
-				buffers.ptrs[i] += spms;
+			for (size_t i = 0; i < ArraySize(voice_buffers.ptrs); ++i)
+				voice_buffers.ptrs[i] += spms;
 		}
+	};
+
+	// Updates may change the link to the next PB, which voice processing never does
+	auto get_next = [&](const AXPB& pb)
+	{
+		AXPB updated = pb;
+		u16* updates = (u16*)HLEMemory_Get_Pointer(HILO_TO_32(updated.updates.data), GetUpdatesSize(updated));
+		for (int curr_ms = 0; curr_ms < 5; ++curr_ms)
+			ApplyUpdatesForMs(curr_ms, (u16*)&updated, updated.updates.num_updates, updates);
+		return HILO_TO_32(updated.next_pb);
+	};
+
+	if (!m_voice_workers.empty() && ReadPBList(pb_addr, &m_pb_addresses, &m_pbs, get_next))
+	{
+		u32 buffer_sizes[ArraySize(buffers.ptrs)];
+		for (u32& size : buffer_sizes)
+			size = spms * 5;
+
+		MixVoices((u32)m_pbs.size(), buffers.ptrs, buffer_sizes, ArraySize(buffers.ptrs),
+			[&](u32 voice, int* const* voice_buffers)
+			{
+				AXBuffers thread_buffers;
+				std::copy(voice_buffers, voice_buffers + ArraySize(thread_buffers.ptrs), thread_buffers.ptrs);
+				process_pb(m_pbs[voice], thread_buffers);
+			});
+
+		for (size_t i = 0; i < m_pbs.size(); ++i)
+			WritePB(m_pb_addresses[i], m_pbs[i]);
+		return;
+	}
+
+	AXPB pb;
+
+	while (pb_addr)
+	{
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		process_pb(pb, buffers);
 
 		WritePB(pb_addr, pb);
 		pb_addr = HILO_TO_32(pb.next_pb);
@@ -448,7 +613,7 @@ void AXUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr)
 	// First, we need to send the contents of our AUX buffers to the CPU.
 	if (write_addr)
 	{
-		int* ptr = (int*)HLEMemory_Get_Pointer(write_addr);
+		int* ptr = (int*)HLEMemory_Get_Pointer(write_addr, 3 * 5 * 32 * sizeof (int));
 		for (auto& buffer : buffers)
 			for (u32 j = 0; j < 5 * 32; ++j)
 				*ptr++ = Common::swap32(buffer[j]);
@@ -456,7 +621,7 @@ void AXUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr)
 
 	// Then, we read the new temp from the CPU and add to our current
 	// temp.
-	int* ptr = (int*)HLEMemory_Get_Pointer(read_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(read_addr, 3 * 5 * 32 * sizeof (int));
 	for (auto& sample : m_samples_left)
 		sample += (int)Common::swap32(*ptr++);
 	for (auto& sample : m_samples_right)
@@ -475,12 +640,12 @@ void AXUCode::UploadLRS(u32 dst_addr)
 		buffers[1][i] = Common::swap32(m_samples_right[i]);
 		buffers[2][i] = Common::swap32(m_samples_surround[i]);
 	}
-	memcpy(HLEMemory_Get_Pointer(dst_addr), buffers, sizeof (buffers));
+	memcpy(HLEMemory_Get_Pointer(dst_addr, sizeof (buffers)), buffers, sizeof (buffers));
 }
 
 void AXUCode::SetMainLR(u32 src_addr)
 {
-	int* ptr = (int*)HLEMemory_Get_Pointer(src_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(src_addr, 5 * 32 * sizeof (int));
 	for (u32 i = 0; i < 5 * 32; ++i)
 	{
 		int samp = (int)Common::swap32(*ptr++);
@@ -496,7 +661,7 @@ void AXUCode::OutputSamples(u32 lr_addr, u32 surround_addr)
 
 	for (u32 i = 0; i < 5 * 32; ++i)
 		surround_buffer[i] = Common::swap32(m_samples_surround[i]);
-	memcpy(HLEMemory_Get_Pointer(surround_addr), surround_buffer, sizeof (surround_buffer));
+	memcpy(HLEMemory_Get_Pointer(surround_addr, sizeof (surround_buffer)), surround_buffer, sizeof (surround_buffer));
 
 	// 32 samples per ms, 5 ms, 2 channels
 	short buffer[5 * 32 * 2];
@@ -511,20 +676,20 @@ void AXUCode::OutputSamples(u32 lr_addr, u32 surround_addr)
 		buffer[2 * i + 1] = Common::swap16(left);
 	}
 
-	memcpy(HLEMemory_Get_Pointer(lr_addr), buffer, sizeof (buffer));
+	memcpy(HLEMemory_Get_Pointer(lr_addr, sizeof (buffer)), buffer, sizeof (buffer));
 }
 
 void AXUCode::MixAUXBLR(u32 ul_addr, u32 dl_addr)
 {
 	// Upload AUXB L/R
-	int* ptr = (int*)HLEMemory_Get_Pointer(ul_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(ul_addr, 2 * 5 * 32 * sizeof (int));
 	for (auto& sample : m_samples_auxB_left)
 		*ptr++ = Common::swap32(sample);
 	for (auto& sample : m_samples_auxB_right)
 		*ptr++ = Common::swap32(sample);
 
 	// Mix AUXB L/R to MAIN L/R, and replace AUXB L/R
-	ptr = (int*)HLEMemory_Get_Pointer(dl_addr);
+	ptr = (int*)HLEMemory_Get_Pointer(dl_addr, 2 * 5 * 32 * sizeof (int));
 	for (u32 i = 0; i < 5 * 32; ++i)
 	{
 		int samp = Common::swap32(*ptr++);
@@ -541,7 +706,7 @@ void AXUCode::MixAUXBLR(u32 ul_addr, u32 dl_addr)
 
 void AXUCode::SetOppositeLR(u32 src_addr)
 {
-	int* ptr = (int*)HLEMemory_Get_Pointer(src_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(src_addr, 5 * 32 * sizeof (int));
 	for (u32 i = 0; i < 5 * 32; ++i)
 	{
 		int inp = Common::swap32(*ptr++);
@@ -562,13 +727,13 @@ void AXUCode::SendAUXAndMix(u32 main_auxa_up, u32 auxb_s_up, u32 main_l_dl,
 	};
 
 	// Upload AUXA LRS
-	int* ptr = (int*)HLEMemory_Get_Pointer(main_auxa_up);
+	int* ptr = (int*)HLEMemory_Get_Pointer(main_auxa_up, 3 * 5 * 32 * sizeof (int));
 	for (auto& up_buffer : up_buffers)
 		for (u32 j = 0; j < 32 * 5; ++j)
 			*ptr++ = Common::swap32(up_buffer[j]);
 
 	// Upload AUXB S
-	ptr = (int*)HLEMemory_Get_Pointer(auxb_s_up);
+	ptr = (int*)HLEMemory_Get_Pointer(auxb_s_up, 5 * 32 * sizeof (int));
 	for (auto& sample : m_samples_auxB_surround)
 		*ptr++ = Common::swap32(sample);
 
@@ -589,7 +754,7 @@ void AXUCode::SendAUXAndMix(u32 main_auxa_up, u32 auxb_s_up, u32 main_l_dl,
 	// Download and mix
 	for (size_t i = 0; i < ArraySize(dl_buffers); ++i)
 	{
-		int* dl_src = (int*)HLEMemory_Get_Pointer(dl_addrs[i]);
+		int* dl_src = (int*)HLEMemory_Get_Pointer(dl_addrs[i], 5 * 32 * sizeof (int));
 		for (size_t j = 0; j < 32 * 5; ++j)
 			dl_buffers[i][j] += (int)Common::swap32(*dl_src++);
 	}
@@ -597,15 +762,11 @@ void AXUCode::SendAUXAndMix(u32 main_auxa_up, u32 auxb_s_up, u32 main_l_dl,
 
 void AXUCode::HandleMail(u32 mail)
 {
-	// Indicates if the next message is a command list address.
-	static bool next_is_cmdlist = false;
-	static u16 cmdlist_size = 0;
-
 	bool set_next_is_cmdlist = false;
 
-	if (next_is_cmdlist)
+	if (m_next_is_cmdlist)
 	{
-		CopyCmdList(mail, cmdlist_size);
+		CopyCmdList(mail, m_next_cmdlist_size);
 		HandleCommandList();
 		m_cmdlist_size = 0;
 		SignalWorkEnd();
@@ -637,14 +798,14 @@ void AXUCode::HandleMail(u32 mail)
 	{
 		// A command list address is going to be sent next.
 		set_next_is_cmdlist = true;
-		cmdlist_size = (u16)(mail & ~MAIL_CMDLIST_MASK);
+		m_next_cmdlist_size = (u16)(mail & ~MAIL_CMDLIST_MASK);
 	}
 	else
 	{
 		ERROR_LOG(DSPHLE, "Unknown mail sent to AX::HandleMail: %08x", mail);
 	}
 
-	next_is_cmdlist = set_next_is_cmdlist;
+	m_next_is_cmdlist = set_next_is_cmdlist;
 }
 
 void AXUCode::CopyCmdList(u32 addr, u16 size)
@@ -12,6 +12,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Common/Event.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 
@@ -86,6 +93,10 @@ protected:
 	u16 m_cmdlist[512];
 	u32 m_cmdlist_size;
 
+	// Indicates if the next mail is the address of a command list, and its size
+	bool m_next_is_cmdlist;
+	u16 m_next_cmdlist_size;
+
 	// Table of coefficients for polyphase sample rate conversion.
 	// The coefficients aren't always available (they are part of the DSP DROM)
 	// so we also need to know if they are valid or not.
@@ -94,6 +105,39 @@ protected:
 
 	void LoadResamplingCoefficients();
 
+	// Voices can be processed on several threads when enabled in the config.
+	// Every thread then mixes into its own zeroed set of buffers, which are
+	// added to the real ones at the end. Mixing only adds integers, so the
+	// result is the same as processing the voices one after another.
+	struct VoiceWorker
+	{
+		std::thread thread;
+		Common::Event start_event;
+		Common::Event done_event;
+	};
+
+	std::vector<std::unique_ptr<VoiceWorker>> m_voice_workers;
+	std::vector<std::vector<int>> m_voice_samples;
+	const std::function<void(u32)>* m_voice_job;
+	std::atomic<bool> m_voice_workers_quit;
+
+	// PBs read up front for the voice threads
+	std::vector<u32> m_pb_addresses;
+	std::vector<AXPB> m_pbs;
+
+	// Starts the voice threads if they are enabled in the config
+	void StartVoiceWorkers();
+	// Starts num_threads - 1 voice threads, the calling thread being the last one
+	void StartVoiceWorkers(u32 num_threads);
+	void StopVoiceWorkers();
+	void VoiceWorkerThread(VoiceWorker* worker, u32 index);
+
+	// Calls <process> for every voice below <num_voices>, spread over the
+	// voice threads. <process> gets the buffers of its thread, which have the
+	// same sizes as <buffers>.
+	void MixVoices(u32 num_voices, int* const* buffers, const u32* buffer_sizes, u32 num_buffers,
+	               const std::function<void(u32, int* const*)>& process);
+
 	// Copy a command list from memory to our temp buffer
 	void CopyCmdList(u32 addr, u16 size);
 
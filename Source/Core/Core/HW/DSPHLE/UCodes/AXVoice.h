@@ -12,12 +12,16 @@
 #error AXVoice.h included without specifying version
 #endif
 
-#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/HLECapture.h"
 #include "Core/HW/DSPHLE/UCodes/AX.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 
@@ -81,6 +85,7 @@ union AXBuffers
 bool ReadPB(u32 addr, PB_TYPE& pb)
 {
 	u16* dst = (u16*)&pb;
+	HLECapture::UseMemory(addr, sizeof (pb));
 	const u16* src = (const u16*)Memory::GetPointer(addr);
 	if (!src)
 		return false;
@@ -95,6 +100,7 @@ bool ReadPB(u32 addr, PB_TYPE& pb)
 bool WritePB(u32 addr, const PB_TYPE& pb)
 {
 	const u16* src = (const u16*)&pb;
+	HLECapture::UseMemory(addr, sizeof (pb));
 	u16* dst = (u16*)Memory::GetPointer(addr);
 	if (!dst)
 		return false;
@@ -105,6 +111,32 @@ bool WritePB(u32 addr, const PB_TYPE& pb)
 	return true;
 }
 
+// Read all PBs of a list up front, so that their voices can be processed in
+// parallel. <get_next> returns the address of the next PB, as it will be once
+// the voice has been processed. Returns false if a PB comes up twice, as its
+// voice then depends on the previous processing of the same PB.
+template <typename GetNextFunc>
+bool ReadPBList(u32 pb_addr, std::vector<u32>* addresses, std::vector<PB_TYPE>* pbs, GetNextFunc get_next)
+{
+	addresses->clear();
+	pbs->clear();
+
+	PB_TYPE pb;
+	while (pb_addr)
+	{
+		if (std::find(addresses->begin(), addresses->end(), pb_addr) != addresses->end())
+			return false;
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		addresses->push_back(pb_addr);
+		pbs->push_back(pb);
+		pb_addr = get_next(pb);
+	}
+
+	return true;
+}
+
 #if 0
 // Dump the value of a PB for debugging
 #define DUMP_U16(field) WARN_LOG(DSPHLE, "    %04x (%s)", pb.field, #field)
@@ -127,91 +159,102 @@ void DumpPB(const PB_TYPE& pb)
 }
 #endif
 
-// Simulated accelerator state.
-static u32 acc_loop_addr, acc_end_addr;
-static u32* acc_cur_addr;
-static PB_TYPE* acc_pb;
-static bool acc_end_reached;
+// Simulated accelerator state. Every voice has its own, so that voices can be
+// processed on several threads.
+struct AcceleratorState
+{
+	u32 loop_addr, end_addr;
+	u32* cur_addr;
+	PB_TYPE* pb;
+	bool end_reached;
+};
 
 // Sets up the simulated accelerator.
-void AcceleratorSetup(PB_TYPE* pb, u32* cur_addr)
+void AcceleratorSetup(AcceleratorState* acc, PB_TYPE* pb, u32* cur_addr)
 {
-	acc_pb = pb;
-	acc_loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
-	acc_end_addr = HILO_TO_32(pb->audio_addr.end_addr);
-	acc_cur_addr = cur_addr;
-	acc_end_reached = false;
+	acc->pb = pb;
+	acc->loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
+	acc->end_addr = HILO_TO_32(pb->audio_addr.end_addr);
+	acc->cur_addr = cur_addr;
+	acc->end_reached = false;
+}
+
+// Reads a byte of sample data for the simulated accelerator.
+u8 AcceleratorReadARAM(u32 address)
+{
+	HLECapture::UseARAM(address, 1);
+	return DSP::ReadARAM(address);
 }
 
 // Reads a sample from the simulated accelerator. Also handles looping and
 // disabling streams that reached the end (this is done by an exception raised
 // by the accelerator on real hardware).
-u16 AcceleratorGetSample()
+u16 AcceleratorGetSample(AcceleratorState* acc)
 {
 	u16 ret;
 	u8 step_size_bytes = 0;
 
-	// See below for explanations about acc_end_reached.
-	if (acc_end_reached)
+	// See below for explanations about acc->end_reached.
+	if (acc->end_reached)
 		return 0;
 
-	switch (acc_pb->audio_addr.sample_format)
+	switch (acc->pb->audio_addr.sample_format)
 	{
 		case 0x00: // ADPCM
 		{
 			// ADPCM decoding, not much to explain here.
-			if ((*acc_cur_addr & 15) == 0)
+			if ((*acc->cur_addr & 15) == 0)
 			{
-				acc_pb->adpcm.pred_scale = DSP::ReadARAM((*acc_cur_addr & ~15) >> 1);
-				*acc_cur_addr += 2;
+				acc->pb->adpcm.pred_scale = AcceleratorReadARAM((*acc->cur_addr & ~15) >> 1);
+				*acc->cur_addr += 2;
 			}
 
-			if ((acc_end_addr & 15) == 0)
+			if ((acc->end_addr & 15) == 0)
 				step_size_bytes = 1;
 			else
 				step_size_bytes = 2;
 
-			int scale = 1 << (acc_pb->adpcm.pred_scale & 0xF);
-			int coef_idx = (acc_pb->adpcm.pred_scale >> 4) & 0x7;
+			int scale = 1 << (acc->pb->adpcm.pred_scale & 0xF);
+			int coef_idx = (acc->pb->adpcm.pred_scale >> 4) & 0x7;
 
-			s32 coef1 = acc_pb->adpcm.coefs[coef_idx * 2 + 0];
-			s32 coef2 = acc_pb->adpcm.coefs[coef_idx * 2 + 1];
+			s32 coef1 = acc->pb->adpcm.coefs[coef_idx * 2 + 0];
+			s32 coef2 = acc->pb->adpcm.coefs[coef_idx * 2 + 1];
 
-			int temp = (*acc_cur_addr & 1) ?
-					(DSP::ReadARAM(*acc_cur_addr >> 1) & 0xF) :
-					(DSP::ReadARAM(*acc_cur_addr >> 1) >> 4);
+			int temp = (*acc->cur_addr & 1) ?
+					(AcceleratorReadARAM(*acc->cur_addr >> 1) & 0xF) :
+					(AcceleratorReadARAM(*acc->cur_addr >> 1) >> 4);
 
 			if (temp >= 8)
 				temp -= 16;
 
-			int val = (scale * temp) + ((0x400 + coef1 * acc_pb->adpcm.yn1 + coef2 * acc_pb->adpcm.yn2) >> 11);
+			int val = (scale * temp) + ((0x400 + coef1 * acc->pb->adpcm.yn1 + coef2 * acc->pb->adpcm.yn2) >> 11);
 			val = MathUtil::Clamp(val, -0x7FFF, 0x7FFF);
 
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = val;
-			*acc_cur_addr += 1;
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = val;
+			*acc->cur_addr += 1;
 			ret = val;
 			break;
 		}
 
 		case 0x0A: // 16-bit PCM audio
-			ret = (DSP::ReadARAM(*acc_cur_addr * 2) << 8) | DSP::ReadARAM(*acc_cur_addr * 2 + 1);
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
+			ret = (AcceleratorReadARAM(*acc->cur_addr * 2) << 8) | AcceleratorReadARAM(*acc->cur_addr * 2 + 1);
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = ret;
 			step_size_bytes = 2;
-			*acc_cur_addr += 1;
+			*acc->cur_addr += 1;
 			break;
 
 		case 0x19: // 8-bit PCM audio
-			ret = DSP::ReadARAM(*acc_cur_addr) << 8;
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
+			ret = AcceleratorReadARAM(*acc->cur_addr) << 8;
+			acc->pb->adpcm.yn2 = acc->pb->adpcm.yn1;
+			acc->pb->adpcm.yn1 = ret;
 			step_size_bytes = 2;
-			*acc_cur_addr += 1;
+			*acc->cur_addr += 1;
 			break;
 
 		default:
-			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc_pb->audio_addr.sample_format);
+			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc->pb->audio_addr.sample_format);
 			return 0;
 	}
 
@@ -219,29 +262,29 @@ u16 AcceleratorGetSample()
 	//
 	// On real hardware, this would raise an interrupt that is handled by the
 	// UCode. We simulate what this interrupt does here.
-	if (*acc_cur_addr == (acc_end_addr + step_size_bytes - 1))
+	if (*acc->cur_addr == (acc->end_addr + step_size_bytes - 1))
 	{
 		// loop back to loop_addr.
-		*acc_cur_addr = acc_loop_addr;
+		*acc->cur_addr = acc->loop_addr;
 
-		if (acc_pb->audio_addr.looping)
+		if (acc->pb->audio_addr.looping)
 		{
 			// Set the ADPCM infos to continue processing at loop_addr.
 			//
 			// For some reason, yn1 and yn2 aren't set if the voice is not of
 			// stream type. This is what the AX UCode does and I don't really
 			// know why.
-			acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
-			if (!acc_pb->is_stream)
+			acc->pb->adpcm.pred_scale = acc->pb->adpcm_loop_info.pred_scale;
+			if (!acc->pb->is_stream)
 			{
-				acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
-				acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
+				acc->pb->adpcm.yn1 = acc->pb->adpcm_loop_info.yn1;
+				acc->pb->adpcm.yn2 = acc->pb->adpcm_loop_info.yn2;
 			}
 		}
 		else
 		{
 			// Non looping voice reached the end -> running = 0.
-			acc_pb->running = 0;
+			acc->pb->running = 0;
 
 #ifdef AX_WII
 			// One of the few meaningful differences between AXGC and AXWii:
@@ -249,7 +292,7 @@ u16 AcceleratorGetSample()
 			// samples at the loop address, AXWii has the 0000 samples
 			// internally in DRAM and use an internal pointer to it (loop addr
 			// does not contain 0000 samples on AXWii!).
-			acc_end_reached = true;
+			acc->end_reached = true;
 #endif
 		}
 	}
@@ -257,9 +300,112 @@ u16 AcceleratorGetSample()
 	return ret;
 }
 
-// Reads samples from the input callback, resamples them to <count> samples at
+// Reads <count> samples from the simulated accelerator into <samples>. Every
+// sample depends on the previous ones (ADPCM history, looping), so they are
+// decoded one after the other, but in a single loop without indirect calls.
+void AcceleratorGetSamples(AcceleratorState* acc, s16* samples, u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+		samples[i] = AcceleratorGetSample(acc);
+}
+
+// Maximum number of input samples resampled at once. This holds a whole frame
+// for all ratios up to 4.0 on AX Wii, larger ratios are handled in pieces.
+const u32 MAX_INPUT_SAMPLES = 512;
+
+// The resampling kernels below take <input> as the four last samples followed
+// by the samples read for this block. <positions> has the number of samples
+// read before every output sample, which is also the index of the oldest of
+// the four samples it is made from, and <fracs> its fractional position.
+
+// Linear interpolation between the two oldest of the four last samples.
+void ResampleLinear(const s16* input, const u32* positions, const u16* fracs,
+                    s16* output, u32 count)
+{
+	u32 i = 0;
+
+#ifdef _M_X86
+	// s0 * (0x10000 - frac) + s1 * frac == (s0 << 16) + (s1 - s0) * frac.
+	// frac does not fit in a signed 16 bit multiplier, so (s1 - s0) * frac is
+	// computed as 2 * (s1 - s0) * (frac >> 1) + (s1 - s0) * (frac & 1).
+	for (; i + 4 <= count; i += 4)
+	{
+		u32 pairs[4], half[4], odd[4];
+		for (u32 j = 0; j < 4; ++j)
+		{
+			memcpy(&pairs[j], &input[positions[i + j]], sizeof (u32));
+			u16 h = fracs[i + j] >> 1;
+			half[j] = ((u32)h << 16) | (u16)-h;
+			odd[j] = (fracs[i + j] & 1) ? 0x0001FFFF : 0;
+		}
+
+		const __m128i s = _mm_loadu_si128((const __m128i*)pairs);
+		__m128i diff = _mm_slli_epi32(_mm_madd_epi16(s, _mm_loadu_si128((const __m128i*)half)), 1);
+		diff = _mm_add_epi32(diff, _mm_madd_epi16(s, _mm_loadu_si128((const __m128i*)odd)));
+		const __m128i result = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(s, 16), diff), 16);
+		_mm_storel_epi64((__m128i*)&output[i], _mm_packs_epi32(result, result));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		s32 s0 = input[positions[i]];
+		s32 s1 = input[positions[i] + 1];
+		s32 frac = fracs[i];
+
+		output[i] = (s0 * (0x10000 - frac) + s1 * frac) >> 16;
+	}
+}
+
+// Polyphase filtering of the four last samples with the DROM coefficients.
+void ResamplePolyphase(const s16* input, const u32* positions, const u16* fracs,
+                       s16* output, u32 count, const s16* coeffs)
+{
+	u32 i = 0;
+
+#ifdef _M_X86
+	// Only bits 15 to 30 of the sums end up in the output, so they can be
+	// computed with wrapping 32 bit arithmetic.
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i sums[2];
+		for (u32 j = 0; j < 2; ++j)
+		{
+			const u32 a = i + 2 * j;
+			const u32 b = a + 1;
+			const __m128i t = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&input[positions[a]]),
+			                                     _mm_loadl_epi64((const __m128i*)&input[positions[b]]));
+			const __m128i c = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&coeffs[(fracs[a] >> 9) << 2]),
+			                                     _mm_loadl_epi64((const __m128i*)&coeffs[(fracs[b] >> 9) << 2]));
+			sums[j] = _mm_madd_epi16(t, c);
+		}
+
+		const __m128 lo = _mm_castsi128_ps(sums[0]);
+		const __m128 hi = _mm_castsi128_ps(sums[1]);
+		__m128i result = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+		                               _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))));
+		// Truncate to 16 bits like the cast to s16 does.
+		result = _mm_srai_epi32(_mm_slli_epi32(_mm_srai_epi32(result, 15), 16), 16);
+		_mm_storel_epi64((__m128i*)&output[i], _mm_packs_epi32(result, result));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const s16* t = &input[positions[i]];
+		const s16* c = &coeffs[(fracs[i] >> 9) << 2];
+
+		s64 samp = ((s64)t[0] * c[0] + (s64)t[1] * c[1] + (s64)t[2] * c[2] + (s64)t[3] * c[3]) >> 15;
+
+		output[i] = (s16)samp;
+	}
+}
+
+// Reads samples with the input function, resamples them to <count> samples at
 // the wanted sample rate (computed from the ratio, see below).
 //
+// <read_input>(s16* samples, u32 count) reads the next <count> input samples.
+//
 // If srctype is SRCTYPE_POLYPHASE, coefficients need to be provided as well
 // (or the srctype will automatically be changed to LINEAR).
 //
@@ -277,118 +423,83 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count,
+template <typename ReadFunc>
+u32 ResampleAudio(ReadFunc read_input, s16* output, u32 count,
                   s16* last_samples, u32 curr_pos, u32 ratio, int srctype,
                   const s16* coeffs)
 {
-	int read_samples_count = 0;
+	if (srctype != SRCTYPE_LINEAR && srctype != SRCTYPE_POLYPHASE) // SRCTYPE_NEAREST
+	{
+		// No sample rate conversion here: simply read samples from the
+		// accelerator to the output buffer.
+		read_input(output, count);
+
+		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
+		return curr_pos;
+	}
 
 	// TODO(delroth): find out why the polyphase resampling algorithm causes
 	// audio glitches in Wii games with non integral ratios.
 
 	// If DSP DROM coefficients are available, support polyphase resampling.
-	if (0) // if (coeffs && srctype == SRCTYPE_POLYPHASE)
+	const bool polyphase = false; // coeffs && srctype == SRCTYPE_POLYPHASE
+
+	// The four last samples, used for the interpolation, followed by the
+	// samples read for the current block. The four last samples are
+	// initialized with the values from the PB, and stored back at the end.
+	s16 input[4 + MAX_INPUT_SAMPLES];
+	u32 positions[MAX_SAMPLES_PER_FRAME];
+	u16 fracs[MAX_SAMPLES_PER_FRAME];
+	memcpy(input, last_samples, 4 * sizeof (s16));
+
+	u32 done = 0;
+	while (done < count)
 	{
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
-		for (u32 i = 0; i < count; ++i)
+		// Step through the input for as many output samples as fit in the
+		// buffer. Every time our current position is >= 1.0, a new sample is
+		// read.
+		u32 read = 0;
+		u32 block = 0;
+		for (; done + block < count; ++block)
 		{
-			curr_pos += ratio;
-			while (curr_pos >= 0x10000)
+			u32 next_pos = curr_pos + ratio;
+			u32 step = next_pos >> 16;
+			if (read + step > MAX_INPUT_SAMPLES)
 			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
+				if (block)
+					break;
+
+				// A single output sample needs more samples than the buffer
+				// holds. Only the last four of them are used, skip the others.
+				for (u32 skip = step - 4; skip; )
+				{
+					u32 skipped = std::min(skip, MAX_INPUT_SAMPLES);
+					read_input(input + 4, skipped);
+					skip -= skipped;
+				}
+				step = 4;
 			}
 
-			u16 curr_pos_frac = ((curr_pos & 0xFFFF) >> 9) << 2;
-			const s16* c = &coeffs[curr_pos_frac];
-
-			s64 t0 = temp[idx++ & 3];
-			s64 t1 = temp[idx++ & 3];
-			s64 t2 = temp[idx++ & 3];
-			s64 t3 = temp[idx++ & 3];
-
-			s64 samp = (t0 * c[0] + t1 * c[1] + t2 * c[2] + t3 * c[3]) >> 15;
-
-			output[i] = (s16)samp;
+			read += step;
+			curr_pos = next_pos & 0xFFFF;
+			positions[block] = read;
+			fracs[block] = (u16)curr_pos;
 		}
 
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
-	}
-	else if (srctype == SRCTYPE_LINEAR || srctype == SRCTYPE_POLYPHASE)
-	{
-		// This is the circular buffer containing samples to use for the
-		// interpolation. It is initialized with the values from the PB, and it
-		// will be stored back to the PB at the end.
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
-		for (u32 i = 0; i < count; ++i)
-		{
-			curr_pos += ratio;
-
-			// While our current position is >= 1.0, push new samples to the
-			// circular buffer.
-			while (curr_pos >= 0x10000)
-			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
-			}
-
-			// Get our current fractional position, used to know how much of
-			// curr0 and how much of curr1 the output sample should be.
-			u16 curr_frac = curr_pos & 0xFFFF;
-			u16 inv_curr_frac = -curr_frac;
-
-			// Interpolate! If curr_frac is 0, we can simply take the last
-			// sample without any multiplying.
-			s16 sample;
-			if (curr_frac)
-			{
-				s32 s0 = temp[idx++ & 3];
-				s32 s1 = temp[idx++ & 3];
-
-				sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
-				idx += 2;
-			}
-			else
-			{
-				sample = temp[idx++ & 3];
-				idx += 3;
-			}
+		read_input(input + 4, read);
 
-			output[i] = sample;
-		}
+		if (polyphase)
+			ResamplePolyphase(input, positions, fracs, output + done, block, coeffs);
+		else
+			ResampleLinear(input, positions, fracs, output + done, block);
 
-		// Update the four last_samples values.
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
+		// The last four samples read are the history of the next block.
+		memmove(input, input + read, 4 * sizeof (s16));
+		done += block;
 	}
-	else // SRCTYPE_NEAREST
-	{
-		// No sample rate conversion here: simply read samples from the
-		// accelerator to the output buffer.
-		for (u32 i = 0; i < count; ++i)
-			output[i] = input_callback(i);
 
-		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
-	}
+	// Update the four last_samples values.
+	memcpy(last_samples, input, 4 * sizeof (s16));
 
 	return curr_pos;
 }
@@ -398,11 +509,12 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 {
 	u32 cur_addr = HILO_TO_32(pb.audio_addr.cur_addr);
-	AcceleratorSetup(&pb, &cur_addr);
+	AcceleratorState acc;
+	AcceleratorSetup(&acc, &pb, &cur_addr);
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
+	u32 curr_pos = ResampleAudio([&acc](s16* input, u32 input_count) { AcceleratorGetSamples(&acc, input, input_count); },
 	                             samples, count, pb.src.last_samples,
 	                             pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio),
 	                             pb.src_type, coeffs);
@@ -425,7 +537,45 @@ void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ra
 	if (!ramp)
 		volume_delta = 0;
 
-	for (u32 i = 0; i < count; ++i)
+	u32 i = 0;
+
+#ifdef _M_X86
+	if (count >= 8)
+	{
+		// The volumes of eight samples in a row, wrapping around like the u16.
+		__m128i volumes = _mm_mullo_epi16(_mm_set1_epi16(volume_delta), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+		volumes = _mm_add_epi16(volumes, _mm_set1_epi16(volume));
+		const __m128i volume_step = _mm_set1_epi16((u16)(volume_delta * 8));
+		__m128i mixed = _mm_setzero_si128();
+
+		for (; i + 8 <= count; i += 8)
+		{
+			// The samples are signed and the volumes unsigned: a signed
+			// multiply treats volumes >= 0x8000 as volume - 0x10000, which is
+			// corrected by adding the sample to the high half of the product.
+			const __m128i samples = _mm_loadu_si128((const __m128i*)&input[i]);
+			const __m128i lo = _mm_mullo_epi16(samples, volumes);
+			const __m128i hi = _mm_add_epi16(_mm_mulhi_epi16(samples, volumes),
+			                                 _mm_and_si128(samples, _mm_srai_epi16(volumes, 15)));
+
+			mixed = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15),
+			                        _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+			mixed = _mm_max_epi16(mixed, _mm_set1_epi16(-32767));
+
+			const __m128i sign = _mm_srai_epi16(mixed, 15);
+			__m128i* dst = (__m128i*)&out[i];
+			_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_unpacklo_epi16(mixed, sign)));
+			_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_unpackhi_epi16(mixed, sign)));
+
+			volumes = _mm_add_epi16(volumes, volume_step);
+		}
+
+		volume += (u16)(volume_delta * i);
+		*dpop = (s16)_mm_extract_epi16(mixed, 7);
+	}
+#endif
+
+	for (; i < count; ++i)
 	{
 		s64 sample = input[i];
 		sample *= volume;
@@ -532,7 +682,14 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 
 		// We use ratio 0x55555 == (5 * 65536 + 21845) / 65536 == 5.3333 which
 		// is the nearest we can get to 96/18
-		u32 curr_pos = ResampleAudio([&samples](u32 i) { return samples[i]; },
+		u32 wm_read = 0;
+		// At this ratio, at most the count samples from above are read. The copy
+		// is clamped all the same, as compilers can't tell.
+		u32 curr_pos = ResampleAudio([&samples, &wm_read, count](s16* input, u32 input_count) {
+		                                 const u32 copy_count = std::min<u32>(input_count, count - std::min<u32>(wm_read, count));
+		                                 memcpy(input, samples + wm_read, copy_count * sizeof (s16));
+		                                 wm_read += input_count;
+		                             },
 		                             wm_samples, wm_count, pb.remote_src.last_samples,
 		                             pb.remote_src.cur_addr_frac, 0x55555,
 		                             SRCTYPE_POLYPHASE, coeffs);
@@ -306,7 +306,7 @@ void AXWiiUCode::SetupProcessing(u32 init_addr)
 
 void AXWiiUCode::AddToLR(u32 val_addr, bool neg)
 {
-	int* ptr = (int*)HLEMemory_Get_Pointer(val_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(val_addr, 32 * 3 * sizeof (int));
 	for (int i = 0; i < 32 * 3; ++i)
 	{
 		int val = (int)Common::swap32(*ptr++);
@@ -320,7 +320,7 @@ void AXWiiUCode::AddToLR(u32 val_addr, bool neg)
 
 void AXWiiUCode::AddSubToLR(u32 val_addr)
 {
-	int* ptr = (int*)HLEMemory_Get_Pointer(val_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(val_addr, 2 * 32 * 3 * sizeof (int));
 	for (int i = 0; i < 32 * 3; ++i)
 	{
 		int val = (int)Common::swap32(*ptr++);
@@ -386,13 +386,13 @@ bool AXWiiUCode::ExtractUpdatesFields(AXPBWii& pb, u16* num_updates, u16* update
 	u16 addr_hi = pb_mem[44];
 	u16 addr_lo = pb_mem[45];
 	u32 addr = HILO_TO_32(addr);
-	u16* ptr = (u16*)HLEMemory_Get_Pointer(addr);
+	u32 updates_count = num_updates[0] + num_updates[1] + num_updates[2];
+	u16* ptr = (u16*)HLEMemory_Get_Pointer(addr, updates_count * 2 * sizeof (u16));
 
 	*updates_addr = addr;
 
 	// Copy the updates data and change the offset to match a PB without
 	// updates data.
-	u32 updates_count = num_updates[0] + num_updates[1] + num_updates[2];
 	for (u32 i = 0; i < updates_count; ++i)
 	{
 		u16 update_off = Common::swap16(ptr[2 * i]);
@@ -428,36 +428,31 @@ void AXWiiUCode::ReinjectUpdatesFields(AXPBWii& pb, u16* num_updates, u32 update
 
 void AXWiiUCode::ProcessPBList(u32 pb_addr)
 {
-	AXPBWii pb;
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround,
+		m_samples_auxC_left,
+		m_samples_auxC_right,
+		m_samples_auxC_surround,
+		m_samples_wm0,
+		m_samples_aux0,
+		m_samples_wm1,
+		m_samples_aux1,
+		m_samples_wm2,
+		m_samples_aux2,
+		m_samples_wm3,
+		m_samples_aux3
+	}};
 
-	while (pb_addr)
+	auto process_pb = [&](AXPBWii& pb, AXBuffers voice_buffers)
 	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround,
-			m_samples_auxC_left,
-			m_samples_auxC_right,
-			m_samples_auxC_surround,
-			m_samples_wm0,
-			m_samples_aux0,
-			m_samples_wm1,
-			m_samples_aux1,
-			m_samples_wm2,
-			m_samples_aux2,
-			m_samples_wm3,
-			m_samples_aux3
-		}};
-
-		if (!ReadPB(pb_addr, pb))
-			break;
-
 		u16 num_updates[3];
 		u16 updates[1024];
 		u32 updates_addr;
@@ -466,22 +461,68 @@ void AXWiiUCode::ProcessPBList(u32 pb_addr)
 			for (int curr_ms = 0; curr_ms < 3; ++curr_ms)
 			{
 				ApplyUpdatesForMs(curr_ms, (u16*)&pb, num_updates, updates);
-				ProcessVoice(pb, buffers, 32,
+				ProcessVoice(pb, voice_buffers, 32,
 				             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 				             m_coeffs_available ? m_coeffs : nullptr);
 
 				// Forward the buffers
-				for (size_t i = 0; i < ArraySize(buffers.ptrs); ++i)
-					buffers.ptrs[i] += 32;
+				for (size_t i = 0; i < ArraySize(voice_buffers.ptrs); ++i)
+					voice_buffers.ptrs[i] += 32;
 			}
 			ReinjectUpdatesFields(pb, num_updates, updates_addr);
 		}
 		else
 		{
-			ProcessVoice(pb, buffers, 96,
+			ProcessVoice(pb, voice_buffers, 96,
 			             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 			             m_coeffs_available ? m_coeffs : nullptr);
 		}
+	};
+
+	// Updates may change the link to the next PB, which voice processing never does
+	auto get_next = [&](const AXPBWii& pb)
+	{
+		AXPBWii updated = pb;
+		u16 num_updates[3];
+		u16 updates[1024];
+		u32 updates_addr;
+		if (ExtractUpdatesFields(updated, num_updates, updates, &updates_addr))
+		{
+			for (int curr_ms = 0; curr_ms < 3; ++curr_ms)
+				ApplyUpdatesForMs(curr_ms, (u16*)&updated, num_updates, updates);
+			ReinjectUpdatesFields(updated, num_updates, updates_addr);
+		}
+		return HILO_TO_32(updated.next_pb);
+	};
+
+	if (!m_voice_workers.empty() && ReadPBList(pb_addr, &m_pb_addresses, &m_pbs_wii, get_next))
+	{
+		// 3ms of main and AUX samples at 32KHz, and of Wiimote samples at 6KHz
+		u32 buffer_sizes[ArraySize(buffers.ptrs)];
+		for (size_t i = 0; i < ArraySize(buffers.ptrs); ++i)
+			buffer_sizes[i] = i < 12 ? 32 * 3 : 6 * 3;
+
+		MixVoices((u32)m_pbs_wii.size(), buffers.ptrs, buffer_sizes, ArraySize(buffers.ptrs),
+			[&](u32 voice, int* const* voice_buffers)
+			{
+				AXBuffers thread_buffers;
+				std::copy(voice_buffers, voice_buffers + ArraySize(thread_buffers.ptrs), thread_buffers.ptrs);
+				process_pb(m_pbs_wii[voice], thread_buffers);
+			});
+
+		for (size_t i = 0; i < m_pbs_wii.size(); ++i)
+			WritePB(m_pb_addresses[i], m_pbs_wii[i]);
+		return;
+	}
+
+	AXPBWii pb;
+
+	while (pb_addr)
+	{
+		if (!ReadPB(pb_addr, pb))
+			break;
+
+		process_pb(pb, buffers);
 
 		WritePB(pb_addr, pb);
 		pb_addr = HILO_TO_32(pb.next_pb);
@@ -525,14 +566,14 @@ void AXWiiUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr, u16 vo
 	// Send the content of AUX buffers to the CPU
 	if (write_addr)
 	{
-		int* ptr = (int*)HLEMemory_Get_Pointer(write_addr);
+		int* ptr = (int*)HLEMemory_Get_Pointer(write_addr, 3 * 3 * 32 * sizeof (int));
 		for (auto& buffer : buffers)
 			for (u32 j = 0; j < 3 * 32; ++j)
 				*ptr++ = Common::swap32(buffer[j]);
 	}
 
 	// Then read the buffers from the CPU and add to our main buffers.
-	int* ptr = (int*)HLEMemory_Get_Pointer(read_addr);
+	int* ptr = (int*)HLEMemory_Get_Pointer(read_addr, 3 * 3 * 32 * sizeof (int));
 	for (auto& main_buffer : main_buffers)
 		for (u32 j = 0; j < 3 * 32; ++j)
 		{
@@ -549,7 +590,7 @@ void AXWiiUCode::UploadAUXMixLRSC(int aux_id, u32* addresses, u16 volume)
 	int* aux_surround = aux_id ? m_samples_auxB_surround : m_samples_auxA_surround;
 	int* auxc_buffer = aux_id ? m_samples_auxC_surround : m_samples_auxC_right;
 
-	int* upload_ptr = (int*)HLEMemory_Get_Pointer(addresses[0]);
+	int* upload_ptr = (int*)HLEMemory_Get_Pointer(addresses[0], 3 * 96 * sizeof (int));
 	for (u32 i = 0; i < 96; ++i)
 		*upload_ptr++ = Common::swap32(aux_left[i]);
 	for (u32 i = 0; i < 96; ++i)
@@ -557,7 +598,7 @@ void AXWiiUCode::UploadAUXMixLRSC(int aux_id, u32* addresses, u16 volume)
 	for (u32 i = 0; i < 96; ++i)
 		*upload_ptr++ = Common::swap32(aux_surround[i]);
 
-	upload_ptr = (int*)HLEMemory_Get_Pointer(addresses[1]);
+	upload_ptr = (int*)HLEMemory_Get_Pointer(addresses[1], 96 * sizeof (int));
 	for (u32 i = 0; i < 96; ++i)
 		*upload_ptr++ = Common::swap32(auxc_buffer[i]);
 
@@ -573,7 +614,7 @@ void AXWiiUCode::UploadAUXMixLRSC(int aux_id, u32* addresses, u16 volume)
 	};
 	for (u32 mix_i = 0; mix_i < 4; ++mix_i)
 	{
-		int* dl_ptr = (int*)HLEMemory_Get_Pointer(addresses[2 + mix_i]);
+		int* dl_ptr = (int*)HLEMemory_Get_Pointer(addresses[2 + mix_i], 96 * sizeof (int));
 		for (u32 i = 0; i < 96; ++i)
 			aux_left[i] = Common::swap32(dl_ptr[i]);
 
@@ -597,14 +638,14 @@ void AXWiiUCode::OutputSamples(u32 lr_addr, u32 surround_addr, u16 volume,
 
 	for (u32 i = 0; i < 3 * 32; ++i)
 		upload_buffer[i] = Common::swap32(m_samples_surround[i]);
-	memcpy(HLEMemory_Get_Pointer(surround_addr), upload_buffer, sizeof (upload_buffer));
+	memcpy(HLEMemory_Get_Pointer(surround_addr, sizeof (upload_buffer)), upload_buffer, sizeof (upload_buffer));
 
 	if (upload_auxc)
 	{
 		surround_addr += sizeof (upload_buffer);
 		for (u32 i = 0; i < 3 * 32; ++i)
 			upload_buffer[i] = Common::swap32(m_samples_auxC_left[i]);
-		memcpy(HLEMemory_Get_Pointer(surround_addr), upload_buffer, sizeof (upload_buffer));
+		memcpy(HLEMemory_Get_Pointer(surround_addr, sizeof (upload_buffer)), upload_buffer, sizeof (upload_buffer));
 	}
 
 	short buffer[3 * 32 * 2];
@@ -629,7 +670,7 @@ void AXWiiUCode::OutputSamples(u32 lr_addr, u32 surround_addr, u16 volume,
 		buffer[2 * i + 1] = Common::swap16(m_samples_left[i]);
 	}
 
-	memcpy(HLEMemory_Get_Pointer(lr_addr), buffer, sizeof (buffer));
+	memcpy(HLEMemory_Get_Pointer(lr_addr, sizeof (buffer)), buffer, sizeof (buffer));
 
 	// There should be a DSP_SYNC message sent here. However, it looks like not
 	// sending it does not cause any issue, and sending it actually causes some
@@ -648,7 +689,7 @@ void AXWiiUCode::OutputWMSamples(u32* addresses)
 	for (u32 i = 0; i < 4; ++i)
 	{
 		int* in = buffers[i];
-		u16* out = (u16*)HLEMemory_Get_Pointer(addresses[i]);
+		u16* out = (u16*)HLEMemory_Get_Pointer(addresses[i], 3 * 6 * sizeof (u16));
 		for (u32 j = 0; j < 3 * 6; ++j)
 		{
 			int sample = MathUtil::Clamp(in[j], -32767, 32767);
@@ -30,6 +30,9 @@ protected:
 	int m_samples_wm3[6 * 3];
 	int m_samples_aux3[6 * 3];
 
+	// PBs read up front for the voice threads
+	std::vector<AXPBWii> m_pbs_wii;
+
 	// Are we implementing an old version of AXWii which still has updates?
 	bool m_old_axwii;
 
@@ -70,8 +70,8 @@ void ProcessGBACrypto(u32 address)
 	}
 
 	// Send the result back to mram
-	*(u32*)HLEMemory_Get_Pointer(sec_params.dest_addr) = Common::swap32((x20 << 16) | x21);
-	*(u32*)HLEMemory_Get_Pointer(sec_params.dest_addr+4) = Common::swap32((x22 << 16) | x23);
+	*(u32*)HLEMemory_Get_Pointer(sec_params.dest_addr, sizeof (u32)) = Common::swap32((x20 << 16) | x21);
+	*(u32*)HLEMemory_Get_Pointer(sec_params.dest_addr+4, sizeof (u32)) = Common::swap32((x22 << 16) | x23);
 
 	// Done!
 	DEBUG_LOG(DSPHLE, "\n%08x -> key: %08x, len: %08x, dest_addr: %08x, unk1: %08x, unk2: %08x"
@@ -89,7 +89,7 @@ void ROMUCode::HandleMail(u32 mail)
 void ROMUCode::BootUCode()
 {
 	u32 ector_crc = HashEctor(
-		(u8*)HLEMemory_Get_Pointer(m_current_ucode.m_ram_address),
+		(u8*)HLEMemory_Get_Pointer(m_current_ucode.m_ram_address, m_current_ucode.m_length),
 		m_current_ucode.m_length);
 
 	if (SConfig::GetInstance().m_DumpUCode)
@@ -100,7 +100,7 @@ void ROMUCode::BootUCode()
 		File::IOFile fp(ucode_dump_path, "wb");
 		if (fp)
 		{
-			fp.WriteArray((u8*)HLEMemory_Get_Pointer(m_current_ucode.m_ram_address),
+			fp.WriteArray((u8*)HLEMemory_Get_Pointer(m_current_ucode.m_ram_address, m_current_ucode.m_length),
 						  m_current_ucode.m_length);
 		}
 	}
@@ -131,7 +131,7 @@ void UCodeInterface::PrepareBootUCode(u32 mail)
 		m_upload_setup_in_progress = false;
 
 		u32 ector_crc = HashEctor(
-			(u8*)HLEMemory_Get_Pointer(m_next_ucode.iram_mram_addr),
+			(u8*)HLEMemory_Get_Pointer(m_next_ucode.iram_mram_addr, m_next_ucode.iram_size),
 			m_next_ucode.iram_size);
 
 		if (SConfig::GetInstance().m_DumpUCode)
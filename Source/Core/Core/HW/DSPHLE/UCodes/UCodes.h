@@ -10,6 +10,7 @@
 #include "Common/Thread.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/DSPHLE/DSPHLE.h"
+#include "Core/HW/DSPHLE/HLECapture.h"
 
 #define UCODE_ROM                   0x00000000
 #define UCODE_INIT_AUDIO_SYSTEM     0x00000001
@@ -24,6 +25,8 @@ constexpr bool ExramRead(u32 address)
 
 inline u8 HLEMemory_Read_U8(u32 address)
 {
+	HLECapture::UseMemory(address, sizeof(u8));
+
 	if (ExramRead(address))
 		return Memory::m_pEXRAM[address & Memory::EXRAM_MASK];
 	else
@@ -34,6 +37,7 @@ inline u16 HLEMemory_Read_U16(u32 address)
 {
 	u16 value;
 
+	HLECapture::UseMemory(address, sizeof(u16));
 	if (ExramRead(address))
 		std::memcpy(&value, &Memory::m_pEXRAM[address & Memory::EXRAM_MASK], sizeof(u16));
 	else
@@ -46,6 +50,7 @@ inline u32 HLEMemory_Read_U32(u32 address)
 {
 	u32 value;
 
+	HLECapture::UseMemory(address, sizeof(u32));
 	if (ExramRead(address))
 		std::memcpy(&value, &Memory::m_pEXRAM[address & Memory::EXRAM_MASK], sizeof(u32));
 	else
@@ -54,8 +59,12 @@ inline u32 HLEMemory_Read_U32(u32 address)
 	return Common::swap32(value);
 }
 
-inline void* HLEMemory_Get_Pointer(u32 address)
+// The ucode must not access more than size bytes through the pointer, so that a capture
+// records all the memory it needs.
+inline void* HLEMemory_Get_Pointer(u32 address, u32 size)
 {
+	HLECapture::UseMemory(address, size);
+
 	if (ExramRead(address))
 		return &Memory::m_pEXRAM[address & Memory::EXRAM_MASK];
 	else
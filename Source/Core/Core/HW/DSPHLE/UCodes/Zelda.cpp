@@ -417,7 +417,7 @@ void ZeldaUCode::RunPendingCommands()
 
 			m_renderer.SetVPBBaseAddress(Read32());
 
-			u16* data_ptr = (u16*)HLEMemory_Get_Pointer(Read32());
+			u16* data_ptr = (u16*)HLEMemory_Get_Pointer(Read32(), 0x280 * sizeof (u16));
 
 			std::array<s16, 0x100> resampling_coeffs;
 			for (size_t i = 0; i < 0x100; ++i)
@@ -434,7 +434,7 @@ void ZeldaUCode::RunPendingCommands()
 				sine_table[i] = Common::swap16(data_ptr[0x200 + i]);
 			m_renderer.SetSineTable(std::move(sine_table));
 
-			u16* afc_coeffs_ptr = (u16*)HLEMemory_Get_Pointer(Read32());
+			u16* afc_coeffs_ptr = (u16*)HLEMemory_Get_Pointer(Read32(), 0x20 * sizeof (u16));
 			std::array<s16, 0x20> afc_coeffs;
 			for (size_t i = 0; i < 0x20; ++i)
 				afc_coeffs[i] = Common::swap16(afc_coeffs_ptr[i]);
@@ -975,7 +975,7 @@ void ZeldaAudioRenderer::ApplyReverb(bool post_rendering)
 		&m_buf_front_right_reverb_last8,
 	};
 
-	u16* rpb_base_ptr = (u16*)HLEMemory_Get_Pointer(m_reverb_pb_base_addr);
+	u16* rpb_base_ptr = (u16*)HLEMemory_Get_Pointer(m_reverb_pb_base_addr, 4 * sizeof (ReverbPB));
 	for (u16 rpb_idx = 0; rpb_idx < 4; ++rpb_idx)
 	{
 		ReverbPB rpb;
@@ -991,7 +991,7 @@ void ZeldaAudioRenderer::ApplyReverb(bool post_rendering)
 		u32 mram_addr = ((rpb.circular_buffer_base_h << 16) |
 						 rpb.circular_buffer_base_l) +
 						 mram_buffer_idx * 0x50 * sizeof (s16);
-		s16* mram_ptr = (s16*)HLEMemory_Get_Pointer(mram_addr);
+		s16* mram_ptr = (s16*)HLEMemory_Get_Pointer(mram_addr, 0x50 * sizeof (s16));
 
 		if (!post_rendering)
 		{
@@ -1007,21 +1007,9 @@ void ZeldaAudioRenderer::ApplyReverb(bool post_rendering)
 			for (u16 i = 0; i < 8; ++i)
 				(*last8_samples_buffers[rpb_idx])[i] = buffer[0x50 + i];
 
-			auto ApplyFilter = [&]() {
-				// Filter the buffer using provided coefficients.
-				for (u16 i = 0; i < 0x50; ++i)
-				{
-					s32 sample = 0;
-					for (u16 j = 0; j < 8; ++j)
-						sample += (s32)buffer[i + j] * rpb.filter_coeffs[j];
-					sample >>= 15;
-					buffer[i] = MathUtil::Clamp(sample, -0x8000, 0x7FFF);
-				}
-			};
-
 			// LSB set -> pre-filtering.
 			if (rpb.enabled & 1)
-				ApplyFilter();
+				ApplyReverbFilter(&buffer, rpb.filter_coeffs);
 
 			for (const auto& dest : rpb.dest)
 			{
@@ -1042,7 +1030,7 @@ void ZeldaAudioRenderer::ApplyReverb(bool post_rendering)
 
 			// LSB not set, bit 1 set -> post-filtering.
 			if (rpb.enabled & 2)
-				ApplyFilter();
+				ApplyReverbFilter(&buffer, rpb.filter_coeffs);
 
 			for (u16 i = 0; i < 0x50; ++i)
 				(*reverb_buffers[rpb_idx])[i] = buffer[i];
@@ -1227,6 +1215,20 @@ void ZeldaAudioRenderer::AddVoice(u16 voice_id)
 	StoreVPB(voice_id, &vpb);
 }
 
+// Copies a mixing buffer to RAM, in big endian.
+static void UploadSamples(u16* dst, const s16* src, size_t count)
+{
+#ifdef _M_X86
+	for (; count >= 8; count -= 8, src += 8, dst += 8)
+	{
+		const __m128i v = _mm_loadu_si128((const __m128i*)src);
+		_mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+	}
+#endif
+	while (count--)
+		*dst++ = Common::swap16(*src++);
+}
+
 void ZeldaAudioRenderer::FinalizeFrame()
 {
 	// TODO: Dolby mixing.
@@ -1234,13 +1236,12 @@ void ZeldaAudioRenderer::FinalizeFrame()
 	ApplyVolumeInPlace_4_12(&m_buf_front_left, m_output_volume);
 	ApplyVolumeInPlace_4_12(&m_buf_front_right, m_output_volume);
 
-	u16* ram_left_buffer = (u16*)HLEMemory_Get_Pointer(m_output_lbuf_addr);
-	u16* ram_right_buffer = (u16*)HLEMemory_Get_Pointer(m_output_rbuf_addr);
-	for (size_t i = 0; i < m_buf_front_left.size(); ++i)
-	{
-		ram_left_buffer[i] = Common::swap16(m_buf_front_left[i]);
-		ram_right_buffer[i] = Common::swap16(m_buf_front_right[i]);
-	}
+	u16* ram_left_buffer = (u16*)HLEMemory_Get_Pointer(
+			m_output_lbuf_addr, sizeof (u16) * (u32)m_buf_front_left.size());
+	u16* ram_right_buffer = (u16*)HLEMemory_Get_Pointer(
+			m_output_rbuf_addr, sizeof (u16) * (u32)m_buf_front_right.size());
+	UploadSamples(ram_left_buffer, m_buf_front_left.data(), m_buf_front_left.size());
+	UploadSamples(ram_right_buffer, m_buf_front_right.data(), m_buf_front_right.size());
 	m_output_lbuf_addr += sizeof (u16) * (u32)m_buf_front_left.size();
 	m_output_rbuf_addr += sizeof (u16) * (u32)m_buf_front_right.size();
 
@@ -1254,16 +1255,16 @@ void ZeldaAudioRenderer::FinalizeFrame()
 void ZeldaAudioRenderer::FetchVPB(u16 voice_id, VPB* vpb)
 {
 	u16* vpb_words = (u16*)vpb;
-	u16* ram_vpbs = (u16*)HLEMemory_Get_Pointer(m_vpb_base_addr);
 
 	// A few versions of the UCode have VPB of size 0x80 (vs. the standard
 	// 0xC0). The whole 0x40-0x80 part is gone. Handle that by moving things
 	// around.
 	size_t vpb_size = (m_flags & TINY_VPB) ? 0x80 : 0xC0;
 
-	size_t base_idx = voice_id * vpb_size;
+	u16* ram_vpb = (u16*)HLEMemory_Get_Pointer(
+			m_vpb_base_addr + (u32)(voice_id * vpb_size * sizeof (u16)), (u32)(vpb_size * sizeof (u16)));
 	for (size_t i = 0; i < vpb_size; ++i)
-		vpb_words[i] = Common::swap16(ram_vpbs[base_idx + i]);
+		vpb_words[i] = Common::swap16(ram_vpb[i]);
 
 	if (m_flags & TINY_VPB)
 		vpb->Uncompress();
@@ -1272,17 +1273,18 @@ void ZeldaAudioRenderer::FetchVPB(u16 voice_id, VPB* vpb)
 void ZeldaAudioRenderer::StoreVPB(u16 voice_id, VPB* vpb)
 {
 	u16* vpb_words = (u16*)vpb;
-	u16* ram_vpbs = (u16*)HLEMemory_Get_Pointer(m_vpb_base_addr);
 
 	size_t vpb_size = (m_flags & TINY_VPB) ? 0x80 : 0xC0;
-	size_t base_idx = voice_id * vpb_size;
+
+	// Only the first 0x80 words are transferred back - the rest is read-only.
+	u16* ram_vpb = (u16*)HLEMemory_Get_Pointer(
+			m_vpb_base_addr + (u32)(voice_id * vpb_size * sizeof (u16)), (u32)((vpb_size - 0x40) * sizeof (u16)));
 
 	if (m_flags & TINY_VPB)
 		vpb->Compress();
 
-	// Only the first 0x80 words are transferred back - the rest is read-only.
 	for (size_t i = 0; i < vpb_size - 0x40; ++i)
-		ram_vpbs[base_idx + i] = Common::swap16(vpb_words[i]);
+		ram_vpb[i] = Common::swap16(vpb_words[i]);
 }
 
 void ZeldaAudioRenderer::LoadInputSamples(MixingBuffer* buffer, VPB* vpb)
@@ -1457,12 +1459,13 @@ void ZeldaAudioRenderer::Resample(VPB* vpb, const s16* src, MixingBuffer* dst)
 	vpb->current_pos_frac = pos & 0xFFF;
 }
 
-void* ZeldaAudioRenderer::GetARAMPtr() const
+void* ZeldaAudioRenderer::GetARAMPtr(u32 offset, u32 size) const
 {
 	if (m_aram_base_addr)
-		return HLEMemory_Get_Pointer(m_aram_base_addr);
-	else
-		return DSP::GetARAMPtr();
+		return HLEMemory_Get_Pointer(m_aram_base_addr + offset, size);
+
+	HLECapture::UseARAM(offset, size);
+	return DSP::GetARAMPtr() + offset;
 }
 
 template <typename T>
@@ -1503,9 +1506,9 @@ void ZeldaAudioRenderer::DownloadPCMSamplesFromARAM(s16* dst, VPB* vpb, u16 requ
 					vpb->GetBaseAddress() + vpb->GetCurrentPosition() * sizeof (T));
 		}
 
-		T* src_ptr = (T*)((u8*)GetARAMPtr() + vpb->GetCurrentARAMAddr());
 		u16 samples_to_download = std::min(vpb->GetRemainingLength(),
 		                                   (u32)requested_samples_count);
+		T* src_ptr = (T*)GetARAMPtr(vpb->GetCurrentARAMAddr(), samples_to_download * sizeof (T));
 
 		for (u16 i = 0; i < samples_to_download; ++i)
 			*dst++ = Common::FromBigEndian<T>(*src_ptr++) << (16 - 8 * sizeof (T));
@@ -1645,7 +1648,7 @@ void ZeldaAudioRenderer::DownloadAFCSamplesFromARAM(
 void ZeldaAudioRenderer::DecodeAFC(VPB* vpb, s16* dst, size_t block_count)
 {
 	u32 addr = vpb->GetCurrentARAMAddr();
-	u8* src = (u8*)GetARAMPtr() + addr;
+	u8* src = (u8*)GetARAMPtr(addr, (u32)block_count * vpb->samples_source_type);
 	vpb->SetCurrentARAMAddr(addr + (u32)block_count * vpb->samples_source_type);
 
 	for (size_t b = 0; b < block_count; ++b)
@@ -1710,7 +1713,7 @@ void ZeldaAudioRenderer::DownloadRawSamplesFromMRAM(
 		s16* dst, VPB* vpb, u16 requested_samples_count)
 {
 	u32 addr = vpb->GetBaseAddress() + vpb->current_position_h * sizeof (u16);
-	s16* src_ptr = (s16*)HLEMemory_Get_Pointer(addr);
+	s16* src_ptr = (s16*)HLEMemory_Get_Pointer(addr, requested_samples_count * sizeof (s16));
 
 	if (requested_samples_count > vpb->GetRemainingLength())
 	{
@@ -1739,7 +1742,8 @@ void ZeldaAudioRenderer::DownloadRawSamplesFromMRAM(
 			for (u16 i = 0; i < vpb->samples_before_loop; ++i)
 				*dst++ = Common::swap16(*src_ptr++);
 			vpb->SetBaseAddress(vpb->GetLoopAddress());
-			src_ptr = (s16*)HLEMemory_Get_Pointer(vpb->GetLoopAddress());
+			src_ptr = (s16*)HLEMemory_Get_Pointer(vpb->GetLoopAddress(),
+					(requested_samples_count - vpb->samples_before_loop) * sizeof (s16));
 			for (u16 i = vpb->samples_before_loop; i < requested_samples_count; ++i)
 				*dst++ = Common::swap16(*src_ptr++);
 			vpb->current_position_h = requested_samples_count - vpb->samples_before_loop;
@@ -2,7 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
-#include <mutex>
+#include <chrono>
 #include <thread>
 
 #include "Common/Atomic.h"
@@ -13,6 +13,7 @@
 #include "Common/Event.h"
 #include "Common/IniFile.h"
 #include "Common/Thread.h"
+#include "Common/MathUtil.h"
 #include "Common/Logging/LogManager.h"
 
 #include "Core/ConfigManager.h"
@@ -29,25 +30,62 @@
 #include "Core/DSP/DSPTables.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/SystemTimers.h"
 
 #include "Core/HW/DSPLLE/DSPLLE.h"
 #include "Core/HW/DSPLLE/DSPLLEGlobals.h"
 #include "Core/HW/DSPLLE/DSPSymbols.h"
 
+// CPU cycles between two DSP slices.
+static const u32 DEFAULT_SLICE_CYCLES = 12600;
+// How long a thread polls for the other one to hand over before it sleeps.
+static const int SYNC_SPIN_COUNT = 1000;
+
 DSPLLE::DSPLLE()
 	: m_hDSPThread()
-	, m_csDSPThreadActive()
 	, m_bWii(false)
 	, m_bDSPThread(false)
 	, m_bIsRunning(false)
+	, m_bPaused(false)
 	, m_cycle_count(0)
+	, m_slice_cycles(DEFAULT_SLICE_CYCLES)
 {
 }
 
 static Common::Event dspEvent;
 static Common::Event ppcEvent;
+// Set while the thread sleeps on its event, so the other one knows it has to
+// wake it up.
+static std::atomic<bool> dspParked;
+static std::atomic<bool> ppcParked;
 static bool requestDisableThread;
 
+// Sync statistics of the CPU thread, reported once per emulated second.
+static u64 syncEmulatedCycles;
+static u32 syncSlices;
+static u32 syncParks;
+static std::chrono::steady_clock::duration syncWaitTime;
+
+// Waits until done() is true. The other thread usually hands over within a
+// few microseconds, so this polls for a while before going to sleep.
+// Returns whether it had to sleep.
+template <typename Func>
+static bool SpinThenPark(Func done, std::atomic<bool>& parked, Common::Event& event)
+{
+	for (int i = 0; i < SYNC_SPIN_COUNT; i++)
+	{
+		if (done())
+			return false;
+		Common::YieldCPU();
+	}
+
+	parked.store(true);
+	while (!done())
+		event.Wait();
+	parked.store(false);
+	return true;
+}
+
 void DSPLLE::DoState(PointerWrap &p)
 {
 	bool is_hle = false;
@@ -93,12 +131,14 @@ void DSPLLE::DSPThread(DSPLLE* dsp_lle)
 {
 	Common::SetCurrentThreadName("DSP thread");
 
+	// The CPU thread only hands out cycles while m_cycle_count is 0, and this
+	// thread only sets it back to 0 when it is done with them, so the two
+	// take turns without any lock.
 	while (dsp_lle->m_bIsRunning.IsSet())
 	{
 		const int cycles = static_cast<int>(dsp_lle->m_cycle_count.load());
-		if (cycles > 0)
+		if (cycles > 0 && !dsp_lle->m_bPaused.IsSet())
 		{
-			std::lock_guard<std::mutex> dsp_thread_lock(dsp_lle->m_csDSPThreadActive);
 			if (dspjit)
 			{
 				DSPCore_RunCycles(cycles);
@@ -108,11 +148,15 @@ void DSPLLE::DSPThread(DSPLLE* dsp_lle)
 				DSPInterpreter::RunCyclesThread(cycles);
 			}
 			dsp_lle->m_cycle_count.store(0);
+			if (ppcParked.load())
+				ppcEvent.Set();
 		}
 		else
 		{
-			ppcEvent.Set();
-			dspEvent.Wait();
+			SpinThenPark([dsp_lle] {
+				return (dsp_lle->m_cycle_count.load() != 0 && !dsp_lle->m_bPaused.IsSet()) ||
+				       !dsp_lle->m_bIsRunning.IsSet();
+			}, dspParked, dspEvent);
 		}
 	}
 }
@@ -182,6 +226,13 @@ bool DSPLLE::Initialize(bool bWii, bool bDSPThread)
 	}
 	m_bWii = bWii;
 	m_bDSPThread = bDSPThread;
+	m_slice_cycles = static_cast<u32>(MathUtil::Clamp(SConfig::GetInstance().m_DSPLLESliceCycles, 1200, 120000));
+	m_bPaused.Clear();
+	m_cycle_count.store(0);
+	syncEmulatedCycles = 0;
+	syncSlices = 0;
+	syncParks = 0;
+	syncWaitTime = std::chrono::steady_clock::duration::zero();
 
 	// DSPLLE directly accesses the fastmem arena.
 	// TODO: The fastmem arena is only supposed to be used by the JIT:
@@ -206,7 +257,6 @@ void DSPLLE::DSP_StopSoundStream()
 	if (m_bDSPThread)
 	{
 		m_bIsRunning.Clear();
-		ppcEvent.Set();
 		dspEvent.Set();
 		m_hDSPThread.join();
 	}
@@ -336,22 +386,55 @@ void DSPLLE::DSP_Update(int cycles)
 	}
 	else
 	{
-		// Wait for DSP thread to complete its cycle. Note: this logic should be thought through.
-		ppcEvent.Wait();
+		// Wait for the DSP thread to finish the last slice, then hand it the next one.
+		const auto wait_start = std::chrono::steady_clock::now();
+		if (SpinThenPark([this] { return m_cycle_count.load() == 0; }, ppcParked, ppcEvent))
+			syncParks++;
+		syncWaitTime += std::chrono::steady_clock::now() - wait_start;
+
 		m_cycle_count.fetch_add(dsp_cycles);
-		dspEvent.Set();
+		if (dspParked.load())
+			dspEvent.Set();
+
+		syncSlices++;
+		syncEmulatedCycles += cycles;
+		if (syncEmulatedCycles >= SystemTimers::GetTicksPerSecond())
+		{
+			INFO_LOG(DSPLLE, "DSP thread sync per emulated second: %u slices, %u sleeps, %.3f ms waiting",
+			         syncSlices, syncParks,
+			         std::chrono::duration<double, std::milli>(syncWaitTime).count());
+			syncEmulatedCycles -= SystemTimers::GetTicksPerSecond();
+			syncSlices = 0;
+			syncParks = 0;
+			syncWaitTime = std::chrono::steady_clock::duration::zero();
+		}
 	}
 }
 
 u32 DSPLLE::DSP_UpdateRate()
 {
-	return 12600; // TO BE TWEAKED
+	// Shorter slices keep the DSP thread closer to the CPU, at the cost of
+	// more handovers. Without the thread, the timing has to stay fixed.
+	return m_bDSPThread ? m_slice_cycles : DEFAULT_SLICE_CYCLES;
 }
 
 void DSPLLE::PauseAndLock(bool doLock, bool unpauseOnUnlock)
 {
+	if (!m_bDSPThread)
+		return;
+
 	if (doLock)
-		m_csDSPThreadActive.lock();
+	{
+		// The CPU thread is already paused, so no more cycles come in. Let the
+		// DSP thread finish the ones it has, then keep it from starting on any
+		// which a loaded state might bring.
+		SpinThenPark([this] { return m_cycle_count.load() == 0; }, ppcParked, ppcEvent);
+		m_bPaused.Set();
+	}
 	else
-		m_csDSPThreadActive.unlock();
+	{
+		m_bPaused.Clear();
+		if (dspParked.load())
+			dspEvent.Set();
+	}
 }
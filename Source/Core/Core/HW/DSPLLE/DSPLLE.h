@@ -5,7 +5,6 @@
 #pragma once
 
 #include <atomic>
-#include <mutex>
 #include <thread>
 
 #include "Common/Flag.h"
@@ -39,9 +38,12 @@ private:
 	static void DSPThread(DSPLLE* lpParameter);
 
 	std::thread m_hDSPThread;
-	std::mutex m_csDSPThreadActive;
 	bool m_bWii;
 	bool m_bDSPThread;
 	Common::Flag m_bIsRunning;
+	Common::Flag m_bPaused;
+	// Cycles the DSP thread still has to run. Only the CPU thread raises it
+	// from 0, and only the DSP thread sets it back to 0.
 	std::atomic<u32> m_cycle_count;
+	u32 m_slice_cycles;
 };
@@ -67,7 +67,7 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 static std::thread g_save_thread;
 
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 48; // Last changed in PR 3108
+static const u32 STATE_VERSION = 49; // Last changed for the software renderer rasterizer and TEV state
 
 // Maps savestate versions to Dolphin versions.
 // Versions after 42 don't need to be added to this list,
@@ -78,6 +78,11 @@ SoftwareVideoConfigDialog::SoftwareVideoConfigDialog(wxWindow* parent, const std
 
 	// xfb
 	szr_rendering->Add(new SettingCheckBox(page_general, _("Bypass XFB"), "", vconfig.bBypassXFB));
+	szr_rendering->AddStretchSpacer();
+
+	// threads
+	szr_rendering->Add(new wxStaticText(page_general, wxID_ANY, _("Rasterizer threads (0 = auto):")), 1, wxALIGN_CENTER_VERTICAL, 0);
+	szr_rendering->Add(new U32Setting(page_general, _("Rasterizer threads"), vconfig.numRasterizerThreads, 0, 16));
 	}
 
 	// - info
@@ -2,11 +2,20 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
+#include <thread>
 
 #include "Common/Common.h"
+#include "Common/Event.h"
+#include "Common/FifoQueue.h"
+#include "Common/Flag.h"
 #include "Common/MathUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/GL/GLInterfaceBase.h"
 
 #include "VideoBackends/OGL/ProgramShaderCache.h"
 #include "VideoBackends/OGL/Render.h"
@@ -29,7 +38,7 @@ u32 ProgramShaderCache::s_ubo_buffer_size;
 s32 ProgramShaderCache::s_ubo_align;
 
 static StreamBuffer *s_buffer;
-static int num_failures = 0;
+static std::atomic<int> num_failures(0);
 
 static LinearDiskCache<SHADERUID, u8> g_program_disk_cache;
 static GLuint CurrentProgram = 0;
@@ -42,6 +51,54 @@ UidChecker<GeometryShaderUid,ShaderCode> ProgramShaderCache::geometry_uid_checke
 
 static char s_glsl_header[1024] = "";
 
+// Background compilation: programs are compiled and linked on a worker thread owning
+// a context which shares its objects with the main one. The GPU thread picks them up
+// once linking is done and only has to set the program variables.
+struct CompileJob
+{
+	ProgramShaderCache::PCacheEntry* entry;
+	SHADERUID uid;
+	std::string vcode, pcode, gcode;
+	SHADER shader;
+	bool success;
+};
+
+static std::unique_ptr<cInterfaceBase> s_compile_context;
+static std::thread s_compile_thread;
+static bool s_compile_thread_failed = false;
+static bool s_compile_thread_running = false;
+static Common::Event s_compile_thread_started;
+static Common::Flag s_compile_thread_quit;
+static Common::Event s_compile_event;
+static Common::FifoQueue<std::unique_ptr<CompileJob>, false> s_compile_queue;
+static Common::FifoQueue<std::unique_ptr<CompileJob>, false> s_compiled_queue;
+static int s_num_pending_programs = 0;
+
+// Stand-ins for programs which are still being compiled. Only programs with the same vertex
+// and geometry shader are used so the interface between the stages is guaranteed to match.
+struct FallbackKey
+{
+	VertexShaderUid vuid;
+	GeometryShaderUid guid;
+	u32 dst_alpha_mode;
+
+	explicit FallbackKey(const SHADERUID& uid)
+		: vuid(uid.vuid), guid(uid.guid), dst_alpha_mode(uid.puid.GetUidData()->dstAlphaMode)
+	{
+	}
+
+	bool operator <(const FallbackKey& r) const
+	{
+		if (vuid != r.vuid)
+			return vuid < r.vuid;
+		if (guid != r.guid)
+			return guid < r.guid;
+		return dst_alpha_mode < r.dst_alpha_mode;
+	}
+};
+
+static std::map<FallbackKey, ProgramShaderCache::PCacheEntry*> s_fallback_programs;
+
 static std::string GetGLSLVersionString()
 {
 	GLSL_VERSION v = g_ogl_config.eSupportedGLSLVersion;
@@ -181,8 +238,34 @@ GLuint ProgramShaderCache::GetCurrentProgram()
 	return CurrentProgram;
 }
 
+SHADER* ProgramShaderCache::BindEntry(PCacheEntry* entry, const SHADERUID& uid)
+{
+	if (entry->pending)
+	{
+		auto fallback = s_fallback_programs.end();
+		if (g_ActiveConfig.iShaderCompilationMode == SHADER_COMPILE_ASYNC_FALLBACK)
+			fallback = s_fallback_programs.find(FallbackKey(uid));
+
+		if (fallback == s_fallback_programs.end())
+		{
+			INCSTAT(stats.thisFrame.numDrawsSkippedForShader);
+			return nullptr;
+		}
+
+		INCSTAT(stats.thisFrame.numDrawsWithFallbackShader);
+		entry = fallback->second;
+	}
+
+	GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
+	entry->shader.Bind();
+	return &entry->shader;
+}
+
 SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components, u32 primitive_type)
 {
+	if (s_num_pending_programs)
+		RetrieveCompiledPrograms();
+
 	SHADERUID uid;
 	GetShaderId(&uid, dstAlphaMode, components, primitive_type);
 
@@ -190,11 +273,7 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 	if (last_entry)
 	{
 		if (uid == last_uid)
-		{
-			GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-			last_entry->shader.Bind();
-			return &last_entry->shader;
-		}
+			return BindEntry(last_entry, uid);
 	}
 
 	last_uid = uid;
@@ -203,18 +282,15 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 	PCache::iterator iter = pshaders.find(uid);
 	if (iter != pshaders.end())
 	{
-		PCacheEntry *entry = &iter->second;
-		last_entry = entry;
-
-		GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
-		last_entry->shader.Bind();
-		return &last_entry->shader;
+		last_entry = &iter->second;
+		return BindEntry(last_entry, uid);
 	}
 
 	// Make an entry in the table
 	PCacheEntry& newentry = pshaders[uid];
 	last_entry = &newentry;
 	newentry.in_cache = 0;
+	newentry.pending = false;
 
 	VertexShaderCode vcode;
 	PixelShaderCode pcode;
@@ -249,21 +325,170 @@ SHADER* ProgramShaderCache::SetShader(DSTALPHA_MODE dstAlphaMode, u32 components
 	}
 #endif
 
+	if (g_ActiveConfig.iShaderCompilationMode != SHADER_COMPILE_SYNCHRONOUS && StartCompileThread())
+	{
+		// The generators write to static buffers, so the code has to be copied
+		std::unique_ptr<CompileJob> job(new CompileJob);
+		job->entry = &newentry;
+		job->uid = uid;
+		job->vcode = vcode.GetBuffer();
+		job->pcode = pcode.GetBuffer();
+		if (gcode.GetBuffer() != nullptr)
+			job->gcode = gcode.GetBuffer();
+		job->success = false;
+
+		newentry.pending = true;
+		s_num_pending_programs++;
+		SETSTAT(stats.numShadersPendingCompile, s_num_pending_programs);
+
+		s_compile_queue.Push(std::move(job));
+		s_compile_event.Set();
+
+		return BindEntry(&newentry, uid);
+	}
+
 	if (!CompileShader(newentry.shader, vcode.GetBuffer(), pcode.GetBuffer(), gcode.GetBuffer()))
 	{
 		GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
 		return nullptr;
 	}
 
+	s_fallback_programs[FallbackKey(uid)] = &newentry;
+
 	INCSTAT(stats.numPixelShadersCreated);
 	SETSTAT(stats.numPixelShadersAlive, pshaders.size());
-	GFX_DEBUGGER_PAUSE_AT(NEXT_PIXEL_SHADER_CHANGE, true);
 
-	last_entry->shader.Bind();
-	return &last_entry->shader;
+	return BindEntry(&newentry, uid);
+}
+
+bool ProgramShaderCache::StartCompileThread()
+{
+	if (s_compile_thread.joinable())
+		return true;
+	if (s_compile_thread_failed)
+		return false;
+
+	s_compile_context = GLInterface->CreateSharedContext();
+	if (!s_compile_context)
+	{
+		WARN_LOG(VIDEO, "Shared GL contexts aren't supported, compiling shaders synchronously.");
+		s_compile_thread_failed = true;
+		return false;
+	}
+
+	s_compile_thread_quit.Clear();
+	s_compile_thread = std::thread(CompileThreadFunc);
+	s_compile_thread_started.Wait();
+	if (!s_compile_thread_running)
+	{
+		s_compile_thread.join();
+		s_compile_context->Shutdown();
+		s_compile_context.reset();
+		s_compile_thread_failed = true;
+		return false;
+	}
+
+	return true;
+}
+
+void ProgramShaderCache::StopCompileThread()
+{
+	if (s_compile_thread.joinable())
+	{
+		s_compile_thread_quit.Set();
+		s_compile_event.Set();
+		s_compile_thread.join();
+		s_compile_thread_running = false;
+	}
+
+	// Programs which have been compiled but not picked up yet won't be needed any more
+	std::unique_ptr<CompileJob> job;
+	while (s_compiled_queue.Pop(job))
+		job->shader.Destroy();
+	s_compile_queue.Clear();
+	s_num_pending_programs = 0;
+	SETSTAT(stats.numShadersPendingCompile, 0);
+
+	if (s_compile_context)
+	{
+		s_compile_context->Shutdown();
+		s_compile_context.reset();
+	}
+	s_compile_thread_failed = false;
+}
+
+void ProgramShaderCache::CompileThreadFunc()
+{
+	Common::SetCurrentThreadName("Shader compiler");
+
+	s_compile_thread_running = s_compile_context->MakeCurrent();
+	s_compile_thread_started.Set();
+	if (!s_compile_thread_running)
+	{
+		ERROR_LOG(VIDEO, "Failed to make the shader compiler context current.");
+		return;
+	}
+
+	while (!s_compile_thread_quit.IsSet())
+	{
+		s_compile_event.Wait();
+
+		std::unique_ptr<CompileJob> job;
+		while (!s_compile_thread_quit.IsSet() && s_compile_queue.Pop(job))
+		{
+			job->success = CompileProgram(job->shader, job->vcode.c_str(), job->pcode.c_str(),
+			                              job->gcode.empty() ? nullptr : job->gcode.c_str());
+
+			// Make sure the program is complete before another context uses it
+			glFinish();
+
+			s_compiled_queue.Push(std::move(job));
+		}
+	}
+
+	s_compile_context->ClearCurrent();
+}
+
+void ProgramShaderCache::RetrieveCompiledPrograms()
+{
+	std::unique_ptr<CompileJob> job;
+	while (s_compiled_queue.Pop(job))
+	{
+		PCacheEntry* entry = job->entry;
+		entry->pending = false;
+		s_num_pending_programs--;
+
+		if (!job->success)
+		{
+			GFX_DEBUGGER_PAUSE_AT(NEXT_ERROR, true);
+			continue;
+		}
+
+		entry->shader.glprogid = job->shader.glprogid;
+		entry->shader.SetProgramVariables();
+		s_fallback_programs[FallbackKey(job->uid)] = entry;
+
+		INCSTAT(stats.numPixelShadersCreated);
+		INCSTAT(stats.numShadersCompiledInBackground);
+	}
+
+	SETSTAT(stats.numShadersPendingCompile, s_num_pending_programs);
+	SETSTAT(stats.numPixelShadersAlive, pshaders.size());
 }
 
 bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const char* pcode, const char* gcode)
+{
+	if (!CompileProgram(shader, vcode, pcode, gcode))
+		return false;
+
+	shader.SetProgramVariables();
+
+	return true;
+}
+
+// Compiles and links the program without touching any state of the current context,
+// so it may be called from the background compiler thread.
+bool ProgramShaderCache::CompileProgram(SHADER& shader, const char* vcode, const char* pcode, const char* gcode)
 {
 	GLuint vsid = CompileSingleShader(GL_VERTEX_SHADER, vcode);
 	GLuint psid = CompileSingleShader(GL_FRAGMENT_SHADER, pcode);
@@ -337,11 +562,10 @@ bool ProgramShaderCache::CompileShader(SHADER& shader, const char* vcode, const
 
 		// Don't try to use this shader
 		glDeleteProgram(pid);
+		shader.glprogid = 0;
 		return false;
 	}
 
-	shader.SetProgramVariables();
-
 	return true;
 }
 
@@ -474,6 +698,9 @@ void ProgramShaderCache::Init()
 
 void ProgramShaderCache::Shutdown()
 {
+	StopCompileThread();
+	s_fallback_programs.clear();
+
 	// store all shaders in cache on disk
 	if (g_ogl_config.bSupportsGLSLCache && !g_Config.bEnableShaderDebugging)
 	{
@@ -641,6 +868,7 @@ void ProgramShaderCache::ProgramShaderCacheInserter::Read(const SHADERUID& key,
 
 	PCacheEntry entry;
 	entry.in_cache = 1;
+	entry.pending = false;
 	entry.shader.glprogid = glCreateProgram();
 	glProgramBinary(entry.shader.glprogid, *prog_format, binary, binary_size);
 
@@ -650,6 +878,7 @@ void ProgramShaderCache::ProgramShaderCacheInserter::Read(const SHADERUID& key,
 	if (success)
 	{
 		pshaders[key] = entry;
+		s_fallback_programs[FallbackKey(key)] = &pshaders[key];
 		entry.shader.SetProgramVariables();
 	}
 	else
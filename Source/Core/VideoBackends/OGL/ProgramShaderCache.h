@@ -79,6 +79,7 @@ public:
 	{
 		SHADER shader;
 		bool in_cache;
+		bool pending; // still being compiled in the background
 
 		void Destroy()
 		{
@@ -108,6 +109,14 @@ private:
 		void Read(const SHADERUID &key, const u8 *value, u32 value_size) override;
 	};
 
+	static SHADER* BindEntry(PCacheEntry* entry, const SHADERUID& uid);
+	static bool CompileProgram(SHADER& shader, const char* vcode, const char* pcode, const char* gcode);
+
+	static bool StartCompileThread();
+	static void StopCompileThread();
+	static void CompileThreadFunc();
+	static void RetrieveCompiledPrograms();
+
 	static PCache pshaders;
 	static PCacheEntry* last_entry;
 	static SHADERUID last_uid;
@@ -158,13 +158,15 @@ void VertexManager::vFlush(bool useDstAlpha)
 
 	// If host supports GL_ARB_blend_func_extended, we can do dst alpha in
 	// the same pass as regular rendering.
+	// SetShader returns nullptr if the program isn't usable (yet), skip drawing in that case.
+	SHADER* shader;
 	if (useDstAlpha && dualSourcePossible)
 	{
-		ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, nativeVertexFmt->m_components, current_primitive_type);
+		shader = ProgramShaderCache::SetShader(DSTALPHA_DUAL_SOURCE_BLEND, nativeVertexFmt->m_components, current_primitive_type);
 	}
 	else
 	{
-		ProgramShaderCache::SetShader(DSTALPHA_NONE, nativeVertexFmt->m_components, current_primitive_type);
+		shader = ProgramShaderCache::SetShader(DSTALPHA_NONE, nativeVertexFmt->m_components, current_primitive_type);
 	}
 
 	// upload global constants
@@ -173,13 +175,13 @@ void VertexManager::vFlush(bool useDstAlpha)
 	// setup the pointers
 	nativeVertexFmt->SetupVertexPointers();
 
-	Draw(stride);
+	if (shader)
+		Draw(stride);
 
 	// run through vertex groups again to set alpha
-	if (useDstAlpha && !dualSourcePossible)
+	if (useDstAlpha && !dualSourcePossible &&
+	    ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS, nativeVertexFmt->m_components, current_primitive_type))
 	{
-		ProgramShaderCache::SetShader(DSTALPHA_ALPHA_PASS, nativeVertexFmt->m_components, current_primitive_type);
-
 		// only update alpha
 		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
 
@@ -10,6 +10,7 @@
 #include "VideoBackends/Software/EfbCopy.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWTextureCache.h"
 #include "VideoBackends/Software/Tev.h"
 
 #include "VideoCommon/BoundingBox.h"
@@ -24,6 +25,30 @@ void InitBPMemory()
 	bpmem.bpMask = 0xFFFFFF;
 }
 
+// Registers whose writes do something even if the value doesn't change.
+// TLUT loads and texture invalidations also flush, so that queued triangles are drawn
+// before the texture memory they sample from changes.
+static bool IsTriggerRegister(int address)
+{
+	switch (address)
+	{
+	case BPMEM_SETDRAWDONE:
+	case BPMEM_PE_TOKEN_ID:
+	case BPMEM_PE_TOKEN_INT_ID:
+	case BPMEM_TRIGGER_EFB_COPY:
+	case BPMEM_CLEARBBOX1:
+	case BPMEM_CLEARBBOX2:
+	case BPMEM_CLEAR_PIXEL_PERF:
+	case BPMEM_LOADTLUT0:
+	case BPMEM_LOADTLUT1:
+	case BPMEM_TEXINVALIDATE:
+	case BPMEM_PRELOAD_MODE:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void SWLoadBPReg(u32 value)
 {
 	//handle the mask register
@@ -31,8 +56,19 @@ void SWLoadBPReg(u32 value)
 	int oldval = ((u32*)&bpmem)[address];
 	int newval = (oldval & ~bpmem.bpMask) | (value & bpmem.bpMask);
 
+	// Triangles queued up in the rasterizer need to be drawn with the state they were submitted with.
+	// Games rewrite unchanged registers all the time, so don't flush for those.
+	if (newval != oldval || IsTriggerRegister(address))
+		Rasterizer::Flush();
+
+	// Even unchanged texture registers come with new texture data sometimes
+	SWTextureCache::InvalidateBindings();
+
 	((u32*)&bpmem)[address] = newval;
 
+	if (newval != oldval)
+		Tev::InvalidateStageConfig();
+
 	//reset the mask register
 	if (address != 0xFE)
 		bpmem.bpMask = 0xFFFFFF;
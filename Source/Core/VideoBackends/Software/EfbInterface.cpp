@@ -6,6 +6,7 @@
 
 #include "Common/CommonFuncs.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Core/HW/Memmap.h"
 
 #include "VideoBackends/Software/BPMemLoader.h"
@@ -15,28 +16,80 @@
 #include "VideoCommon/PixelEngine.h"
 
 
-static u8 efb[EFB_WIDTH*EFB_HEIGHT*6];
+// Color and depth are kept in tiles of 8x8 pixels, which matches the order in which the rasterizer
+// draws its blocks. Every pixel takes up a whole u32, holding the same 24 bits as on the real
+// hardware, so switching between the pixel formats still reinterprets the stored bits.
+static const u32 TILE_SIZE = 8;
+static const u32 TILES_X = EFB_WIDTH / TILE_SIZE;
+
+alignas(16) static u32 efbColor[EFB_WIDTH*EFB_HEIGHT];
+alignas(16) static u32 efbDepth[EFB_WIDTH*EFB_HEIGHT];
+
+// Color followed by depth, in the 24 bits per pixel linear layout of the real EFB.
+// The slack covers encoders reading whole texture blocks past the bottom of the EFB.
+static u8 packedEfb[EFB_WIDTH*EFB_HEIGHT*6 + EFB_WIDTH*16*3];
 
 namespace EfbInterface
 {
 	u32 perf_values[PQ_NUM_MEMBERS];
 
-	static inline u32 GetColorOffset(u16 x, u16 y)
+	static inline u32 GetTiledIndex(u16 x, u16 y)
 	{
-		return (x + y * EFB_WIDTH) * 3;
+		u32 tile = (y / TILE_SIZE) * TILES_X + x / TILE_SIZE;
+		return tile * TILE_SIZE * TILE_SIZE + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+	}
+
+	static inline u32* GetColorPixel(u16 x, u16 y)
+	{
+		return &efbColor[GetTiledIndex(x, y)];
+	}
+
+	static inline u32* GetDepthPixel(u16 x, u16 y)
+	{
+		return &efbDepth[GetTiledIndex(x, y)];
+	}
+
+	static void PackRows(u8* dst, const u32* src, u16 left, u16 top, u16 right, u16 bottom)
+	{
+		for (u16 y = top; y < bottom; y++)
+		{
+			u8* row = dst + (left + y * EFB_WIDTH) * 3;
+			for (u16 x = left; x < right; x++)
+			{
+				u32 val = src[GetTiledIndex(x, y)];
+				*row++ = val & 0xff;
+				*row++ = (val >> 8) & 0xff;
+				*row++ = (val >> 16) & 0xff;
+			}
+		}
 	}
 
-	static inline u32 GetDepthOffset(u16 x, u16 y)
+	static void UnpackRows(u32* dst, const u8* src)
 	{
-		return (x + y * EFB_WIDTH) * 3 + DEPTH_BUFFER_START;
+		for (u16 y = 0; y < EFB_HEIGHT; y++)
+		{
+			for (u16 x = 0; x < EFB_WIDTH; x++)
+			{
+				const u8* pixel = src + (x + y * EFB_WIDTH) * 3;
+				dst[GetTiledIndex(x, y)] = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+			}
+		}
 	}
 
 	void DoState(PointerWrap &p)
 	{
-		p.DoArray(efb);
+		// Stored in the packed layout, same as before the EFB was tiled
+		PackRows(packedEfb, efbColor, 0, 0, EFB_WIDTH, EFB_HEIGHT);
+		PackRows(packedEfb + DEPTH_BUFFER_START, efbDepth, 0, 0, EFB_WIDTH, EFB_HEIGHT);
+		p.DoArray(packedEfb, EFB_WIDTH * EFB_HEIGHT * 6);
+		if (p.GetMode() == PointerWrap::MODE_READ)
+		{
+			UnpackRows(efbColor, packedEfb);
+			UnpackRows(efbDepth, packedEfb + DEPTH_BUFFER_START);
+		}
 	}
 
-	static void SetPixelAlphaOnly(u32 offset, u8 a)
+	static void SetPixelAlphaOnly(u32* pixel, u8 a)
 	{
 		switch (bpmem.zcontrol.pixel_format)
 		{
@@ -48,10 +101,9 @@ namespace EfbInterface
 		case PEControl::RGBA6_Z24:
 			{
 				u32 a32 = a;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xffffffc0;
+				u32 val = *pixel & 0xffffc0;
 				val |= (a32 >> 2) & 0x0000003f;
-				*dst = val;
+				*pixel = val;
 			}
 			break;
 		default:
@@ -59,7 +111,7 @@ namespace EfbInterface
 		}
 	}
 
-	static void SetPixelColorOnly(u32 offset, u8 *rgb)
+	static void SetPixelColorOnly(u32* pixel, u8 *rgb)
 	{
 		switch (bpmem.zcontrol.pixel_format)
 		{
@@ -67,31 +119,24 @@ namespace EfbInterface
 		case PEControl::Z24:
 			{
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				*pixel = src >> 8;
 			}
 			break;
 		case PEControl::RGBA6_Z24:
 			{
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff00003f;
+				u32 val = *pixel & 0x0000003f;
 				val |= (src >> 4) & 0x00000fc0; // blue
 				val |= (src >> 6) & 0x0003f000; // green
 				val |= (src >> 8) & 0x00fc0000; // red
-				*dst = val;
+				*pixel = val;
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 				u32 src = *(u32*)rgb;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				*pixel = src >> 8;
 			}
 			break;
 		default:
@@ -99,7 +144,7 @@ namespace EfbInterface
 		}
 	}
 
-	static void SetPixelAlphaColor(u32 offset, u8 *color)
+	static void SetPixelAlphaColor(u32* pixel, u8 *color)
 	{
 		switch (bpmem.zcontrol.pixel_format)
 		{
@@ -107,32 +152,24 @@ namespace EfbInterface
 		case PEControl::Z24:
 			{
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				*pixel = src >> 8;
 			}
 			break;
 		case PEControl::RGBA6_Z24:
 			{
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= (src >> 2) & 0x0000003f; // alpha
+				u32 val = (src >> 2) & 0x0000003f; // alpha
 				val |= (src >> 4) & 0x00000fc0; // blue
 				val |= (src >> 6) & 0x0003f000; // green
 				val |= (src >> 8) & 0x00fc0000; // red
-				*dst = val;
+				*pixel = val;
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
 				u32 src = *(u32*)color;
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= src >> 8;
-				*dst = val;
+				*pixel = src >> 8;
 			}
 			break;
 		default:
@@ -140,14 +177,14 @@ namespace EfbInterface
 		}
 	}
 
-	static void GetPixelColor(u32 offset, u8 *color)
+	static void GetPixelColor(const u32* pixel, u8 *color)
 	{
 		switch (bpmem.zcontrol.pixel_format)
 		{
 		case PEControl::RGB8_Z24:
 		case PEControl::Z24:
 			{
-				u32 src = *(u32*)&efb[offset];
+				u32 src = *pixel;
 				u32 *dst = (u32*)color;
 				u32 val = 0xff | ((src & 0x00ffffff) << 8);
 				*dst = val;
@@ -155,7 +192,7 @@ namespace EfbInterface
 			break;
 		case PEControl::RGBA6_Z24:
 			{
-				u32 src = *(u32*)&efb[offset];
+				u32 src = *pixel;
 				color[ALP_C] = Convert6To8(src & 0x3f);
 				color[BLU_C] = Convert6To8((src >> 6) & 0x3f);
 				color[GRN_C] = Convert6To8((src >> 12) & 0x3f);
@@ -165,7 +202,7 @@ namespace EfbInterface
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-				u32 src = *(u32*)&efb[offset];
+				u32 src = *pixel;
 				u32 *dst = (u32*)color;
 				u32 val = 0xff | ((src & 0x00ffffff) << 8);
 				*dst = val;
@@ -173,10 +210,11 @@ namespace EfbInterface
 			break;
 		default:
 			ERROR_LOG(VIDEO, "Unsupported pixel format: %i", static_cast<int>(bpmem.zcontrol.pixel_format));
+			*(u32*)color = 0;
 		}
 	}
 
-	static void SetPixelDepth(u32 offset, u32 depth)
+	static void SetPixelDepth(u32* pixel, u32 depth)
 	{
 		switch (bpmem.zcontrol.pixel_format)
 		{
@@ -184,19 +222,13 @@ namespace EfbInterface
 		case PEControl::RGBA6_Z24:
 		case PEControl::Z24:
 			{
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= depth & 0x00ffffff;
-				*dst = val;
+				*pixel = depth & 0x00ffffff;
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-				u32 *dst = (u32*)&efb[offset];
-				u32 val = *dst & 0xff000000;
-				val |= depth & 0x00ffffff;
-				*dst = val;
+				*pixel = depth & 0x00ffffff;
 			}
 			break;
 		default:
@@ -204,7 +236,7 @@ namespace EfbInterface
 		}
 	}
 
-	static u32 GetPixelDepth(u32 offset)
+	static u32 GetPixelDepth(const u32* pixel)
 	{
 		u32 depth = 0;
 
@@ -214,13 +246,13 @@ namespace EfbInterface
 		case PEControl::RGBA6_Z24:
 		case PEControl::Z24:
 			{
-				depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+				depth = *pixel;
 			}
 			break;
 		case PEControl::RGB565_Z16:
 			{
 				INFO_LOG(VIDEO, "RGB565_Z16 is not supported correctly yet");
-				depth = (*(u32*)&efb[offset]) & 0x00ffffff;
+				depth = *pixel;
 			}
 			break;
 		default:
@@ -401,11 +433,11 @@ namespace EfbInterface
 	void BlendTev(u16 x, u16 y, u8 *color)
 	{
 		u32 dstClr;
-		u32 offset = GetColorOffset(x, y);
+		u32* pixel = GetColorPixel(x, y);
 
 		u8 *dstClrPtr = (u8*)&dstClr;
 
-		GetPixelColor(offset, dstClrPtr);
+		GetPixelColor(pixel, dstClrPtr);
 
 		if (bpmem.blendmode.blendenable)
 		{
@@ -429,42 +461,42 @@ namespace EfbInterface
 		if (bpmem.blendmode.colorupdate)
 		{
 			if (bpmem.blendmode.alphaupdate)
-				SetPixelAlphaColor(offset, dstClrPtr);
+				SetPixelAlphaColor(pixel, dstClrPtr);
 			else
-				SetPixelColorOnly(offset, dstClrPtr);
+				SetPixelColorOnly(pixel, dstClrPtr);
 		}
 		else if (bpmem.blendmode.alphaupdate)
 		{
-			SetPixelAlphaOnly(offset, dstClrPtr[ALP_C]);
+			SetPixelAlphaOnly(pixel, dstClrPtr[ALP_C]);
 		}
 	}
 
 	void SetColor(u16 x, u16 y, u8 *color)
 	{
-		u32 offset = GetColorOffset(x, y);
+		u32* pixel = GetColorPixel(x, y);
 		if (bpmem.blendmode.colorupdate)
 		{
 			if (bpmem.blendmode.alphaupdate)
-				SetPixelAlphaColor(offset, color);
+				SetPixelAlphaColor(pixel, color);
 			else
-				SetPixelColorOnly(offset, color);
+				SetPixelColorOnly(pixel, color);
 		}
 		else if (bpmem.blendmode.alphaupdate)
 		{
-			SetPixelAlphaOnly(offset, color[ALP_C]);
+			SetPixelAlphaOnly(pixel, color[ALP_C]);
 		}
 	}
 
 	void SetDepth(u16 x, u16 y, u32 depth)
 	{
 		if (bpmem.zmode.updateenable)
-			SetPixelDepth(GetDepthOffset(x, y), depth);
+			SetPixelDepth(GetDepthPixel(x, y), depth);
 	}
 
 	void GetColor(u16 x, u16 y, u8 *color)
 	{
-		u32 offset = GetColorOffset(x, y);
-		GetPixelColor(offset, color);
+		u32* pixel = GetColorPixel(x, y);
+		GetPixelColor(pixel, color);
 	}
 
 	// For internal used only, return a non-normalized value, which saves work later.
@@ -482,15 +514,37 @@ namespace EfbInterface
 
 	u32 GetDepth(u16 x, u16 y)
 	{
-		u32 offset = GetDepthOffset(x, y);
-		return GetPixelDepth(offset);
+		u32* pixel = GetDepthPixel(x, y);
+		return GetPixelDepth(pixel);
 	}
 
-	u8 *GetPixelPointer(u16 x, u16 y, bool depth)
+	u8* PackRect(const EFBRectangle& rect, bool depth)
 	{
-		if (depth)
-			return &efb[GetDepthOffset(x, y)];
-		return &efb[GetColorOffset(x, y)];
+		u16 left = std::max(rect.left, 0);
+		u16 top = std::max(rect.top, 0);
+		int bottom = rect.bottom;
+
+		// Reads past the right edge continue at the start of the next row, as in the linear layout
+		u16 pack_left = left;
+		u16 pack_right = std::min<int>(rect.right, EFB_WIDTH);
+		if (rect.right > EFB_WIDTH)
+		{
+			pack_left = 0;
+			pack_right = EFB_WIDTH;
+			bottom++;
+		}
+
+		u8* dst = depth ? packedEfb + DEPTH_BUFFER_START : packedEfb;
+		u16 pack_bottom = std::min<int>(bottom, EFB_HEIGHT);
+		if (pack_left < pack_right && top < pack_bottom)
+			PackRows(dst, depth ? efbDepth : efbColor, pack_left, top, pack_right, pack_bottom);
+
+		// Reads past the bottom of the color buffer continue in the depth buffer, which is
+		// followed by zeroes
+		if (!depth && bottom > EFB_HEIGHT)
+			PackRows(packedEfb + DEPTH_BUFFER_START, efbDepth, 0, 0, EFB_WIDTH, std::min<int>(bottom - EFB_HEIGHT, EFB_HEIGHT));
+
+		return dst + (left + top * EFB_WIDTH) * 3;
 	}
 
 	void CopyToXFB(yuv422_packed* xfb_in_ram, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma)
@@ -582,8 +636,8 @@ namespace EfbInterface
 
 	bool ZCompare(u16 x, u16 y, u32 z)
 	{
-		u32 offset = GetDepthOffset(x, y);
-		u32 depth = GetPixelDepth(offset);
+		u32* pixel = GetDepthPixel(x, y);
+		u32 depth = GetPixelDepth(pixel);
 
 		bool pass;
 
@@ -620,9 +674,78 @@ namespace EfbInterface
 
 		if (pass && bpmem.zmode.updateenable)
 		{
-			SetPixelDepth(offset, z);
+			SetPixelDepth(pixel, z);
 		}
 
 		return pass;
 	}
+
+	u32 ZCompareQuad(u16 x, u16 y, const s32 z[4], u32 coverage)
+	{
+#ifdef _M_X86
+		auto pixelformat = bpmem.zcontrol.pixel_format;
+		bool z24 = pixelformat == PEControl::RGB8_Z24 || pixelformat == PEControl::RGBA6_Z24 ||
+		           pixelformat == PEControl::RGB565_Z16 || pixelformat == PEControl::Z24;
+		if (z24)
+		{
+			// The block is always inside of a single tile
+			u32* top = GetDepthPixel(x, y);
+			u32* bottom = top + TILE_SIZE;
+			__m128i depth = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i*)top), _mm_loadl_epi64((__m128i*)bottom));
+			__m128i zv = _mm_loadu_si128((const __m128i*)z);
+
+			// Both are 24 bit values, so the signed compares work
+			__m128i pass;
+			switch (bpmem.zmode.func)
+			{
+			case ZMode::LESS:
+				pass = _mm_cmpgt_epi32(depth, zv);
+				break;
+			case ZMode::EQUAL:
+				pass = _mm_cmpeq_epi32(zv, depth);
+				break;
+			case ZMode::LEQUAL:
+				pass = _mm_xor_si128(_mm_cmpgt_epi32(zv, depth), _mm_set1_epi32(-1));
+				break;
+			case ZMode::GREATER:
+				pass = _mm_cmpgt_epi32(zv, depth);
+				break;
+			case ZMode::NEQUAL:
+				pass = _mm_xor_si128(_mm_cmpeq_epi32(zv, depth), _mm_set1_epi32(-1));
+				break;
+			case ZMode::GEQUAL:
+				pass = _mm_xor_si128(_mm_cmpgt_epi32(depth, zv), _mm_set1_epi32(-1));
+				break;
+			case ZMode::ALWAYS:
+				pass = _mm_set1_epi32(-1);
+				break;
+			default:
+				pass = _mm_setzero_si128();
+				break;
+			}
+
+			const __m128i coverageBits = _mm_setr_epi32(1, 2, 4, 8);
+			__m128i covered = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(coverage), coverageBits), coverageBits);
+			pass = _mm_and_si128(pass, covered);
+
+			if (bpmem.zmode.updateenable)
+			{
+				zv = _mm_and_si128(zv, _mm_set1_epi32(0x00ffffff));
+				depth = _mm_or_si128(_mm_and_si128(pass, zv), _mm_andnot_si128(pass, depth));
+				_mm_storel_epi64((__m128i*)top, depth);
+				_mm_storel_epi64((__m128i*)bottom, _mm_srli_si128(depth, 8));
+			}
+
+			return _mm_movemask_ps(_mm_castsi128_ps(pass));
+		}
+#endif
+
+		u32 passed = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			if ((coverage & (1 << i)) && ZCompare(x + (i & 1), y + (i >> 1), z[i]))
+				passed |= 1 << i;
+		}
+		return passed;
+	}
 }
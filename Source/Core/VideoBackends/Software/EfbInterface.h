@@ -45,6 +45,11 @@ namespace EfbInterface
 	// returns result of compare.
 	bool ZCompare(u16 x, u16 y, u32 z);
 
+	// Same as ZCompare() for the covered pixels of the 2x2 block with its top left pixel at x, y,
+	// which have to be even. z and the coverage bits are ordered by rows, then columns.
+	// Returns the covered pixels which passed.
+	u32 ZCompareQuad(u16 x, u16 y, const s32 z[4], u32 coverage);
+
 	// sets the color and alpha
 	void SetColor(u16 x, u16 y, u8 *color);
 	void SetDepth(u16 x, u16 y, u32 depth);
@@ -53,7 +58,11 @@ namespace EfbInterface
 	void GetColorYUV(u16 x, u16 y, yuv444 *color);
 	u32 GetDepth(u16 x, u16 y);
 
-	u8* GetPixelPointer(u16 x, u16 y, bool depth);
+	// Packs the given part of the color or depth buffer into the 24 bits per pixel, EFB_WIDTH wide
+	// layout of the real EFB and returns a pointer to the top left pixel. Like on the real EFB, reads
+	// past the right edge return the start of the next row, and reads past the bottom of the color
+	// buffer return the depth buffer. Only valid until the next call.
+	u8* PackRect(const EFBRectangle& rect, bool depth);
 
 	void CopyToXFB(yuv422_packed* xfb_in_ram, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma);
 	void BypassXFB(u8* texture, u32 fbWidth, u32 fbHeight, const EFBRectangle& sourceRc, float Gamma);
@@ -61,16 +70,15 @@ namespace EfbInterface
 	void DoState(PointerWrap &p);
 
 	extern u32 perf_values[PQ_NUM_MEMBERS];
-	inline void IncPerfCounterQuadCount(PerfQueryType type)
+	inline void IncPerfCounterQuadCount(PerfQueryType type, u32 pixels = 1)
 	{
 		// NOTE: hardware doesn't process individual pixels but quads instead.
 		// Current software renderer architecture works on pixels though, so
 		// we have this "quad" hack here to only increment the registers on
 		// every fourth rendered pixel
 		static u32 quad[PQ_NUM_MEMBERS];
-		if (++quad[type] != 3)
-			return;
-		quad[type] = 0;
-		++perf_values[type];
+		quad[type] += pixels;
+		perf_values[type] += quad[type] / 3;
+		quad[type] %= 3;
 	}
 }
@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Core/HW/Memmap.h"
@@ -11,6 +13,7 @@
 #include "VideoBackends/Software/OpcodeDecoder.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
 #include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWTextureCache.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/XFMemLoader.h"
@@ -64,12 +67,9 @@ static void DecodePrimitiveStream(u32 iBufferSize)
 	}
 	else
 	{
-		while (streamSize > 0 && iBufferSize >= vertexSize)
-		{
-			vertexLoader.LoadVertex();
-			iBufferSize -= vertexSize;
-			streamSize--;
-		}
+		u32 count = vertexSize ? std::min<u32>(streamSize, iBufferSize / vertexSize) : streamSize;
+		vertexLoader.LoadVertices(count);
+		streamSize -= count;
 	}
 
 	if (streamSize == 0)
@@ -208,6 +208,7 @@ static void DecodeStandard(u32 bufferSize)
 			u8 vatIndex = Cmd & GX_VAT_MASK;
 			u8 primitiveType = (Cmd & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT;
 			vertexLoader.SetFormat(vatIndex, primitiveType);
+			SWTextureCache::BindTextures();
 
 			// switch to primitive processing
 			streamSize = DataRead<u16>();
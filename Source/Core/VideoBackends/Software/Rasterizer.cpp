@@ -3,8 +3,19 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "Common/BitSet.h"
 #include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/FPURoundMode.h"
+#include "Common/Intrinsics.h"
+#include "Common/MathUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
@@ -12,12 +23,18 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/Tev.h"
+#ifdef _M_X86_64
+#include "VideoBackends/Software/TevJitX64.h"
+#endif
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/BoundingBox.h"
 
 
 #define BLOCK_SIZE 2
 
+// Size of the areas which are checked against the triangle edges before looking at single pixels
+static const s32 AREA_SIZE = 8;
+
 #define CLAMP(x, a, b) (x>b)?b:(x<a)?a:x
 
 // returns approximation of log2(f) in s28.4
@@ -33,54 +50,83 @@ static inline s32 FixedLog2(float f)
 
 namespace Rasterizer
 {
-static Slope ZSlope;
-static Slope WSlope;
-static Slope ColorSlopes[2][4];
-static Slope TexSlopes[8][3];
+// Everything needed to rasterize a triangle once it has been set up
+struct TriangleSetup
+{
+	Slope ZSlope;
+	Slope WSlope;
+	Slope ColorSlopes[2][4];
+	Slope TexSlopes[8][3];
+
+	s32 vertex0X;
+	s32 vertex0Y;
+	float vertexOffsetX;
+	float vertexOffsetY;
+
+	// Half-edge functions in 28.4 fixed point
+	s32 DX12, DX23, DX31;
+	s32 DY12, DY23, DY31;
+	s32 C1, C2, C3;
+
+	// Scissored bounding rectangle
+	s32 minx, maxx, miny, maxy;
+};
+
+// State used while drawing pixels, one for each rasterizer thread
+struct RasterContext
+{
+	Tev tev;
+	RasterBlock rasterBlock;
+	u32 rasterizedPixels;
+};
+
+// Triangles are binned into screen tiles and the tiles are drawn in parallel.
+// Each tile is only ever drawn by one thread, which draws its triangles in submission
+// order, so every EFB pixel sees exactly the same sequence of writes as when drawing
+// everything on a single thread.
+static const s32 TILE_SIZE = 32;
+static const s32 TILES_X = (EFB_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
+static const s32 TILES_Y = (EFB_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+static const size_t MAX_BINNED_TRIANGLES = 4096;
+static const u32 MAX_THREADS = 16;
+
+struct Worker
+{
+	std::thread thread;
+	Common::Event startEvent;
+	Common::Event doneEvent;
+};
 
-static s32 vertex0X;
-static s32 vertex0Y;
-static float vertexOffsetX;
-static float vertexOffsetY;
+// Z slope of the last triangle, kept for zfreeze
+static Slope ZSlope;
 
 static s32 scissorLeft = 0;
 static s32 scissorTop = 0;
 static s32 scissorRight = 0;
 static s32 scissorBottom = 0;
 
-static Tev tev;
-static RasterBlock rasterBlock;
+// The first context belongs to the GPU thread
+static std::vector<std::unique_ptr<RasterContext>> contexts;
+static std::vector<std::unique_ptr<Worker>> workers;
+static std::atomic<bool> workersQuit;
+
+// Work other than drawing triangles which is handed to the threads while the rasterizer is idle
+static const std::function<void()>* workerJob;
+
+static std::vector<TriangleSetup> binnedTriangles;
+static std::vector<u32> tileBins[TILES_X * TILES_Y];
+static std::atomic<s32> nextTile;
+static bool countersPending = false;
 
 void DoState(PointerWrap &p)
 {
 	ZSlope.DoState(p);
-	WSlope.DoState(p);
-	for (auto& color_slopes_1d : ColorSlopes)
-		for (Slope& color_slope : color_slopes_1d)
-			color_slope.DoState(p);
-	for (auto& tex_slopes_1d : TexSlopes)
-		for (Slope& tex_slope : tex_slopes_1d)
-			tex_slope.DoState(p);
-	p.Do(vertex0X);
-	p.Do(vertex0Y);
-	p.Do(vertexOffsetX);
-	p.Do(vertexOffsetY);
 	p.Do(scissorLeft);
 	p.Do(scissorTop);
 	p.Do(scissorRight);
 	p.Do(scissorBottom);
-	tev.DoState(p);
-	p.Do(rasterBlock);
-}
-
-void Init()
-{
-	tev.Init();
-
-	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
-	// TODO: This is just a guess!
-	ZSlope.dfdx = ZSlope.dfdy = 0.f;
-	ZSlope.f0 = 1.f;
+	contexts[0]->tev.DoState(p);
+	p.Do(contexts[0]->rasterBlock);
 }
 
 static inline int iround(float x)
@@ -116,48 +162,45 @@ void SetScissor()
 
 void SetTevReg(int reg, int comp, bool konst, s16 color)
 {
-	tev.SetRegColor(reg, comp, konst, color);
+	for (auto& context : contexts)
+		context->tev.SetRegColor(reg, comp, konst, color);
 }
 
-inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
+static inline s32 GetPixelDepth(const TriangleSetup& tri, s32 x, s32 y)
 {
-	INCSTAT(swstats.thisFrame.rasterizedPixels);
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
 
-	float dx = vertexOffsetX + (float)(x - vertex0X);
-	float dy = vertexOffsetY + (float)(y - vertex0Y);
+	return (s32)MathUtil::Clamp<float>(tri.ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
+}
 
-	s32 z = (s32)MathUtil::Clamp<float>(ZSlope.GetValue(dx, dy), 0.0f, 16777215.0f);
+// Sets up the given pixel of the current block as the next pixel of the TEV quad
+static inline void AddPixel(const TriangleSetup& tri, RasterContext& context, s32 x, s32 y, s32 z, s32 xi, s32 yi, int* numPixels)
+{
+	Tev& tev = context.tev;
+	RasterBlock& rasterBlock = context.rasterBlock;
 
-	if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
-	{
-		// TODO: Test if perf regs are incremented even if test is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT_ZCOMPLOC);
-		if (bpmem.zmode.testenable)
-		{
-			// early z
-			if (!EfbInterface::ZCompare(x, y, z))
-				return;
-		}
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT_ZCOMPLOC);
-	}
+	float dx = tri.vertexOffsetX + (float)(x - tri.vertex0X);
+	float dy = tri.vertexOffsetY + (float)(y - tri.vertex0Y);
 
 	RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
+	Tev::QuadPixel& quad = tev.Quad[(*numPixels)++];
 
-	tev.Position[0] = x;
-	tev.Position[1] = y;
-	tev.Position[2] = z;
+	quad.Position[0] = x;
+	quad.Position[1] = y;
+	quad.Position[2] = z;
 
 	//  colors
 	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 	{
 		for (int comp = 0; comp < 4; comp++)
 		{
-			u16 color = (u16)ColorSlopes[i][comp].GetValue(dx, dy);
+			u16 color = (u16)tri.ColorSlopes[i][comp].GetValue(dx, dy);
 
 			// clamp color value to 0
 			u16 mask = ~(color >> 8);
 
-			tev.Color[i][comp] = color & mask;
+			quad.Color[i][comp] = color & mask;
 		}
 	}
 
@@ -165,9 +208,16 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
 	{
 		// multiply by 128 because TEV stores UVs as s17.7
-		tev.Uv[i].s = (s32)(pixel.Uv[i][0] * 128);
-		tev.Uv[i].t = (s32)(pixel.Uv[i][1] * 128);
+		quad.Uv[i].s = (s32)(pixel.Uv[i][0] * 128);
+		quad.Uv[i].t = (s32)(pixel.Uv[i][1] * 128);
 	}
+}
+
+// The LODs are the same for all pixels of a block
+static inline void SetBlockLOD(RasterContext& context)
+{
+	Tev& tev = context.tev;
+	RasterBlock& rasterBlock = context.rasterBlock;
 
 	for (unsigned int i = 0; i < bpmem.genMode.numindstages; i++)
 	{
@@ -180,20 +230,18 @@ inline void Draw(s32 x, s32 y, s32 xi, s32 yi)
 		tev.TextureLod[i] = rasterBlock.TextureLod[i];
 		tev.TextureLinear[i] = rasterBlock.TextureLinear[i];
 	}
-
-	tev.Draw();
 }
 
-static void InitTriangle(float X1, float Y1, s32 xi, s32 yi)
+static void InitTriangle(TriangleSetup* tri, float X1, float Y1, s32 xi, s32 yi)
 {
-	vertex0X = xi;
-	vertex0Y = yi;
+	tri->vertex0X = xi;
+	tri->vertex0Y = yi;
 
 	// adjust a little less than 0.5
 	const float adjust = 0.495f;
 
-	vertexOffsetX = ((float)xi - X1) + adjust;
-	vertexOffsetY = ((float)yi - Y1) + adjust;
+	tri->vertexOffsetX = ((float)xi - X1) + adjust;
+	tri->vertexOffsetY = ((float)yi - Y1) + adjust;
 }
 
 static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, float DX12, float DY12, float DY31)
@@ -208,7 +256,7 @@ static void InitSlope(Slope *slope, float f1, float f2, float f3, float DX31, fl
 	slope->f0 = f1;
 }
 
-static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoord)
+static inline void CalculateLOD(const RasterBlock& rasterBlock, s32* lodp, bool* linear, u32 texmap, u32 texcoord)
 {
 	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
 	u8 subTexmap = texmap & 3;
@@ -221,17 +269,17 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	float sDelta, tDelta;
 	if (tm0.diag_lod)
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][1].Uv[texcoord];
 
 		sDelta = fabsf(uv0[0] - uv1[0]);
 		tDelta = fabsf(uv0[1] - uv1[1]);
 	}
 	else
 	{
-		float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
-		float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
-		float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
+		const float *uv0 = rasterBlock.Pixel[0][0].Uv[texcoord];
+		const float *uv1 = rasterBlock.Pixel[1][0].Uv[texcoord];
+		const float *uv2 = rasterBlock.Pixel[0][1].Uv[texcoord];
 
 		sDelta = std::max(fabsf(uv0[0] - uv1[0]), fabsf(uv0[0] - uv2[0]));
 		tDelta = std::max(fabsf(uv0[1] - uv1[1]), fabsf(uv0[1] - uv2[1]));
@@ -255,7 +303,55 @@ static inline void CalculateLOD(s32* lodp, bool* linear, u32 texmap, u32 texcoor
 	*lodp = lod;
 }
 
-static void BuildBlock(s32 blockX, s32 blockY)
+#ifdef _M_X86
+
+// Same order of operations as Slope::GetValue(), so the results are identical
+static inline __m128 GetSlopeValues(const Slope& slope, __m128 dx, __m128 dy)
+{
+	__m128 value = _mm_add_ps(_mm_set1_ps(slope.f0), _mm_mul_ps(_mm_set1_ps(slope.dfdx), dx));
+	return _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(slope.dfdy), dy));
+}
+
+static void InterpolateBlock(const TriangleSetup& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
+{
+	// One lane per pixel, in the order of RasterBlock::Pixel
+	const __m128 dx = _mm_add_ps(_mm_set1_ps(tri.vertexOffsetX),
+		_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(blockX - tri.vertex0X), _mm_setr_epi32(0, 0, 1, 1))));
+	const __m128 dy = _mm_add_ps(_mm_set1_ps(tri.vertexOffsetY),
+		_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(blockY - tri.vertex0Y), _mm_setr_epi32(0, 1, 0, 1))));
+
+	RasterBlockPixel* pixels = &rasterBlock.Pixel[0][0];
+	alignas(16) float values[4];
+
+	const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), GetSlopeValues(tri.WSlope, dx, dy));
+	_mm_store_ps(values, invW);
+	for (int i = 0; i < 4; i++)
+		pixels[i].InvW = values[i];
+
+	// tex coords
+	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
+	{
+		__m128 projection = invW;
+		if (xfmem.texMtxInfo[i].projection)
+		{
+			__m128 q = _mm_mul_ps(GetSlopeValues(tri.TexSlopes[i][2], dx, dy), invW);
+			__m128 nonzero = _mm_cmpneq_ps(q, _mm_setzero_ps());
+			projection = _mm_or_ps(_mm_and_ps(nonzero, _mm_div_ps(invW, q)), _mm_andnot_ps(nonzero, invW));
+		}
+
+		_mm_store_ps(values, _mm_mul_ps(GetSlopeValues(tri.TexSlopes[i][0], dx, dy), projection));
+		for (int j = 0; j < 4; j++)
+			pixels[j].Uv[i][0] = values[j];
+
+		_mm_store_ps(values, _mm_mul_ps(GetSlopeValues(tri.TexSlopes[i][1], dx, dy), projection));
+		for (int j = 0; j < 4; j++)
+			pixels[j].Uv[i][1] = values[j];
+	}
+}
+
+#else
+
+static void InterpolateBlock(const TriangleSetup& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
 {
 	for (s32 yi = 0; yi < BLOCK_SIZE; yi++)
 	{
@@ -263,10 +359,10 @@ static void BuildBlock(s32 blockX, s32 blockY)
 		{
 			RasterBlockPixel& pixel = rasterBlock.Pixel[xi][yi];
 
-			float dx = vertexOffsetX + (float)(xi + blockX - vertex0X);
-			float dy = vertexOffsetY + (float)(yi + blockY - vertex0Y);
+			float dx = tri.vertexOffsetX + (float)(xi + blockX - tri.vertex0X);
+			float dy = tri.vertexOffsetY + (float)(yi + blockY - tri.vertex0Y);
 
-			float invW = 1.0f / WSlope.GetValue(dx, dy);
+			float invW = 1.0f / tri.WSlope.GetValue(dx, dy);
 			pixel.InvW = invW;
 
 			// tex coords
@@ -275,16 +371,23 @@ static void BuildBlock(s32 blockX, s32 blockY)
 				float projection = invW;
 				if (xfmem.texMtxInfo[i].projection)
 				{
-					float q = TexSlopes[i][2].GetValue(dx, dy) * invW;
+					float q = tri.TexSlopes[i][2].GetValue(dx, dy) * invW;
 					if (q != 0.0f)
 						projection = invW / q;
 				}
 
-				pixel.Uv[i][0] = TexSlopes[i][0].GetValue(dx, dy) * projection;
-				pixel.Uv[i][1] = TexSlopes[i][1].GetValue(dx, dy) * projection;
+				pixel.Uv[i][0] = tri.TexSlopes[i][0].GetValue(dx, dy) * projection;
+				pixel.Uv[i][1] = tri.TexSlopes[i][1].GetValue(dx, dy) * projection;
 			}
 		}
 	}
+}
+
+#endif
+
+static void BuildBlock(const TriangleSetup& tri, RasterBlock& rasterBlock, s32 blockX, s32 blockY)
+{
+	InterpolateBlock(tri, rasterBlock, blockX, blockY);
 
 	u32 indref = bpmem.tevindref.hex;
 	for (unsigned int i = 0; i < bpmem.genMode.numindstages; i++)
@@ -294,7 +397,7 @@ static void BuildBlock(s32 blockX, s32 blockY)
 		u32 texcoord = indref & 3;
 		indref >>= 3;
 
-		CalculateLOD(&rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
+		CalculateLOD(rasterBlock, &rasterBlock.IndirectLod[i], &rasterBlock.IndirectLinear[i], texmap, texcoord);
 	}
 
 	for (unsigned int i = 0; i <= bpmem.genMode.numtevstages; i++)
@@ -306,9 +409,318 @@ static void BuildBlock(s32 blockX, s32 blockY)
 			u32 texmap = order.getTexMap(stageOdd);
 			u32 texcoord = order.getTexCoord(stageOdd);
 
-			CalculateLOD(&rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+			CalculateLOD(rasterBlock, &rasterBlock.TextureLod[i], &rasterBlock.TextureLinear[i], texmap, texcoord);
+		}
+	}
+}
+
+// A pixel is covered when all three half-edge functions are positive at its top left corner
+struct EdgeFunction
+{
+	s32 C;
+	s32 DX;
+	s32 DY;
+
+	s32 GetValue(s32 x, s32 y) const { return C + DX * (y << 4) - DY * (x << 4); }
+};
+
+// Returns one bit per pixel of the 8 pixels starting at x, for each of the given rows
+static void GetRowCoverage(const EdgeFunction edges[3], s32 x, s32 y, s32 numRows, u8* rowMasks)
+{
+#ifdef _M_X86
+	__m128i lo[3];
+	__m128i hi[3];
+	__m128i rowStep[3];
+	for (int i = 0; i < 3; i++)
+	{
+		// Stepping by one pixel changes the function by -DY * 16
+		const s32 step = -edges[i].DY * 16;
+		lo[i] = _mm_add_epi32(_mm_set1_epi32(edges[i].GetValue(x, y)), _mm_setr_epi32(0, step, step * 2, step * 3));
+		hi[i] = _mm_add_epi32(lo[i], _mm_set1_epi32(step * 4));
+		rowStep[i] = _mm_set1_epi32(edges[i].DX * 16);
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	for (s32 row = 0; row < numRows; row++)
+	{
+		__m128i insideLo = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(lo[0], zero), _mm_cmpgt_epi32(lo[1], zero)), _mm_cmpgt_epi32(lo[2], zero));
+		__m128i insideHi = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(hi[0], zero), _mm_cmpgt_epi32(hi[1], zero)), _mm_cmpgt_epi32(hi[2], zero));
+		rowMasks[row] = (u8)(_mm_movemask_ps(_mm_castsi128_ps(insideLo)) | (_mm_movemask_ps(_mm_castsi128_ps(insideHi)) << 4));
+
+		for (int i = 0; i < 3; i++)
+		{
+			lo[i] = _mm_add_epi32(lo[i], rowStep[i]);
+			hi[i] = _mm_add_epi32(hi[i], rowStep[i]);
+		}
+	}
+#else
+	for (s32 row = 0; row < numRows; row++)
+	{
+		u8 mask = 0;
+		for (s32 column = 0; column < 8; column++)
+		{
+			if (edges[0].GetValue(x + column, y + row) > 0 &&
+			    edges[1].GetValue(x + column, y + row) > 0 &&
+			    edges[2].GetValue(x + column, y + row) > 0)
+			{
+				mask |= 1 << column;
+			}
 		}
+		rowMasks[row] = mask;
 	}
+#endif
+}
+
+// Draws the part of the triangle within the given rectangle, which must start on a block boundary.
+//
+// The rectangle is walked in areas of 8x8 pixels. Areas outside of an edge are skipped and areas
+// inside of all edges are drawn completely, both decided by the edge functions at the corners.
+// For all other areas, the edge functions are evaluated for a whole row at a time.
+// Then the 2x2 blocks with at least one covered pixel are sent to the TEV.
+static void RasterizeTriangle(const TriangleSetup& tri, RasterContext& context, s32 minx, s32 maxx, s32 miny, s32 maxy)
+{
+	const EdgeFunction edges[3] = {
+		{ tri.C1, tri.DX12, tri.DY12 },
+		{ tri.C2, tri.DX23, tri.DY23 },
+		{ tri.C3, tri.DX31, tri.DY31 },
+	};
+
+	// Only whole blocks are drawn
+	maxx = minx + ROUND_UP(maxx - minx, BLOCK_SIZE);
+	maxy = miny + ROUND_UP(maxy - miny, BLOCK_SIZE);
+
+	for (s32 y = miny; y < maxy; y += AREA_SIZE)
+	{
+		const s32 numRows = std::min(AREA_SIZE, maxy - y);
+
+		for (s32 x = minx; x < maxx; x += AREA_SIZE)
+		{
+			const s32 numColumns = std::min(AREA_SIZE, maxx - x);
+			const u8 columnMask = (u8)((1 << numColumns) - 1);
+
+			const s32 x1 = x + numColumns - 1;
+			const s32 y1 = y + numRows - 1;
+
+			bool inside = true;
+			bool outside = false;
+			for (const EdgeFunction& edge : edges)
+			{
+				int corners = (edge.GetValue(x, y) > 0) + (edge.GetValue(x1, y) > 0) +
+				              (edge.GetValue(x, y1) > 0) + (edge.GetValue(x1, y1) > 0);
+				inside &= corners == 4;
+				outside |= corners == 0;
+			}
+
+			// The edge functions are linear, so the corners tell about all pixels in between
+			if (outside)
+				continue;
+
+			u8 rowMasks[AREA_SIZE];
+			if (inside)
+				std::fill(rowMasks, rowMasks + numRows, columnMask);
+			else
+				GetRowCoverage(edges, x, y, numRows, rowMasks);
+
+			for (s32 blockY = 0; blockY < numRows; blockY += BLOCK_SIZE)
+			{
+				for (s32 blockX = 0; blockX < numColumns; blockX += BLOCK_SIZE)
+				{
+					// Coverage of the 2x2 block, bits 0 and 1 from the top row
+					const u32 coverage = ((rowMasks[blockY] >> blockX) & 3) | (((rowMasks[blockY + 1] >> blockX) & 3) << 2);
+					if (!coverage)
+						continue;
+
+					BuildBlock(tri, context.rasterBlock, x + blockX, y + blockY);
+					SetBlockLOD(context);
+
+					const s32 blockLeft = x + blockX;
+					const s32 blockTop = y + blockY;
+					const u32 numCovered = CountSetBits(coverage);
+					context.rasterizedPixels += numCovered;
+
+					s32 z[4];
+					for (s32 i = 0; i < 4; i++)
+						z[i] = GetPixelDepth(tri, blockLeft + (i & 1), blockTop + (i >> 1));
+
+					// The whole block goes through the early depth test at once
+					u32 passed = coverage;
+					if (bpmem.UseEarlyDepthTest() && g_SWVideoConfig.bZComploc)
+					{
+						// TODO: Test if perf regs are incremented even if test is disabled
+						context.tev.PerfPixelCounts[PQ_ZCOMP_INPUT_ZCOMPLOC] += numCovered;
+						if (bpmem.zmode.testenable)
+							passed = EfbInterface::ZCompareQuad(blockLeft, blockTop, z, coverage);
+						context.tev.PerfPixelCounts[PQ_ZCOMP_OUTPUT_ZCOMPLOC] += CountSetBits(passed);
+					}
+
+					// The pixels of a block are distinct, so their TEV stages can run together
+					int numPixels = 0;
+					for (s32 i = 0; i < 4; i++)
+					{
+						if (passed & (1 << i))
+							AddPixel(tri, context, blockLeft + (i & 1), blockTop + (i >> 1), z[i], i & 1, i >> 1, &numPixels);
+					}
+
+					if (numPixels)
+						context.tev.DrawQuad(numPixels);
+				}
+			}
+		}
+	}
+}
+
+static void RasterizeTiles(RasterContext& context)
+{
+	s32 tile;
+	while ((tile = nextTile++) < TILES_X * TILES_Y)
+	{
+		const s32 tileLeft = (tile % TILES_X) * TILE_SIZE;
+		const s32 tileTop = (tile / TILES_X) * TILE_SIZE;
+
+		for (u32 index : tileBins[tile])
+		{
+			const TriangleSetup& tri = binnedTriangles[index];
+			RasterizeTriangle(tri, context,
+				std::max(tri.minx, tileLeft), std::min(tri.maxx, tileLeft + TILE_SIZE),
+				std::max(tri.miny, tileTop), std::min(tri.maxy, tileTop + TILE_SIZE));
+		}
+	}
+}
+
+static void WorkerThread(Worker* worker, int index)
+{
+	Common::SetCurrentThreadName(StringFromFormat("SW Rasterizer %d", index).c_str());
+	FPURoundMode::LoadDefaultSIMDState();
+
+	RasterContext& context = *contexts[index];
+
+	while (true)
+	{
+		worker->startEvent.Wait();
+		if (workersQuit.load())
+			break;
+
+		if (workerJob)
+			(*workerJob)();
+		else
+			RasterizeTiles(context);
+		worker->doneEvent.Set();
+	}
+}
+
+static void DrawBinnedTriangles()
+{
+	if (binnedTriangles.empty())
+		return;
+
+	SWTiming::Scope timing(SWTiming::RASTERIZATION);
+
+	nextTile.store(0);
+	for (auto& worker : workers)
+		worker->startEvent.Set();
+
+	RasterizeTiles(*contexts[0]);
+
+	for (auto& worker : workers)
+		worker->doneEvent.Wait();
+
+	for (auto& bin : tileBins)
+		bin.clear();
+	binnedTriangles.clear();
+}
+
+static bool UseTileBinning()
+{
+	// The debug dumps expect every pixel to be drawn right away on this thread
+	return !workers.empty() &&
+	       !g_SWVideoConfig.bDumpObjects &&
+	       !g_SWVideoConfig.bDumpTevStages &&
+	       !g_SWVideoConfig.bDumpTevTextureFetches;
+}
+
+void Flush()
+{
+	DrawBinnedTriangles();
+
+	if (!countersPending)
+		return;
+
+	for (auto& context : contexts)
+	{
+		context->tev.CommitCounters();
+		ADDSTAT(swstats.thisFrame.rasterizedPixels, context->rasterizedPixels);
+		context->rasterizedPixels = 0;
+	}
+	countersPending = false;
+}
+
+void RunOnAllThreads(const std::function<void()>& job)
+{
+	Flush();
+
+	workerJob = &job;
+	for (auto& worker : workers)
+		worker->startEvent.Set();
+
+	job();
+
+	for (auto& worker : workers)
+		worker->doneEvent.Wait();
+	workerJob = nullptr;
+}
+
+void Init()
+{
+	u32 numThreads = g_SWVideoConfig.numRasterizerThreads;
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	numThreads = MathUtil::Clamp<u32>(numThreads, 1, MAX_THREADS);
+
+	contexts.clear();
+	for (u32 i = 0; i < numThreads; i++)
+	{
+		std::unique_ptr<RasterContext> context = std::make_unique<RasterContext>();
+		context->tev.Init();
+		context->rasterizedPixels = 0;
+		contexts.push_back(std::move(context));
+	}
+
+	// Set initial z reference plane in the unlikely case that zfreeze is enabled when drawing the first primitive.
+	// TODO: This is just a guess!
+	ZSlope.dfdx = ZSlope.dfdy = 0.f;
+	ZSlope.f0 = 1.f;
+
+	binnedTriangles.reserve(MAX_BINNED_TRIANGLES);
+	countersPending = false;
+
+	workersQuit.store(false);
+	workerJob = nullptr;
+	for (u32 i = 1; i < numThreads; i++)
+	{
+		workers.push_back(std::make_unique<Worker>());
+		Worker* worker = workers.back().get();
+		worker->thread = std::thread(WorkerThread, worker, i);
+	}
+}
+
+void Shutdown()
+{
+	workersQuit.store(true);
+	for (auto& worker : workers)
+	{
+		worker->startEvent.Set();
+		worker->thread.join();
+	}
+	workers.clear();
+
+	for (auto& bin : tileBins)
+		bin.clear();
+	binnedTriangles.clear();
+	contexts.clear();
+
+#ifdef _M_X86_64
+	TevJitX64::Shutdown();
+#endif
 }
 
 void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2)
@@ -336,15 +748,6 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	const s32 DY23 = Y2 - Y3;
 	const s32 DY31 = Y3 - Y1;
 
-	// Fixed-pos32 deltas
-	const s32 FDX12 = DX12 * 16;
-	const s32 FDX23 = DX23 * 16;
-	const s32 FDX31 = DX31 * 16;
-
-	const s32 FDY12 = DY12 * 16;
-	const s32 FDY23 = DY23 * 16;
-	const s32 FDY31 = DY31 * 16;
-
 	// Bounding rectangle
 	s32 minx = (std::min(std::min(X1, X2), X3) + 0xF) >> 4;
 	s32 maxx = (std::max(std::max(X1, X2), X3) + 0xF) >> 4;
@@ -360,6 +763,20 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	if (minx >= maxx || miny >= maxy)
 		return;
 
+	const bool binning = UseTileBinning();
+	if (!binning)
+		DrawBinnedTriangles();
+	else if (binnedTriangles.size() >= MAX_BINNED_TRIANGLES)
+		Flush();
+
+	TriangleSetup immediateTri;
+	TriangleSetup* tri = &immediateTri;
+	if (binning)
+	{
+		binnedTriangles.emplace_back();
+		tri = &binnedTriangles.back();
+	}
+
 	// Setup slopes
 	float fltx1 = v0->screenPosition.x;
 	float flty1 = v0->screenPosition.y;
@@ -368,10 +785,10 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	float fltdy12 = flty1 - v1->screenPosition.y;
 	float fltdy31 = v2->screenPosition.y - flty1;
 
-	InitTriangle(fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
+	InitTriangle(tri, fltx1, flty1, (X1 + 0xF) >> 4, (Y1 + 0xF) >> 4);
 
 	float w[3] = { 1.0f / v0->projectedPosition.w, 1.0f / v1->projectedPosition.w, 1.0f / v2->projectedPosition.w };
-	InitSlope(&WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	InitSlope(&tri->WSlope, w[0], w[1], w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 
 	// TODO: The zfreeze emulation is not quite correct, yet!
 	// Many things might prevent us from reaching this line (culling, clipping, scissoring).
@@ -379,110 +796,61 @@ void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVer
 	// We're currently sloppy at this since we abort early if any of the culling/clipping/scissoring tests fail.
 	if (!bpmem.genMode.zfreeze || !g_SWVideoConfig.bZFreeze)
 		InitSlope(&ZSlope, v0->screenPosition[2], v1->screenPosition[2], v2->screenPosition[2], fltdx31, fltdx12, fltdy12, fltdy31);
+	tri->ZSlope = ZSlope;
 
 	for (unsigned int i = 0; i < bpmem.genMode.numcolchans; i++)
 	{
 		for (int comp = 0; comp < 4; comp++)
-			InitSlope(&ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&tri->ColorSlopes[i][comp], v0->color[i][comp], v1->color[i][comp], v2->color[i][comp], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
 	for (unsigned int i = 0; i < bpmem.genMode.numtexgens; i++)
 	{
 		for (int comp = 0; comp < 3; comp++)
-			InitSlope(&TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
+			InitSlope(&tri->TexSlopes[i][comp], v0->texCoords[i][comp] * w[0], v1->texCoords[i][comp] * w[1], v2->texCoords[i][comp] * w[2], fltdx31, fltdx12, fltdy12, fltdy31);
 	}
 
+	tri->DX12 = DX12;
+	tri->DX23 = DX23;
+	tri->DX31 = DX31;
+	tri->DY12 = DY12;
+	tri->DY23 = DY23;
+	tri->DY31 = DY31;
+
 	// Half-edge constants
-	s32 C1 = DY12 * X1 - DX12 * Y1;
-	s32 C2 = DY23 * X2 - DX23 * Y2;
-	s32 C3 = DY31 * X3 - DX31 * Y3;
+	tri->C1 = DY12 * X1 - DX12 * Y1;
+	tri->C2 = DY23 * X2 - DX23 * Y2;
+	tri->C3 = DY31 * X3 - DX31 * Y3;
 
 	// Correct for fill convention
-	if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
-	if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
-	if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
+	if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) tri->C1++;
+	if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) tri->C2++;
+	if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) tri->C3++;
 
 	// Start in corner of 8x8 block
 	minx &= ~(BLOCK_SIZE - 1);
 	miny &= ~(BLOCK_SIZE - 1);
 
-	// Loop through blocks
-	for (s32 y = miny; y < maxy; y += BLOCK_SIZE)
-	{
-		for (s32 x = minx; x < maxx; x += BLOCK_SIZE)
-		{
-			// Corners of block
-			s32 x0 = x << 4;
-			s32 x1 = (x + BLOCK_SIZE - 1) << 4;
-			s32 y0 = y << 4;
-			s32 y1 = (y + BLOCK_SIZE - 1) << 4;
-
-			// Evaluate half-space functions
-			bool a00 = C1 + DX12 * y0 - DY12 * x0 > 0;
-			bool a10 = C1 + DX12 * y0 - DY12 * x1 > 0;
-			bool a01 = C1 + DX12 * y1 - DY12 * x0 > 0;
-			bool a11 = C1 + DX12 * y1 - DY12 * x1 > 0;
-			int a = (a00 << 0) | (a10 << 1) | (a01 << 2) | (a11 << 3);
-
-			bool b00 = C2 + DX23 * y0 - DY23 * x0 > 0;
-			bool b10 = C2 + DX23 * y0 - DY23 * x1 > 0;
-			bool b01 = C2 + DX23 * y1 - DY23 * x0 > 0;
-			bool b11 = C2 + DX23 * y1 - DY23 * x1 > 0;
-			int b = (b00 << 0) | (b10 << 1) | (b01 << 2) | (b11 << 3);
-
-			bool c00 = C3 + DX31 * y0 - DY31 * x0 > 0;
-			bool c10 = C3 + DX31 * y0 - DY31 * x1 > 0;
-			bool c01 = C3 + DX31 * y1 - DY31 * x0 > 0;
-			bool c11 = C3 + DX31 * y1 - DY31 * x1 > 0;
-			int c = (c00 << 0) | (c10 << 1) | (c01 << 2) | (c11 << 3);
-
-			// Skip block when outside an edge
-			if (a == 0x0 || b == 0x0 || c == 0x0)
-				continue;
-
-			BuildBlock(x, y);
+	tri->minx = minx;
+	tri->maxx = maxx;
+	tri->miny = miny;
+	tri->maxy = maxy;
 
-			// Accept whole block when totally covered
-			if (a == 0xF && b == 0xF && c == 0xF)
-			{
-				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-				{
-					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-					{
-						Draw(x + ix, y + iy, ix, iy);
-					}
-				}
-			}
-			else // Partially covered block
-			{
-				s32 CY1 = C1 + DX12 * y0 - DY12 * x0;
-				s32 CY2 = C2 + DX23 * y0 - DY23 * x0;
-				s32 CY3 = C3 + DX31 * y0 - DY31 * x0;
+	countersPending = true;
 
-				for (s32 iy = 0; iy < BLOCK_SIZE; iy++)
-				{
-					s32 CX1 = CY1;
-					s32 CX2 = CY2;
-					s32 CX3 = CY3;
-
-					for (s32 ix = 0; ix < BLOCK_SIZE; ix++)
-					{
-						if (CX1 > 0 && CX2 > 0 && CX3 > 0)
-						{
-							Draw(x + ix, y + iy, ix, iy);
-						}
-
-						CX1 -= FDY12;
-						CX2 -= FDY23;
-						CX3 -= FDY31;
-					}
+	if (!binning)
+	{
+		SWTiming::Scope timing(SWTiming::RASTERIZATION);
+		RasterizeTriangle(*tri, *contexts[0], minx, maxx, miny, maxy);
+		return;
+	}
 
-					CY1 += FDX12;
-					CY2 += FDX23;
-					CY3 += FDX31;
-				}
-			}
-		}
+	// Blocks are never split between tiles, as the tile size is a multiple of the block size
+	const u32 index = (u32)(binnedTriangles.size() - 1);
+	for (s32 tileY = miny / TILE_SIZE; tileY <= (maxy - 1) / TILE_SIZE; tileY++)
+	{
+		for (s32 tileX = minx / TILE_SIZE; tileX <= (maxx - 1) / TILE_SIZE; tileX++)
+			tileBins[tileY * TILES_X + tileX].push_back(index);
 	}
 }
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Common/ChunkFile.h"
 
 struct OutputVertexData;
@@ -11,9 +13,18 @@ struct OutputVertexData;
 namespace Rasterizer
 {
 	void Init();
+	void Shutdown();
 
 	void DrawTriangleFrontFace(OutputVertexData *v0, OutputVertexData *v1, OutputVertexData *v2);
 
+	// Finishes drawing all triangles that have been queued up for the rasterizer threads.
+	// Must be called before anything the rasterizer depends on or writes to is accessed.
+	void Flush();
+
+	// Runs the job once on the GPU thread and once on every rasterizer thread, and waits for all of
+	// them to finish. The job is responsible for splitting up its work between the threads.
+	void RunOnAllThreads(const std::function<void()>& job);
+
 	void SetScissor();
 
 	void SetTevReg(int reg, int comp, bool konst, s16 color);
@@ -24,7 +35,7 @@ namespace Rasterizer
 		float dfdy;
 		float f0;
 
-		float GetValue(float dx, float dy) { return f0 + (dfdx * dx) + (dfdy * dy); }
+		float GetValue(float dx, float dy) const { return f0 + (dfdx * dx) + (dfdy * dy); }
 		void DoState(PointerWrap &p)
 		{
 			p.Do(dfdx);
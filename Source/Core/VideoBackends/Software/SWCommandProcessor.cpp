@@ -18,7 +18,9 @@
 #include "Core/HW/ProcessorInterface.h"
 
 #include "VideoBackends/Software/OpcodeDecoder.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/SWCommandProcessor.h"
+#include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/VideoBackend.h"
 
 #include "VideoCommon/Fifo.h"
@@ -303,6 +305,8 @@ static void SetStatus()
 
 bool RunBuffer()
 {
+	SWTiming::Scope timing(SWTiming::OPCODE_DECODE);
+
 	// fifo is read 32 bytes at a time
 	// read fifo data to internal buffer
 	if (cpreg.ctrl.GPReadEnable)
@@ -328,6 +332,10 @@ bool RunBuffer()
 		availableBytes = writePos - readPos;
 	}
 
+	// Draw everything before running out of commands, the CPU might be waiting to read the results
+	if (!cpreg.ctrl.GPReadEnable || AtBreakpoint() || cpreg.readptr == cpreg.writeptr)
+		Rasterizer::Flush();
+
 	cpreg.status.CommandIdle = 1;
 
 	bool ranDecoder = false;
@@ -4,10 +4,14 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cinttypes>
 #include <mutex>
 #include <string>
 
 #include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
 #include "Common/StringUtil.h"
 
 #include "Core/Core.h"
@@ -16,6 +20,7 @@
 #include "VideoBackends/Software/SWOGLWindow.h"
 #include "VideoBackends/Software/SWRenderer.h"
 #include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
 
 #include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/OnScreenDisplay.h"
@@ -27,6 +32,8 @@ static std::atomic<bool> s_bScreenshot;
 static std::mutex s_criticalScreenshot;
 static std::string s_sScreenshotName;
 
+static File::IOFile s_frameHashFile;
+
 void SWRenderer::Init()
 {
 	s_bScreenshot.store(false);
@@ -36,6 +43,8 @@ void SWRenderer::Shutdown()
 {
 	delete[] s_xfbColorTexture[0];
 	delete[] s_xfbColorTexture[1];
+
+	s_frameHashFile.Close();
 }
 
 void SWRenderer::Prepare()
@@ -44,6 +53,9 @@ void SWRenderer::Prepare()
 	s_xfbColorTexture[1] = new u8[MAX_XFB_WIDTH * MAX_XFB_HEIGHT * 4];
 
 	s_currentColorTexture = 0;
+
+	if (!g_SWVideoConfig.sFrameHashFile.empty() && !s_frameHashFile.Open(g_SWVideoConfig.sFrameHashFile, "w"))
+		ERROR_LOG(VIDEO, "Failed to open frame hash file %s", g_SWVideoConfig.sFrameHashFile.c_str());
 }
 
 void SWRenderer::SetScreenshot(const char *_szFilename)
@@ -137,6 +149,34 @@ void SWRenderer::UpdateColorTexture(EfbInterface::yuv422_packed *xfb, u32 fbWidt
 	SwapColorTexture();
 }
 
+// Hashes are compared between different machines, so this has to give the same hash on all of them
+static u64 HashFrame(const u8* data, u32 size)
+{
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+	if (cpu_info.bAVX2)
+		return GetWideHash64AVX2(data, size, 0);
+#endif
+	return GetWideHash64(data, size, 0);
+}
+
+static void WriteFrameHash(u32 fbWidth, u32 fbHeight)
+{
+	u8* frame = SWRenderer::GetCurrentColorTexture();
+	u64 hash = HashFrame(frame, fbWidth * fbHeight * 4);
+
+	std::string line = StringFromFormat("%u %ux%u %016" PRIx64 "\n", swstats.frameCount, fbWidth, fbHeight, hash);
+	s_frameHashFile.WriteBytes(line.data(), line.size());
+	s_frameHashFile.Flush(); // keep what has been written if the run is killed
+
+	if (g_SWVideoConfig.bDumpHashedFrames)
+	{
+		// Frames are only written once, most of them repeat across frames or runs
+		std::string filename = StringFromFormat("%s%016" PRIx64 ".png", File::GetUserPath(D_DUMPFRAMES_IDX).c_str(), hash);
+		if (!File::Exists(filename) && File::CreateFullPath(filename))
+			TextureToPng(frame, fbWidth * 4, filename, fbWidth, fbHeight, false);
+	}
+}
+
 // Called on the GPU thread
 void SWRenderer::Swap(u32 fbWidth, u32 fbHeight)
 {
@@ -150,11 +190,18 @@ void SWRenderer::Swap(u32 fbWidth, u32 fbHeight)
 		s_bScreenshot.store(false);
 	}
 
+	if (s_frameHashFile.IsOpen())
+		WriteFrameHash(fbWidth, fbHeight);
+
 	OSD::DoCallbacks(OSD::OSD_ONFRAME);
 
-	DrawDebugText();
+	// There is no window in headless mode
+	if (SWOGLWindow::s_instance)
+	{
+		DrawDebugText();
 
-	SWOGLWindow::s_instance->ShowImage(GetCurrentColorTexture(), fbWidth * 4, fbWidth, fbHeight, 1.0);
+		SWOGLWindow::s_instance->ShowImage(GetCurrentColorTexture(), fbWidth * 4, fbWidth, fbHeight, 1.0);
+	}
 
 	swstats.frameCount++;
 	swstats.ResetFrame();
@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <cstring>
 #include "VideoBackends/Software/SWStatistics.h"
 
@@ -16,3 +17,38 @@ void SWStatistics::ResetFrame()
 {
 	memset(&thisFrame, 0, sizeof(ThisFrame));
 }
+
+namespace SWTiming
+{
+
+static u64 s_totals[NUM_STAGES];
+static Stage s_current = NONE;
+static std::chrono::steady_clock::time_point s_stageStart = std::chrono::steady_clock::now();
+
+// Adds the time since the last switch to the current stage
+static void Switch(Stage stage)
+{
+	auto now = std::chrono::steady_clock::now();
+	s_totals[s_current] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - s_stageStart).count();
+	s_stageStart = now;
+	s_current = stage;
+}
+
+void GetTotals(u64 totals[NUM_STAGES])
+{
+	Switch(s_current);
+	memcpy(totals, s_totals, sizeof(s_totals));
+}
+
+Scope::Scope(Stage stage)
+	: m_previous(s_current)
+{
+	Switch(stage);
+}
+
+Scope::~Scope()
+{
+	Switch(m_previous);
+}
+
+}
@@ -36,6 +36,37 @@ struct SWStatistics
 
 extern SWStatistics swstats;
 
+// Time spent on the GPU thread in the parts of the pipeline, for benchmarking.
+// Kept apart from swstats, as it isn't part of the savestates.
+namespace SWTiming
+{
+	enum Stage
+	{
+		NONE,
+		OPCODE_DECODE,
+		VERTEX_LOADING,
+		TEXTURE_DECODE,
+		RASTERIZATION,
+		NUM_STAGES
+	};
+
+	// Total time spent in every stage since the backend was started, in nanoseconds.
+	// Must be called on the GPU thread, or while it is idle.
+	void GetTotals(u64 totals[NUM_STAGES]);
+
+	// Attributes the time until it goes out of scope to the given stage, instead of to the
+	// stage which was running before. Only for the GPU thread.
+	class Scope
+	{
+	public:
+		explicit Scope(Stage stage);
+		~Scope();
+
+	private:
+		Stage m_previous;
+	};
+}
+
 #if (STATISTICS)
 #define INCSTAT(a) (a)++;
 #define ADDSTAT(a,b) (a)+=(b);
@@ -0,0 +1,272 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Hash.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/Memmap.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWTextureCache.h"
+#include "VideoBackends/Software/TextureSampler.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace SWTextureCache
+{
+
+// Same as TextureCacheBase, some games cycle through the same textures over many frames
+static const u32 TEXTURE_KILL_THRESHOLD = 64;
+
+// Marks texture addresses which point into TMEM instead of main memory
+static const u32 TMEM_ADDRESS_FLAG = 0x80000000;
+
+struct CacheKey
+{
+	u32 address;
+	u32 format; // texture format, and TLUT format for palette textures
+	u32 size;   // raw width and height fields of TexImage0
+	u32 numLevels;
+	u64 hash;
+
+	bool operator<(const CacheKey& other) const
+	{
+		return std::tie(address, format, size, numLevels, hash) <
+		       std::tie(other.address, other.format, other.size, other.numLevels, other.hash);
+	}
+
+	// Whether both keys describe the same texture, maybe with different contents
+	bool SameTexture(const CacheKey& other) const
+	{
+		return address == other.address && format == other.format &&
+		       size == other.size && numLevels == other.numLevels;
+	}
+};
+
+struct CacheEntry
+{
+	std::vector<Level> levels;
+	u32 frameCount;
+};
+
+static std::map<CacheKey, CacheEntry> s_textures;
+static const CacheEntry* s_bound[8];
+static bool s_boundValid;
+static u32 s_lastCleanupFrame;
+
+void Init()
+{
+	SetHash64Function();
+	s_textures.clear();
+	std::fill(std::begin(s_bound), std::end(s_bound), nullptr);
+	s_boundValid = false;
+	s_lastCleanupFrame = swstats.frameCount;
+}
+
+void Shutdown()
+{
+	std::fill(std::begin(s_bound), std::end(s_bound), nullptr);
+	s_boundValid = false;
+	s_textures.clear();
+}
+
+static bool IsPaletteFormat(u32 format)
+{
+	return format == GX_TF_C4 || format == GX_TF_C8 || format == GX_TF_C14X2;
+}
+
+// The mip levels which TextureSampler::Sample() can pick with the current LOD settings
+static u32 GetNumLevels(const TexMode0& tm0, const TexMode1& tm1, const TexImage0& ti0)
+{
+	if (!(tm0.min_filter & 3))
+		return 1;
+
+	u32 maxLevel = (tm1.max_lod + 0xf) >> 4;
+	u32 chainLength = IntLog2(std::max<u32>(ti0.width, ti0.height) + 1) + 1;
+	return std::min(maxLevel + 1, chainLength);
+}
+
+static void DecodeLevel(Level* level, const u8* src, const u8* srcOdd, int imageWidth, int imageHeight,
+                        int format, const u8* tlut, TlutFormat tlutfmt)
+{
+	level->width = imageWidth + 1;
+	level->height = imageHeight + 1;
+	level->texels.resize(level->width * level->height);
+
+	// Uses the same decoder as the sampler, so the cached texels are exactly what it would have fetched
+	u8* dst = (u8*)level->texels.data();
+	for (int t = 0; t <= imageHeight; t++)
+	{
+		for (int s = 0; s <= imageWidth; s++)
+		{
+			if (srcOdd)
+				TexDecoder_DecodeTexelRGBA8FromTmem(dst, src, srcOdd, s, t, imageWidth);
+			else
+				TexDecoder_DecodeTexel(dst, src, s, t, imageWidth, format, tlut, tlutfmt);
+			dst += 4;
+		}
+	}
+}
+
+static const CacheEntry* LookupTexture(u32 texmap)
+{
+	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
+	u8 subTexmap = texmap & 3;
+
+	const TexMode0& tm0 = texUnit.texMode0[subTexmap];
+	const TexMode1& tm1 = texUnit.texMode1[subTexmap];
+	const TexImage0& ti0 = texUnit.texImage0[subTexmap];
+	const TexTLUT& texTlut = texUnit.texTlut[subTexmap];
+	const TlutFormat tlutfmt = (TlutFormat)texTlut.tlut_format;
+	const bool fromTmem = texUnit.texImage1[subTexmap].image_type != 0;
+
+	CacheKey key;
+	key.format = ti0.format;
+	key.size = ti0.width | (ti0.height << 10);
+	key.numLevels = GetNumLevels(tm0, tm1, ti0);
+
+	const u32 lastLevel = key.numLevels - 1;
+	const int bsw = TexDecoder_GetBlockWidthInTexels(ti0.format);
+	const int bsh = TexDecoder_GetBlockHeightInTexels(ti0.format);
+	u32 dataSize = TextureSampler::GetMipOffset(ti0.width, ti0.height, lastLevel, ti0.format) +
+		TexDecoder_GetTextureSizeInBytes(ROUND_UP((ti0.width >> lastLevel) + 1, bsw),
+		                                 ROUND_UP((ti0.height >> lastLevel) + 1, bsh), ti0.format);
+
+	const u8* src;
+	const u8* srcOdd = nullptr;
+	if (fromTmem)
+	{
+		u32 evenOffset = texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE;
+		src = &texMem[evenOffset];
+		key.address = TMEM_ADDRESS_FLAG | texUnit.texImage1[subTexmap].tmem_even;
+
+		u32 tmemSize = TMEM_SIZE - evenOffset;
+		if (ti0.format == GX_TF_RGBA8)
+		{
+			u32 oddOffset = texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE;
+			srcOdd = &texMem[oddOffset];
+			key.address |= texUnit.texImage2[subTexmap].tmem_odd << 16;
+			tmemSize = std::min<u32>(tmemSize, TMEM_SIZE - oddOffset);
+		}
+		dataSize = std::min(dataSize, tmemSize);
+	}
+	else
+	{
+		key.address = texUnit.texImage3[subTexmap].image_base << 5;
+		src = Memory::GetPointer(key.address);
+		if (!src)
+			return nullptr;
+	}
+
+	// Hashed the same way as in TextureCacheBase, but always looking at all of the data
+	key.hash = GetHash64(src, dataSize, 0);
+	if (srcOdd)
+		key.hash ^= GetHash64(srcOdd, dataSize, 0);
+
+	const u8* tlut = &texMem[texTlut.tmem_offset << 9];
+	if (IsPaletteFormat(ti0.format))
+	{
+		key.format |= tlutfmt << 8;
+		key.hash ^= GetHash64(tlut, TexDecoder_GetPaletteSize(ti0.format), 0);
+	}
+
+	auto it = s_textures.find(key);
+	if (it != s_textures.end())
+	{
+		it->second.frameCount = swstats.frameCount;
+		return &it->second;
+	}
+
+	// The texture at this address has changed, old versions which haven't been used in this frame
+	// are unlikely to come back.
+	for (auto old = s_textures.lower_bound({ key.address, key.format, key.size, key.numLevels, 0 });
+	     old != s_textures.end() && old->first.SameTexture(key);)
+	{
+		bool bound = std::find(std::begin(s_bound), std::end(s_bound), &old->second) != std::end(s_bound);
+		if (old->second.frameCount != swstats.frameCount && !bound)
+			old = s_textures.erase(old);
+		else
+			++old;
+	}
+
+	CacheEntry& entry = s_textures[key];
+	entry.frameCount = swstats.frameCount;
+	entry.levels.resize(key.numLevels);
+	for (u32 mip = 0; mip < key.numLevels; mip++)
+	{
+		u32 offset = TextureSampler::GetMipOffset(ti0.width, ti0.height, mip, ti0.format);
+		DecodeLevel(&entry.levels[mip], src + offset, srcOdd, ti0.width >> mip, ti0.height >> mip,
+		            ti0.format, tlut, tlutfmt);
+	}
+
+	return &entry;
+}
+
+static void Cleanup()
+{
+	for (auto it = s_textures.begin(); it != s_textures.end();)
+	{
+		if (it->second.frameCount + TEXTURE_KILL_THRESHOLD < swstats.frameCount)
+			it = s_textures.erase(it);
+		else
+			++it;
+	}
+}
+
+void BindTextures()
+{
+	// Hashing large textures for every primitive of a draw batch costs more than drawing them
+	if (s_boundValid)
+		return;
+	s_boundValid = true;
+
+	SWTiming::Scope timing(SWTiming::TEXTURE_DECODE);
+
+	bool used[8] = {};
+	for (u32 i = 0; i <= bpmem.genMode.numtevstages; i++)
+	{
+		TwoTevStageOrders& order = bpmem.tevorders[i >> 1];
+		if (order.getEnable(i & 1))
+			used[order.getTexMap(i & 1)] = true;
+	}
+	for (u32 i = 0; i < bpmem.genMode.numindstages; i++)
+		used[bpmem.tevindref.getTexMap(i)] = true;
+
+	const CacheEntry* textures[8];
+	for (u32 texmap = 0; texmap < 8; texmap++)
+		textures[texmap] = used[texmap] ? LookupTexture(texmap) : nullptr;
+
+	// Triangles which are still queued up have to be drawn with the textures they were submitted with
+	if (!std::equal(std::begin(textures), std::end(textures), std::begin(s_bound)))
+	{
+		Rasterizer::Flush();
+		std::copy(std::begin(textures), std::end(textures), std::begin(s_bound));
+	}
+
+	if (swstats.frameCount != s_lastCleanupFrame)
+	{
+		Cleanup();
+		s_lastCleanupFrame = swstats.frameCount;
+	}
+}
+
+void InvalidateBindings()
+{
+	s_boundValid = false;
+}
+
+const Level* GetLevel(u32 texmap, u32 mip)
+{
+	const CacheEntry* entry = s_bound[texmap];
+	if (!entry || mip >= entry->levels.size())
+		return nullptr;
+	return &entry->levels[mip];
+}
+
+}
@@ -0,0 +1,43 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Keeps decoded copies of the textures used by the software renderer, so TextureSampler
+// doesn't need to decode every texel it fetches from the raw texture format again.
+//
+// Textures are looked up by their hash, so changes made to the texture data by the CPU or by
+// EFB copies are picked up. Like TextureCacheBase, which only loads textures when the vertex
+// manager flushes, that doesn't happen for every primitive, but only after BP writes.
+namespace SWTextureCache
+{
+
+struct Level
+{
+	u32 width;
+	u32 height;
+	std::vector<u32> texels; // RGBA8, in the byte order of TexDecoder_DecodeTexel
+};
+
+void Init();
+void Shutdown();
+
+// Looks up the textures read by the current TEV configuration, decoding them if necessary.
+// Must be called on the GPU thread before a new primitive is drawn.
+void BindTextures();
+
+// Makes the next BindTextures() look the textures up again. Called for every BP write, as
+// those set up the textures, load TMEM and trigger the EFB copies and texture invalidations
+// which come with new texture data.
+void InvalidateBindings();
+
+// Returns the given mip level of the texture bound to texmap, or nullptr if there is none.
+// Only reads data which doesn't change while the rasterizer threads are running.
+const Level* GetLevel(u32 texmap, u32 mip);
+
+}
@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 
 #include "Common/ChunkFile.h"
@@ -21,9 +23,11 @@
 
 
 SWVertexLoader::SWVertexLoader() :
-	m_VertexSize(0)
+	m_VertexSize(0), m_UseVertexCache(false), m_CacheGeneration(0)
 {
 	m_SetupUnit = new SetupUnit;
+	for (CacheEntry& entry : m_VertexCache)
+		entry.generation = 0;
 }
 
 SWVertexLoader::~SWVertexLoader()
@@ -81,6 +85,15 @@ void SWVertexLoader::SetFormat(u8 attributeIndex, u8 primitiveType)
 		(xfmem.texMtxInfo[0].projection == XF_TEXPROJ_ST);
 
 	m_SetupUnit->Init(primitiveType);
+
+	// Only indexed vertices are likely to repeat. Starting a new generation drops all cached vertices.
+	m_UseVertexCache = (g_main_cp_state.vtx_desc.Position & 2) && m_VertexSize <= MAX_CACHE_KEY_SIZE;
+	if (++m_CacheGeneration == 0)
+	{
+		for (CacheEntry& entry : m_VertexCache)
+			entry.generation = 0;
+		m_CacheGeneration = 1;
+	}
 }
 
 template <typename T, typename I>
@@ -136,74 +149,153 @@ static void ReadVertexAttribute(T* dst, DataReader src, const AttributeFormat& f
 	}
 }
 
-void SWVertexLoader::ParseVertex(const PortableVertexDeclaration& vdec)
+void SWVertexLoader::ParseVertex(const PortableVertexDeclaration& vdec, u8* data, InputVertexData* vertex)
 {
-	DataReader src(m_LoadedVertices.data(), m_LoadedVertices.data() + m_LoadedVertices.size());
+	DataReader src(data, data + vdec.stride);
 
-	ReadVertexAttribute<float>(&m_Vertex.position[0], src, vdec.position, 0, 3, false);
+	ReadVertexAttribute<float>(&vertex->position[0], src, vdec.position, 0, 3, false);
 
 	for (int i = 0; i < 3; i++)
 	{
-		ReadVertexAttribute<float>(&m_Vertex.normal[i][0], src, vdec.normals[i], 0, 3, false);
+		ReadVertexAttribute<float>(&vertex->normal[i][0], src, vdec.normals[i], 0, 3, false);
 	}
 
 	for (int i = 0; i < 2; i++)
 	{
-		ReadVertexAttribute<u8>(m_Vertex.color[i], src, vdec.colors[i], 0, 4, true);
+		ReadVertexAttribute<u8>(vertex->color[i], src, vdec.colors[i], 0, 4, true);
 	}
 
 	for (int i = 0; i < 8; i++)
 	{
-		ReadVertexAttribute<float>(m_Vertex.texCoords[i], src, vdec.texcoords[i], 0, 2, false);
+		ReadVertexAttribute<float>(vertex->texCoords[i], src, vdec.texcoords[i], 0, 2, false);
 
 		// the texmtr is stored as third component of the texCoord
 		if (vdec.texcoords[i].components >= 3)
 		{
-			ReadVertexAttribute<u8>(&m_Vertex.texMtx[i], src, vdec.texcoords[i], 2, 1, false);
+			ReadVertexAttribute<u8>(&vertex->texMtx[i], src, vdec.texcoords[i], 2, 1, false);
 		}
 	}
 
-	ReadVertexAttribute<u8>(&m_Vertex.posMtx, src, vdec.posmtx, 0, 1, false);
+	ReadVertexAttribute<u8>(&vertex->posMtx, src, vdec.posmtx, 0, 1, false);
+}
+
+static u32 HashVertex(const u8* data, u32 size)
+{
+	u32 hash = 0;
+	for (u32 i = 0; i < size; i++)
+		hash = hash * 31 + data[i];
+	return hash * 0x9E3779B1;
 }
 
-void SWVertexLoader::LoadVertex()
+void SWVertexLoader::LoadBatch(u32 count)
 {
 	const PortableVertexDeclaration& vdec = m_CurrentLoader->m_native_vtx_decl;
 
-	// reserve memory for the destination of the vertex loader
-	m_LoadedVertices.resize(vdec.stride + 4);
+	// the vertices of the batch in drawing order, with the ones loaded in this batch in m_Outputs
+	OutputVertexData* vertices[TransformUnit::MAX_BATCH_SIZE];
+	CacheEntry* cacheEntries[TransformUnit::MAX_BATCH_SIZE];
+	u32 numVertices = 0;
+	u32 numLoaded = 0;
 
-	VertexLoaderManager::UpdateVertexArrayPointers();
+	if (!m_UseVertexCache)
+	{
+		// convert the vertices from the gc format to the videocommon (hardware optimized) format
+		u8* old = g_video_buffer_read_ptr;
+		numLoaded = m_CurrentLoader->RunVertices(
+			DataReader(g_video_buffer_read_ptr, nullptr), // src
+			DataReader(m_LoadedVertices.data(), m_LoadedVertices.data() + m_LoadedVertices.size()), // dst
+			count // vertices
+		);
+		g_video_buffer_read_ptr = old + count * m_VertexSize;
+
+		for (u32 i = 0; i < numLoaded; i++)
+			vertices[numVertices++] = &m_Outputs[i];
+	}
+	else
+	{
+		u8* start = g_video_buffer_read_ptr;
+		for (u32 i = 0; i < count; i++)
+		{
+			u8* src = start + i * m_VertexSize;
+
+			CacheEntry& entry = m_VertexCache[HashVertex(src, m_VertexSize) >> (32 - VERTEX_CACHE_BITS)];
+			if (entry.generation == m_CacheGeneration && memcmp(entry.key, src, m_VertexSize) == 0)
+			{
+				vertices[numVertices++] = entry.pending ? entry.pending : &entry.vertex;
+				continue;
+			}
+
+			u8* dst = &m_LoadedVertices[numLoaded * vdec.stride];
+			if (m_CurrentLoader->RunVertices(DataReader(src, nullptr), DataReader(dst, dst + vdec.stride + 4), 1) == 0)
+				continue;
+
+			// The old vertex in this entry stays valid until the whole batch has been drawn
+			entry.generation = m_CacheGeneration;
+			memcpy(entry.key, src, m_VertexSize);
+			entry.pending = &m_Outputs[numLoaded];
+			cacheEntries[numLoaded] = &entry;
+
+			vertices[numVertices++] = &m_Outputs[numLoaded++];
+		}
+		g_video_buffer_read_ptr = start + count * m_VertexSize;
+	}
+
+	if (numLoaded > 0)
+	{
+		// parse the videocommon format to our own struct format, attributes which aren't part of the
+		// vertex format keep the values of the last vertex which had them
+		for (u32 i = 0; i < numLoaded; i++)
+		{
+			m_Inputs[i] = m_Vertex;
+			ParseVertex(vdec, &m_LoadedVertices[i * vdec.stride], &m_Inputs[i]);
+		}
+		m_Vertex = m_Inputs[numLoaded - 1];
+
+		// transform the vertices so that they can be used for rasterization
+		TransformUnit::TransformVertices(m_Inputs, m_Outputs, numLoaded,
+			g_main_cp_state.vtx_desc.Normal != NOT_PRESENT, m_CurrentVat->g0.NormalElements, m_TexGenSpecialCase);
+	}
 
-	// convert the vertex from the gc format to the videocommon (hardware optimized) format
-	u8* old = g_video_buffer_read_ptr;
-	int converted_vertices = m_CurrentLoader->RunVertices(
-		DataReader(g_video_buffer_read_ptr, nullptr), // src
-		DataReader(m_LoadedVertices.data(), m_LoadedVertices.data() + m_LoadedVertices.size()), // dst
-		1 // vertices
-	);
-	g_video_buffer_read_ptr = old + m_CurrentLoader->m_VertexSize;
-
-	if (converted_vertices == 0)
-		return;
-
-	// parse the videocommon format to our own struct format (m_Vertex)
-	ParseVertex(vdec);
-
-	// transform this vertex so that it can be used for rasterization (outVertex)
-	OutputVertexData* outVertex = m_SetupUnit->GetVertex();
-	TransformUnit::TransformPosition(&m_Vertex, outVertex);
-	if (g_main_cp_state.vtx_desc.Normal != NOT_PRESENT)
+	// assemble and rasterize the primitives
+	for (u32 i = 0; i < numVertices; i++)
 	{
-		TransformUnit::TransformNormal(&m_Vertex, m_CurrentVat->g0.NormalElements, outVertex);
+		*m_SetupUnit->GetVertex() = *vertices[i];
+		m_SetupUnit->SetupVertex();
+
+		INCSTAT(swstats.thisFrame.numVerticesLoaded)
+	}
+
+	if (m_UseVertexCache)
+	{
+		for (u32 i = 0; i < numLoaded; i++)
+		{
+			CacheEntry* entry = cacheEntries[i];
+			if (entry->pending == &m_Outputs[i])
+			{
+				entry->vertex = m_Outputs[i];
+				entry->pending = nullptr;
+			}
+		}
 	}
-	TransformUnit::TransformColor(&m_Vertex, outVertex);
-	TransformUnit::TransformTexCoord(&m_Vertex, outVertex, m_TexGenSpecialCase);
+}
+
+void SWVertexLoader::LoadVertices(u32 count)
+{
+	SWTiming::Scope timing(SWTiming::VERTEX_LOADING);
 
-	// assemble and rasterize the primitive
-	m_SetupUnit->SetupVertex();
+	const PortableVertexDeclaration& vdec = m_CurrentLoader->m_native_vtx_decl;
 
-	INCSTAT(swstats.thisFrame.numVerticesLoaded)
+	// reserve memory for the destination of the vertex loader
+	m_LoadedVertices.resize(vdec.stride * TransformUnit::MAX_BATCH_SIZE + 4);
+
+	VertexLoaderManager::UpdateVertexArrayPointers();
+
+	while (count > 0)
+	{
+		u32 batchSize = std::min<u32>(count, TransformUnit::MAX_BATCH_SIZE);
+		LoadBatch(batchSize);
+		count -= batchSize;
+	}
 }
 
 void SWVertexLoader::DoState(PointerWrap &p)
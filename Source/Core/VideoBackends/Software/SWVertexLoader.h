@@ -6,11 +6,13 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 
 #include "VideoBackends/Software/CPMemLoader.h"
 #include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/TransformUnit.h"
 
 #include "VideoCommon/VertexLoaderBase.h"
 
@@ -19,13 +21,32 @@ class SetupUnit;
 
 class SWVertexLoader
 {
+	// Post-transform vertex cache. Within one primitive, vertices with the same indices always
+	// transform to the same output, so indexed vertices are looked up by their raw data.
+	// It's reset for every primitive, as the vertex arrays and the XF state may change in between.
+	enum
+	{
+		VERTEX_CACHE_BITS = 8,
+		VERTEX_CACHE_SIZE = 1 << VERTEX_CACHE_BITS,
+		MAX_CACHE_KEY_SIZE = 16
+	};
+
+	struct CacheEntry
+	{
+		u32 generation;
+		u8 key[MAX_CACHE_KEY_SIZE];
+		OutputVertexData* pending; // set while the vertex is transformed as part of the current batch
+		OutputVertexData vertex;
+	};
+
 	u32 m_VertexSize;
 
 	VAT* m_CurrentVat;
 
 	InputVertexData m_Vertex;
 
-	void ParseVertex(const PortableVertexDeclaration& vdec);
+	void ParseVertex(const PortableVertexDeclaration& vdec, u8* data, InputVertexData* vertex);
+	void LoadBatch(u32 count);
 
 	SetupUnit *m_SetupUnit;
 
@@ -37,6 +58,13 @@ class SWVertexLoader
 
 	u8 m_attributeIndex;
 
+	InputVertexData m_Inputs[TransformUnit::MAX_BATCH_SIZE];
+	OutputVertexData m_Outputs[TransformUnit::MAX_BATCH_SIZE];
+
+	bool m_UseVertexCache;
+	u32 m_CacheGeneration;
+	CacheEntry m_VertexCache[VERTEX_CACHE_SIZE];
+
 public:
 	SWVertexLoader();
 	~SWVertexLoader();
@@ -45,6 +73,7 @@ public:
 
 	u32 GetVertexSize() { return m_VertexSize; }
 
-	void LoadVertex();
+	// Loads, transforms and draws the next count vertices of the current primitive
+	void LoadVertices(u32 count);
 	void DoState(PointerWrap &p);
 };
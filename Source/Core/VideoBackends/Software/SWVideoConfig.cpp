@@ -13,6 +13,7 @@ SWVideoConfig::SWVideoConfig()
 	bFullscreen = false;
 	bHideCursor = false;
 	renderToMainframe = false;
+	bHeadless = false;
 
 	bBypassXFB = false;
 
@@ -20,10 +21,14 @@ SWVideoConfig::SWVideoConfig()
 
 	bDumpTextures = false;
 	bDumpObjects = false;
+	bDumpHashedFrames = false;
 
 	bZComploc = true;
 	bZFreeze = true;
 
+	numRasterizerThreads = 0;
+	bJitTev = true;
+
 	bDumpTevStages = false;
 	bDumpTevTextureFetches = false;
 
@@ -39,11 +44,14 @@ void SWVideoConfig::Load(const char* ini_file)
 	IniFile::Section* hardware = iniFile.GetOrCreateSection("Hardware");
 	hardware->Get("Fullscreen", &bFullscreen, 0); // Hardware
 	hardware->Get("RenderToMainframe", &renderToMainframe, false);
+	hardware->Get("Headless", &bHeadless, false);
 
 	IniFile::Section* rendering = iniFile.GetOrCreateSection("Rendering");
 	rendering->Get("BypassXFB", &bBypassXFB, false);
 	rendering->Get("ZComploc", &bZComploc, true);
 	rendering->Get("ZFreeze", &bZFreeze, true);
+	rendering->Get("RasterizerThreads", &numRasterizerThreads, 0);
+	rendering->Get("JitTev", &bJitTev, true);
 
 	IniFile::Section* info = iniFile.GetOrCreateSection("Info");
 	info->Get("ShowStats", &bShowStats, false);
@@ -53,6 +61,8 @@ void SWVideoConfig::Load(const char* ini_file)
 	utility->Get("DumpObjects", &bDumpObjects, false);
 	utility->Get("DumpTevStages", &bDumpTevStages, false);
 	utility->Get("DumpTevTexFetches", &bDumpTevTextureFetches, false);
+	utility->Get("FrameHashFile", &sFrameHashFile, "");
+	utility->Get("DumpHashedFrames", &bDumpHashedFrames, false);
 
 	IniFile::Section* misc = iniFile.GetOrCreateSection("Misc");
 	misc->Get("DrawStart", &drawStart, 0);
@@ -67,11 +77,14 @@ void SWVideoConfig::Save(const char* ini_file)
 	IniFile::Section* hardware = iniFile.GetOrCreateSection("Hardware");
 	hardware->Set("Fullscreen", bFullscreen);
 	hardware->Set("RenderToMainframe", renderToMainframe);
+	hardware->Set("Headless", bHeadless);
 
 	IniFile::Section* rendering = iniFile.GetOrCreateSection("Rendering");
 	rendering->Set("BypassXFB", bBypassXFB);
 	rendering->Set("ZComploc", bZComploc);
 	rendering->Set("ZFreeze", bZFreeze);
+	rendering->Set("RasterizerThreads", numRasterizerThreads);
+	rendering->Set("JitTev", bJitTev);
 
 	IniFile::Section* info = iniFile.GetOrCreateSection("Info");
 	info->Set("ShowStats", bShowStats);
@@ -81,6 +94,8 @@ void SWVideoConfig::Save(const char* ini_file)
 	utility->Set("DumpObjects", bDumpObjects);
 	utility->Set("DumpTevStages", bDumpTevStages);
 	utility->Set("DumpTevTexFetches", bDumpTevTextureFetches);
+	utility->Set("FrameHashFile", sFrameHashFile);
+	utility->Set("DumpHashedFrames", bDumpHashedFrames);
 
 	IniFile::Section* misc = iniFile.GetOrCreateSection("Misc");
 	misc->Set("DrawStart", drawStart);
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "Common/CommonTypes.h"
 #include "Common/NonCopyable.h"
 
@@ -21,17 +23,31 @@ struct SWVideoConfig : NonCopyable
 	bool bHideCursor;
 	bool renderToMainframe;
 
+	// Don't create a window, frames are only hashed and dumped
+	bool bHeadless;
+
 	bool bBypassXFB;
 
 	// Emulation features
 	bool bZComploc;
 	bool bZFreeze;
 
+	// 0 = one per CPU core
+	u32 numRasterizerThreads;
+
+	// Generate native code for the TEV combiners (x64 only)
+	bool bJitTev;
+
 	bool bShowStats;
 
 	bool bDumpTextures;
 	bool bDumpObjects;
 
+	// Writes a hash of every frame to this file, if set
+	std::string sFrameHashFile;
+	// Dumps every frame with a new hash, named after the hash
+	bool bDumpHashedFrames;
+
 	// Debug only
 	bool bDumpTevStages;
 	bool bDumpTevTextureFetches;
@@ -26,6 +26,7 @@
 #include "VideoBackends/Software/SWOGLWindow.h"
 #include "VideoBackends/Software/SWRenderer.h"
 #include "VideoBackends/Software/SWStatistics.h"
+#include "VideoBackends/Software/SWTextureCache.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/VideoBackend.h"
@@ -79,7 +80,9 @@ bool VideoSoftware::Initialize(void *window_handle)
 {
 	g_SWVideoConfig.Load((File::GetUserPath(D_CONFIG_IDX) + GetConfigName() + ".ini").c_str());
 
-	SWOGLWindow::Init(window_handle);
+	// Hosts without a render window, like dolphin-fifo-bench, always run headless
+	if (!g_SWVideoConfig.bHeadless && window_handle)
+		SWOGLWindow::Init(window_handle);
 
 	InitBPMemory();
 	InitXFMemory();
@@ -88,6 +91,7 @@ bool VideoSoftware::Initialize(void *window_handle)
 	OpcodeDecoder::Init();
 	Clipper::Init();
 	Rasterizer::Init();
+	SWTextureCache::Init();
 	SWRenderer::Init();
 	DebugUtil::Init();
 
@@ -103,6 +107,7 @@ void VideoSoftware::DoState(PointerWrap& p)
 		p.SetMode(PointerWrap::MODE_VERIFY);
 
 	// TODO: incomplete?
+	Rasterizer::Flush();
 	SWCommandProcessor::DoState(p);
 	PixelEngine::DoState(p);
 	EfbInterface::DoState(p);
@@ -111,6 +116,7 @@ void VideoSoftware::DoState(PointerWrap& p)
 	p.Do(xfmem);
 	p.Do(bpmem);
 	p.DoPOD(swstats);
+	SWTextureCache::InvalidateBindings();
 
 	// CP Memory
 	DoCPState(p);
@@ -151,13 +157,16 @@ void VideoSoftware::EmuStateChange(EMUSTATE_CHANGE newState)
 void VideoSoftware::Shutdown()
 {
 	// TODO: should be in Video_Cleanup
+	Rasterizer::Shutdown();
+	SWTextureCache::Shutdown();
 	SWRenderer::Shutdown();
 	DebugUtil::Shutdown();
 
 	// Do our OSD callbacks
 	OSD::DoCallbacks(OSD::OSD_SHUTDOWN);
 
-	SWOGLWindow::Shutdown();
+	if (SWOGLWindow::s_instance)
+		SWOGLWindow::Shutdown();
 }
 
 void VideoSoftware::Video_Cleanup()
@@ -344,6 +353,8 @@ void VideoSoftware::RegisterCPMMIO(MMIO::Mapping* mmio, u32 base)
 // Draw messages on top of the screen
 unsigned int VideoSoftware::PeekMessages()
 {
+	if (!SWOGLWindow::s_instance)
+		return 0;
 	return SWOGLWindow::s_instance->PeekMessages();
 }
 
@@ -2,16 +2,22 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "VideoBackends/Software/DebugUtil.h"
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/Tev.h"
 #include "VideoBackends/Software/TextureSampler.h"
+#ifdef _M_X86_64
+#include "VideoBackends/Software/TevJitX64.h"
+#endif
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/BoundingBox.h"
 
@@ -21,6 +27,9 @@
 #define ALLOW_TEV_DUMPS 0
 #endif
 
+// Bumped whenever bpmem changes, so each Tev knows when to decode its stages again
+static u32 s_stageConfigVersion = 1;
+
 void Tev::Init()
 {
 	FixedConstants[0] = 0;
@@ -122,6 +131,39 @@ void Tev::Init()
 	m_ScaleRShiftLUT[1] = 0;
 	m_ScaleRShiftLUT[2] = 0;
 	m_ScaleRShiftLUT[3] = 1;
+
+	memset(Reg, 0, sizeof(Reg));
+	memset(RegInit, 0, sizeof(RegInit));
+
+	memset(&m_Quad, 0, sizeof(m_Quad));
+	for (int pixel = 0; pixel < 4; pixel++)
+	{
+		m_Quad.One[pixel] = 255;
+		m_Quad.Half[pixel] = 128;
+		m_Quad.Zero[pixel] = 0;
+		m_Quad.InputMask[pixel] = 0xff;
+		m_Quad.LerpMax[pixel] = 256;
+		m_Quad.Round[0][pixel] = 128;
+		m_Quad.Round[1][pixel] = 127;
+		m_Quad.Bias[0][pixel] = 128;
+		m_Quad.Bias[1][pixel] = -128;
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		m_Quad.ClampMin[0][i] = 0;
+		m_Quad.ClampMax[0][i] = 255;
+		m_Quad.ClampMin[1][i] = -1024;
+		m_Quad.ClampMax[1][i] = 1023;
+	}
+	m_StagesVersion = 0;
+	m_CombinerFunc = nullptr;
+	memset(Quad, 0, sizeof(Quad));
+
+	memset(PerfPixelCounts, 0, sizeof(PerfPixelCounts));
+	BBox[BoundingBox::LEFT] = BBox[BoundingBox::TOP] = 0xffff;
+	BBox[BoundingBox::RIGHT] = BBox[BoundingBox::BOTTOM] = 0;
+	PixelsIn = 0;
+	PixelsOut = 0;
 }
 
 static inline s16 Clamp255(s16 in)
@@ -504,13 +546,8 @@ void Tev::Indirect(unsigned int stageNum, s32 s, s32 t)
 	}
 }
 
-void Tev::Draw()
+void Tev::SampleIndirectStages()
 {
-	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
-	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
-
-	INCSTAT(swstats.thisFrame.tevPixelsIn);
-
 	for (unsigned int stageNum = 0; stageNum < bpmem.genMode.numindstages; stageNum++)
 	{
 		int stageNum2 = stageNum >> 1;
@@ -539,6 +576,23 @@ void Tev::Draw()
 		}
 #endif
 	}
+}
+
+void Tev::Draw()
+{
+	_assert_(Position[0] >= 0 && Position[0] < EFB_WIDTH);
+	_assert_(Position[1] >= 0 && Position[1] < EFB_HEIGHT);
+
+	PixelsIn++;
+
+	// Nothing is carried over from the previously drawn pixel, so the result
+	// doesn't depend on the order pixels are drawn in.
+	memcpy(Reg, RegInit, sizeof(Reg));
+	memset(TexColor, 0, sizeof(TexColor));
+	TexCoord.s = 0;
+	TexCoord.t = 0;
+
+	SampleIndirectStages();
 
 	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
 	{
@@ -647,6 +701,12 @@ void Tev::Draw()
 	u32 alpha_index = bpmem.combiners[bpmem.genMode.numtevstages].alphaC.dest;
 	u8 output[4] = {(u8)Reg[alpha_index][ALP_C], (u8)Reg[color_index][BLU_C], (u8)Reg[color_index][GRN_C], (u8)Reg[color_index][RED_C]};
 
+	FinishPixel(output);
+}
+
+// Everything after the TEV combiners: alpha test, z textures, fog, late depth test and blending
+void Tev::FinishPixel(u8 output[4])
+{
 	if (!TevAlphaTest(output[ALP_C]))
 		return;
 
@@ -758,19 +818,19 @@ void Tev::Draw()
 	if (late_ztest && bpmem.zmode.testenable)
 	{
 		// TODO: Check against hw if these values get incremented even if depth testing is disabled
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_INPUT);
+		PerfPixelCounts[PQ_ZCOMP_INPUT]++;
 
 		if (!EfbInterface::ZCompare(Position[0], Position[1], Position[2]))
 			return;
 
-		EfbInterface::IncPerfCounterQuadCount(PQ_ZCOMP_OUTPUT);
+		PerfPixelCounts[PQ_ZCOMP_OUTPUT]++;
 	}
 
 	// branchless bounding box update
-	BoundingBox::coords[BoundingBox::LEFT] = std::min((u16)Position[0], BoundingBox::coords[BoundingBox::LEFT]);
-	BoundingBox::coords[BoundingBox::RIGHT] = std::max((u16)Position[0], BoundingBox::coords[BoundingBox::RIGHT]);
-	BoundingBox::coords[BoundingBox::TOP] = std::min((u16)Position[1], BoundingBox::coords[BoundingBox::TOP]);
-	BoundingBox::coords[BoundingBox::BOTTOM] = std::max((u16)Position[1], BoundingBox::coords[BoundingBox::BOTTOM]);
+	BBox[BoundingBox::LEFT] = std::min((u16)Position[0], BBox[BoundingBox::LEFT]);
+	BBox[BoundingBox::RIGHT] = std::max((u16)Position[0], BBox[BoundingBox::RIGHT]);
+	BBox[BoundingBox::TOP] = std::min((u16)Position[1], BBox[BoundingBox::TOP]);
+	BBox[BoundingBox::BOTTOM] = std::max((u16)Position[1], BBox[BoundingBox::BOTTOM]);
 
 #if ALLOW_TEV_DUMPS
 	if (g_SWVideoConfig.bDumpTevStages)
@@ -792,12 +852,423 @@ void Tev::Draw()
 	}
 #endif
 
-	INCSTAT(swstats.thisFrame.tevPixelsOut);
-	EfbInterface::IncPerfCounterQuadCount(PQ_BLEND_INPUT);
+	PixelsOut++;
+	PerfPixelCounts[PQ_BLEND_INPUT]++;
 
 	EfbInterface::BlendTev(Position[0], Position[1], output);
 }
 
+void Tev::InvalidateStageConfig()
+{
+	s_stageConfigVersion++;
+}
+
+void Tev::DecodeStages()
+{
+	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+	{
+		StageConfig& stage = m_Stages[stageNum];
+		int stageOdd = stageNum & 1;
+		TwoTevStageOrders& order = bpmem.tevorders[stageNum >> 1];
+		TevKSel& kSel = bpmem.tevksel[stageNum >> 1];
+		const TevStageCombiner::ColorCombiner& cc = bpmem.combiners[stageNum].colorC;
+		const TevStageCombiner::AlphaCombiner& ac = bpmem.combiners[stageNum].alphaC;
+
+		stage.texCoord = order.getTexCoord(stageOdd);
+		stage.texMap = order.getTexMap(stageOdd);
+		stage.texEnable = order.getEnable(stageOdd) != 0;
+		stage.rasChan = order.getColorChan(stageOdd);
+
+		int tswap = ac.tswap * 2;
+		stage.texSwap[RED_C] = bpmem.tevksel[tswap].swap1;
+		stage.texSwap[GRN_C] = bpmem.tevksel[tswap].swap2;
+		stage.texSwap[BLU_C] = bpmem.tevksel[tswap + 1].swap1;
+		stage.texSwap[ALP_C] = bpmem.tevksel[tswap + 1].swap2;
+
+		int rswap = ac.rswap * 2;
+		stage.rasSwap[RED_C] = bpmem.tevksel[rswap].swap1;
+		stage.rasSwap[GRN_C] = bpmem.tevksel[rswap].swap2;
+		stage.rasSwap[BLU_C] = bpmem.tevksel[rswap + 1].swap1;
+		stage.rasSwap[ALP_C] = bpmem.tevksel[rswap + 1].swap2;
+
+		int kc = kSel.getKC(stageOdd);
+		int ka = kSel.getKA(stageOdd);
+		stage.konst[RED_C] = *m_KonstLUT[kc][RED_C];
+		stage.konst[GRN_C] = *m_KonstLUT[kc][GRN_C];
+		stage.konst[BLU_C] = *m_KonstLUT[kc][BLU_C];
+		stage.konst[ALP_C] = *m_KonstLUT[ka][ALP_C];
+		for (int comp = 0; comp < 4; comp++)
+		{
+			for (int pixel = 0; pixel < 4; pixel++)
+				m_Quad.Konst[stageNum][comp][pixel] = stage.konst[comp];
+		}
+
+		CombinerConfig& color = stage.color;
+		color.a = cc.a;
+		color.b = cc.b;
+		color.c = cc.c;
+		color.d = cc.d;
+		color.dest = cc.dest;
+		color.compare = cc.bias == 3;
+		color.compareMode = (cc.shift << 1) | cc.op | 8;
+		color.negate = cc.op != 0;
+		color.lshift = m_ScaleLShiftLUT[cc.shift];
+		color.rshift = m_ScaleRShiftLUT[cc.shift];
+		color.bias = m_BiasLUT[cc.bias];
+		color.round = (cc.shift == 3) ? 0 : (cc.op == 1) ? 127 : 128;
+		color.clamp = cc.clamp != 0;
+
+		CombinerConfig& alpha = stage.alpha;
+		alpha.a = ac.a;
+		alpha.b = ac.b;
+		alpha.c = ac.c;
+		alpha.d = ac.d;
+		alpha.dest = ac.dest;
+		alpha.compare = ac.bias == 3;
+		alpha.compareMode = (ac.shift << 1) | ac.op | 8;
+		alpha.negate = ac.op != 0;
+		alpha.lshift = m_ScaleLShiftLUT[ac.shift];
+		alpha.rshift = m_ScaleRShiftLUT[ac.shift];
+		alpha.bias = m_BiasLUT[ac.bias];
+		alpha.round = (ac.shift != 3) ? 0 : (ac.op == 1) ? 127 : 128;
+		alpha.clamp = ac.clamp != 0;
+	}
+
+	m_StagesVersion = s_stageConfigVersion;
+}
+
+const s32* Tev::GetQuadColorInput(const QuadState& state, int stageNum, int input, int comp)
+{
+	// Odd inputs replicate the alpha component
+	int inputComp = (input & 1) ? ALP_C : comp;
+
+	switch (input)
+	{
+	case 0: case 1: case 2: case 3: case 4: case 5: case 6: case 7: // prev, c0, c1, c2
+		return state.Reg[input >> 1][inputComp];
+	case 8: case 9: // tex
+		return state.TexColor[stageNum][inputComp];
+	case 10: case 11: // ras
+		return state.RasColor[stageNum][inputComp];
+	case 12: // one
+		return state.One;
+	case 13: // half
+		return state.Half;
+	case 14: // konst
+		return state.Konst[stageNum][comp];
+	default: // zero
+		return state.Zero;
+	}
+}
+
+const s32* Tev::GetQuadAlphaInput(const QuadState& state, int stageNum, int input)
+{
+	switch (input)
+	{
+	case 0: case 1: case 2: case 3: // prev, c0, c1, c2
+		return state.Reg[input][ALP_C];
+	case 4: // tex
+		return state.TexColor[stageNum][ALP_C];
+	case 5: // ras
+		return state.RasColor[stageNum][ALP_C];
+	case 6: // konst
+		return state.Konst[stageNum][ALP_C];
+	default: // zero
+		return state.Zero;
+	}
+}
+
+// Does everything Draw() does before the combiners for one pixel of the quad
+void Tev::SampleQuadPixel(int pixel)
+{
+	const QuadPixel& quad = Quad[pixel];
+	memcpy(Color, quad.Color, sizeof(Color));
+	memcpy(Uv, quad.Uv, sizeof(Uv));
+
+	memset(TexColor, 0, sizeof(TexColor));
+	TexCoord.s = 0;
+	TexCoord.t = 0;
+
+	SampleIndirectStages();
+
+	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+	{
+		const StageConfig& stage = m_Stages[stageNum];
+
+		Indirect(stageNum, Uv[stage.texCoord].s, Uv[stage.texCoord].t);
+
+		if (stage.texEnable)
+		{
+			u8 texel[4];
+			TextureSampler::Sample(TexCoord.s, TexCoord.t, TextureLod[stageNum], TextureLinear[stageNum], stage.texMap, texel);
+
+			for (int comp = 0; comp < 4; comp++)
+				TexColor[comp] = texel[stage.texSwap[comp]];
+		}
+
+		s16 rasColor[4];
+		switch (stage.rasChan)
+		{
+		case 0: // Color0
+		case 1: // Color1
+			for (int comp = 0; comp < 4; comp++)
+				rasColor[comp] = Color[stage.rasChan][stage.rasSwap[comp]];
+			break;
+		case 5: // alpha bump
+			for (s16& comp : rasColor)
+				comp = AlphaBump;
+			break;
+		case 6: // alpha bump normalized
+			for (s16& comp : rasColor)
+				comp = AlphaBump | AlphaBump >> 5;
+			break;
+		default: // zero
+			for (s16& comp : rasColor)
+				comp = 0;
+			break;
+		}
+
+		for (int comp = 0; comp < 4; comp++)
+		{
+			m_Quad.TexColor[stageNum][comp][pixel] = TexColor[comp];
+			m_Quad.RasColor[stageNum][comp][pixel] = rasColor[comp];
+		}
+	}
+
+	// needed for z textures
+	memcpy(m_QuadLastTexColor[pixel], TexColor, sizeof(TexColor));
+}
+
+#ifdef _M_X86
+
+// The inputs are stored in bitfields by Draw(): a, b and c are unsigned 8 bit, d is signed 11 bit
+static inline __m128i LoadInputABC(const s32* input)
+{
+	return _mm_and_si128(_mm_loadu_si128((const __m128i*)input), _mm_set1_epi32(0xff));
+}
+
+static inline __m128i LoadInputD(const s32* input)
+{
+	return _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)input), 21), 21);
+}
+
+static inline __m128i CombineRegular(__m128i a, __m128i b, __m128i c, __m128i d, int lshift, int rshift, s32 bias, s32 round, bool negate, bool alpha)
+{
+	c = _mm_add_epi32(c, _mm_srli_epi32(c, 7));
+
+	// a * (256 - c) + b * c, all factors fit into 16 bits
+	__m128i ab = _mm_or_si128(a, _mm_slli_epi32(b, 16));
+	__m128i weights = _mm_or_si128(_mm_sub_epi32(_mm_set1_epi32(256), c), _mm_slli_epi32(c, 16));
+	__m128i temp = _mm_madd_epi16(ab, weights);
+
+	__m128i lshiftCount = _mm_cvtsi32_si128(lshift);
+	temp = _mm_sll_epi32(temp, lshiftCount);
+	temp = _mm_add_epi32(temp, _mm_set1_epi32(round));
+
+	// color is shifted down before negating, alpha after
+	if (alpha)
+	{
+		if (negate)
+			temp = _mm_sub_epi32(_mm_setzero_si128(), temp);
+		temp = _mm_srai_epi32(temp, 8);
+	}
+	else
+	{
+		temp = _mm_srai_epi32(temp, 8);
+		if (negate)
+			temp = _mm_sub_epi32(_mm_setzero_si128(), temp);
+	}
+
+	__m128i result = _mm_sll_epi32(_mm_add_epi32(d, _mm_set1_epi32(bias)), lshiftCount);
+	result = _mm_add_epi32(result, temp);
+	return _mm_sra_epi32(result, _mm_cvtsi32_si128(rshift));
+}
+
+// Value compared by the R8, GR16 and BGR24 modes, made from the color inputs (BLU_C + i)
+static inline __m128i CompareValue(const __m128i inputs[3], int mode)
+{
+	switch (mode & ~1)
+	{
+	case TEVCMP_R8_GT:
+		return inputs[2];
+	case TEVCMP_GR16_GT:
+		return _mm_or_si128(_mm_slli_epi32(inputs[1], 8), inputs[2]);
+	default: // TEVCMP_BGR24_GT
+		return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(inputs[0], 16), _mm_slli_epi32(inputs[1], 8)), inputs[2]);
+	}
+}
+
+static inline __m128i CompareResult(__m128i a, __m128i b, __m128i c, __m128i d, int mode)
+{
+	__m128i mask = (mode & 1) ? _mm_cmpeq_epi32(a, b) : _mm_cmpgt_epi32(a, b);
+	return _mm_add_epi32(d, _mm_and_si128(mask, c));
+}
+
+static inline __m128i ClampResult(__m128i value, bool clamp)
+{
+	__m128i low = clamp ? _mm_setzero_si128() : _mm_set1_epi32(-1024);
+	__m128i high = clamp ? _mm_set1_epi32(255) : _mm_set1_epi32(1023);
+
+	__m128i above = _mm_cmpgt_epi32(value, high);
+	value = _mm_or_si128(_mm_and_si128(above, high), _mm_andnot_si128(above, value));
+	__m128i below = _mm_cmplt_epi32(value, low);
+	return _mm_or_si128(_mm_and_si128(below, low), _mm_andnot_si128(below, value));
+}
+
+void Tev::CombineQuad()
+{
+	for (unsigned int stageNum = 0; stageNum <= bpmem.genMode.numtevstages; stageNum++)
+	{
+		const StageConfig& stage = m_Stages[stageNum];
+		const CombinerConfig& cc = stage.color;
+		const CombinerConfig& ac = stage.alpha;
+
+		// Gather all inputs before writing anything, the destinations may be inputs as well.
+		// The color inputs are indexed by BLU_C + i like in Draw().
+		__m128i colorA[3], colorB[3], colorC[3], colorD[3];
+		for (int i = 0; i < 3; i++)
+		{
+			colorA[i] = LoadInputABC(GetQuadColorInput(m_Quad, stageNum, cc.a, BLU_C + i));
+			colorB[i] = LoadInputABC(GetQuadColorInput(m_Quad, stageNum, cc.b, BLU_C + i));
+			colorC[i] = LoadInputABC(GetQuadColorInput(m_Quad, stageNum, cc.c, BLU_C + i));
+			colorD[i] = LoadInputD(GetQuadColorInput(m_Quad, stageNum, cc.d, BLU_C + i));
+		}
+		__m128i alphaA = LoadInputABC(GetQuadAlphaInput(m_Quad, stageNum, ac.a));
+		__m128i alphaB = LoadInputABC(GetQuadAlphaInput(m_Quad, stageNum, ac.b));
+		__m128i alphaC = LoadInputABC(GetQuadAlphaInput(m_Quad, stageNum, ac.c));
+		__m128i alphaD = LoadInputD(GetQuadAlphaInput(m_Quad, stageNum, ac.d));
+
+		__m128i color[3];
+		if (!cc.compare)
+		{
+			for (int i = 0; i < 3; i++)
+				color[i] = CombineRegular(colorA[i], colorB[i], colorC[i], colorD[i], cc.lshift, cc.rshift, cc.bias, cc.round, cc.negate, false);
+		}
+		else if ((cc.compareMode & ~1) == TEVCMP_RGB8_GT)
+		{
+			for (int i = 0; i < 3; i++)
+				color[i] = CompareResult(colorA[i], colorB[i], colorC[i], colorD[i], cc.compareMode);
+		}
+		else
+		{
+			__m128i a = CompareValue(colorA, cc.compareMode);
+			__m128i b = CompareValue(colorB, cc.compareMode);
+			for (int i = 0; i < 3; i++)
+				color[i] = CompareResult(a, b, colorC[i], colorD[i], cc.compareMode);
+		}
+
+		__m128i alpha;
+		if (!ac.compare)
+		{
+			alpha = CombineRegular(alphaA, alphaB, alphaC, alphaD, ac.lshift, ac.rshift, ac.bias, ac.round, ac.negate, true);
+		}
+		else if ((ac.compareMode & ~1) == TEVCMP_A8_GT)
+		{
+			alpha = CompareResult(alphaA, alphaB, alphaC, alphaD, ac.compareMode);
+		}
+		else
+		{
+			alpha = CompareResult(CompareValue(colorA, ac.compareMode), CompareValue(colorB, ac.compareMode),
+			                      alphaC, alphaD, ac.compareMode);
+		}
+
+		for (int i = 0; i < 3; i++)
+			_mm_storeu_si128((__m128i*)m_Quad.Reg[cc.dest][BLU_C + i], ClampResult(color[i], cc.clamp));
+		_mm_storeu_si128((__m128i*)m_Quad.Reg[ac.dest][ALP_C], ClampResult(alpha, ac.clamp));
+	}
+}
+
+#endif
+
+void Tev::DrawQuad(int numPixels)
+{
+	bool scalar = true;
+#ifdef _M_X86
+	scalar = false;
+#endif
+#if ALLOW_TEV_DUMPS
+	// the dumps are only implemented in Draw()
+	if (g_SWVideoConfig.bDumpTevStages || g_SWVideoConfig.bDumpTevTextureFetches)
+		scalar = true;
+#endif
+
+	if (scalar)
+	{
+		for (int pixel = 0; pixel < numPixels; pixel++)
+		{
+			memcpy(Position, Quad[pixel].Position, sizeof(Position));
+			memcpy(Color, Quad[pixel].Color, sizeof(Color));
+			memcpy(Uv, Quad[pixel].Uv, sizeof(Uv));
+			Draw();
+		}
+		return;
+	}
+
+#ifdef _M_X86
+	PixelsIn += numPixels;
+
+	if (m_StagesVersion != s_stageConfigVersion)
+	{
+		DecodeStages();
+
+		m_CombinerFunc = nullptr;
+#ifdef _M_X86_64
+		if (g_SWVideoConfig.bJitTev)
+			m_CombinerFunc = TevJitX64::GetCombiner(m_Stages, bpmem.genMode.numtevstages + 1);
+#endif
+	}
+
+	for (int pixel = 0; pixel < numPixels; pixel++)
+		SampleQuadPixel(pixel);
+
+	for (int reg = 0; reg < 4; reg++)
+	{
+		for (int comp = 0; comp < 4; comp++)
+			_mm_storeu_si128((__m128i*)m_Quad.Reg[reg][comp], _mm_set1_epi32(RegInit[reg][comp]));
+	}
+
+	if (m_CombinerFunc)
+		m_CombinerFunc(&m_Quad);
+	else
+		CombineQuad();
+
+	const StageConfig& lastStage = m_Stages[bpmem.genMode.numtevstages];
+	const s32 (&colorReg)[4][4] = m_Quad.Reg[lastStage.color.dest];
+	const s32 (&alphaReg)[4][4] = m_Quad.Reg[lastStage.alpha.dest];
+
+	for (int pixel = 0; pixel < numPixels; pixel++)
+	{
+		u8 output[4] = {(u8)alphaReg[ALP_C][pixel], (u8)colorReg[BLU_C][pixel], (u8)colorReg[GRN_C][pixel], (u8)colorReg[RED_C][pixel]};
+
+		memcpy(Position, Quad[pixel].Position, sizeof(Position));
+		memcpy(TexColor, m_QuadLastTexColor[pixel], sizeof(TexColor));
+		FinishPixel(output);
+	}
+#endif
+}
+
+void Tev::CommitCounters()
+{
+	for (int i = 0; i < PQ_NUM_MEMBERS; i++)
+	{
+		if (PerfPixelCounts[i])
+			EfbInterface::IncPerfCounterQuadCount((PerfQueryType)i, PerfPixelCounts[i]);
+		PerfPixelCounts[i] = 0;
+	}
+
+	BoundingBox::coords[BoundingBox::LEFT] = std::min(BBox[BoundingBox::LEFT], BoundingBox::coords[BoundingBox::LEFT]);
+	BoundingBox::coords[BoundingBox::RIGHT] = std::max(BBox[BoundingBox::RIGHT], BoundingBox::coords[BoundingBox::RIGHT]);
+	BoundingBox::coords[BoundingBox::TOP] = std::min(BBox[BoundingBox::TOP], BoundingBox::coords[BoundingBox::TOP]);
+	BoundingBox::coords[BoundingBox::BOTTOM] = std::max(BBox[BoundingBox::BOTTOM], BoundingBox::coords[BoundingBox::BOTTOM]);
+	BBox[BoundingBox::LEFT] = BBox[BoundingBox::TOP] = 0xffff;
+	BBox[BoundingBox::RIGHT] = BBox[BoundingBox::BOTTOM] = 0;
+
+	ADDSTAT(swstats.thisFrame.tevPixelsIn, PixelsIn);
+	ADDSTAT(swstats.thisFrame.tevPixelsOut, PixelsOut);
+	PixelsIn = 0;
+	PixelsOut = 0;
+}
+
 void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 {
 	if (konst)
@@ -806,13 +1277,18 @@ void Tev::SetRegColor(int reg, int comp, bool konst, s16 color)
 	}
 	else
 	{
-		Reg[reg][comp] = color;
+		RegInit[reg][comp] = color;
 	}
 }
 
 void Tev::DoState(PointerWrap &p)
 {
+	// bpmem might be different after loading a state
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		InvalidateStageConfig();
+
 	p.DoArray(Reg);
+	p.DoArray(RegInit);
 
 	p.DoArray(KonstantColors);
 	p.DoArray(TexColor);
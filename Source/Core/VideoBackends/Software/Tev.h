@@ -5,6 +5,7 @@
 #pragma once
 
 #include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoCommon/PerfQueryBase.h"
 
 class PointerWrap;
 
@@ -26,6 +27,7 @@ class Tev
 
 	// color order: ABGR
 	s16 Reg[4][4];
+	s16 RegInit[4][4]; // values set through BP, every pixel starts out with these in Reg
 	s16 KonstantColors[4][4];
 	s16 TexColor[4];
 	s16 RasColor[4];
@@ -61,6 +63,12 @@ class Tev
 
 	void SetRasColor(int colorChan, int swaptable);
 
+	void DecodeStages();
+	void SampleQuadPixel(int pixel);
+	void CombineQuad();
+	void SampleIndirectStages();
+	void FinishPixel(u8 output[4]);
+
 	void DrawColorRegular(TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
 	void DrawColorCompare(TevStageCombiner::ColorCombiner& cc, const InputRegType inputs[4]);
 	void DrawAlphaRegular(TevStageCombiner::AlphaCombiner& ac, const InputRegType inputs[4]);
@@ -69,6 +77,62 @@ class Tev
 	void Indirect(unsigned int stageNum, s32 s, s32 t);
 
 public:
+	// Stage configuration used by DrawQuad(), decoded from bpmem whenever it changes
+	struct CombinerConfig
+	{
+		u8 a, b, c, d;
+		u8 dest;
+		bool compare;
+		u8 compareMode; // TEVCMP_R8_GT ... TEVCMP_RGB8_EQ
+		bool negate;
+		u8 lshift;
+		u8 rshift;
+		s32 bias;
+		s32 round;
+		bool clamp;
+	};
+
+	struct StageConfig
+	{
+		u8 texCoord;
+		u8 texMap;
+		bool texEnable;
+		u8 texSwap[4]; // texel component used for each TexColor component
+		u8 rasChan;
+		u8 rasSwap[4]; // rasterized color component used for each RasColor component
+		s16 konst[4];
+		CombinerConfig color;
+		CombinerConfig alpha;
+	};
+
+	// DrawQuad() evaluates the combiners for all pixels of a quad at once, so the
+	// stage inputs are stored as [stage][component][pixel] and the registers as
+	// [register][component][pixel]. Aligned so generated code can use it as SSE operands.
+	struct alignas(16) QuadState
+	{
+		s32 TexColor[16][4][4];
+		s32 RasColor[16][4][4];
+		s32 Konst[16][4][4];
+		s32 Reg[4][4][4];
+
+		// Constants, each replicated for all pixels
+		s32 One[4];
+		s32 Half[4];
+		s32 Zero[4];
+		s32 InputMask[4];   // 0xff
+		s32 LerpMax[4];     // 256
+		s32 Round[2][4];    // 128, 127
+		s32 Bias[2][4];     // 128, -128
+		s16 ClampMin[2][8]; // 0, -1024
+		s16 ClampMax[2][8]; // 255, 1023
+	};
+
+	// Evaluates the combiners of all TEV stages for a quad, see TevJitX64
+	typedef void (*CombinerFunc)(QuadState* state);
+
+	static const s32* GetQuadColorInput(const QuadState& state, int stageNum, int input, int comp);
+	static const s32* GetQuadAlphaInput(const QuadState& state, int stageNum, int input);
+
 	s32 Position[3];
 	u8 Color[2][4]; // must be RGBA for correct swap table ordering
 	TextureCoordinateType Uv[8];
@@ -77,6 +141,23 @@ public:
 	s32 TextureLod[16];
 	bool TextureLinear[16];
 
+	// Draw() doesn't touch any global state apart from the EFB pixel it is drawing,
+	// so that each rasterizer thread can use its own Tev. These collect the rest
+	// until CommitCounters() is called, which must not run concurrently with Draw().
+	u32 PerfPixelCounts[PQ_NUM_MEMBERS];
+	u16 BBox[4];
+	u32 PixelsIn;
+	u32 PixelsOut;
+
+	// Per-pixel inputs of DrawQuad(). Everything else is shared by the whole quad.
+	struct QuadPixel
+	{
+		s32 Position[3];
+		u8 Color[2][4];
+		TextureCoordinateType Uv[8];
+	};
+	QuadPixel Quad[4];
+
 	enum
 	{
 		ALP_C,
@@ -89,7 +170,24 @@ public:
 
 	void Draw();
 
+	// Draws the first numPixels pixels of Quad. Gives the same results as calling
+	// Draw() for each of them, but evaluates the TEV combiners for all of them at once.
+	void DrawQuad(int numPixels);
+
+	// Must be called when any bpmem register used by the TEV stages changes.
+	static void InvalidateStageConfig();
+
+	void CommitCounters();
+
 	void SetRegColor(int reg, int comp, bool konst, s16 color);
 
 	void DoState(PointerWrap &p);
+
+private:
+	StageConfig m_Stages[16];
+	u32 m_StagesVersion;
+	CombinerFunc m_CombinerFunc;
+
+	QuadState m_Quad;
+	s16 m_QuadLastTexColor[4][4];
 };
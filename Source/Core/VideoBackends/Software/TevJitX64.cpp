@@ -0,0 +1,389 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "Common/BitSet.h"
+#include "Common/CommonTypes.h"
+#include "Common/JitRegister.h"
+#include "Common/MsgHandler.h"
+#include "Common/x64ABI.h"
+#include "Common/x64Emitter.h"
+#include "VideoBackends/Software/TevJitX64.h"
+#include "VideoCommon/BPMemory.h"
+
+using namespace Gen;
+
+namespace TevJitX64
+{
+
+static const X64Reg state_reg = ABI_PARAM1;
+
+// Results of the color (BLU, GRN, RED) and alpha combiners of the current stage.
+// They are only written back once all inputs of the stage have been read.
+static const X64Reg color_regs[3] = { XMM8, XMM9, XMM10 };
+static const X64Reg alpha_reg = XMM11;
+
+static const int CODE_SIZE = 4 * 1024 * 1024;
+
+// Everything that goes into the generated code, packed into one word per combiner
+struct CombinerUid
+{
+	u32 numStages;
+	u32 combiners[16][2];
+
+	bool operator<(const CombinerUid& other) const
+	{
+		return memcmp(this, &other, sizeof(*this)) < 0;
+	}
+};
+
+static u32 PackCombiner(const Tev::CombinerConfig& config)
+{
+	u32 bias = config.bias == 0 ? 0 : config.bias > 0 ? 1 : 2;
+	u32 round = config.round == 0 ? 0 : config.round == 128 ? 1 : 2;
+
+	return config.a | (config.b << 4) | (config.c << 8) | (config.d << 12) |
+	       (config.dest << 16) | (config.compare << 18) | ((config.compareMode & 7) << 19) |
+	       (config.negate << 22) | (config.lshift << 23) | (config.rshift << 25) |
+	       (bias << 26) | (round << 28) | (config.clamp << 30);
+}
+
+class CombinerJit : public X64CodeBlock
+{
+public:
+	CombinerJit()
+	{
+		AllocCodeSpace(CODE_SIZE, false);
+		ClearCodeSpace();
+		memset(&m_layout, 0, sizeof(m_layout));
+	}
+
+	Tev::CombinerFunc Generate(const Tev::StageConfig* stages, u32 numStages);
+
+private:
+	// Only used to find out where things are in the state passed to the generated code
+	Tev::QuadState m_layout;
+
+	OpArg StateArg(const void* ptr) const
+	{
+		return MDisp(state_reg, (s32)((const u8*)ptr - (const u8*)&m_layout));
+	}
+
+	bool IsConstant(const s32* input) const
+	{
+		return input == m_layout.One || input == m_layout.Half || input == m_layout.Zero;
+	}
+
+	// Texture and rasterized colors as well as the constants are always 0..255
+	bool IsUnsigned8(const s32* input) const
+	{
+		const u8* ptr = (const u8*)input;
+		return IsConstant(input) ||
+		       (ptr >= (const u8*)m_layout.TexColor && ptr < (const u8*)m_layout.Konst);
+	}
+
+	void LoadInput(X64Reg reg, const s32* input, bool is_d);
+	void Negate(X64Reg reg, X64Reg scratch);
+	void CombineRegular(X64Reg out, const s32* a, const s32* b, const s32* c, const s32* d, const Tev::CombinerConfig& config, bool alpha);
+	void LoadCompareValue(X64Reg reg, const s32* const inputs[3], int mode);
+	void Clamp(X64Reg reg, bool clamp);
+	void GenerateStage(const Tev::StageConfig& stage, int stageNum);
+};
+
+// a, b and c are unsigned 8 bit, d is signed 11 bit, just like the bitfields used by Tev::Draw()
+void CombinerJit::LoadInput(X64Reg reg, const s32* input, bool is_d)
+{
+	if (input == m_layout.Zero)
+	{
+		PXOR(reg, R(reg));
+		return;
+	}
+
+	MOVDQA(reg, StateArg(input));
+	if (IsUnsigned8(input))
+		return;
+
+	if (is_d)
+	{
+		PSLLD(reg, 21);
+		PSRAD(reg, 21);
+	}
+	else
+	{
+		PAND(reg, StateArg(m_layout.InputMask));
+	}
+}
+
+void CombinerJit::Negate(X64Reg reg, X64Reg scratch)
+{
+	PXOR(scratch, R(scratch));
+	PSUBD(scratch, R(reg));
+	MOVDQA(reg, R(scratch));
+}
+
+void CombinerJit::CombineRegular(X64Reg out, const s32* a, const s32* b, const s32* c, const s32* d, const Tev::CombinerConfig& config, bool alpha)
+{
+	// The interpolation is zero no matter what c is, so only the rounding is left
+	bool lerp_zero = a == m_layout.Zero && b == m_layout.Zero;
+
+	s32 lerp_constant = 0;
+	if (lerp_zero)
+	{
+		if (alpha)
+			lerp_constant = config.negate ? (-config.round >> 8) : (config.round >> 8);
+		else
+			lerp_constant = config.negate ? -(config.round >> 8) : (config.round >> 8);
+		_assert_(lerp_constant == 0 || lerp_constant == -1);
+	}
+	else
+	{
+		LoadInput(XMM0, a, false);
+		LoadInput(XMM1, b, false);
+		LoadInput(XMM2, c, false);
+
+		// c += c >> 7
+		MOVDQA(XMM3, R(XMM2));
+		PSRLD(XMM3, 7);
+		PADDD(XMM2, R(XMM3));
+
+		// a * (256 - c) + b * c, all factors fit into 16 bits
+		MOVDQA(XMM3, StateArg(m_layout.LerpMax));
+		PSUBD(XMM3, R(XMM2));
+		PSLLD(XMM2, 16);
+		POR(XMM3, R(XMM2));
+		PSLLD(XMM1, 16);
+		POR(XMM0, R(XMM1));
+		PMADDWD(XMM0, R(XMM3));
+
+		if (config.lshift)
+			PSLLD(XMM0, config.lshift);
+		if (config.round)
+			PADDD(XMM0, StateArg(m_layout.Round[config.round == 128 ? 0 : 1]));
+
+		// color is shifted down before negating, alpha after
+		if (alpha && config.negate)
+			Negate(XMM0, XMM3);
+		PSRAD(XMM0, 8);
+		if (!alpha && config.negate)
+			Negate(XMM0, XMM3);
+	}
+
+	LoadInput(out, d, true);
+	if (config.bias)
+		PADDD(out, StateArg(m_layout.Bias[config.bias > 0 ? 0 : 1]));
+	if (config.lshift)
+		PSLLD(out, config.lshift);
+
+	if (!lerp_zero)
+	{
+		PADDD(out, R(XMM0));
+	}
+	else if (lerp_constant == -1)
+	{
+		PCMPEQD(XMM0, R(XMM0));
+		PADDD(out, R(XMM0));
+	}
+
+	if (config.rshift)
+		PSRAD(out, config.rshift);
+}
+
+// Value compared by the R8, GR16 and BGR24 modes, made from the color inputs (BLU_C + i)
+void CombinerJit::LoadCompareValue(X64Reg reg, const s32* const inputs[3], int mode)
+{
+	switch (mode & ~1)
+	{
+	case TEVCMP_R8_GT:
+		LoadInput(reg, inputs[2], false);
+		break;
+	case TEVCMP_GR16_GT:
+		LoadInput(reg, inputs[1], false);
+		PSLLD(reg, 8);
+		LoadInput(XMM5, inputs[2], false);
+		POR(reg, R(XMM5));
+		break;
+	default: // TEVCMP_BGR24_GT
+		LoadInput(reg, inputs[0], false);
+		PSLLD(reg, 16);
+		LoadInput(XMM5, inputs[1], false);
+		PSLLD(XMM5, 8);
+		POR(reg, R(XMM5));
+		LoadInput(XMM5, inputs[2], false);
+		POR(reg, R(XMM5));
+		break;
+	}
+}
+
+// All results fit into 16 bits, so saturate them as words
+void CombinerJit::Clamp(X64Reg reg, bool clamp)
+{
+	int range = clamp ? 0 : 1;
+	PACKSSDW(reg, R(reg));
+	PMAXSW(reg, StateArg(m_layout.ClampMin[range]));
+	PMINSW(reg, StateArg(m_layout.ClampMax[range]));
+	PUNPCKLWD(reg, R(reg));
+	PSRAD(reg, 16);
+}
+
+void CombinerJit::GenerateStage(const Tev::StageConfig& stage, int stageNum)
+{
+	const Tev::CombinerConfig& cc = stage.color;
+	const Tev::CombinerConfig& ac = stage.alpha;
+
+	const s32* color_a[3];
+	const s32* color_b[3];
+	const s32* color_c[3];
+	const s32* color_d[3];
+	for (int i = 0; i < 3; i++)
+	{
+		color_a[i] = Tev::GetQuadColorInput(m_layout, stageNum, cc.a, Tev::BLU_C + i);
+		color_b[i] = Tev::GetQuadColorInput(m_layout, stageNum, cc.b, Tev::BLU_C + i);
+		color_c[i] = Tev::GetQuadColorInput(m_layout, stageNum, cc.c, Tev::BLU_C + i);
+		color_d[i] = Tev::GetQuadColorInput(m_layout, stageNum, cc.d, Tev::BLU_C + i);
+	}
+	const s32* alpha_a = Tev::GetQuadAlphaInput(m_layout, stageNum, ac.a);
+	const s32* alpha_b = Tev::GetQuadAlphaInput(m_layout, stageNum, ac.b);
+	const s32* alpha_c = Tev::GetQuadAlphaInput(m_layout, stageNum, ac.c);
+	const s32* alpha_d = Tev::GetQuadAlphaInput(m_layout, stageNum, ac.d);
+
+	if (!cc.compare)
+	{
+		for (int i = 0; i < 3; i++)
+			CombineRegular(color_regs[i], color_a[i], color_b[i], color_c[i], color_d[i], cc, false);
+	}
+	else
+	{
+		bool per_component = (cc.compareMode & ~1) == TEVCMP_RGB8_GT;
+		if (!per_component)
+		{
+			LoadCompareValue(XMM4, color_a, cc.compareMode);
+			LoadCompareValue(XMM1, color_b, cc.compareMode);
+			if (cc.compareMode & 1)
+				PCMPEQD(XMM4, R(XMM1));
+			else
+				PCMPGTD(XMM4, R(XMM1));
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			if (per_component)
+			{
+				LoadInput(XMM4, color_a[i], false);
+				LoadInput(XMM1, color_b[i], false);
+				if (cc.compareMode & 1)
+					PCMPEQD(XMM4, R(XMM1));
+				else
+					PCMPGTD(XMM4, R(XMM1));
+			}
+			LoadInput(XMM2, color_c[i], false);
+			PAND(XMM2, R(XMM4));
+			LoadInput(color_regs[i], color_d[i], true);
+			PADDD(color_regs[i], R(XMM2));
+		}
+	}
+
+	if (!ac.compare)
+	{
+		CombineRegular(alpha_reg, alpha_a, alpha_b, alpha_c, alpha_d, ac, true);
+	}
+	else
+	{
+		if ((ac.compareMode & ~1) == TEVCMP_A8_GT)
+		{
+			LoadInput(XMM4, alpha_a, false);
+			LoadInput(XMM1, alpha_b, false);
+		}
+		else
+		{
+			LoadCompareValue(XMM4, color_a, ac.compareMode);
+			LoadCompareValue(XMM1, color_b, ac.compareMode);
+		}
+		if (ac.compareMode & 1)
+			PCMPEQD(XMM4, R(XMM1));
+		else
+			PCMPGTD(XMM4, R(XMM1));
+
+		LoadInput(XMM2, alpha_c, false);
+		PAND(XMM2, R(XMM4));
+		LoadInput(alpha_reg, alpha_d, true);
+		PADDD(alpha_reg, R(XMM2));
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		Clamp(color_regs[i], cc.clamp);
+		MOVDQA(StateArg(m_layout.Reg[cc.dest][Tev::BLU_C + i]), color_regs[i]);
+	}
+	Clamp(alpha_reg, ac.clamp);
+	MOVDQA(StateArg(m_layout.Reg[ac.dest][Tev::ALP_C]), alpha_reg);
+}
+
+Tev::CombinerFunc CombinerJit::Generate(const Tev::StageConfig* stages, u32 numStages)
+{
+	// A routine for 16 stages is far smaller than this
+	if (IsAlmostFull())
+		return nullptr;
+
+	const u8* start = AlignCode16();
+
+	// XMM registers start at bit 16 of the ABI register sets
+	BitSet32 saved_regs = BitSet32{
+		static_cast<int>(color_regs[0] + 16), static_cast<int>(color_regs[1] + 16),
+		static_cast<int>(color_regs[2] + 16), static_cast<int>(alpha_reg + 16)
+	} & ABI_ALL_CALLEE_SAVED;
+	ABI_PushRegistersAndAdjustStack(saved_regs, 8);
+
+	for (u32 stageNum = 0; stageNum < numStages; stageNum++)
+		GenerateStage(stages[stageNum], stageNum);
+
+	ABI_PopRegistersAndAdjustStack(saved_regs, 8);
+	RET();
+
+	JitRegister::Register(start, GetCodePtr(), "TevCombiner_%u", numStages);
+
+	return (Tev::CombinerFunc)start;
+}
+
+static std::mutex s_mutex;
+static std::unique_ptr<CombinerJit> s_jit;
+static std::map<CombinerUid, Tev::CombinerFunc> s_combiners;
+
+Tev::CombinerFunc GetCombiner(const Tev::StageConfig* stages, u32 numStages)
+{
+	CombinerUid uid;
+	memset(&uid, 0, sizeof(uid));
+	uid.numStages = numStages;
+	for (u32 i = 0; i < numStages; i++)
+	{
+		uid.combiners[i][0] = PackCombiner(stages[i].color);
+		uid.combiners[i][1] = PackCombiner(stages[i].alpha);
+	}
+
+	std::lock_guard<std::mutex> lk(s_mutex);
+
+	auto it = s_combiners.find(uid);
+	if (it != s_combiners.end())
+		return it->second;
+
+	if (!s_jit)
+		s_jit = std::make_unique<CombinerJit>();
+
+	Tev::CombinerFunc func = s_jit->Generate(stages, numStages);
+	if (func)
+		s_combiners.emplace(uid, func);
+	return func;
+}
+
+void Shutdown()
+{
+	std::lock_guard<std::mutex> lk(s_mutex);
+	s_combiners.clear();
+	s_jit.reset();
+}
+
+}
@@ -0,0 +1,22 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/Tev.h"
+
+// Generates specialised code for the TEV combiners of Tev::DrawQuad(), with the
+// input selectors, scale, bias and compare modes of all stages resolved at compile time.
+namespace TevJitX64
+{
+
+// Returns the code for the given stage configuration, generating it if it doesn't exist yet.
+// Returns nullptr if the code space is full, Tev then falls back to the interpreted combiners.
+// The code stays valid until Shutdown() is called. Can be called from several threads.
+Tev::CombinerFunc GetCombiner(const Tev::StageConfig* stages, u32 numStages);
+
+void Shutdown();
+
+}
@@ -2,8 +2,12 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <atomic>
+
+#include "Common/Intrinsics.h"
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/TextureEncoder.h"
 
 #include "VideoCommon/LookUpTables.h"
@@ -13,6 +17,10 @@
 namespace TextureEncoder
 {
 
+// The copy is split into bands of rows of blocks, which are encoded on all rasterizer threads
+static const u32 MAX_BANDS = 16;
+static const u32 MIN_PARALLEL_PIXELS = 128 * 128;
+
 static inline void RGBA_to_RGBA8(const u8 *src, u8* r, u8* g, u8* b, u8* a)
 {
 	u32 srcColor = *(u32*)src;
@@ -224,7 +232,26 @@ static void SetSpans(int sBlkSize, int tBlkSize, s32* tSpan, s32* sBlkSpan, s32*
 	*writeStride = bpmem.copyMipMapStrideChannels * 32;
 }
 
+// A part of the copy, which can be encoded independently of the others
+struct Band
+{
+	u32 index;
+	u32 count;
+};
+
+// Restricts the encoding loop to the rows of blocks which belong to the band
+static void SetBand(const Band& band, int tBlkSize, s32 writeStride, u16* tBlkCount, u8** src, u8** dstBlockStart)
+{
+	u32 start = *tBlkCount * band.index / band.count;
+	u32 end = *tBlkCount * (band.index + 1) / band.count;
+
+	*src += start * tBlkSize * 640 * (3 << bpmem.triggerEFBCopy.half_scale);
+	*dstBlockStart += start * writeStride;
+	*tBlkCount = end - start;
+}
+
 #define ENCODE_LOOP_BLOCKS									\
+		SetBand(band, tBlkSize, writeStride, &tBlkCount, &src, &dstBlockStart); \
 		for (int tBlk = 0; tBlk < tBlkCount; tBlk++) {		\
 			dst = dstBlockStart;							\
 			for (int sBlk = 0; sBlk < sBlkCount; sBlk++) {	\
@@ -253,7 +280,7 @@ static void SetSpans(int sBlkSize, int tBlkSize, s32* tSpan, s32* sBlkSpan, s32*
 			dstBlockStart += writeStride;					\
 		}													\
 
-static void EncodeRGBA6(u8 *dst, u8 *src, u32 format)
+static void EncodeRGBA6(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -490,7 +517,7 @@ static void EncodeRGBA6(u8 *dst, u8 *src, u32 format)
 }
 
 
-static void EncodeRGBA6halfscale(u8 *dst, u8 *src, u32 format)
+static void EncodeRGBA6halfscale(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -725,7 +752,7 @@ static void EncodeRGBA6halfscale(u8 *dst, u8 *src, u32 format)
 	}
 }
 
-static void EncodeRGB8(u8 *dst, u8 *src, u32 format)
+static void EncodeRGB8(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -939,7 +966,7 @@ static void EncodeRGB8(u8 *dst, u8 *src, u32 format)
 	}
 }
 
-static void EncodeRGB8halfscale(u8 *dst, u8 *src, u32 format)
+static void EncodeRGB8halfscale(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -1170,7 +1197,7 @@ static void EncodeRGB8halfscale(u8 *dst, u8 *src, u32 format)
 	}
 }
 
-static void EncodeZ24(u8 *dst, u8 *src, u32 format)
+static void EncodeZ24(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -1274,7 +1301,7 @@ static void EncodeZ24(u8 *dst, u8 *src, u32 format)
 	}
 }
 
-static void EncodeZ24halfscale(u8 *dst, u8 *src, u32 format)
+static void EncodeZ24halfscale(u8 *dst, u8 *src, u32 format, const Band& band)
 {
 	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
 	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
@@ -1384,10 +1411,177 @@ static void EncodeZ24halfscale(u8 *dst, u8 *src, u32 format)
 	}
 }
 
-void Encode(u8 *dest_ptr)
+#ifdef _M_X86
+// Loads four full scale EFB pixels, expanded to 8 bits per channel as 0xAARRGGBB
+template <bool rgba6>
+static inline __m128i LoadARGB(const u8* src)
+{
+	__m128i raw = _mm_setr_epi32(*(u32*)src, *(u32*)(src + 3), *(u32*)(src + 6), *(u32*)(src + 9));
+	if (!rgba6)
+		return _mm_or_si128(raw, _mm_set1_epi32(0xff000000));
+
+	const __m128i mask = _mm_set1_epi32(0x3f);
+	__m128i c6 = _mm_slli_epi32(_mm_and_si128(raw, mask), 24);
+	c6 = _mm_or_si128(c6, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(raw, 18), mask), 16));
+	c6 = _mm_or_si128(c6, _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(raw, 12), mask), 8));
+	c6 = _mm_or_si128(c6, _mm_and_si128(_mm_srli_epi32(raw, 6), mask));
+
+	// Convert6To8 on every byte
+	return _mm_or_si128(_mm_slli_epi32(c6, 2), _mm_and_si128(_mm_srli_epi32(c6, 4), _mm_set1_epi32(0x03030303)));
+}
+
+// Same as RGB8_to_I, for every lane
+static inline __m128i ARGB_to_I(__m128i argb)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	__m128i r = _mm_and_si128(_mm_srli_epi32(argb, 16), mask);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(argb, 8), mask);
+	__m128i b = _mm_and_si128(argb, mask);
+
+	__m128i val = _mm_add_epi32(_mm_set1_epi32(4096), _mm_mullo_epi16(r, _mm_set1_epi32(66)));
+	val = _mm_add_epi32(val, _mm_mullo_epi16(g, _mm_set1_epi32(129)));
+	val = _mm_add_epi32(val, _mm_mullo_epi16(b, _mm_set1_epi32(25)));
+	return _mm_srli_epi32(val, 8);
+}
+
+// Packs the low 16 bits of every lane of a, followed by the ones of b
+static inline __m128i PackU16(__m128i a, __m128i b)
+{
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+// Walks the blocks of a full scale copy like ENCODE_LOOP_BLOCKS, but encodes one row of a block at a time
+template <typename EncodeRow>
+static void EncodeBlockRows(u8 *dst, u8 *src, const Band& band, int blkWidthLog2, int blkHeightLog2,
+                            int blockBytes, EncodeRow encodeRow)
+{
+	u16 sBlkCount, tBlkCount, sBlkSize, tBlkSize;
+	s32 tSpan, sBlkSpan, tBlkSpan, writeStride;
+	u8 *dstBlockStart = dst;
+
+	SetBlockDimensions(blkWidthLog2, blkHeightLog2, &sBlkCount, &tBlkCount, &sBlkSize, &tBlkSize);
+	SetSpans(sBlkSize, tBlkSize, &tSpan, &sBlkSpan, &tBlkSpan, &writeStride);
+	SetBand(band, tBlkSize, writeStride, &tBlkCount, &src, &dstBlockStart);
+
+	for (int tBlk = 0; tBlk < tBlkCount; tBlk++)
+	{
+		dst = dstBlockStart;
+		for (int sBlk = 0; sBlk < sBlkCount; sBlk++)
+		{
+			for (int t = 0; t < tBlkSize; t++)
+				encodeRow(src + (sBlk * sBlkSize + t * 640) * 3, dst, t);
+			dst += blockBytes;
+		}
+		src += 640 * tBlkSize * 3;
+		dstBlockStart += writeStride;
+	}
+}
+
+template <bool rgba6>
+static bool EncodeFast(u8 *dst, u8 *src, u32 format, const Band& band)
+{
+	switch (format)
+	{
+	case GX_TF_I8:
+		EncodeBlockRows(dst, src, band, 3, 2, 32, [](const u8* rowSrc, u8* blockDst, int t)
+		{
+			__m128i i0 = ARGB_to_I(LoadARGB<rgba6>(rowSrc));
+			__m128i i1 = ARGB_to_I(LoadARGB<rgba6>(rowSrc + 12));
+			__m128i i = _mm_packs_epi32(i0, i1);
+			_mm_storel_epi64((__m128i*)(blockDst + t * 8), _mm_packus_epi16(i, i));
+		});
+		return true;
+
+	case GX_TF_IA8:
+		EncodeBlockRows(dst, src, band, 2, 2, 32, [](const u8* rowSrc, u8* blockDst, int t)
+		{
+			__m128i argb = LoadARGB<rgba6>(rowSrc);
+			__m128i ia = _mm_or_si128(_mm_srli_epi32(argb, 24), _mm_slli_epi32(ARGB_to_I(argb), 8));
+			_mm_storel_epi64((__m128i*)(blockDst + t * 8), PackU16(ia, ia));
+		});
+		return true;
+
+	case GX_TF_RGB565:
+		EncodeBlockRows(dst, src, band, 2, 2, 32, [](const u8* rowSrc, u8* blockDst, int t)
+		{
+			__m128i argb = LoadARGB<rgba6>(rowSrc);
+			__m128i val = _mm_and_si128(_mm_srli_epi32(argb, 8), _mm_set1_epi32(0xf800));
+			val = _mm_or_si128(val, _mm_and_si128(_mm_srli_epi32(argb, 5), _mm_set1_epi32(0x07e0)));
+			val = _mm_or_si128(val, _mm_and_si128(_mm_srli_epi32(argb, 3), _mm_set1_epi32(0x001e)));
+			val = _mm_or_si128(_mm_srli_epi32(val, 8), _mm_slli_epi32(val, 8)); // Common::swap16
+			val = PackU16(val, val);
+			_mm_storel_epi64((__m128i*)(blockDst + t * 8), val);
+		});
+		return true;
+
+	case GX_TF_RGBA8:
+		EncodeBlockRows(dst, src, band, 2, 2, 64, [](const u8* rowSrc, u8* blockDst, int t)
+		{
+			__m128i argb = LoadARGB<rgba6>(rowSrc);
+			const __m128i mask = _mm_set1_epi32(0xff);
+			__m128i ar = _mm_or_si128(_mm_srli_epi32(argb, 24), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(argb, 16), mask), 8));
+			__m128i gb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(argb, 8), mask), _mm_slli_epi32(_mm_and_si128(argb, mask), 8));
+			__m128i packed = PackU16(ar, gb);
+			_mm_storel_epi64((__m128i*)(blockDst + t * 8), packed);
+			_mm_storel_epi64((__m128i*)(blockDst + 32 + t * 8), _mm_srli_si128(packed, 8));
+		});
+		return true;
+
+	default:
+		return false;
+	}
+}
+#endif
+
+// Encodes the most common full scale color copies with SSE2. Returns false if the copy has to be
+// encoded by the generic code instead.
+static bool EncodeBandFast(u8 *dest_ptr, u8 *src, u32 format, const Band& band)
+{
+#ifdef _M_X86
+	if (bpmem.triggerEFBCopy.half_scale)
+		return false;
+
+	auto pixelformat = bpmem.zcontrol.pixel_format;
+	if (pixelformat == PEControl::RGBA6_Z24)
+		return EncodeFast<true>(dest_ptr, src, format, band);
+	else if (pixelformat == PEControl::RGB8_Z24 || pixelformat == PEControl::RGB565_Z16)
+		return EncodeFast<false>(dest_ptr, src, format, band);
+#endif
+	return false;
+}
+
+static void EncodeBand(u8 *dest_ptr, u8 *src, u32 format, const Band& band)
 {
 	auto pixelformat = bpmem.zcontrol.pixel_format;
-	bool bFromZBuffer = pixelformat == PEControl::Z24;
+	if (bpmem.triggerEFBCopy.half_scale)
+	{
+		if (pixelformat == PEControl::RGBA6_Z24)
+			EncodeRGBA6halfscale(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::RGB8_Z24)
+			EncodeRGB8halfscale(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::RGB565_Z16)  // not supported
+			EncodeRGB8halfscale(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::Z24)
+			EncodeZ24halfscale(dest_ptr, src, format, band);
+	}
+	else
+	{
+		if (pixelformat == PEControl::RGBA6_Z24)
+			EncodeRGBA6(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::RGB8_Z24)
+			EncodeRGB8(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::RGB565_Z16)  // not supported
+			EncodeRGB8(dest_ptr, src, format, band);
+		else if (pixelformat == PEControl::Z24)
+			EncodeZ24(dest_ptr, src, format, band);
+	}
+}
+
+static u32 GetEncodeFormat()
+{
+	bool bFromZBuffer = bpmem.zcontrol.pixel_format == PEControl::Z24;
 	bool bIsIntensityFmt = bpmem.triggerEFBCopy.intensity_fmt > 0;
 	u32 copyfmt = ((bpmem.triggerEFBCopy.target_pixel_format / 2) + ((bpmem.triggerEFBCopy.target_pixel_format & 1) * 8));
 
@@ -1405,30 +1599,51 @@ void Encode(u8 *dest_ptr)
 		if (copyfmt > GX_TF_RGBA8 || (copyfmt < GX_TF_RGB565 && !bIsIntensityFmt))
 			format |= _GX_TF_CTF;
 
-	u8 *src = EfbInterface::GetPixelPointer(bpmem.copyTexSrcXY.x, bpmem.copyTexSrcXY.y, bFromZBuffer);
+	return format;
+}
 
-	if (bpmem.triggerEFBCopy.half_scale)
+static u8* GetEncodeSource()
+{
+	bool bFromZBuffer = bpmem.zcontrol.pixel_format == PEControl::Z24;
+
+	// The encoders read whole blocks of up to 8x8 texels, so up to 16 pixels past the copy
+	// rectangle with half scale
+	int left = bpmem.copyTexSrcXY.x;
+	int top = bpmem.copyTexSrcXY.y;
+	EFBRectangle rect(left, top, left + bpmem.copyTexSrcWH.x + 1 + 16, top + bpmem.copyTexSrcWH.y + 1 + 16);
+	return EfbInterface::PackRect(rect, bFromZBuffer);
+}
+
+void Encode(u8 *dest_ptr)
+{
+	u32 format = GetEncodeFormat();
+	u8 *src = GetEncodeSource();
+
+	// Small copies aren't worth waking up the other threads for
+	if ((u32)((bpmem.copyTexSrcWH.x + 1) * (bpmem.copyTexSrcWH.y + 1)) < MIN_PARALLEL_PIXELS)
 	{
-		if (pixelformat == PEControl::RGBA6_Z24)
-			EncodeRGBA6halfscale(dest_ptr, src, format);
-		else if (pixelformat == PEControl::RGB8_Z24)
-			EncodeRGB8halfscale(dest_ptr, src, format);
-		else if (pixelformat == PEControl::RGB565_Z16)  // not supported
-			EncodeRGB8halfscale(dest_ptr, src, format);
-		else if (pixelformat == PEControl::Z24)
-			EncodeZ24halfscale(dest_ptr, src, format);
+		Rasterizer::Flush();
+		if (!EncodeBandFast(dest_ptr, src, format, { 0, 1 }))
+			EncodeBand(dest_ptr, src, format, { 0, 1 });
+		return;
 	}
-	else
+
+	const u32 numBands = MAX_BANDS;
+	std::atomic<u32> nextBand(0);
+	Rasterizer::RunOnAllThreads([&]
 	{
-		if (pixelformat == PEControl::RGBA6_Z24)
-			EncodeRGBA6(dest_ptr, src, format);
-		else if (pixelformat == PEControl::RGB8_Z24)
-			EncodeRGB8(dest_ptr, src, format);
-		else if (pixelformat == PEControl::RGB565_Z16)  // not supported
-			EncodeRGB8(dest_ptr, src, format);
-		else if (pixelformat == PEControl::Z24)
-			EncodeZ24(dest_ptr, src, format);
-	}
+		u32 band;
+		while ((band = nextBand++) < numBands)
+		{
+			if (!EncodeBandFast(dest_ptr, src, format, { band, numBands }))
+				EncodeBand(dest_ptr, src, format, { band, numBands });
+		}
+	});
+}
+
+void EncodeReference(u8 *dest_ptr)
+{
+	EncodeBand(dest_ptr, GetEncodeSource(), GetEncodeFormat(), { 0, 1 });
 }
 
 
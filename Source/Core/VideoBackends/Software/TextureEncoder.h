@@ -9,4 +9,7 @@
 namespace TextureEncoder
 {
 	void Encode(u8 *dest_ptr);
+
+	// Same as Encode(), but on the calling thread only and without the SIMD fast paths
+	void EncodeReference(u8 *dest_ptr);
 }
@@ -4,10 +4,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "Common/Common.h"
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/BPMemLoader.h"
+#include "VideoBackends/Software/SWTextureCache.h"
 #include "VideoBackends/Software/TextureSampler.h"
 #include "VideoCommon/TextureDecoder.h"
 
@@ -101,64 +103,34 @@ void Sample(s32 s, s32 t, s32 lod, bool linear, u8 texmap, u8 *sample)
 	}
 }
 
-void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
+u32 GetMipOffset(int imageWidth, int imageHeight, int mip, int format)
 {
-	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
-	u8 subTexmap = texmap & 3;
-
-	TexMode0& tm0 = texUnit.texMode0[subTexmap];
-	TexImage0& ti0 = texUnit.texImage0[subTexmap];
-	TexTLUT& texTlut = texUnit.texTlut[subTexmap];
-	TlutFormat tlutfmt = (TlutFormat) texTlut.tlut_format;
-
-	u8 *imageSrc, *imageSrcOdd = nullptr;
-	if (texUnit.texImage1[subTexmap].image_type)
-	{
-		imageSrc = &texMem[texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE];
-		if (ti0.format == GX_TF_RGBA8)
-			imageSrcOdd = &texMem[texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE];
-	}
-	else
-	{
-		u32 imageBase = texUnit.texImage3[subTexmap].image_base << 5;
-		imageSrc = Memory::GetPointer(imageBase);
-	}
-
-	int imageWidth = ti0.width;
-	int imageHeight = ti0.height;
+	int mipWidth = imageWidth + 1;
+	int mipHeight = imageHeight + 1;
 
-	int tlutAddress = texTlut.tmem_offset << 9;
-	const u8* tlut = &texMem[tlutAddress];
+	int fmtWidth = TexDecoder_GetBlockWidthInTexels(format);
+	int fmtHeight = TexDecoder_GetBlockHeightInTexels(format);
+	int fmtDepth = TexDecoder_GetTexelSizeInNibbles(format);
 
-	// reduce sample location and texture size to mip level
-	// move texture pointer to mip location
-	if (mip)
+	u32 offset = 0;
+	while (mip)
 	{
-		int mipWidth = imageWidth + 1;
-		int mipHeight = imageHeight + 1;
-
-		int fmtWidth = TexDecoder_GetBlockWidthInTexels(ti0.format);
-		int fmtHeight = TexDecoder_GetBlockHeightInTexels(ti0.format);
-		int fmtDepth = TexDecoder_GetTexelSizeInNibbles(ti0.format);
-
-		imageWidth >>= mip;
-		imageHeight >>= mip;
-		s >>= mip;
-		t >>= mip;
-
-		while (mip)
-		{
-			mipWidth = std::max(mipWidth, fmtWidth);
-			mipHeight = std::max(mipHeight, fmtHeight);
-			u32 size = (mipWidth * mipHeight * fmtDepth) >> 1;
-
-			imageSrc += size;
-			mipWidth >>= 1;
-			mipHeight >>= 1;
-			mip--;
-		}
+		mipWidth = std::max(mipWidth, fmtWidth);
+		mipHeight = std::max(mipHeight, fmtHeight);
+		u32 size = (mipWidth * mipHeight * fmtDepth) >> 1;
+
+		offset += size;
+		mipWidth >>= 1;
+		mipHeight >>= 1;
+		mip--;
 	}
+	return offset;
+}
 
+// Filters the texels returned by fetchTexel(dst, s, t), with s and t in 1/128 texels
+template <typename FetchTexel>
+static void SampleTexels(s32 s, s32 t, int imageWidth, int imageHeight, const TexMode0& tm0, bool linear, FetchTexel fetchTexel, u8 *sample)
+{
 	if (linear)
 	{
 		// offset linear sampling
@@ -184,34 +156,17 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(&imageSPlus1, tm0.wrap_s, imageWidth);
 		WrapCoord(&imageTPlus1, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-		{
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageT, imageWidth, ti0.format, tlut, tlutfmt);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageT, imageWidth, ti0.format, tlut, tlutfmt);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageTPlus1, imageWidth, ti0.format, tlut, tlutfmt);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageTPlus1, imageWidth, ti0.format, tlut, tlutfmt);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
-		else
-		{
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
+		fetchTexel(sampledTex, imageS, imageT);
+		SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
 
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageT, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
+		fetchTexel(sampledTex, imageSPlus1, imageT);
+		AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
 
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
+		fetchTexel(sampledTex, imageS, imageTPlus1);
+		AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
 
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
+		fetchTexel(sampledTex, imageSPlus1, imageTPlus1);
+		AddTexel(sampledTex, texel, (fractS) * (fractT));
 
 		sample[0] = (u8)(texel[0] >> 14);
 		sample[1] = (u8)(texel[1] >> 14);
@@ -228,10 +183,78 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(&imageS, tm0.wrap_s, imageWidth);
 		WrapCoord(&imageT, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-			TexDecoder_DecodeTexel(sample, imageSrc, imageS, imageT, imageWidth, ti0.format, tlut, tlutfmt);
-		else
-			TexDecoder_DecodeTexelRGBA8FromTmem(sample, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
+		fetchTexel(sample, imageS, imageT);
+	}
+}
+
+void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
+{
+	FourTexUnits& texUnit = bpmem.tex[(texmap >> 2) & 1];
+	u8 subTexmap = texmap & 3;
+
+	TexMode0& tm0 = texUnit.texMode0[subTexmap];
+
+	// Textures used by the current primitive have already been decoded
+	const SWTextureCache::Level* level = SWTextureCache::GetLevel(texmap, mip);
+	if (level)
+	{
+		const u32* texels = level->texels.data();
+		const int stride = level->width;
+		SampleTexels(s >> mip, t >> mip, level->width - 1, level->height - 1, tm0, linear,
+			[texels, stride](u8* dst, int imageS, int imageT) {
+				memcpy(dst, &texels[imageT * stride + imageS], 4);
+			}, sample);
+		return;
+	}
+
+	TexImage0& ti0 = texUnit.texImage0[subTexmap];
+	TexTLUT& texTlut = texUnit.texTlut[subTexmap];
+	TlutFormat tlutfmt = (TlutFormat) texTlut.tlut_format;
+
+	u8 *imageSrc, *imageSrcOdd = nullptr;
+	if (texUnit.texImage1[subTexmap].image_type)
+	{
+		imageSrc = &texMem[texUnit.texImage1[subTexmap].tmem_even * TMEM_LINE_SIZE];
+		if (ti0.format == GX_TF_RGBA8)
+			imageSrcOdd = &texMem[texUnit.texImage2[subTexmap].tmem_odd * TMEM_LINE_SIZE];
+	}
+	else
+	{
+		u32 imageBase = texUnit.texImage3[subTexmap].image_base << 5;
+		imageSrc = Memory::GetPointer(imageBase);
+	}
+
+	int imageWidth = ti0.width;
+	int imageHeight = ti0.height;
+
+	int tlutAddress = texTlut.tmem_offset << 9;
+	const u8* tlut = &texMem[tlutAddress];
+
+	// reduce sample location and texture size to mip level
+	// move texture pointer to mip location
+	if (mip)
+	{
+		imageWidth >>= mip;
+		imageHeight >>= mip;
+		s >>= mip;
+		t >>= mip;
+
+		imageSrc += GetMipOffset(ti0.width, ti0.height, mip, ti0.format);
+	}
+
+	if (imageSrcOdd)
+	{
+		SampleTexels(s, t, imageWidth, imageHeight, tm0, linear,
+			[=](u8* dst, int imageS, int imageT) {
+				TexDecoder_DecodeTexelRGBA8FromTmem(dst, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
+			}, sample);
+	}
+	else
+	{
+		SampleTexels(s, t, imageWidth, imageHeight, tm0, linear,
+			[=](u8* dst, int imageS, int imageT) {
+				TexDecoder_DecodeTexel(dst, imageSrc, imageS, imageT, imageWidth, ti0.format, tlut, tlutfmt);
+			}, sample);
 	}
 }
 
@@ -12,6 +12,9 @@ namespace TextureSampler
 
 	void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample);
 
+	// Byte offset of the given mip level, for a texture of (imageWidth + 1) x (imageHeight + 1) texels
+	u32 GetMipOffset(int imageWidth, int imageHeight, int mip, int format);
+
 	enum
 	{
 		RED_SMP,
@@ -6,6 +6,7 @@
 #include <cmath>
 
 #include "Common/CommonTypes.h"
+#include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
 
 #include "VideoBackends/Software/BPMemLoader.h"
@@ -296,38 +297,84 @@ static void LightAlpha(const Vec3 &pos, const Vec3 &normal, u8 lightNum, const L
 	}
 }
 
+static Vec3 GetAmbientColor(const InputVertexData *src, u32 chan)
+{
+	if (xfmem.color[chan].ambsource)
+	{
+		// vertex
+		return Vec3(src->color[chan][1], src->color[chan][2], src->color[chan][3]);
+	}
+
+	u8 *ambColor = (u8*)&xfmem.ambColor[chan];
+	return Vec3(ambColor[1], ambColor[2], ambColor[3]);
+}
+
+static float GetAmbientAlpha(const InputVertexData *src, u32 chan)
+{
+	if (xfmem.alpha[chan].ambsource)
+		return src->color[chan][0]; // vertex
+	else
+		return (float)(xfmem.ambColor[chan] & 0xff);
+}
+
+// Applies the light color and alpha, which are only used if lighting is enabled, to the material color
+static void CombineChannelColor(const InputVertexData *src, u32 chan, const Vec3 &lightCol, float lightAlpha, u8 *dst)
+{
+	// abgr
+	u8 matcolor[4];
+	u8 chancolor[4];
+
+	// color
+	LitChannel &colorchan = xfmem.color[chan];
+	if (colorchan.matsource)
+		*(u32*)matcolor = *(u32*)src->color[chan];  // vertex
+	else
+		*(u32*)matcolor = xfmem.matColor[chan];
+
+	if (colorchan.enablelighting)
+	{
+		int light_x = MathUtil::Clamp(static_cast<int>(lightCol.x), 0, 255);
+		int light_y = MathUtil::Clamp(static_cast<int>(lightCol.y), 0, 255);
+		int light_z = MathUtil::Clamp(static_cast<int>(lightCol.z), 0, 255);
+		chancolor[1] = (matcolor[1] * (light_x + (light_x >> 7))) >> 8;
+		chancolor[2] = (matcolor[2] * (light_y + (light_y >> 7))) >> 8;
+		chancolor[3] = (matcolor[3] * (light_z + (light_z >> 7))) >> 8;
+	}
+	else
+	{
+		*(u32*)chancolor = *(u32*)matcolor;
+	}
+
+	// alpha
+	LitChannel &alphachan = xfmem.alpha[chan];
+	if (alphachan.matsource)
+		matcolor[0] = src->color[chan][0];  // vertex
+	else
+		matcolor[0] = xfmem.matColor[chan] & 0xff;
+
+	if (alphachan.enablelighting)
+	{
+		int light_a = MathUtil::Clamp(static_cast<int>(lightAlpha), 0, 255);
+		chancolor[0] = (matcolor[0] * (light_a + (light_a >> 7))) >> 8;
+	}
+	else
+	{
+		chancolor[0] = matcolor[0];
+	}
+
+	// abgr -> rgba
+	*(u32*)dst = Common::swap32(*(u32*)chancolor);
+}
+
 void TransformColor(const InputVertexData *src, OutputVertexData *dst)
 {
 	for (u32 chan = 0; chan < xfmem.numChan.numColorChans; chan++)
 	{
-		// abgr
-		u8 matcolor[4];
-		u8 chancolor[4];
-
-		// color
+		Vec3 lightCol(0.0f);
 		LitChannel &colorchan = xfmem.color[chan];
-		if (colorchan.matsource)
-			*(u32*)matcolor = *(u32*)src->color[chan];  // vertex
-		else
-			*(u32*)matcolor = xfmem.matColor[chan];
-
 		if (colorchan.enablelighting)
 		{
-			Vec3 lightCol;
-			if (colorchan.ambsource)
-			{
-				// vertex
-				lightCol.x = src->color[chan][1];
-				lightCol.y = src->color[chan][2];
-				lightCol.z = src->color[chan][3];
-			}
-			else
-			{
-				u8 *ambColor = (u8*)&xfmem.ambColor[chan];
-				lightCol.x = ambColor[1];
-				lightCol.y = ambColor[2];
-				lightCol.z = ambColor[3];
-			}
+			lightCol = GetAmbientColor(src, chan);
 
 			u8 mask = colorchan.GetFullLightMask();
 			for (int i = 0; i < 8; ++i)
@@ -335,51 +382,23 @@ void TransformColor(const InputVertexData *src, OutputVertexData *dst)
 				if (mask&(1<<i))
 					LightColor(dst->mvPosition, dst->normal[0], i, colorchan, lightCol);
 			}
-
-			int light_x = MathUtil::Clamp(static_cast<int>(lightCol.x), 0, 255);
-			int light_y = MathUtil::Clamp(static_cast<int>(lightCol.y), 0, 255);
-			int light_z = MathUtil::Clamp(static_cast<int>(lightCol.z), 0, 255);
-			chancolor[1] = (matcolor[1] * (light_x + (light_x >> 7))) >> 8;
-			chancolor[2] = (matcolor[2] * (light_y + (light_y >> 7))) >> 8;
-			chancolor[3] = (matcolor[3] * (light_z + (light_z >> 7))) >> 8;
-		}
-		else
-		{
-			*(u32*)chancolor = *(u32*)matcolor;
 		}
 
-		// alpha
+		float lightAlpha = 0.0f;
 		LitChannel &alphachan = xfmem.alpha[chan];
-		if (alphachan.matsource)
-			matcolor[0] = src->color[chan][0];  // vertex
-		else
-			matcolor[0] = xfmem.matColor[chan] & 0xff;
-
-		if (xfmem.alpha[chan].enablelighting)
+		if (alphachan.enablelighting)
 		{
-			float lightCol;
-			if (alphachan.ambsource)
-				lightCol = src->color[chan][0]; // vertex
-			else
-				lightCol = (float)(xfmem.ambColor[chan] & 0xff);
+			lightAlpha = GetAmbientAlpha(src, chan);
 
 			u8 mask = alphachan.GetFullLightMask();
 			for (int i = 0; i < 8; ++i)
 			{
 				if (mask&(1<<i))
-					LightAlpha(dst->mvPosition, dst->normal[0], i, alphachan, lightCol);
+					LightAlpha(dst->mvPosition, dst->normal[0], i, alphachan, lightAlpha);
 			}
-
-			int light_a = MathUtil::Clamp(static_cast<int>(lightCol), 0, 255);
-			chancolor[0] = (matcolor[0] * (light_a + (light_a >> 7))) >> 8;
-		}
-		else
-		{
-			chancolor[0] = matcolor[0];
 		}
 
-		// abgr -> rgba
-		*(u32*)dst->color[chan] = Common::swap32(*(u32*)chancolor);
+		CombineChannelColor(src, chan, lightCol, lightAlpha, dst->color[chan]);
 	}
 }
 
@@ -433,4 +452,376 @@ void TransformTexCoord(const InputVertexData *src, OutputVertexData *dst, bool s
 	}
 }
 
+
+#ifdef _M_X86
+
+// The vertices of a batch as structure of arrays, so that four vertices fit into the lanes of a
+// register. The lanes past the end of the batch repeat the last vertex.
+struct VertexBatch
+{
+	alignas(16) float position[3][MAX_BATCH_SIZE];
+	alignas(16) float mvPosition[3][MAX_BATCH_SIZE];
+	alignas(16) float projectedPosition[4][MAX_BATCH_SIZE];
+	alignas(16) float normal[3][3][MAX_BATCH_SIZE];
+	alignas(16) float lightColor[3][MAX_BATCH_SIZE];
+	alignas(16) float lightAlpha[MAX_BATCH_SIZE];
+};
+
+static VertexBatch s_batch;
+
+struct Vec3x4
+{
+	__m128 x, y, z;
+};
+
+static inline Vec3x4 LoadVec3x4(const float (*src)[MAX_BATCH_SIZE], int i)
+{
+	return { _mm_load_ps(&src[0][i]), _mm_load_ps(&src[1][i]), _mm_load_ps(&src[2][i]) };
+}
+
+static inline void StoreVec3x4(float (*dst)[MAX_BATCH_SIZE], int i, const Vec3x4 &v)
+{
+	_mm_store_ps(&dst[0][i], v.x);
+	_mm_store_ps(&dst[1][i], v.y);
+	_mm_store_ps(&dst[2][i], v.z);
+}
+
+static inline Vec3x4 Broadcast(const Vec3 &v)
+{
+	return { _mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z) };
+}
+
+static inline Vec3x4 Select(__m128 mask, const Vec3x4 &a, const Vec3x4 &b)
+{
+	return {
+		_mm_or_ps(_mm_and_ps(mask, a.x), _mm_andnot_ps(mask, b.x)),
+		_mm_or_ps(_mm_and_ps(mask, a.y), _mm_andnot_ps(mask, b.y)),
+		_mm_or_ps(_mm_and_ps(mask, a.z), _mm_andnot_ps(mask, b.z)),
+	};
+}
+
+// All of these do the same operations in the same order as the Vec3 versions, so the results are
+// bit-identical.
+static inline __m128 Dot(const Vec3x4 &a, const Vec3x4 &b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+static inline Vec3x4 Scale(const Vec3x4 &v, __m128 f)
+{
+	return { _mm_mul_ps(v.x, f), _mm_mul_ps(v.y, f), _mm_mul_ps(v.z, f) };
+}
+
+static inline Vec3x4 Normalized(const Vec3x4 &v)
+{
+	return Scale(v, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(Dot(v, v))));
+}
+
+static inline __m128 SafeDivide(__m128 n, __m128 d)
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 divByZero = _mm_cmpeq_ps(d, zero);
+	__m128 special = _mm_and_ps(_mm_cmpgt_ps(n, zero), _mm_set1_ps(1.0f));
+	return _mm_or_ps(_mm_and_ps(divByZero, special), _mm_andnot_ps(divByZero, _mm_div_ps(n, d)));
+}
+
+// Loads the given elements of the matrices used by four vertices, one matrix per lane
+static inline void LoadMatrices(const float* const mats[4], int numElements, __m128 *elements)
+{
+	if (mats[0] == mats[1] && mats[0] == mats[2] && mats[0] == mats[3])
+	{
+		for (int i = 0; i < numElements; i++)
+			elements[i] = _mm_set1_ps(mats[0][i]);
+	}
+	else
+	{
+		for (int i = 0; i < numElements; i++)
+			elements[i] = _mm_setr_ps(mats[0][i], mats[1][i], mats[2][i], mats[3][i]);
+	}
+}
+
+static inline __m128 MultiplyRow3(const __m128 *row, const Vec3x4 &v)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(row[0], v.x), _mm_mul_ps(row[1], v.y)), _mm_mul_ps(row[2], v.z));
+}
+
+static void TransformPositions(const InputVertexData *src, int count, int i)
+{
+	const float* mats[4];
+	for (int lane = 0; lane < 4; lane++)
+		mats[lane] = &xfmem.posMatrices[src[std::min(i + lane, count - 1)].posMtx * 4];
+
+	__m128 mat[12];
+	LoadMatrices(mats, 12, mat);
+
+	Vec3x4 pos = LoadVec3x4(s_batch.position, i);
+	Vec3x4 mv = {
+		_mm_add_ps(MultiplyRow3(&mat[0], pos), mat[3]),
+		_mm_add_ps(MultiplyRow3(&mat[4], pos), mat[7]),
+		_mm_add_ps(MultiplyRow3(&mat[8], pos), mat[11]),
+	};
+	StoreVec3x4(s_batch.mvPosition, i, mv);
+
+	const float* proj = xfmem.projection.rawProjection;
+	__m128 x, y, z, w;
+	if (xfmem.projection.type == GX_PERSPECTIVE)
+	{
+		x = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv.x), _mm_mul_ps(_mm_set1_ps(proj[1]), mv.z));
+		y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv.y), _mm_mul_ps(_mm_set1_ps(proj[3]), mv.z));
+		z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv.z), _mm_set1_ps(proj[5]));
+		z = _mm_mul_ps(z, _mm_set1_ps(1.0f - (float)1e-7));
+		w = _mm_xor_ps(mv.z, _mm_set1_ps(-0.0f));
+	}
+	else
+	{
+		x = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[0]), mv.x), _mm_set1_ps(proj[1]));
+		y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[2]), mv.y), _mm_set1_ps(proj[3]));
+		z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(proj[4]), mv.z), _mm_set1_ps(proj[5]));
+		w = _mm_set1_ps(1.0f);
+	}
+	_mm_store_ps(&s_batch.projectedPosition[0][i], x);
+	_mm_store_ps(&s_batch.projectedPosition[1][i], y);
+	_mm_store_ps(&s_batch.projectedPosition[2][i], z);
+	_mm_store_ps(&s_batch.projectedPosition[3][i], w);
+}
+
+static void TransformNormals(const InputVertexData *src, bool nbt, int count, int i)
+{
+	const float* mats[4];
+	for (int lane = 0; lane < 4; lane++)
+		mats[lane] = &xfmem.normalMatrices[(src[std::min(i + lane, count - 1)].posMtx & 31) * 3];
+
+	__m128 mat[9];
+	LoadMatrices(mats, 9, mat);
+
+	for (int n = 0; n < (nbt ? 3 : 1); n++)
+	{
+		Vec3x4 normal = LoadVec3x4(s_batch.normal[n], i);
+		Vec3x4 result = { MultiplyRow3(&mat[0], normal), MultiplyRow3(&mat[3], normal), MultiplyRow3(&mat[6], normal) };
+		StoreVec3x4(s_batch.normal[n], i, n == 0 ? Normalized(result) : result);
+	}
+}
+
+static __m128 CalculateLightAttn(const LightPointer *light, Vec3x4 *ldir, const Vec3x4 &normal, const LitChannel &chan)
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	switch (chan.attnfunc)
+	{
+		case LIGHTATTN_NONE:
+		case LIGHTATTN_DIR:
+		{
+			*ldir = Normalized(*ldir);
+			__m128 isZero = _mm_and_ps(_mm_and_ps(_mm_cmpeq_ps(ldir->x, zero), _mm_cmpeq_ps(ldir->y, zero)),
+			                           _mm_cmpeq_ps(ldir->z, zero));
+			*ldir = Select(isZero, normal, *ldir);
+			return _mm_set1_ps(1.0f);
+		}
+		case LIGHTATTN_SPEC:
+		{
+			*ldir = Normalized(*ldir);
+			__m128 facing = _mm_cmpge_ps(Dot(*ldir, normal), zero);
+			__m128 attn = _mm_and_ps(facing, _mm_max_ps(Dot(Broadcast(light->dir), normal), zero));
+
+			Vec3 cosAttn = light->cosatt;
+			Vec3 distAttn = light->distatt;
+			if (chan.diffusefunc != LIGHTDIF_NONE)
+				distAttn = distAttn.Normalized();
+
+			// Dot products with (1, attn, attn * attn)
+			__m128 attn2 = _mm_mul_ps(attn, attn);
+			__m128 cosAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cosAttn.x), _mm_mul_ps(attn, _mm_set1_ps(cosAttn.y))),
+			                           _mm_mul_ps(attn2, _mm_set1_ps(cosAttn.z)));
+			__m128 distAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(distAttn.x), _mm_mul_ps(attn, _mm_set1_ps(distAttn.y))),
+			                            _mm_mul_ps(attn2, _mm_set1_ps(distAttn.z)));
+			return SafeDivide(_mm_max_ps(cosAtt, zero), distAtt);
+		}
+		case LIGHTATTN_SPOT:
+		{
+			__m128 dist2 = Dot(*ldir, *ldir);
+			__m128 dist = _mm_sqrt_ps(dist2);
+			*ldir = Scale(*ldir, _mm_div_ps(_mm_set1_ps(1.0f), dist));
+			__m128 attn = _mm_max_ps(Dot(*ldir, Broadcast(light->dir)), zero);
+
+			const Vec3 &cosAttn = light->cosatt;
+			const Vec3 &distAttn = light->distatt;
+			__m128 cosAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(cosAttn.x), _mm_mul_ps(_mm_set1_ps(cosAttn.y), attn)),
+			                           _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(cosAttn.z), attn), attn));
+			__m128 distAtt = _mm_add_ps(_mm_add_ps(_mm_set1_ps(distAttn.x), _mm_mul_ps(_mm_set1_ps(distAttn.y), dist)),
+			                            _mm_mul_ps(_mm_set1_ps(distAttn.z), dist2));
+			return SafeDivide(_mm_max_ps(cosAtt, zero), distAtt);
+		}
+		default:
+			PanicAlert("LightColor");
+			return _mm_set1_ps(1.0f);
+	}
+}
+
+// Calculates the attenuation and the diffuse factor of a light for four vertices.
+// Returns false if the light doesn't contribute anything.
+static bool CalculateLight(u8 lightNum, const LitChannel &chan, int i, __m128 *attn, __m128 *difAttn)
+{
+	const LightPointer *light = (const LightPointer*)&xfmem.lights[lightNum];
+
+	Vec3x4 pos = LoadVec3x4(s_batch.mvPosition, i);
+	Vec3x4 normal = LoadVec3x4(s_batch.normal[0], i);
+	Vec3x4 ldir = {
+		_mm_sub_ps(_mm_set1_ps(light->pos.x), pos.x),
+		_mm_sub_ps(_mm_set1_ps(light->pos.y), pos.y),
+		_mm_sub_ps(_mm_set1_ps(light->pos.z), pos.z),
+	};
+	*attn = CalculateLightAttn(light, &ldir, normal, chan);
+	*difAttn = Dot(ldir, normal);
+
+	switch (chan.diffusefunc)
+	{
+		case LIGHTDIF_NONE:
+		case LIGHTDIF_SIGN:
+			return true;
+		case LIGHTDIF_CLAMP:
+			*difAttn = _mm_max_ps(*difAttn, _mm_setzero_ps());
+			return true;
+		default:
+			_assert_(0);
+			return false;
+	}
+}
+
+static void LightColor(u8 lightNum, const LitChannel &chan, int i)
+{
+	__m128 attn, difAttn;
+	if (!CalculateLight(lightNum, chan, i, &attn, &difAttn))
+		return;
+
+	__m128 scale = chan.diffusefunc == LIGHTDIF_NONE ? attn : _mm_mul_ps(attn, difAttn);
+	const u8 *color = xfmem.lights[lightNum].color;
+	for (int c = 0; c < 3; c++)
+	{
+		__m128 sum = _mm_add_ps(_mm_load_ps(&s_batch.lightColor[c][i]), _mm_mul_ps(_mm_set1_ps(color[c + 1]), scale));
+		_mm_store_ps(&s_batch.lightColor[c][i], sum);
+	}
+}
+
+static void LightAlpha(u8 lightNum, const LitChannel &chan, int i)
+{
+	__m128 attn, difAttn;
+	if (!CalculateLight(lightNum, chan, i, &attn, &difAttn))
+		return;
+
+	__m128 value = _mm_mul_ps(_mm_set1_ps(xfmem.lights[lightNum].color[0]), attn);
+	if (chan.diffusefunc != LIGHTDIF_NONE)
+		value = _mm_mul_ps(value, difAttn);
+	_mm_store_ps(&s_batch.lightAlpha[i], _mm_add_ps(_mm_load_ps(&s_batch.lightAlpha[i]), value));
+}
+
+void TransformVertices(const InputVertexData *src, OutputVertexData *dst, int count, bool hasNormal, bool nbt, bool texGenSpecialCase)
+{
+	_assert_(count > 0 && count <= MAX_BATCH_SIZE);
+	const int paddedCount = (count + 3) & ~3;
+
+	for (int i = 0; i < paddedCount; i++)
+	{
+		const InputVertexData &vertex = src[std::min(i, count - 1)];
+		for (int c = 0; c < 3; c++)
+			s_batch.position[c][i] = vertex.position[c];
+
+		// Without normals, lighting uses what the output vertex held before
+		const Vec3 *normals = hasNormal ? vertex.normal : dst[std::min(i, count - 1)].normal;
+		for (int n = 0; n < 3; n++)
+		{
+			for (int c = 0; c < 3; c++)
+				s_batch.normal[n][c][i] = normals[n][c];
+		}
+	}
+
+	for (int i = 0; i < paddedCount; i += 4)
+	{
+		TransformPositions(src, count, i);
+		if (hasNormal)
+			TransformNormals(src, nbt, count, i);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		OutputVertexData &vertex = dst[i];
+		vertex.mvPosition = Vec3(s_batch.mvPosition[0][i], s_batch.mvPosition[1][i], s_batch.mvPosition[2][i]);
+		vertex.projectedPosition.x = s_batch.projectedPosition[0][i];
+		vertex.projectedPosition.y = s_batch.projectedPosition[1][i];
+		vertex.projectedPosition.z = s_batch.projectedPosition[2][i];
+		vertex.projectedPosition.w = s_batch.projectedPosition[3][i];
+		if (hasNormal)
+		{
+			for (int n = 0; n < (nbt ? 3 : 1); n++)
+				vertex.normal[n] = Vec3(s_batch.normal[n][0][i], s_batch.normal[n][1][i], s_batch.normal[n][2][i]);
+		}
+	}
+
+	// Each channel accumulates its lights for the whole batch before the colors are combined
+	for (u32 chan = 0; chan < xfmem.numChan.numColorChans; chan++)
+	{
+		const LitChannel &colorchan = xfmem.color[chan];
+		if (colorchan.enablelighting)
+		{
+			for (int i = 0; i < paddedCount; i++)
+			{
+				Vec3 ambient = GetAmbientColor(&src[std::min(i, count - 1)], chan);
+				for (int c = 0; c < 3; c++)
+					s_batch.lightColor[c][i] = ambient[c];
+			}
+
+			u8 mask = colorchan.GetFullLightMask();
+			for (int light = 0; light < 8; ++light)
+			{
+				if (mask & (1 << light))
+				{
+					for (int i = 0; i < paddedCount; i += 4)
+						LightColor(light, colorchan, i);
+				}
+			}
+		}
+
+		const LitChannel &alphachan = xfmem.alpha[chan];
+		if (alphachan.enablelighting)
+		{
+			for (int i = 0; i < paddedCount; i++)
+				s_batch.lightAlpha[i] = GetAmbientAlpha(&src[std::min(i, count - 1)], chan);
+
+			u8 mask = alphachan.GetFullLightMask();
+			for (int light = 0; light < 8; ++light)
+			{
+				if (mask & (1 << light))
+				{
+					for (int i = 0; i < paddedCount; i += 4)
+						LightAlpha(light, alphachan, i);
+				}
+			}
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			Vec3 lightCol(s_batch.lightColor[0][i], s_batch.lightColor[1][i], s_batch.lightColor[2][i]);
+			CombineChannelColor(&src[i], chan, lightCol, s_batch.lightAlpha[i], dst[i].color[chan]);
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		TransformTexCoord(&src[i], &dst[i], texGenSpecialCase);
+}
+
+#else
+
+void TransformVertices(const InputVertexData *src, OutputVertexData *dst, int count, bool hasNormal, bool nbt, bool texGenSpecialCase)
+{
+	for (int i = 0; i < count; i++)
+	{
+		TransformPosition(&src[i], &dst[i]);
+		if (hasNormal)
+			TransformNormal(&src[i], nbt, &dst[i]);
+		TransformColor(&src[i], &dst[i]);
+		TransformTexCoord(&src[i], &dst[i], texGenSpecialCase);
+	}
+}
+
+#endif
+
 }
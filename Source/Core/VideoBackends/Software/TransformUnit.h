@@ -13,4 +13,9 @@ namespace TransformUnit
 	void TransformNormal(const InputVertexData *src, bool nbt, OutputVertexData *dst);
 	void TransformColor(const InputVertexData *src, OutputVertexData *dst);
 	void TransformTexCoord(const InputVertexData *src, OutputVertexData *dst, bool specialCase);
+
+	// Transforms a batch of vertices at once, with the same results as calling the functions
+	// above for every single vertex. Positions, normals and lighting use SIMD on x86.
+	static const int MAX_BATCH_SIZE = 64;
+	void TransformVertices(const InputVertexData *src, OutputVertexData *dst, int count, bool hasNormal, bool nbt, bool texGenSpecialCase);
 }
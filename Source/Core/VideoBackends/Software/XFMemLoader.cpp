@@ -7,6 +7,7 @@
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/Clipper.h"
 #include "VideoBackends/Software/CPMemLoader.h"
+#include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/VideoCommon.h"
 
@@ -63,6 +64,10 @@ void SWLoadXFReg(u32 transferSize, u32 baseAddress, u32 *pData)
 	// write to XF regs
 	if (transferSize > 0)
 	{
+		// The rasterizer reads some XF registers, but nothing from the matrix and light memory below them
+		if (baseAddress + transferSize > XFMEM_ERROR)
+			Rasterizer::Flush();
+
 		memcpy((u32*)(&xfmem) + baseAddress, pData, transferSize * 4);
 		XFWritten(transferSize, baseAddress);
 	}
@@ -1119,4 +1119,10 @@ extern BPMemory bpmem;
 void LoadBPReg(u32 value0);
 void LoadBPRegPreprocess(u32 value0);
 
+// In g_use_gpu_convert_thread mode, the conversion thread keeps track of the BP registers ahead
+// of the GPU thread. Returns whether the write would neither change bpmem nor trigger anything,
+// so that the GPU thread can skip it.
+bool IsRedundantBPWrite(u32 value0);
+void ResetBPWriteTracking();
+
 void GetBPRegInfo(const u8* data, std::string* name, std::string* desc);
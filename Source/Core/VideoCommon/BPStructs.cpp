@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <bitset>
 #include <cmath>
 
 #include "Common/StringUtil.h"
@@ -20,6 +21,7 @@
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/RenderBase.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureCacheBase.h"
 #include "VideoCommon/TextureDecoder.h"
@@ -41,6 +43,23 @@ void BPInit()
 {
 	memset(&bpmem, 0, sizeof(bpmem));
 	bpmem.bpMask = 0xFFFFFF;
+	InvalidateShaderUids(SHADER_UID_ALL);
+}
+
+// The registers whose writes do something even when they don't change the value
+static bool IsTriggerRegister(int address)
+{
+	return address == BPMEM_TRIGGER_EFB_COPY ||
+	       address == BPMEM_CLEARBBOX1 ||
+	       address == BPMEM_CLEARBBOX2 ||
+	       address == BPMEM_SETDRAWDONE ||
+	       address == BPMEM_PE_TOKEN_ID ||
+	       address == BPMEM_PE_TOKEN_INT_ID ||
+	       address == BPMEM_LOADTLUT0 ||
+	       address == BPMEM_LOADTLUT1 ||
+	       address == BPMEM_TEXINVALIDATE ||
+	       address == BPMEM_PRELOAD_MODE ||
+	       address == BPMEM_CLEAR_PIXEL_PERF;
 }
 
 static void BPWritten(const BPCmd& bp)
@@ -65,27 +84,13 @@ static void BPWritten(const BPCmd& bp)
 	// check for invalid state, else unneeded configuration are built
 	g_video_backend->CheckInvalidState();
 
-	if (((s32*)&bpmem)[bp.address] == bp.newvalue)
-	{
-		if (!(bp.address == BPMEM_TRIGGER_EFB_COPY ||
-		      bp.address == BPMEM_CLEARBBOX1 ||
-		      bp.address == BPMEM_CLEARBBOX2 ||
-		      bp.address == BPMEM_SETDRAWDONE ||
-		      bp.address == BPMEM_PE_TOKEN_ID ||
-		      bp.address == BPMEM_PE_TOKEN_INT_ID ||
-		      bp.address == BPMEM_LOADTLUT0 ||
-		      bp.address == BPMEM_LOADTLUT1 ||
-		      bp.address == BPMEM_TEXINVALIDATE ||
-		      bp.address == BPMEM_PRELOAD_MODE ||
-		      bp.address == BPMEM_CLEAR_PIXEL_PERF))
-		{
-			return;
-		}
-	}
+	if (((s32*)&bpmem)[bp.address] == bp.newvalue && !IsTriggerRegister(bp.address))
+		return;
 
 	FlushPipeline();
 
 	((u32*)&bpmem)[bp.address] = bp.newvalue;
+	InvalidateShaderUidsForBPReg(bp.address);
 
 	switch (bp.address)
 	{
@@ -237,7 +242,7 @@ static void BPWritten(const BPCmd& bp)
 				// here. Not sure if there's a better spot to put this.
 				// the number of lines copied is determined by the y scale * source efb height
 
-				BoundingBox::active = false;
+				BoundingBox::SetActive(false);
 
 				float yScale;
 				if (PE_copy.scale_invert)
@@ -384,7 +389,7 @@ static void BPWritten(const BPCmd& bp)
 		if (!g_bSkipCurrentFrame)
 		{
 			u8 offset = bp.address & 2;
-			BoundingBox::active = true;
+			BoundingBox::SetActive(true);
 
 			if (g_ActiveConfig.backend_info.bSupportsBBox && g_ActiveConfig.bBBoxEnable)
 			{
@@ -722,6 +727,46 @@ void LoadBPRegPreprocess(u32 value0)
 	}
 }
 
+// The registers as the writes the conversion thread has seen leave them
+static u32 s_tracked_bpmem[256];
+static std::bitset<256> s_tracked_bpmem_known;
+static u32 s_tracked_bp_mask;
+static bool s_tracked_bp_mask_known;
+
+bool IsRedundantBPWrite(u32 value0)
+{
+	int regNum = value0 >> 24;
+	u32 oldval = s_tracked_bpmem[regNum];
+	u32 newval = (oldval & ~s_tracked_bp_mask) | (value0 & s_tracked_bp_mask);
+	bool known = s_tracked_bp_mask_known && (s_tracked_bp_mask == 0xFFFFFF || s_tracked_bpmem_known[regNum]);
+
+	// Masked writes and writes to the mask itself are always left to LoadBPReg
+	bool redundant = s_tracked_bp_mask_known && s_tracked_bp_mask == 0xFFFFFF && s_tracked_bpmem_known[regNum] &&
+	                 oldval == newval && regNum != BPMEM_BP_MASK && !IsTriggerRegister(regNum);
+
+	s_tracked_bpmem[regNum] = newval;
+	s_tracked_bpmem_known[regNum] = known;
+	if (regNum == BPMEM_BP_MASK)
+	{
+		s_tracked_bp_mask = newval;
+		s_tracked_bp_mask_known = known;
+	}
+	else
+	{
+		s_tracked_bp_mask = 0xFFFFFF;
+		s_tracked_bp_mask_known = true;
+	}
+
+	return redundant;
+}
+
+void ResetBPWriteTracking()
+{
+	s_tracked_bpmem_known.reset();
+	s_tracked_bp_mask = 0xFFFFFF;
+	s_tracked_bp_mask_known = false;
+}
+
 void GetBPRegInfo(const u8* data, std::string* name, std::string* desc)
 {
 	const char* no_yes[2] = { "No", "Yes" };
@@ -5,6 +5,7 @@
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "VideoCommon/BoundingBox.h"
+#include "VideoCommon/ShaderGenCommon.h"
 
 namespace BoundingBox
 {
@@ -13,6 +14,15 @@ namespace BoundingBox
 bool active = false;
 u16 coords[4] = { 0x80, 0xA0, 0x80, 0xA0 };
 
+void SetActive(bool enable)
+{
+	if (active == enable)
+		return;
+
+	active = enable;
+	InvalidateShaderUids(SHADER_UID_PIXEL);
+}
+
 // Save state
 void DoState(PointerWrap &p)
 {
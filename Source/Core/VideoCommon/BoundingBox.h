@@ -14,6 +14,9 @@ namespace BoundingBox
 // Determines if bounding box is active
 extern bool active;
 
+// Changes the flag, the pixel shader UID depends on it
+void SetActive(bool enable);
+
 // Bounding box current coordinates
 extern u16 coords[4];
 
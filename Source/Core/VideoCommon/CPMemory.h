@@ -271,6 +271,8 @@ extern CPState g_preprocess_cp_state;
 
 // Might move this into its own file later.
 void LoadCPReg(u32 SubCmd, u32 Value, bool is_preprocess = false);
+// In g_use_gpu_convert_thread mode, the conversion thread's part of LoadCPReg
+void LoadCPRegForConversion(u32 SubCmd, u32 Value);
 
 // Fills memory with data from CP regs
 void FillCPMemoryArray(u32 *memory);
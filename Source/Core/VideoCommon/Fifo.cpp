@@ -2,7 +2,9 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
+#include <thread>
 
 #include "Common/Atomic.h"
 #include "Common/BlockingLoop.h"
@@ -33,6 +35,7 @@
 bool g_bSkipCurrentFrame = false;
 
 static Common::BlockingLoop s_gpu_mainloop;
+static Common::BlockingLoop s_convert_loop;
 
 static std::atomic<bool> s_emu_running_state;
 
@@ -40,8 +43,14 @@ static std::atomic<bool> s_emu_running_state;
 static u8 s_fifo_aux_data[FIFO_SIZE];
 static u8* s_fifo_aux_write_ptr;
 static u8* s_fifo_aux_read_ptr;
+static u8* s_fifo_aux_convert_ptr;
 
 bool g_use_deterministic_gpu_thread;
+bool g_use_gpu_convert_thread;
+
+// In g_use_deterministic_gpu_thread mode, the CPU thread preprocesses FIFO data in batches
+// of up to this size, waking up the GPU thread after each of them.
+static const u32 DETERMINISTIC_GPU_BATCH_SIZE = 1024;
 
 // STATE_TO_SAVE
 static u8* s_video_buffer;
@@ -49,6 +58,10 @@ static u8* s_video_buffer_read_ptr;
 static std::atomic<u8*> s_video_buffer_write_ptr;
 static std::atomic<u8*> s_video_buffer_seen_ptr;
 static u8* s_video_buffer_pp_read_ptr;
+static u8* s_video_buffer_convert_ptr;
+static std::atomic<u8*> s_video_buffer_converted_ptr;
+static std::atomic<bool> s_convert_stalled;
+static bool s_convert_left_to_gpu;
 // The read_ptr is always owned by the GPU thread.  In normal mode, so is the
 // write_ptr, despite it being atomic.  In g_use_deterministic_gpu_thread mode,
 // things get a bit more complicated:
@@ -60,6 +73,13 @@ static u8* s_video_buffer_pp_read_ptr;
 // FIFO.  Maybe someday it will be under the lock.  For now, because RunGpuLoop
 // polls, it's just atomic.
 // - The pp_read_ptr is the CPU preprocessing version of the read_ptr.
+// In g_use_gpu_convert_thread mode, a third thread goes over the data between
+// the CPU and the GPU thread, loading the vertices and dropping BP and XF
+// writes which don't change anything:
+// - The convert_ptr is its version of the read_ptr.
+// - The converted_ptr is written by it, and takes the place of the write_ptr
+// for the GPU thread.  It's not the same as the write_ptr when the conversion
+// thread stalled to wait for the GPU thread, which it then wakes up again.
 
 static std::atomic<int> s_sync_ticks;
 static Common::Event s_sync_wakeup_event;
@@ -75,6 +95,10 @@ void Fifo_DoState(PointerWrap &p)
 	{
 		// We're good and paused, right?
 		s_video_buffer_seen_ptr = s_video_buffer_pp_read_ptr = s_video_buffer_read_ptr;
+		s_video_buffer_converted_ptr = s_video_buffer_convert_ptr = s_video_buffer_read_ptr;
+		s_convert_stalled = false;
+		s_convert_left_to_gpu = false;
+		OpcodeDecoder_ResetConversion();
 	}
 	p.Do(g_bSkipCurrentFrame);
 }
@@ -101,7 +125,11 @@ void Fifo_Init()
 	s_video_buffer = (u8*)AllocateMemoryPages(FIFO_SIZE + 4);
 	ResetVideoBuffer();
 	if (SConfig::GetInstance().bCPUThread)
+	{
 		s_gpu_mainloop.Prepare();
+		if (SConfig::GetInstance().bGPUConvertThread)
+			s_convert_loop.Prepare();
+	}
 	s_sync_ticks.store(0);
 }
 
@@ -116,8 +144,11 @@ void Fifo_Shutdown()
 	s_video_buffer_pp_read_ptr = nullptr;
 	s_video_buffer_read_ptr = nullptr;
 	s_video_buffer_seen_ptr = nullptr;
+	s_video_buffer_convert_ptr = nullptr;
+	s_video_buffer_converted_ptr = nullptr;
 	s_fifo_aux_write_ptr = nullptr;
 	s_fifo_aux_read_ptr = nullptr;
+	s_fifo_aux_convert_ptr = nullptr;
 }
 
 void Fifo_SetRendering(bool enabled)
@@ -142,13 +173,28 @@ void EmulatorState(bool running)
 {
 	s_emu_running_state.store(running);
 	s_gpu_mainloop.Wakeup();
+	s_convert_loop.Wakeup();
 }
 
 void SyncGPU(SyncGPUReason reason, bool may_move_read_ptr)
 {
 	if (g_use_deterministic_gpu_thread)
 	{
-		s_gpu_mainloop.Wait();
+		// The conversion thread may have stalled to wait for the GPU thread, which wakes it up
+		// again after catching up, and it wakes up the GPU thread itself. Only stop once neither
+		// of them has anything left to do: a conversion thread that is done and not stalled can't
+		// be woken up by the GPU thread any more, so check it before the GPU thread.
+		while (true)
+		{
+			s_convert_loop.Wait();
+			s_gpu_mainloop.Wait();
+			if (!s_gpu_mainloop.IsRunning() || !s_emu_running_state.load())
+				break;
+			if (s_convert_loop.IsDone() && !s_convert_stalled.load() && s_gpu_mainloop.IsDone())
+				break;
+			if (s_convert_stalled.load())
+				s_convert_loop.Wakeup();
+		}
 		if (!s_gpu_mainloop.IsRunning())
 			return;
 
@@ -159,6 +205,7 @@ void SyncGPU(SyncGPUReason reason, bool may_move_read_ptr)
 		memmove(s_fifo_aux_data, s_fifo_aux_read_ptr, s_fifo_aux_write_ptr - s_fifo_aux_read_ptr);
 		s_fifo_aux_write_ptr -= (s_fifo_aux_read_ptr - s_fifo_aux_data);
 		s_fifo_aux_read_ptr = s_fifo_aux_data;
+		s_fifo_aux_convert_ptr = s_fifo_aux_data;
 
 		if (may_move_read_ptr)
 		{
@@ -174,6 +221,8 @@ void SyncGPU(SyncGPUReason reason, bool may_move_read_ptr)
 			s_video_buffer_write_ptr = write_ptr = s_video_buffer + size;
 			s_video_buffer_pp_read_ptr = s_video_buffer;
 			s_video_buffer_read_ptr = s_video_buffer;
+			s_video_buffer_convert_ptr = s_video_buffer;
+			s_video_buffer_converted_ptr = write_ptr;
 			s_video_buffer_seen_ptr = write_ptr;
 		}
 	}
@@ -208,6 +257,13 @@ void* PopFifoAuxBuffer(size_t size)
 	return ret;
 }
 
+void* PopFifoAuxBufferForConversion(size_t size)
+{
+	void* ret = s_fifo_aux_convert_ptr;
+	s_fifo_aux_convert_ptr += size;
+	return ret;
+}
+
 // Description: RunGpuLoop() sends data through this function.
 static void ReadDataFromFifo(u32 readPtr)
 {
@@ -230,9 +286,9 @@ static void ReadDataFromFifo(u32 readPtr)
 }
 
 // The deterministic_gpu_thread version.
-static void ReadDataFromFifoOnCPU(u32 readPtr)
+// Copies and preprocesses len bytes at once, which must not cross the end of the FIFO.
+static void ReadDataFromFifoOnCPU(u32 readPtr, size_t len)
 {
-	size_t len = 32;
 	u8 *write_ptr = s_video_buffer_write_ptr;
 	if (len > (size_t)(s_video_buffer + FIFO_SIZE - write_ptr))
 	{
@@ -270,8 +326,44 @@ void ResetVideoBuffer()
 	s_video_buffer_write_ptr = s_video_buffer;
 	s_video_buffer_seen_ptr = s_video_buffer;
 	s_video_buffer_pp_read_ptr = s_video_buffer;
+	s_video_buffer_convert_ptr = s_video_buffer;
+	s_video_buffer_converted_ptr = s_video_buffer;
+	s_convert_stalled = false;
+	s_convert_left_to_gpu = false;
 	s_fifo_aux_write_ptr = s_fifo_aux_data;
 	s_fifo_aux_read_ptr = s_fifo_aux_data;
+	s_fifo_aux_convert_ptr = s_fifo_aux_data;
+}
+
+// The conversion thread, see the pointers above.
+static void RunConvertLoop()
+{
+	Common::SetCurrentThreadName("Vertex conversion thread");
+
+	s_convert_loop.Run(
+	[] {
+		// Do nothing while paused
+		if (!s_emu_running_state.load() || !g_use_gpu_convert_thread)
+			return;
+
+		// Once the GPU thread is done with the vertices left to it, go on after them. It has also
+		// gone through the rest of their display list, which the conversion thread hasn't seen.
+		if (s_convert_left_to_gpu)
+		{
+			if (VertexLoaderManager::HasPendingConvertedVertices())
+				return;
+			s_convert_left_to_gpu = false;
+			s_fifo_aux_convert_ptr = s_fifo_aux_read_ptr;
+			OpcodeDecoder_ResetConversion();
+		}
+
+		u8* write_ptr = s_video_buffer_write_ptr;
+		bool stalled = false;
+		s_video_buffer_convert_ptr = OpcodeDecoder_RunConversion(DataReader(s_video_buffer_convert_ptr, write_ptr), false, &stalled, &s_convert_left_to_gpu);
+		s_convert_stalled.store(stalled);
+		s_video_buffer_converted_ptr = stalled ? s_video_buffer_convert_ptr : write_ptr;
+		s_gpu_mainloop.Wakeup();
+	});
 }
 
 
@@ -283,6 +375,10 @@ void RunGpuLoop()
 	AsyncRequests::GetInstance()->SetEnable(true);
 	AsyncRequests::GetInstance()->SetPassthrough(false);
 
+	std::thread convert_thread;
+	if (SConfig::GetInstance().bGPUConvertThread)
+		convert_thread = std::thread(RunConvertLoop);
+
 	s_gpu_mainloop.Run(
 	[] {
 		const SConfig& param = SConfig::GetInstance();
@@ -299,13 +395,16 @@ void RunGpuLoop()
 
 			// All the fifo/CP stuff is on the CPU.  We just need to run the opcode decoder.
 			u8* seen_ptr = s_video_buffer_seen_ptr;
-			u8* write_ptr = s_video_buffer_write_ptr;
+			u8* write_ptr = g_use_gpu_convert_thread ? s_video_buffer_converted_ptr : s_video_buffer_write_ptr;
 			// See comment in SyncGPU
 			if (write_ptr > seen_ptr)
 			{
 				s_video_buffer_read_ptr = OpcodeDecoder_Run(DataReader(s_video_buffer_read_ptr, write_ptr), nullptr, false);
 				s_video_buffer_seen_ptr = write_ptr;
 			}
+
+			if (g_use_gpu_convert_thread && s_convert_stalled.load())
+				s_convert_loop.Wakeup();
 		}
 		else
 		{
@@ -371,6 +470,12 @@ void RunGpuLoop()
 		}
 	}, 100);
 
+	if (convert_thread.joinable())
+	{
+		s_convert_loop.Stop();
+		convert_thread.join();
+	}
+
 	AsyncRequests::GetInstance()->SetEnable(false);
 	AsyncRequests::GetInstance()->SetPassthrough(true);
 }
@@ -409,8 +514,32 @@ void RunGpu()
 		{
 			if (g_use_deterministic_gpu_thread)
 			{
-				ReadDataFromFifoOnCPU(fifo.CPReadPointer);
-				s_gpu_mainloop.Wakeup();
+				// Run the preprocessing decoder over as much contiguous data as possible instead of
+				// once per 32 byte block, as it has to restart at the beginning of any command that
+				// is split across blocks (e.g. large primitives). With a FIFO breakpoint set, go
+				// block by block so that it is hit exactly.
+				u32 len = 32;
+				if (!fifo.bFF_BPEnable && fifo.CPReadPointer < fifo.CPEnd)
+				{
+					const u32 distance = fifo.CPReadWriteDistance;
+					const u32 until_wrap = fifo.CPEnd + 32 - fifo.CPReadPointer;
+					len = std::min(std::min(distance, until_wrap), DETERMINISTIC_GPU_BATCH_SIZE) & ~31u;
+					len = std::max(len, 32u);
+				}
+
+				ReadDataFromFifoOnCPU(fifo.CPReadPointer, len);
+				if (g_use_gpu_convert_thread)
+					s_convert_loop.Wakeup();
+				else
+					s_gpu_mainloop.Wakeup();
+
+				if (fifo.CPReadPointer + len - 32 == fifo.CPEnd)
+					fifo.CPReadPointer = fifo.CPBase;
+				else
+					fifo.CPReadPointer += len;
+
+				fifo.CPReadWriteDistance -= len;
+				continue;
 			}
 			else
 			{
@@ -480,10 +609,14 @@ void Fifo_UpdateWantDeterminism(bool want)
 	if (g_use_deterministic_gpu_thread != gpu_thread)
 	{
 		g_use_deterministic_gpu_thread = gpu_thread;
+		g_use_gpu_convert_thread = gpu_thread && param.bGPUConvertThread;
 		if (gpu_thread)
 		{
 			// These haven't been updated in non-deterministic mode.
 			s_video_buffer_seen_ptr = s_video_buffer_pp_read_ptr = s_video_buffer_read_ptr;
+			s_video_buffer_converted_ptr = s_video_buffer_convert_ptr = s_video_buffer_read_ptr;
+			s_fifo_aux_convert_ptr = s_fifo_aux_read_ptr;
+			OpcodeDecoder_ResetConversion();
 			CopyPreprocessCPStateFromMain();
 			VertexLoaderManager::MarkAllDirty();
 		}
@@ -16,6 +16,9 @@ extern bool g_bSkipCurrentFrame;
 // This could be in SConfig, but it depends on multiple settings
 // and can change at runtime.
 extern bool g_use_deterministic_gpu_thread;
+// In g_use_deterministic_gpu_thread mode, whether the vertices are loaded on a third thread
+// ahead of the GPU thread, see Fifo.cpp.
+extern bool g_use_gpu_convert_thread;
 extern std::atomic<u8*> g_video_buffer_write_ptr_xthread;
 
 void Fifo_Init();
@@ -40,6 +43,7 @@ void SyncGPU(SyncGPUReason reason, bool may_move_read_ptr = true);
 
 void PushFifoAuxBuffer(void* ptr, size_t size);
 void* PopFifoAuxBuffer(size_t size);
+void* PopFifoAuxBufferForConversion(size_t size);
 
 void FlushGpu();
 void RunGpu();
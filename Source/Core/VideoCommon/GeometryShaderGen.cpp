@@ -329,7 +329,10 @@ static inline void EndPrimitive(T& out, API_TYPE ApiType)
 
 void GetGeometryShaderUid(GeometryShaderUid& object, u32 primitive_type, API_TYPE ApiType)
 {
-	GenerateGeometryShader<GeometryShaderUid>(object, primitive_type, ApiType);
+	static ShaderUidCache<GeometryShaderUid> cache(SHADER_UID_GEOMETRY);
+	cache.Get(object, primitive_type, 0, ApiType, [&](GeometryShaderUid& uid) {
+		GenerateGeometryShader<GeometryShaderUid>(uid, primitive_type, ApiType);
+	});
 }
 
 void GenerateGeometryShaderCode(ShaderCode& object, u32 primitive_type, API_TYPE ApiType)
@@ -54,6 +54,8 @@ static u32 InterpretDisplayList(u32 address, u32 size)
 
 		OpcodeDecoder_Run(DataReader(startAddress, startAddress + size), &cycles, true);
 		INCSTAT(stats.thisFrame.numDListsCalled);
+		if (g_use_gpu_convert_thread)
+			VertexLoaderManager::FinishDisplayList();
 
 		// un-swap
 		Statistics::SwapDL();
@@ -126,6 +128,7 @@ static void UnknownOpcode(u8 cmd_byte, void *buffer, bool preprocess)
 void OpcodeDecoder_Init()
 {
 	s_bFifoErrorSeen = false;
+	OpcodeDecoder_ResetConversion();
 }
 
 
@@ -319,3 +322,117 @@ end:
 
 template u8* OpcodeDecoder_Run<true>(DataReader src, u32* cycles, bool in_display_list);
 template u8* OpcodeDecoder_Run<false>(DataReader src, u32* cycles, bool in_display_list);
+
+u8* OpcodeDecoder_RunConversion(DataReader src, bool in_display_list, bool* stalled, bool* left_to_gpu)
+{
+	// The FIFO recorder has to see the commands as they were sent
+	bool skip_redundant_writes = !g_bRecordFifoData;
+	u8* opcodeStart;
+	while (true)
+	{
+		opcodeStart = src.GetPointer();
+
+		if (!src.size())
+			return opcodeStart;
+
+		u8 cmd_byte = src.Read<u8>();
+		switch (cmd_byte)
+		{
+		case GX_LOAD_CP_REG:
+			{
+				if (src.size() < 1 + 4)
+					return opcodeStart;
+				u8 sub_cmd = src.Read<u8>();
+				u32 value = src.Read<u32>();
+				LoadCPRegForConversion(sub_cmd, value);
+			}
+			break;
+
+		case GX_LOAD_XF_REG:
+			{
+				if (src.size() < 4)
+					return opcodeStart;
+				u32 Cmd2 = src.Read<u32>();
+				int transfer_size = ((Cmd2 >> 16) & 15) + 1;
+				if (src.size() < transfer_size * sizeof(u32))
+					return opcodeStart;
+				if (IsRedundantXFWrite(transfer_size, Cmd2 & 0xFFFF, src) && skip_redundant_writes)
+					memset(opcodeStart, GX_NOP, 1 + 4 + transfer_size * sizeof(u32));
+				src.Skip<u32>(transfer_size);
+			}
+			break;
+
+		case GX_LOAD_INDX_A:
+		case GX_LOAD_INDX_B:
+		case GX_LOAD_INDX_C:
+		case GX_LOAD_INDX_D:
+			{
+				if (src.size() < 4)
+					return opcodeStart;
+				u32 val = src.Read<u32>();
+				int size = ((val >> 12) & 0xF) + 1;
+				TrackIndexedXFWrite(val, (u32*)PopFifoAuxBufferForConversion(size * sizeof(u32)));
+			}
+			break;
+
+		case GX_CMD_CALL_DL:
+			{
+				if (src.size() < 8)
+					return opcodeStart;
+				src.Skip<u32>();
+				u32 count = src.Read<u32>();
+
+				if (!in_display_list)
+				{
+					u8* startAddress = (u8*)PopFifoAuxBufferForConversion(count);
+					OpcodeDecoder_RunConversion(DataReader(startAddress, startAddress + count), true, stalled, left_to_gpu);
+					// The GPU thread goes on with the rest of the display list
+					if (*left_to_gpu)
+						return src.GetPointer();
+				}
+			}
+			break;
+
+		case GX_LOAD_BP_REG:
+			{
+				if (src.size() < 4)
+					return opcodeStart;
+				if (IsRedundantBPWrite(src.Read<u32>()) && skip_redundant_writes)
+					memset(opcodeStart, GX_NOP, 1 + 4);
+			}
+			break;
+
+		default:
+			if ((cmd_byte & 0xC0) == 0x80)
+			{
+				// load vertices
+				if (src.size() < 2)
+					return opcodeStart;
+				u16 num_vertices = src.Read<u16>();
+				int bytes = VertexLoaderManager::ConvertVertices(cmd_byte & GX_VAT_MASK, num_vertices, src,
+				                                                 in_display_list, left_to_gpu);
+
+				if (bytes == -2)
+					*stalled = true;
+				if (bytes < 0)
+					return opcodeStart;
+
+				src.Skip(bytes);
+
+				if (*left_to_gpu)
+				{
+					*stalled = true;
+					return src.GetPointer();
+				}
+			}
+			// Everything else is a single byte, or an unknown opcode the GPU thread complains about
+			break;
+		}
+	}
+}
+
+void OpcodeDecoder_ResetConversion()
+{
+	ResetBPWriteTracking();
+	ResetXFWriteTracking();
+}
@@ -43,3 +43,12 @@ void OpcodeDecoder_Shutdown();
 
 template <bool is_preprocess = false>
 u8* OpcodeDecoder_Run(DataReader src, u32* cycles, bool in_display_list);
+
+// In g_use_gpu_convert_thread mode, the conversion thread's pass over the commands, between the
+// preprocessing on the CPU thread and OpcodeDecoder_Run on the GPU thread. Loads the vertices of
+// the primitives, and turns the BP and XF writes which wouldn't change anything into NOPs. Sets
+// *stalled if it stops early as it has to wait for the GPU thread, and *left_to_gpu if that is
+// because it left vertices to the GPU thread.
+u8* OpcodeDecoder_RunConversion(DataReader src, bool in_display_list, bool* stalled, bool* left_to_gpu);
+// Forgets the BP and XF writes the conversion thread has seen
+void OpcodeDecoder_ResetConversion();
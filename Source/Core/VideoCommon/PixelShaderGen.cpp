@@ -1170,7 +1170,10 @@ static inline void WriteFog(T& out, pixel_shader_uid_data* uid_data)
 
 void GetPixelShaderUid(PixelShaderUid& object, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
 {
-	GeneratePixelShader<PixelShaderUid>(object, dstAlphaMode, ApiType, components);
+	static ShaderUidCache<PixelShaderUid> cache(SHADER_UID_PIXEL);
+	cache.Get(object, dstAlphaMode, components, ApiType, [&](PixelShaderUid& uid) {
+		GeneratePixelShader<PixelShaderUid>(uid, dstAlphaMode, ApiType, components);
+	});
 }
 
 void GeneratePixelShaderCode(PixelShaderCode& object, DSTALPHA_MODE dstAlphaMode, API_TYPE ApiType, u32 components)
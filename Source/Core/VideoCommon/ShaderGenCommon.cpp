@@ -0,0 +1,77 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/ShaderGenCommon.h"
+#include "VideoCommon/XFMemory.h"
+
+// Atomic, as the bounding box flag is also cleared by PE reads on the CPU thread
+static std::atomic<u32> s_invalidated_uid_stages(SHADER_UID_ALL);
+
+void InvalidateShaderUids(u32 stages)
+{
+	s_invalidated_uid_stages.fetch_or(stages, std::memory_order_relaxed);
+}
+
+bool ConsumeShaderUidInvalidation(ShaderUidStage stage)
+{
+	// Only pay for the read-modify-write when the flag is set
+	if (!(s_invalidated_uid_stages.load(std::memory_order_relaxed) & stage))
+		return false;
+	return (s_invalidated_uid_stages.fetch_and(~stage, std::memory_order_relaxed) & stage) != 0;
+}
+
+// Keep these in sync with the bpmem/xfmem fields read by the shader generators.
+void InvalidateShaderUidsForBPReg(u32 address)
+{
+	switch (address)
+	{
+	case BPMEM_GENMODE:
+		InvalidateShaderUids(SHADER_UID_PIXEL | SHADER_UID_VERTEX);
+		return;
+
+	case BPMEM_IREF:
+	case BPMEM_ZMODE:
+	case BPMEM_ZCOMPARE:
+	case BPMEM_FOGRANGE:
+	case BPMEM_FOGPARAM3:
+	case BPMEM_ALPHACOMPARE:
+	case BPMEM_ZTEX2:
+		InvalidateShaderUids(SHADER_UID_PIXEL);
+		return;
+	}
+
+	if ((address >= BPMEM_IND_CMD && address < BPMEM_IND_CMD + 16) ||
+	    (address >= BPMEM_TREF && address < BPMEM_TREF + 8) ||
+	    (address >= BPMEM_TEV_COLOR_ENV && address < BPMEM_TEV_COLOR_ENV + 32) ||
+	    (address >= BPMEM_TEV_KSEL && address < BPMEM_TEV_KSEL + 8))
+	{
+		InvalidateShaderUids(SHADER_UID_PIXEL);
+	}
+}
+
+void InvalidateShaderUidsForXFReg(u32 address)
+{
+	switch (address)
+	{
+	case XFMEM_SETNUMTEXGENS:
+		InvalidateShaderUids(SHADER_UID_ALL);
+		return;
+
+	case XFMEM_SETNUMCHAN:
+	case XFMEM_SETCHAN0_COLOR:
+	case XFMEM_SETCHAN1_COLOR:
+	case XFMEM_SETCHAN0_ALPHA:
+	case XFMEM_SETCHAN1_ALPHA:
+	case XFMEM_DUALTEX:
+		InvalidateShaderUids(SHADER_UID_PIXEL | SHADER_UID_VERTEX);
+		return;
+	}
+
+	// texMtxInfo and postMtxInfo
+	if (address >= XFMEM_SETTEXMTXINFO && address < XFMEM_SETPOSMTXINFO + 8)
+		InvalidateShaderUids(SHADER_UID_PIXEL | SHADER_UID_VERTEX);
+}
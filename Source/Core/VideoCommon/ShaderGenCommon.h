@@ -13,6 +13,7 @@
 
 #include "Common/CommonTypes.h"
 #include "Common/StringUtil.h"
+#include "VideoCommon/Statistics.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/VideoConfig.h"
 #include "VideoCommon/XFMemory.h"
@@ -111,6 +112,66 @@ private:
 	};
 };
 
+// Shader stages, used to tell which cached UIDs a state change affects
+enum ShaderUidStage : u32
+{
+	SHADER_UID_PIXEL    = 1 << 0,
+	SHADER_UID_VERTEX   = 1 << 1,
+	SHADER_UID_GEOMETRY = 1 << 2,
+	SHADER_UID_ALL      = SHADER_UID_PIXEL | SHADER_UID_VERTEX | SHADER_UID_GEOMETRY,
+};
+
+// Generating a UID walks the whole shader generator, so the last UID of every stage is cached
+// and only regenerated after state it depends on has been written.
+// BP/XF register writes only mark the stages reading that register, as does toggling the
+// bounding box, while config changes and savestate loads mark all of them.
+void InvalidateShaderUids(u32 stages);
+void InvalidateShaderUidsForBPReg(u32 address);
+void InvalidateShaderUidsForXFReg(u32 address);
+
+// Returns whether the given stage has been invalidated since the last call and resets its flag.
+bool ConsumeShaderUidInvalidation(ShaderUidStage stage);
+
+/**
+ * Remembers the last UID of one shader stage and the generator arguments it has been built for.
+ * Get() hands out that UID again until the arguments change or the stage gets invalidated.
+ */
+template<class UidT>
+class ShaderUidCache
+{
+public:
+	explicit ShaderUidCache(ShaderUidStage stage) : m_stage(stage) {}
+
+	template<typename Generator>
+	void Get(UidT& uid, u32 arg0, u32 arg1, API_TYPE api_type, Generator generate)
+	{
+		const bool invalidated = ConsumeShaderUidInvalidation(m_stage);
+		if (m_valid && !invalidated && m_arg0 == arg0 && m_arg1 == arg1 && m_api_type == api_type)
+		{
+			uid = m_uid;
+			INCSTAT(stats.thisFrame.numShaderUidsReused);
+			return;
+		}
+
+		generate(uid);
+		INCSTAT(stats.thisFrame.numShaderUidsGenerated);
+
+		m_uid = uid;
+		m_arg0 = arg0;
+		m_arg1 = arg1;
+		m_api_type = api_type;
+		m_valid = true;
+	}
+
+private:
+	const ShaderUidStage m_stage;
+	UidT m_uid;
+	u32 m_arg0 = 0;
+	u32 m_arg1 = 0;
+	API_TYPE m_api_type = API_NONE;
+	bool m_valid = false;
+};
+
 class ShaderCode : public ShaderGeneratorInterface
 {
 public:
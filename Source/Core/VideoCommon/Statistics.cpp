@@ -34,7 +34,13 @@ std::string Statistics::ToString()
 	str += StringFromFormat("pshaders alive: %i\n", stats.numPixelShadersAlive);
 	str += StringFromFormat("vshaders created: %i\n", stats.numVertexShadersCreated);
 	str += StringFromFormat("vshaders alive: %i\n", stats.numVertexShadersAlive);
+	str += StringFromFormat("shaders pending compile: %i\n", stats.numShadersPendingCompile);
+	str += StringFromFormat("shaders compiled in background: %i\n", stats.numShadersCompiledInBackground);
 	str += StringFromFormat("shaders changes: %i\n", stats.thisFrame.numShaderChanges);
+	str += StringFromFormat("shader UIDs generated: %i\n", stats.thisFrame.numShaderUidsGenerated);
+	str += StringFromFormat("shader UIDs reused: %i\n", stats.thisFrame.numShaderUidsReused);
+	str += StringFromFormat("draws skipped for pending shaders: %i\n", stats.thisFrame.numDrawsSkippedForShader);
+	str += StringFromFormat("draws with fallback shaders: %i\n", stats.thisFrame.numDrawsWithFallbackShader);
 	str += StringFromFormat("dlists called: %i\n", stats.thisFrame.numDListsCalled);
 	str += StringFromFormat("Primitive joins: %i\n", stats.thisFrame.numPrimitiveJoins);
 	str += StringFromFormat("Draw calls: %i\n", stats.thisFrame.numDrawCalls);
@@ -17,6 +17,9 @@ struct Statistics
 	int numVertexShadersCreated;
 	int numVertexShadersAlive;
 
+	int numShadersPendingCompile;
+	int numShadersCompiledInBackground;
+
 	int numTexturesCreated;
 	int numTexturesUploaded;
 	int numTexturesAlive;
@@ -45,6 +48,10 @@ struct Statistics
 		int numPrims;
 		int numDLPrims;
 		int numShaderChanges;
+		int numShaderUidsGenerated;
+		int numShaderUidsReused;
+		int numDrawsSkippedForShader;
+		int numDrawsWithFallbackShader;
 
 		int numPrimitiveJoins;
 		int numDrawCalls;
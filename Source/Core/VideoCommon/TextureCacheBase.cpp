@@ -33,8 +33,9 @@ TextureCache* g_texture_cache;
 alignas(16) u8* TextureCache::temp = nullptr;
 size_t TextureCache::temp_size;
 
-TextureCache::TexCache TextureCache::textures_by_address;
-TextureCache::TexCache TextureCache::textures_by_hash;
+TextureCache::TexAddressCache TextureCache::textures_by_address;
+TextureCache::TexHashCache TextureCache::textures_by_hash;
+TextureCache::EfbCopyList TextureCache::efb_copies_by_address;
 TextureCache::TexPool TextureCache::texture_pool;
 TextureCache::TCacheEntryBase* TextureCache::bound_textures[8];
 
@@ -80,18 +81,17 @@ void TextureCache::Invalidate()
 {
 	UnbindTextures();
 
-	for (auto& tex : textures_by_address)
-	{
-		delete tex.second;
-	}
-	textures_by_address.clear();
-	textures_by_hash.clear();
-
-	for (auto& rt : texture_pool)
-	{
-		delete rt.second;
-	}
-	texture_pool.clear();
+	textures_by_address.ForEach([](TCacheEntryBase* entry) {
+		delete entry;
+	});
+	textures_by_address.Clear();
+	textures_by_hash.Clear();
+	efb_copies_by_address.clear();
+
+	texture_pool.ForEach([](TCacheEntryBase* entry) {
+		delete entry;
+	});
+	texture_pool.Clear();
 }
 
 TextureCache::~TextureCache()
@@ -145,60 +145,41 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 
 void TextureCache::Cleanup(int _frameCount)
 {
-	TexCache::iterator iter = textures_by_address.begin();
-	TexCache::iterator tcend = textures_by_address.end();
-	while (iter != tcend)
-	{
-		if (iter->second->frameCount == FRAMECOUNT_INVALID)
+	textures_by_address.ForEach([_frameCount](TCacheEntryBase* entry) {
+		if (entry->frameCount == FRAMECOUNT_INVALID)
 		{
-			iter->second->frameCount = _frameCount;
-			++iter;
+			entry->frameCount = _frameCount;
 		}
-		else if (_frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount)
+		else if (_frameCount > TEXTURE_KILL_THRESHOLD + entry->frameCount)
 		{
-			if (iter->second->IsEfbCopy())
+			if (entry->IsEfbCopy())
 			{
 				// Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB copies living on the
 				// host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for performance reasons
-				if ((_frameCount - iter->second->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
-					iter->second->hash != iter->second->CalculateHash())
-				{
-					iter = FreeTexture(iter);
-				}
-				else
+				if ((_frameCount - entry->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
+					entry->hash != entry->CalculateHash())
 				{
-					++iter;
+					FreeTexture(entry);
 				}
 			}
 			else
 			{
-				iter = FreeTexture(iter);
+				FreeTexture(entry);
 			}
 		}
-		else
-		{
-			++iter;
-		}
-	}
+	});
 
-	TexPool::iterator iter2 = texture_pool.begin();
-	TexPool::iterator tcend2 = texture_pool.end();
-	while (iter2 != tcend2)
-	{
-		if (iter2->second->frameCount == FRAMECOUNT_INVALID)
-		{
-			iter2->second->frameCount = _frameCount;
-		}
-		if (_frameCount > TEXTURE_POOL_KILL_THRESHOLD + iter2->second->frameCount)
+	texture_pool.ForEach([_frameCount](TCacheEntryBase* entry) {
+		if (entry->frameCount == FRAMECOUNT_INVALID)
 		{
-			delete iter2->second;
-			iter2 = texture_pool.erase(iter2);
+			entry->frameCount = _frameCount;
 		}
-		else
+		if (_frameCount > TEXTURE_POOL_KILL_THRESHOLD + entry->frameCount)
 		{
-			++iter2;
+			texture_pool.Erase(entry);
+			delete entry;
 		}
-	}
+	});
 }
 
 bool TextureCache::TCacheEntryBase::OverlapsMemoryRange(u32 range_address, u32 range_size) const
@@ -212,9 +193,8 @@ bool TextureCache::TCacheEntryBase::OverlapsMemoryRange(u32 range_address, u32 r
 	return true;
 }
 
-TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::iterator iter_t)
+TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TCacheEntryBase* entry_to_update)
 {
-	TCacheEntryBase* entry_to_update = iter_t->second;
 	const bool isPaletteTexture = (entry_to_update->format == GX_TF_C4
 		|| entry_to_update->format == GX_TF_C8
 		|| entry_to_update->format == GX_TF_C14X2
@@ -233,15 +213,16 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 
 	u32 numBlocksX = (entry_to_update->native_width + block_width - 1) / block_width;
 
-	TexCache::iterator iter = textures_by_address.lower_bound(entry_to_update->addr);
-	TexCache::iterator iterend = textures_by_address.upper_bound(entry_to_update->addr + entry_to_update->size_in_bytes);
+	// Only EFB copies can be used for partial texture updates, so only look at those.
+	// The list is modified while walking over it, hence the index based loop.
+	const u32 range_end = entry_to_update->addr + entry_to_update->size_in_bytes;
+	size_t i = std::lower_bound(efb_copies_by_address.begin(), efb_copies_by_address.end(), entry_to_update->addr,
+		[](const std::pair<u32, TCacheEntryBase*>& copy, u32 addr) { return copy.first < addr; }) - efb_copies_by_address.begin();
 	bool entry_need_scaling = true;
-	while (iter != iterend)
+	while (i < efb_copies_by_address.size() && efb_copies_by_address[i].first <= range_end)
 	{
-		TCacheEntryBase* entry = iter->second;
-		if (entry != entry_to_update
-			&& entry->IsEfbCopy()
-			&& entry_to_update->addr <= entry->addr
+		TCacheEntryBase* entry = efb_copies_by_address[i].second;
+		if (entry_to_update->addr <= entry->addr
 			&& entry->addr + entry->size_in_bytes <= entry_to_update->addr + entry_to_update->size_in_bytes
 			&& entry->frameCount == FRAMECOUNT_INVALID
 			&& entry->memory_stride == numBlocksX * block_size)
@@ -267,7 +248,7 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 					u32 max = g_renderer->GetMaxTextureSize();
 					if (max < w || max < h)
 					{
-						iter++;
+						++i;
 						continue;
 					}
 					if (entry_to_update->config.width != w || entry_to_update->config.height != h)
@@ -287,10 +268,9 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 						dstrect.right = w;
 						dstrect.bottom = h;
 						newentry->CopyRectangleFromTexture(entry_to_update, srcrect, dstrect);
+						FreeTexture(entry_to_update);
 						entry_to_update = newentry;
-						u64 key = iter_t->first;
-						iter_t = FreeTexture(iter_t);
-						textures_by_address.emplace(key, entry_to_update);
+						AddTexture(entry_to_update);
 					}
 				}
 				srcrect.right = entry->config.width;
@@ -306,11 +286,11 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 			else
 			{
 				// If the hash does not match, this EFB copy will not be used for anything, so remove it
-				iter = FreeTexture(iter);
+				FreeTexture(entry);
 				continue;
 			}
 		}
-		++iter;
+		++i;
 	}
 	return entry_to_update;
 }
@@ -471,15 +451,14 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	//
 	// For efb copies, the entry created in CopyRenderTargetToTexture always has to be used, or else it was
 	// done in vain.
-	std::pair<TexCache::iterator, TexCache::iterator> iter_range = textures_by_address.equal_range((u64)address);
-	TexCache::iterator iter = iter_range.first;
-	TexCache::iterator oldest_entry = iter;
+	TCacheEntryBase* oldest_entry = nullptr;
 	int temp_frameCount = 0x7fffffff;
-	TexCache::iterator unconverted_copy = textures_by_address.end();
+	TCacheEntryBase* unconverted_copy = nullptr;
 
-	while (iter != iter_range.second)
+	TCacheEntryBase* next_entry;
+	for (TCacheEntryBase* entry = textures_by_address.Find(address); entry; entry = next_entry)
 	{
-		TCacheEntryBase* entry = iter->second;
+		next_entry = TexAddressCache::Next(entry);
 		// Do not load strided EFB copies, they are not meant to be used directly
 		if (entry->IsEfbCopy() && entry->native_width == nativeW && entry->native_height == nativeH &&
 			entry->memory_stride == entry->CacheLinesPerRow() * 32)
@@ -500,7 +479,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 				// perform the conversion later.  Currently, we only convert EFB copies to
 				// palette textures; we could do other conversions if it proved to be
 				// beneficial.
-				unconverted_copy = iter;
+				unconverted_copy = entry;
 			}
 			else
 			{
@@ -508,7 +487,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 				// never be useful again.  It's theoretically possible for a game to do
 				// something weird where the copy could become useful in the future, but in
 				// practice it doesn't happen.
-				iter = FreeTexture(iter);
+				FreeTexture(entry);
 				continue;
 			}
 		}
@@ -518,7 +497,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 			if (entry->hash == full_hash && entry->format == full_format && entry->native_levels >= tex_levels &&
 				entry->native_width == nativeW && entry->native_height == nativeH)
 			{
-				entry = DoPartialTextureUpdates(iter);
+				entry = DoPartialTextureUpdates(entry);
 
 				return ReturnEntry(stage, entry);
 			}
@@ -533,15 +512,14 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 			!entry->IsEfbCopy() && !(isPaletteTexture && entry->base_hash == base_hash))
 		{
 			temp_frameCount = entry->frameCount;
-			oldest_entry = iter;
+			oldest_entry = entry;
 		}
-		++iter;
 	}
 
-	if (unconverted_copy != textures_by_address.end())
+	if (unconverted_copy)
 	{
 		// Perform palette decoding.
-		TCacheEntryBase *entry = unconverted_copy->second;
+		TCacheEntryBase *entry = unconverted_copy;
 
 		TCacheEntryConfig config;
 		config.rendertarget = true;
@@ -557,7 +535,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 		decoded_entry->is_efb_copy = false;
 
 		g_texture_cache->ConvertTexture(decoded_entry, entry, &texMem[tlutaddr], (TlutFormat)tlutfmt);
-		textures_by_address.emplace((u64)address, decoded_entry);
+		AddTexture(decoded_entry);
 		return ReturnEntry(stage, decoded_entry);
 	}
 
@@ -568,25 +546,21 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
 		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
 	{
-		iter_range = textures_by_hash.equal_range(full_hash);
-		iter = iter_range.first;
-		while (iter != iter_range.second)
+		for (TCacheEntryBase* entry = textures_by_hash.Find(full_hash); entry; entry = TexHashCache::Next(entry))
 		{
-			TCacheEntryBase* entry = iter->second;
 			// All parameters, except the address, need to match here
 			if (entry->format == full_format && entry->native_levels >= tex_levels &&
 				entry->native_width == nativeW && entry->native_height == nativeH)
 			{
-				entry = DoPartialTextureUpdates(iter);
+				entry = DoPartialTextureUpdates(entry);
 
 				return ReturnEntry(stage, entry);
 			}
-			++iter;
 		}
 	}
 
 	// If at least one entry was not used for the same frame, overwrite the oldest one
-	if (temp_frameCount != 0x7fffffff)
+	if (oldest_entry)
 	{
 		// pool this texture and make a new one later
 		FreeTexture(oldest_entry);
@@ -643,19 +617,19 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	TCacheEntryBase* entry = AllocateTexture(config);
 	GFX_DEBUGGER_PAUSE_AT(NEXT_NEW_TEXTURE, true);
 
-	iter = textures_by_address.emplace((u64)address, entry);
-	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
-		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
-	{
-		entry->textures_by_hash_iter = textures_by_hash.emplace(full_hash, entry);
-	}
-
 	entry->SetGeneralParameters(address, texture_size, full_format);
 	entry->SetDimensions(nativeW, nativeH, tex_levels);
 	entry->SetHashes(base_hash, full_hash);
 	entry->is_efb_copy = false;
 	entry->is_custom_tex = hires_tex != nullptr;
 
+	AddTexture(entry);
+	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
+		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
+	{
+		textures_by_hash.Insert(full_hash, entry);
+	}
+
 	// load texture
 	entry->Load(width, height, expandedWidth, 0);
 
@@ -717,9 +691,9 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	}
 
 	INCSTAT(stats.numTexturesUploaded);
-	SETSTAT(stats.numTexturesAlive, textures_by_address.size());
+	SETSTAT(stats.numTexturesAlive, textures_by_address.Size());
 
-	entry = DoPartialTextureUpdates(iter);
+	entry = DoPartialTextureUpdates(entry);
 
 	return ReturnEntry(stage, entry);
 }
@@ -1036,12 +1010,8 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 
 	// remove all texture cache entries at dstAddr
 	{
-		std::pair<TexCache::iterator, TexCache::iterator> iter_range = textures_by_address.equal_range((u64)dstAddr);
-		TexCache::iterator iter = iter_range.first;
-		while (iter != iter_range.second)
-		{
-			iter = FreeTexture(iter);
-		}
+		while (TCacheEntryBase* tex = textures_by_address.Find(dstAddr))
+			FreeTexture(tex);
 	}
 
 	// create the texture
@@ -1070,14 +1040,11 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	// we might be able to do a partial texture update on.
 	if (entry->memory_stride == entry->CacheLinesPerRow() * 32)
 	{
-		TexCache::iterator iter = textures_by_address.begin();
-		while (iter != textures_by_address.end())
-		{
-			if (iter->second->OverlapsMemoryRange(dstAddr, entry->size_in_bytes))
-				iter = FreeTexture(iter);
-			else
-				++iter;
-		}
+		const u32 copy_size = entry->size_in_bytes;
+		textures_by_address.ForEach([dstAddr, copy_size](TCacheEntryBase* tex) {
+			if (tex->OverlapsMemoryRange(dstAddr, copy_size))
+				FreeTexture(tex);
+		});
 	}
 
 	if (g_ActiveConfig.bDumpEFBTarget)
@@ -1098,17 +1065,15 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 		}
 	}
 
-	textures_by_address.emplace((u64)dstAddr, entry);
+	AddTexture(entry);
 }
 
 TextureCache::TCacheEntryBase* TextureCache::AllocateTexture(const TCacheEntryConfig& config)
 {
-	TexPool::iterator iter = texture_pool.find(config);
-	TextureCache::TCacheEntryBase* entry;
-	if (iter != texture_pool.end())
+	TextureCache::TCacheEntryBase* entry = texture_pool.Find(config.GetId());
+	if (entry)
 	{
-		entry = iter->second;
-		texture_pool.erase(iter);
+		texture_pool.Erase(entry);
 	}
 	else
 	{
@@ -1116,24 +1081,48 @@ TextureCache::TCacheEntryBase* TextureCache::AllocateTexture(const TCacheEntryCo
 		INCSTAT(stats.numTexturesCreated);
 	}
 
-	entry->textures_by_hash_iter = textures_by_hash.end();
 	return entry;
 }
 
-TextureCache::TexCache::iterator TextureCache::FreeTexture(TexCache::iterator iter)
+static bool CompareEfbCopyAddress(const std::pair<u32, TextureCache::TCacheEntryBase*>& a,
+	const std::pair<u32, TextureCache::TCacheEntryBase*>& b)
 {
-	TCacheEntryBase* entry = iter->second;
+	return a.first < b.first;
+}
+
+void TextureCache::AddTexture(TCacheEntryBase* entry)
+{
+	textures_by_address.Insert(entry->addr, entry);
 
-	if (entry->textures_by_hash_iter != textures_by_hash.end())
+	if (entry->IsEfbCopy())
 	{
-		textures_by_hash.erase(entry->textures_by_hash_iter);
-		entry->textures_by_hash_iter = textures_by_hash.end();
+		// Insert after all copies at the same address, to keep the order stable
+		std::pair<u32, TCacheEntryBase*> copy(entry->addr, entry);
+		efb_copies_by_address.insert(std::upper_bound(efb_copies_by_address.begin(), efb_copies_by_address.end(),
+			copy, CompareEfbCopyAddress), copy);
 	}
+}
 
-	entry->frameCount = FRAMECOUNT_INVALID;
-	texture_pool.emplace(entry->config, entry);
+void TextureCache::FreeTexture(TCacheEntryBase* entry)
+{
+	if (entry->hash_link.IsLinked())
+		textures_by_hash.Erase(entry);
 
-	return textures_by_address.erase(iter);
+	if (entry->IsEfbCopy())
+	{
+		std::pair<u32, TCacheEntryBase*> copy(entry->addr, entry);
+		auto iter = std::lower_bound(efb_copies_by_address.begin(), efb_copies_by_address.end(), copy, CompareEfbCopyAddress);
+		while (iter != efb_copies_by_address.end() && iter->second != entry)
+			++iter;
+		_assert_msg_(VIDEO, iter != efb_copies_by_address.end(), "EFB copy at 0x%08x is not in the list of EFB copies", entry->addr);
+		if (iter != efb_copies_by_address.end())
+			efb_copies_by_address.erase(iter);
+	}
+
+	textures_by_address.Erase(entry);
+
+	entry->frameCount = FRAMECOUNT_INVALID;
+	texture_pool.Insert(entry->config.GetId(), entry);
 }
 
 u32 TextureCache::TCacheEntryBase::CacheLinesPerRow() const
@@ -4,11 +4,12 @@
 
 #pragma once
 
-#include <functional>
-#include <map>
-#include <unordered_map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/HashIndex.h"
 #include "Common/Thread.h"
 
 #include "VideoCommon/BPMemory.h"
@@ -33,14 +34,11 @@ public:
 			return width == b.width && height == b.height && levels == b.levels && layers == b.layers && rendertarget == b.rendertarget;
 		}
 
-		struct Hasher : std::hash<u64>
+		// Used as the key of the texture pool
+		u64 GetId() const
 		{
-			size_t operator()(const TextureCache::TCacheEntryConfig& c) const
-			{
-				u64 id = (u64)c.rendertarget << 63 | (u64)c.layers << 48 | (u64)c.levels << 32 | (u64)c.height << 16 | (u64)c.width;
-				return std::hash<u64>::operator()(id);
-			}
-		};
+			return (u64)rendertarget << 63 | (u64)layers << 48 | (u64)levels << 32 | (u64)height << 16 | (u64)width;
+		}
 	};
 	struct TCacheEntryBase
 	{
@@ -62,8 +60,11 @@ public:
 		// used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
 		int frameCount;
 
-		// Keep an iterator to the entry in textures_by_hash, so it does not need to be searched when removing the cache entry
-		std::multimap<u64, TCacheEntryBase*>::iterator textures_by_hash_iter;
+		// Links into textures_by_address, textures_by_hash and texture_pool, so entries can be
+		// found and removed without any searching or allocations
+		Common::HashIndexLink<u64, TCacheEntryBase> address_link;
+		Common::HashIndexLink<u64, TCacheEntryBase> hash_link;
+		Common::HashIndexLink<u64, TCacheEntryBase> pool_link;
 
 		void SetGeneralParameters(u32 _addr, u32 _size, u32 _format)
 		{
@@ -150,19 +151,25 @@ protected:
 	static size_t temp_size;
 
 private:
-	typedef std::multimap<u64, TCacheEntryBase*> TexCache;
-	typedef std::unordered_multimap<TCacheEntryConfig, TCacheEntryBase*, TCacheEntryConfig::Hasher> TexPool;
-	static TCacheEntryBase* DoPartialTextureUpdates(TexCache::iterator iter);
+	typedef Common::HashIndex<u64, TCacheEntryBase, &TCacheEntryBase::address_link> TexAddressCache;
+	typedef Common::HashIndex<u64, TCacheEntryBase, &TCacheEntryBase::hash_link> TexHashCache;
+	typedef Common::HashIndex<u64, TCacheEntryBase, &TCacheEntryBase::pool_link> TexPool;
+	// EFB copies sorted by address, for the range queries of partial texture updates
+	typedef std::vector<std::pair<u32, TCacheEntryBase*>> EfbCopyList;
+
+	static TCacheEntryBase* DoPartialTextureUpdates(TCacheEntryBase* entry_to_update);
 	static void DumpTexture(TCacheEntryBase* entry, std::string basename, unsigned int level);
 	static void CheckTempSize(size_t required_size);
 
 	static TCacheEntryBase* AllocateTexture(const TCacheEntryConfig& config);
-	static TexCache::iterator FreeTexture(TexCache::iterator t_iter);
+	static void AddTexture(TCacheEntryBase* entry);
+	static void FreeTexture(TCacheEntryBase* entry);
 
 	static TCacheEntryBase* ReturnEntry(unsigned int stage, TCacheEntryBase* entry);
 
-	static TexCache textures_by_address;
-	static TexCache textures_by_hash;
+	static TexAddressCache textures_by_address;
+	static TexHashCache textures_by_hash;
+	static EfbCopyList efb_copies_by_address;
 	static TexPool texture_pool;
 	static TCacheEntryBase* bound_textures[8];
 
@@ -3,6 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -10,9 +12,11 @@
 #include <vector>
 
 #include "Common/CommonFuncs.h"
+#include "Common/MathUtil.h"
 #include "Core/HW/Memmap.h"
 
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/Fifo.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderBase.h"
@@ -28,6 +32,8 @@ namespace VertexLoaderManager
 
 float position_cache[3][4];
 u32 position_matrix_index[3];
+float converted_position_cache[3][4];
+u32 converted_position_matrix_index[3];
 
 typedef std::unordered_map<PortableVertexDeclaration, std::unique_ptr<NativeVertexFormat>> NativeVertexFormatMap;
 static NativeVertexFormatMap s_native_vertex_map;
@@ -40,9 +46,45 @@ static VertexLoaderMap s_vertex_loader_map;
 
 u8 *cached_arraybases[12];
 
+// The vertices the conversion thread has loaded ahead of the GPU thread, see ConvertVertices.
+// Every primitive is a record of this header followed by its vertices in the native format. Only
+// the conversion thread moves the write offset, and only the GPU thread the read offset.
+struct ConvertedPrimitive
+{
+	// nullptr if the vertices are left to the GPU thread
+	VertexLoaderBase* loader;
+	u32 count;
+	// The bytes of the vertices in the FIFO, and of the whole record
+	u32 size;
+	u32 record_size;
+	bool in_display_list;
+	// The records go on at the beginning of the buffer
+	bool wrap;
+	float position_cache[3][4];
+	u32 position_matrix_index[3];
+};
+
+static const u32 CONVERTED_BUFFER_SIZE = 4 * 1024 * 1024;
+// Larger primitives are left to the GPU thread. This makes sure that any other record fits into
+// the empty buffer, wherever the offsets are.
+static const u32 MAX_CONVERTED_PRIMITIVE_SIZE = CONVERTED_BUFFER_SIZE / 4;
+// The SIMD vertex loaders may write a bit past the last vertex
+static const u32 CONVERTED_PRIMITIVE_PADDING = 16;
+static const u32 LEFT_TO_GPU_RECORD_SIZE = ROUND_UP(sizeof(ConvertedPrimitive), 16);
+
+// Most of this array is unlikely to be faulted in...
+alignas(16) static u8 s_converted_buffer[CONVERTED_BUFFER_SIZE];
+static std::atomic<u32> s_converted_read;
+static std::atomic<u32> s_converted_write;
+// Set on the GPU thread while it loads vertices left to it
+static bool s_gpu_loads_vertices;
+
 void Init()
 {
 	MarkAllDirty();
+	s_converted_read.store(0);
+	s_converted_write.store(0);
+	s_gpu_loads_vertices = false;
 	for (auto& map_entry : g_main_cp_state.vertex_loaders)
 		map_entry = nullptr;
 	for (auto& map_entry : g_preprocess_cp_state.vertex_loaders)
@@ -120,23 +162,33 @@ void MarkAllDirty()
 	g_preprocess_cp_state.attr_dirty = BitSet32::AllTrue(8);
 }
 
-static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = false)
+static void SetNativeVertexFormat(VertexLoaderBase* loader)
+{
+	// search for a cached native vertex format
+	const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
+	std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
+	if (!native)
+	{
+		native.reset(g_vertex_manager->CreateNativeVertexFormat());
+		native->Initialize(format);
+		native->m_components = loader->m_native_components;
+	}
+	loader->m_native_vertex_format = native.get();
+}
+
+static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = false, bool convert = false)
 {
 	CPState* state = preprocess ? &g_preprocess_cp_state : &g_main_cp_state;
 
 	VertexLoaderBase* loader;
 	if (state->attr_dirty[vtx_attr_group])
 	{
-		// We are not allowed to create a native vertex format on preprocessing as this is on the wrong thread
-		bool check_for_native_format = !preprocess;
-
 		VertexLoaderUID uid(state->vtx_desc, state->vtx_attr[vtx_attr_group]);
 		std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
 		VertexLoaderMap::iterator iter = s_vertex_loader_map.find(uid);
 		if (iter != s_vertex_loader_map.end())
 		{
 			loader = iter->second.get();
-			check_for_native_format &= !loader->m_native_vertex_format;
 		}
 		else
 		{
@@ -144,25 +196,17 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
 			s_vertex_loader_map[uid] = std::unique_ptr<VertexLoaderBase>(loader);
 			INCSTAT(stats.numVertexLoaders);
 		}
-		if (check_for_native_format)
-		{
-			// search for a cached native vertex format
-			const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
-			std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
-			if (!native)
-			{
-				native.reset(g_vertex_manager->CreateNativeVertexFormat());
-				native->Initialize(format);
-				native->m_components = loader->m_native_components;
-			}
-			loader->m_native_vertex_format = native.get();
-		}
 		state->vertex_loaders[vtx_attr_group] = loader;
 		state->attr_dirty[vtx_attr_group] = false;
 	} else {
 		loader = state->vertex_loaders[vtx_attr_group];
 	}
 
+	// We are not allowed to create a native vertex format on preprocessing or conversion as this is on the wrong thread.
+	// The conversion thread may have left it out for a loader which isn't dirty anymore.
+	if (!preprocess && !convert && !loader->m_native_vertex_format)
+		SetNativeVertexFormat(loader);
+
 	// Lookup pointers for any vertex arrays.
 	if (!preprocess)
 		UpdateVertexArrayPointers();
@@ -170,11 +214,174 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
 	return loader;
 }
 
+static ConvertedPrimitive* AllocateConvertedPrimitive(u32 record_size, u32 reserve)
+{
+	u32 read = s_converted_read.load(std::memory_order_acquire);
+	u32 write = s_converted_write.load(std::memory_order_relaxed);
+	ConvertedPrimitive* primitive = (ConvertedPrimitive*)&s_converted_buffer[write];
+
+	// Always leave room for the header which wraps around
+	if (write >= read)
+	{
+		if (write + record_size + reserve + sizeof(ConvertedPrimitive) <= CONVERTED_BUFFER_SIZE)
+			return primitive;
+		if (record_size + reserve >= read)
+			return nullptr;
+		primitive->wrap = true;
+		return (ConvertedPrimitive*)s_converted_buffer;
+	}
+	if (write + record_size + reserve >= read)
+		return nullptr;
+	return primitive;
+}
+
+static void PublishConvertedPrimitive(ConvertedPrimitive* primitive)
+{
+	primitive->wrap = false;
+	s_converted_write.store((u32)((u8*)primitive - s_converted_buffer) + primitive->record_size, std::memory_order_release);
+}
+
+static ConvertedPrimitive* PeekConvertedPrimitive()
+{
+	u32 read = s_converted_read.load(std::memory_order_relaxed);
+	if (read == s_converted_write.load(std::memory_order_acquire))
+		return nullptr;
+	ConvertedPrimitive* primitive = (ConvertedPrimitive*)&s_converted_buffer[read];
+	if (primitive->wrap)
+		primitive = (ConvertedPrimitive*)s_converted_buffer;
+	return primitive;
+}
+
+static void ReleaseConvertedPrimitive(ConvertedPrimitive* primitive)
+{
+	s_converted_read.store((u32)((u8*)primitive - s_converted_buffer) + primitive->record_size, std::memory_order_release);
+}
+
+int ConvertVertices(int vtx_attr_group, int count, DataReader src, bool in_display_list, bool* left_to_gpu)
+{
+	if (!count)
+		return 0;
+
+	VertexLoaderBase* loader = RefreshLoader(vtx_attr_group, false, true);
+
+	int size = count * loader->m_VertexSize;
+	if ((int)src.size() < size)
+		return -1;
+
+	u32 data_size = count * loader->m_native_vtx_decl.stride;
+	u32 record_size = ROUND_UP(sizeof(ConvertedPrimitive) + data_size + CONVERTED_PRIMITIVE_PADDING, 16);
+
+	// Keep room for a record which leaves the vertices to the GPU thread, as display lists
+	// can't be stopped in the middle
+	ConvertedPrimitive* converted = nullptr;
+	if (record_size <= MAX_CONVERTED_PRIMITIVE_SIZE)
+		converted = AllocateConvertedPrimitive(record_size, LEFT_TO_GPU_RECORD_SIZE);
+	if (!converted)
+	{
+		if (!in_display_list && record_size <= MAX_CONVERTED_PRIMITIVE_SIZE)
+			return -2;
+
+		converted = AllocateConvertedPrimitive(LEFT_TO_GPU_RECORD_SIZE, 0);
+		if (!converted)
+			return -2;
+		converted->loader = nullptr;
+		converted->record_size = LEFT_TO_GPU_RECORD_SIZE;
+		converted->in_display_list = in_display_list;
+		PublishConvertedPrimitive(converted);
+		*left_to_gpu = true;
+		return size;
+	}
+
+	u8* data = (u8*)(converted + 1);
+	converted->loader = loader;
+	converted->count = loader->RunVertices(src, DataReader(data, data + data_size + CONVERTED_PRIMITIVE_PADDING), count);
+	converted->size = size;
+	converted->record_size = record_size;
+	memcpy(converted->position_cache, position_cache, sizeof(position_cache));
+	memcpy(converted->position_matrix_index, position_matrix_index, sizeof(position_matrix_index));
+	PublishConvertedPrimitive(converted);
+	return size;
+}
+
+bool HasPendingConvertedVertices()
+{
+	return s_converted_read.load(std::memory_order_acquire) != s_converted_write.load(std::memory_order_relaxed);
+}
+
+void FinishDisplayList()
+{
+	if (!s_gpu_loads_vertices)
+		return;
+
+	// Hand the vertices back to the conversion thread
+	s_gpu_loads_vertices = false;
+	ReleaseConvertedPrimitive(PeekConvertedPrimitive());
+}
+
+static int RunConvertedVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool skip_drawing)
+{
+	// The conversion thread only skips primitives which aren't complete yet
+	ConvertedPrimitive* converted = PeekConvertedPrimitive();
+	if (!converted)
+		return -1;
+
+	// The conversion thread may already be past the end of the data the GPU thread was given,
+	// so the record stays in place until all of the primitive is there
+	if (!converted->loader)
+	{
+		s_gpu_loads_vertices = true;
+		int size = RunVertices(vtx_attr_group, primitive, count, src, skip_drawing, false);
+		if (size < 0)
+			s_gpu_loads_vertices = false;
+		else if (!converted->in_display_list)
+			FinishDisplayList();
+		return size;
+	}
+
+	if ((int)src.size() < converted->size)
+		return -1;
+
+	VertexLoaderBase* loader = converted->loader;
+	if (!skip_drawing)
+	{
+		if (!loader->m_native_vertex_format)
+			SetNativeVertexFormat(loader);
+
+		// If the native vertex format changed, force a flush.
+		if (loader->m_native_vertex_format != s_current_vtx_fmt)
+			VertexManager::Flush();
+		s_current_vtx_fmt = loader->m_native_vertex_format;
+
+		// if cull mode is CULL_ALL, tell VertexManager to skip triangles and quads.
+		bool cullall = (bpmem.genMode.cullmode == GenMode::CULL_ALL && primitive < 5);
+
+		u32 stride = loader->m_native_vtx_decl.stride;
+		DataReader dst = VertexManager::PrepareForAdditionalData(primitive, count, stride, cullall);
+		memcpy(dst.GetPointer(), converted + 1, converted->count * stride);
+		memcpy(converted_position_cache, converted->position_cache, sizeof(converted_position_cache));
+		memcpy(converted_position_matrix_index, converted->position_matrix_index, sizeof(converted_position_matrix_index));
+
+		IndexGenerator::AddIndices(primitive, converted->count);
+
+		VertexManager::FlushData(converted->count, stride);
+
+		ADDSTAT(stats.thisFrame.numPrims, converted->count);
+		INCSTAT(stats.thisFrame.numPrimitiveJoins);
+	}
+
+	int size = converted->size;
+	ReleaseConvertedPrimitive(converted);
+	return size;
+}
+
 int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool skip_drawing, bool is_preprocess)
 {
 	if (!count)
 		return 0;
 
+	if (g_use_gpu_convert_thread && !is_preprocess && !s_gpu_loads_vertices)
+		return RunConvertedVertices(vtx_attr_group, primitive, count, src, skip_drawing);
+
 	VertexLoaderBase* loader = RefreshLoader(vtx_attr_group, is_preprocess);
 
 	int size = count * loader->m_VertexSize;
@@ -198,6 +405,12 @@ int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bo
 
 	count = loader->RunVertices(src, dst, count);
 
+	if (g_use_gpu_convert_thread)
+	{
+		memcpy(converted_position_cache, position_cache, sizeof(position_cache));
+		memcpy(converted_position_matrix_index, position_matrix_index, sizeof(position_matrix_index));
+	}
+
 	IndexGenerator::AddIndices(primitive, count);
 
 	VertexManager::FlushData(count, loader->m_native_vtx_decl.stride);
@@ -214,22 +427,10 @@ NativeVertexFormat* GetCurrentVertexFormat()
 
 }  // namespace
 
-void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
+static void LoadVertexCPReg(CPState* state, u32 sub_cmd, u32 value)
 {
-	bool update_global_state = !is_preprocess;
-	CPState* state = is_preprocess ? &g_preprocess_cp_state : &g_main_cp_state;
 	switch (sub_cmd & 0xF0)
 	{
-	case 0x30:
-		if (update_global_state)
-			VertexShaderManager::SetTexMatrixChangedA(value);
-		break;
-
-	case 0x40:
-		if (update_global_state)
-			VertexShaderManager::SetTexMatrixChangedB(value);
-		break;
-
 	case 0x50:
 		state->vtx_desc.Hex &= ~0x1FFFF;  // keep the Upper bits
 		state->vtx_desc.Hex |= value;
@@ -274,6 +475,35 @@ void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
 	}
 }
 
+void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
+{
+	if (is_preprocess)
+	{
+		LoadVertexCPReg(&g_preprocess_cp_state, sub_cmd, value);
+		return;
+	}
+
+	switch (sub_cmd & 0xF0)
+	{
+	case 0x30:
+		VertexShaderManager::SetTexMatrixChangedA(value);
+		break;
+
+	case 0x40:
+		VertexShaderManager::SetTexMatrixChangedB(value);
+		break;
+	}
+
+	// The conversion thread has already loaded the rest, unless it left the vertices to us
+	if (!g_use_gpu_convert_thread || VertexLoaderManager::s_gpu_loads_vertices)
+		LoadVertexCPReg(&g_main_cp_state, sub_cmd, value);
+}
+
+void LoadCPRegForConversion(u32 sub_cmd, u32 value)
+{
+	LoadVertexCPReg(&g_main_cp_state, sub_cmd, value);
+}
+
 void FillCPMemoryArray(u32 *memory)
 {
 	memory[0x30] = g_main_cp_state.matrix_index_a.Hex;
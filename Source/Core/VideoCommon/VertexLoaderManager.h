@@ -20,6 +20,18 @@ namespace VertexLoaderManager
 	// Returns -1 if buf_size is insufficient, else the amount of bytes consumed
 	int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool skip_drawing, bool is_preprocess);
 
+	// In g_use_gpu_convert_thread mode, the conversion thread loads the vertices of every primitive
+	// ahead of the GPU thread into a ring buffer, which RunVertices then only copies from. When a
+	// primitive doesn't fit in, its vertices and those of the rest of its display list are left to
+	// the GPU thread, with the conversion thread waiting until it is done with them.
+	// Returns -1 if buf_size is insufficient, -2 if the ring buffer is full, else the amount of
+	// bytes consumed. Sets *left_to_gpu if the vertices were left to the GPU thread.
+	int ConvertVertices(int vtx_attr_group, int count, DataReader src, bool in_display_list, bool* left_to_gpu);
+	// Whether the GPU thread has converted vertices left to draw, or vertices left to it to load
+	bool HasPendingConvertedVertices();
+	// Called by the GPU thread at the end of every display list
+	void FinishDisplayList();
+
 	// For debugging
 	void AppendListToString(std::string *dest);
 
@@ -33,5 +45,9 @@ namespace VertexLoaderManager
 	// These arrays are in reverse order.
 	extern float position_cache[3][4];
 	extern u32 position_matrix_index[3];
+	// In g_use_gpu_convert_thread mode, the loaders fill these ahead of the GPU thread, so it gets
+	// them from the converted vertices, into the following copies.
+	extern float converted_position_cache[3][4];
+	extern u32 converted_position_matrix_index[3];
 }
 
@@ -6,6 +6,7 @@
 
 #include "VideoCommon/BPStructs.h"
 #include "VideoCommon/Debugger.h"
+#include "VideoCommon/Fifo.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/IndexGenerator.h"
 #include "VideoCommon/MainBase.h"
@@ -293,6 +294,15 @@ void VertexManager::CalculateZSlope(NativeVertexFormat* format)
 	if ((s_pCurBufferPointer - s_pBaseBufferPointer) < (vert_decl.stride * 3))
 		return;
 
+	// The loaders may be ahead of us on the conversion thread
+	float (*position_cache)[4] = VertexLoaderManager::position_cache;
+	u32* position_matrix_index = VertexLoaderManager::position_matrix_index;
+	if (g_use_gpu_convert_thread)
+	{
+		position_cache = VertexLoaderManager::converted_position_cache;
+		position_matrix_index = VertexLoaderManager::converted_position_matrix_index;
+	}
+
 	// Lookup vertices of the last rendered triangle and software-transform them
 	// This allows us to determine the depth slope, which will be used if z-freeze
 	// is enabled in the following flush.
@@ -300,12 +310,12 @@ void VertexManager::CalculateZSlope(NativeVertexFormat* format)
 	{
 		// If this vertex format has per-vertex position matrix IDs, look it up.
 		if (vert_decl.posmtx.enable)
-			mtxIdx = VertexLoaderManager::position_matrix_index[2 - i];
+			mtxIdx = position_matrix_index[2 - i];
 
 		if (vert_decl.position.components == 2)
-			VertexLoaderManager::position_cache[2 - i][2] = 0;
+			position_cache[2 - i][2] = 0;
 
-		VertexShaderManager::TransformToClipSpace(&VertexLoaderManager::position_cache[2 - i][0], &out[i * 4], mtxIdx);
+		VertexShaderManager::TransformToClipSpace(&position_cache[2 - i][0], &out[i * 4], mtxIdx);
 
 		// Transform to Screenspace
 		float inv_w = 1.0f / out[3 + i * 4];
@@ -416,7 +416,10 @@ static inline void GenerateVertexShader(T& out, u32 components, API_TYPE api_typ
 
 void GetVertexShaderUid(VertexShaderUid& object, u32 components, API_TYPE api_type)
 {
-	GenerateVertexShader<VertexShaderUid>(object, components, api_type);
+	static ShaderUidCache<VertexShaderUid> cache(SHADER_UID_VERTEX);
+	cache.Get(object, components, 0, api_type, [&](VertexShaderUid& uid) {
+		GenerateVertexShader<VertexShaderUid>(uid, components, api_type);
+	});
 }
 
 void GenerateVertexShaderCode(VertexShaderCode& object, u32 components, API_TYPE api_type)
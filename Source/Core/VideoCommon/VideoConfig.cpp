@@ -12,6 +12,7 @@
 #include "Core/Core.h"
 #include "Core/Movie.h"
 #include "VideoCommon/OnScreenDisplay.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/VideoCommon.h"
 #include "VideoCommon/VideoConfig.h"
 
@@ -23,6 +24,9 @@ void UpdateActiveConfig()
 	if (Movie::IsPlayingInput() && Movie::IsConfigSaved())
 		Movie::SetGraphicsConfig();
 	g_ActiveConfig = g_Config;
+
+	// Shader UIDs depend on a bunch of settings, so don't bother figuring out what changed
+	InvalidateShaderUids(SHADER_UID_ALL);
 }
 
 VideoConfig::VideoConfig()
@@ -113,6 +117,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	hacks->Get("EFBToTextureEnable", &bSkipEFBCopyToRam, true);
 	hacks->Get("EFBScaledCopy", &bCopyEFBScaled, true);
 	hacks->Get("EFBEmulateFormatChanges", &bEFBEmulateFormatChanges, false);
+	hacks->Get("ShaderCompilationMode", &iShaderCompilationMode, (int)SHADER_COMPILE_SYNCHRONOUS);
 
 	// hacks which are disabled by default
 	iPhackvalue[0] = 0;
@@ -231,6 +236,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Hacks", "EFBToTextureEnable", bSkipEFBCopyToRam);
 	CHECK_SETTING("Video_Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	CHECK_SETTING("Video_Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
+	CHECK_SETTING("Video_Hacks", "ShaderCompilationMode", iShaderCompilationMode);
 
 	CHECK_SETTING("Video", "ProjectionHack", iPhackvalue[0]);
 	CHECK_SETTING("Video", "PH_SZNear", iPhackvalue[1]);
@@ -321,6 +327,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	hacks->Set("EFBToTextureEnable", bSkipEFBCopyToRam);
 	hacks->Set("EFBScaledCopy", bCopyEFBScaled);
 	hacks->Set("EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
+	hacks->Set("ShaderCompilationMode", iShaderCompilationMode);
 
 	iniFile.Save(ini_file);
 }
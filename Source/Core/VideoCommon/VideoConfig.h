@@ -51,6 +51,13 @@ enum StereoMode
 	STEREO_3DVISION
 };
 
+enum ShaderCompilationMode
+{
+	SHADER_COMPILE_SYNCHRONOUS = 0,  // stall until a new shader is ready
+	SHADER_COMPILE_ASYNC_SKIP_DRAW,  // compile in the background, skip draws until ready
+	SHADER_COMPILE_ASYNC_FALLBACK,   // compile in the background, draw with a similar shader until ready
+};
+
 constexpr int STEREOSCOPY_PRESETS_NUM = 3;
 
 struct StereoscopyPreset final
@@ -133,6 +140,7 @@ struct VideoConfig final
 	float fAspectRatioHackW, fAspectRatioHackH;
 	bool bEnablePixelLighting;
 	bool bFastDepthCalc;
+	int iShaderCompilationMode;
 	int iLog; // CONF_ bits
 	int iSaveTargetId; // TODO: Should be dropped
 
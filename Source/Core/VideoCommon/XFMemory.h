@@ -311,3 +311,10 @@ extern XFMemory xfmem;
 void LoadXFReg(u32 transferSize, u32 address, DataReader src);
 void LoadIndexedXF(u32 val, int array);
 void PreprocessIndexedXF(u32 val, int refarray);
+
+// In g_use_gpu_convert_thread mode, the conversion thread keeps track of the XF memory ahead of
+// the GPU thread. IsRedundantXFWrite returns whether a load only writes XF memory with the values
+// it already holds, so that the GPU thread can skip it.
+bool IsRedundantXFWrite(u32 transferSize, u32 address, DataReader src);
+void TrackIndexedXFWrite(u32 val, const u32* data);
+void ResetXFWriteTracking();
@@ -2,6 +2,9 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <bitset>
+
 #include "Common/Common.h"
 #include "Core/HW/Memmap.h"
 #include "VideoCommon/CPMemory.h"
@@ -9,6 +12,7 @@
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/GeometryShaderManager.h"
 #include "VideoCommon/PixelShaderManager.h"
+#include "VideoCommon/ShaderGenCommon.h"
 #include "VideoCommon/VertexManagerBase.h"
 #include "VideoCommon/VertexShaderManager.h"
 #include "VideoCommon/VideoCommon.h"
@@ -242,7 +246,11 @@ void LoadXFReg(u32 transferSize, u32 baseAddress, DataReader src)
 		XFRegWritten(transferSize, baseAddress, src);
 		for (u32 i = 0; i < transferSize; i++)
 		{
-			((u32*)&xfmem)[baseAddress + i] = src.Read<u32>();
+			u32& reg = ((u32*)&xfmem)[baseAddress + i];
+			u32 value = src.Read<u32>();
+			if (reg != value)
+				InvalidateShaderUidsForXFReg(baseAddress + i);
+			reg = value;
 		}
 	}
 }
@@ -292,3 +300,45 @@ void PreprocessIndexedXF(u32 val, int refarray)
 	size_t buf_size = size * sizeof(u32);
 	PushFifoAuxBuffer(new_data, buf_size);
 }
+
+// The XF memory (without the registers) as the loads the conversion thread has seen leave it
+static u32 s_tracked_xfmem[0x1000];
+static std::bitset<0x1000> s_tracked_xfmem_known;
+
+bool IsRedundantXFWrite(u32 transferSize, u32 baseAddress, DataReader src)
+{
+	if (baseAddress >= 0x1000)
+		return false;
+
+	// Register writes are always left to LoadXFReg
+	bool redundant = baseAddress + transferSize <= 0x1000;
+	u32 end = std::min(baseAddress + transferSize, 0x1000u);
+	for (u32 address = baseAddress; address < end; address++)
+	{
+		u32 value = src.Read<u32>();
+		if (!s_tracked_xfmem_known[address] || s_tracked_xfmem[address] != value)
+		{
+			s_tracked_xfmem[address] = value;
+			s_tracked_xfmem_known[address] = true;
+			redundant = false;
+		}
+	}
+	return redundant;
+}
+
+void TrackIndexedXFWrite(u32 val, const u32* data)
+{
+	int address = val & 0xFFF;
+	int size = ((val >> 12) & 0xF) + 1;
+
+	for (int i = 0; i < size && address + i < 0x1000; ++i)
+	{
+		s_tracked_xfmem[address + i] = Common::swap32(data[i]);
+		s_tracked_xfmem_known[address + i] = true;
+	}
+}
+
+void ResetXFWriteTracking()
+{
+	s_tracked_xfmem_known.reset();
+}
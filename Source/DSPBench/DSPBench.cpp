@@ -0,0 +1,436 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Replays a capture of the HLE ucodes (see HLECapture.h) a number of times without the rest
+// of the emulator, and reports how fast the ucodes ran and whether their output still matches
+// the one which was captured.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/MemoryUtil.h"
+#include "Common/GL/GLInterfaceBase.h"
+
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/DSPEmulator.h"
+#include "Core/Host.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/HLECapture.h"
+
+#include "UICommon/UICommon.h"
+
+enum Stage
+{
+	STAGE_MAILS,
+	STAGE_UPDATES,
+	STAGE_RESETS,
+	NUM_STAGES
+};
+
+static const char* const STAGE_NAMES[NUM_STAGES] = {
+	"mails", "updates", "resets",
+};
+
+struct Record
+{
+	u8 type;
+	u8 region;
+	u32 value;
+	u64 hash;
+	// Offset of the data of memory records in the capture
+	size_t data;
+};
+
+struct RunTiming
+{
+	u64 stages[NUM_STAGES];
+};
+
+struct Capture
+{
+	bool wii;
+	std::vector<u8> contents;
+	std::vector<Record> records;
+	u32 mails;
+	u32 resets;
+	u32 updates;
+};
+
+void Host_NotifyMapLoaded() {}
+void Host_RefreshDSPDebuggerWindow() {}
+void Host_Message(int) {}
+void* Host_GetRenderHandle() { return nullptr; }
+void Host_UpdateTitle(const std::string&) {}
+void Host_UpdateDisasmDialog() {}
+void Host_UpdateMainFrame() {}
+void Host_RequestRenderWindowSize(int, int) {}
+void Host_RequestFullscreen(bool) {}
+void Host_SetStartupDebuggingParameters() {}
+bool Host_UIHasFocus() { return false; }
+bool Host_RendererHasFocus() { return false; }
+bool Host_RendererIsFullscreen() { return false; }
+void Host_ConnectWiimote(int, bool) {}
+void Host_SetWiiMoteConnectionState(int) {}
+void Host_ShowVideoConfig(void*, const std::string&, const std::string&) {}
+cInterfaceBase* HostGL_CreateGLInterface() { return nullptr; }
+
+template <typename T>
+static bool ReadValue(const std::vector<u8>& contents, size_t* offset, T* value)
+{
+	if (contents.size() - *offset < sizeof (T))
+		return false;
+
+	memcpy(value, &contents[*offset], sizeof (T));
+	*offset += sizeof (T);
+	return true;
+}
+
+static bool LoadCapture(const char* filename, Capture* capture)
+{
+	File::IOFile file(filename, "rb");
+	capture->contents.resize(file.GetSize());
+	if (!file || !file.ReadBytes(capture->contents.data(), capture->contents.size()))
+	{
+		fprintf(stderr, "Could not read %s\n", filename);
+		return false;
+	}
+
+	const std::vector<u8>& contents = capture->contents;
+	size_t offset = 0;
+	HLECapture::CaptureHeader header;
+	if (!ReadValue(contents, &offset, &header) || header.magic != HLECapture::CAPTURE_MAGIC)
+	{
+		fprintf(stderr, "%s is not a capture of the HLE ucodes\n", filename);
+		return false;
+	}
+	if (header.version != HLECapture::CAPTURE_VERSION || header.block_size != HLECapture::BLOCK_SIZE)
+	{
+		fprintf(stderr, "%s was made by an incompatible version (%u)\n", filename, header.version);
+		return false;
+	}
+	capture->wii = (header.flags & HLECapture::FLAG_WII) != 0;
+
+	const u32 region_sizes[HLECapture::NUM_REGIONS] = {
+		Memory::RAM_SIZE, capture->wii ? (u32)Memory::EXRAM_SIZE : 0, capture->wii ? 0 : (u32)DSP::ARAM_SIZE
+	};
+
+	capture->mails = capture->resets = capture->updates = 0;
+	while (offset < contents.size())
+	{
+		Record record = {};
+		bool valid = ReadValue(contents, &offset, &record.type);
+		switch (record.type)
+		{
+		case HLECapture::RECORD_MEMORY:
+			valid = valid && ReadValue(contents, &offset, &record.region) &&
+			        ReadValue(contents, &offset, &record.value) &&
+			        record.region < HLECapture::NUM_REGIONS &&
+			        record.value < (region_sizes[record.region] >> HLECapture::BLOCK_SHIFT) &&
+			        contents.size() - offset >= HLECapture::BLOCK_SIZE;
+			record.data = offset;
+			offset += HLECapture::BLOCK_SIZE;
+			break;
+		case HLECapture::RECORD_MAIL:
+		case HLECapture::RECORD_CONTROL:
+			valid = valid && ReadValue(contents, &offset, &record.value) &&
+			        ReadValue(contents, &offset, &record.hash);
+			if (record.type == HLECapture::RECORD_MAIL)
+				capture->mails++;
+			else
+				capture->resets++;
+			break;
+		case HLECapture::RECORD_UPDATE:
+			valid = valid && ReadValue(contents, &offset, &record.value);
+			capture->updates += record.value;
+			break;
+		case HLECapture::RECORD_READ_MAIL:
+			valid = valid && ReadValue(contents, &offset, &record.value);
+			break;
+		default:
+			valid = false;
+			break;
+		}
+
+		if (!valid)
+		{
+			// The capture may have been cut short by a crash, so play what came before
+			fprintf(stderr, "%s is damaged at offset %zu, ignoring the rest\n", filename, offset);
+			break;
+		}
+		capture->records.push_back(record);
+	}
+
+	return true;
+}
+
+static u8* GetRegionPointer(u8 region)
+{
+	switch (region)
+	{
+	case HLECapture::REGION_RAM:
+		return Memory::m_pRAM;
+	case HLECapture::REGION_EXRAM:
+		return Memory::m_pEXRAM;
+	default:
+		return DSP::GetARAMPtr();
+	}
+}
+
+// Events which the DSP sends to the CPU would pile up, as there is no CPU to handle them
+static void DiscardEvents()
+{
+	CoreTiming::MoveEvents();
+	CoreTiming::ClearPendingEvents();
+}
+
+// Plays the capture once from a freshly booted DSP. When verifying, the memory used by the
+// ucodes is tracked to check their output, which is too slow to be timed.
+static RunTiming PlayCapture(const Capture& capture, bool verify, u32* mismatches)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	RunTiming timing = {};
+	*mismatches = 0;
+
+	memset(Memory::m_pRAM, 0, Memory::RAM_SIZE);
+	if (capture.wii)
+		memset(Memory::m_pEXRAM, 0, Memory::EXRAM_SIZE);
+	else
+		memset(DSP::GetARAMPtr(), 0, DSP::ARAM_SIZE);
+
+	if (verify)
+		HLECapture::StartTracking();
+
+	DSPEmulator* dsp = DSP::GetDSPEmulator();
+	dsp->Initialize(capture.wii, false);
+
+	for (const Record& record : capture.records)
+	{
+		const auto start = Clock::now();
+		int stage = STAGE_MAILS;
+		u64 hash = 0;
+
+		switch (record.type)
+		{
+		case HLECapture::RECORD_MEMORY:
+			memcpy(GetRegionPointer(record.region) + (record.value << HLECapture::BLOCK_SHIFT),
+			       &capture.contents[record.data], HLECapture::BLOCK_SIZE);
+			continue;
+		case HLECapture::RECORD_MAIL:
+			dsp->DSP_WriteMailBoxHigh(true, record.value >> 16);
+			dsp->DSP_WriteMailBoxLow(true, record.value & 0xFFFF);
+			hash = HLECapture::GetLastEventHash();
+			break;
+		case HLECapture::RECORD_CONTROL:
+			dsp->DSP_WriteControlRegister(record.value);
+			hash = HLECapture::GetLastEventHash();
+			stage = STAGE_RESETS;
+			break;
+		case HLECapture::RECORD_UPDATE:
+			for (u32 i = 0; i < record.value; i++)
+				dsp->DSP_Update(0);
+			stage = STAGE_UPDATES;
+			break;
+		case HLECapture::RECORD_READ_MAIL:
+		{
+			const u32 high = dsp->DSP_ReadMailBoxHigh(false);
+			const u32 mail = (high << 16) | dsp->DSP_ReadMailBoxLow(false);
+			if (mail != record.value)
+				++*mismatches;
+			continue;
+		}
+		}
+
+		timing.stages[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		if (verify && hash != record.hash)
+			++*mismatches;
+		DiscardEvents();
+	}
+
+	// Also stops the tracking
+	dsp->Shutdown();
+	DiscardEvents();
+
+	return timing;
+}
+
+static u64 Median(std::vector<u64> times)
+{
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+static void PrintResults(const Capture& capture, const std::vector<RunTiming>& runs, const char* csv_filename)
+{
+	// The HLE ucodes are updated every millisecond of emulated time, see DSPHLE::DSP_UpdateRate
+	printf("%u mails, %u resets and %u updates (%.3f s of emulated audio) per run, %u runs\n\n",
+		capture.mails, capture.resets, capture.updates, capture.updates / 1e3, (u32)runs.size());
+	printf("%-16s %10s %10s %10s\n", "ms per run", "mean", "median", "max");
+
+	std::vector<u64> totals(runs.size());
+	for (int stage = 0; stage <= NUM_STAGES; stage++)
+	{
+		std::vector<u64> times;
+		for (size_t i = 0; i < runs.size(); i++)
+		{
+			if (stage < NUM_STAGES)
+			{
+				times.push_back(runs[i].stages[stage]);
+				totals[i] += runs[i].stages[stage];
+			}
+			else
+			{
+				times.push_back(totals[i]);
+			}
+		}
+
+		u64 sum = 0;
+		for (u64 time : times)
+			sum += time;
+		printf("%-16s %10.3f %10.3f %10.3f\n", stage < NUM_STAGES ? STAGE_NAMES[stage] : "total",
+			sum / 1e6 / times.size(), Median(times) / 1e6, *std::max_element(times.begin(), times.end()) / 1e6);
+	}
+
+	const u64 median = std::max<u64>(Median(totals), 1);
+	printf("\n%.0f mails per second, %.1fx realtime\n",
+		capture.mails * 1e9 / median, capture.updates * 1e6 / median);
+
+	if (!csv_filename)
+		return;
+
+	File::IOFile csv(csv_filename, "w");
+	if (!csv)
+	{
+		fprintf(stderr, "Could not write %s\n", csv_filename);
+		return;
+	}
+
+	fprintf(csv.GetHandle(), "run,mails_us,updates_us,resets_us,total_us\n");
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		const RunTiming& run = runs[i];
+		fprintf(csv.GetHandle(), "%u,%.3f,%.3f,%.3f,%.3f\n", (u32)i, run.stages[STAGE_MAILS] / 1e3,
+			run.stages[STAGE_UPDATES] / 1e3, run.stages[STAGE_RESETS] / 1e3, totals[i] / 1e3);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int ch, help = 0;
+	u32 num_runs = 5;
+	bool parallel_voices = false;
+	const char* csv_filename = nullptr;
+	std::string user_directory;
+	struct option longopts[] = {
+		{ "runs",     required_argument, nullptr, 'n' },
+		{ "csv",      required_argument, nullptr, 'o' },
+		{ "user",     required_argument, nullptr, 'u' },
+		{ "parallel", no_argument,       nullptr, 'p' },
+		{ "help",     no_argument,       nullptr, 'h' },
+		{ nullptr,    0,                 nullptr,  0  }
+	};
+
+	while ((ch = getopt_long(argc, argv, "n:o:u:ph?", longopts, 0)) != -1)
+	{
+		switch (ch)
+		{
+		case 'n':
+			num_runs = std::max(atoi(optarg), 1);
+			break;
+		case 'o':
+			csv_filename = optarg;
+			break;
+		case 'u':
+			user_directory = optarg;
+			break;
+		case 'p':
+			parallel_voices = true;
+			break;
+		case 'h':
+		case '?':
+			help = 1;
+			break;
+		}
+	}
+
+	if (help == 1 || argc != optind + 1)
+	{
+		fprintf(stderr, "Replays a capture of the HLE ucodes, checks their output and times them\n\n");
+		fprintf(stderr, "Usage: %s [-n <runs>] [-o <file>] [-u <dir>] [-p] <dsphle.cap>\n", argv[0]);
+		fprintf(stderr, "  -n, --runs     Number of timed runs (default 5)\n");
+		fprintf(stderr, "  -o, --csv      Write the timings of every run to a CSV file\n");
+		fprintf(stderr, "  -u, --user     User directory to use (default: a new temporary one)\n");
+		fprintf(stderr, "  -p, --parallel Process the AX voices on several threads\n");
+		fprintf(stderr, "  -h, --help     Show this help message\n");
+		return 1;
+	}
+
+	Capture capture;
+	if (!LoadCapture(argv[optind], &capture))
+		return 1;
+
+	// The settings are saved on exit, so the ones changed here must not end up in a real user directory
+	const bool temporary_user_directory = user_directory.empty();
+	if (temporary_user_directory)
+		user_directory = File::CreateTempDir();
+
+	UICommon::SetUserDirectory(user_directory);
+	UICommon::CreateDirectories();
+	UICommon::Init();
+
+	SConfig& StartUp = SConfig::GetInstance();
+	StartUp.bWii = capture.wii;
+	StartUp.m_DSPHLECapture = false;
+	StartUp.m_DSPHLEParallelVoices = parallel_voices;
+
+	// Only the memory the ucodes can reach, the rest of the hardware is not needed
+	Memory::m_pRAM = (u8*)AllocateMemoryPages(Memory::RAM_SIZE);
+	if (capture.wii)
+		Memory::m_pEXRAM = (u8*)AllocateMemoryPages(Memory::EXRAM_SIZE);
+	CoreTiming::Init();
+	DSP::Init(true);
+
+	// The first run checks the output, the following ones are timed
+	u32 mismatches;
+	PlayCapture(capture, true, &mismatches);
+	if (mismatches)
+		printf("%u events do not match the capture\n", mismatches);
+	else
+		printf("The output matches the capture\n");
+
+	std::vector<RunTiming> runs;
+	for (u32 i = 0; i < num_runs; i++)
+	{
+		u32 mail_mismatches;
+		runs.push_back(PlayCapture(capture, false, &mail_mismatches));
+	}
+	PrintResults(capture, runs, csv_filename);
+
+	DSP::Shutdown();
+	CoreTiming::Shutdown();
+	FreeMemoryPages(Memory::m_pRAM, Memory::RAM_SIZE);
+	Memory::m_pRAM = nullptr;
+	if (capture.wii)
+	{
+		FreeMemoryPages(Memory::m_pEXRAM, Memory::EXRAM_SIZE);
+		Memory::m_pEXRAM = nullptr;
+	}
+
+	UICommon::Shutdown();
+
+	if (temporary_user_directory)
+		File::DeleteDirRecursively(user_directory);
+
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,401 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Replays a FIFO log a number of times without any window, and reports how long every frame
+// took. On the software renderer, the time is also split up into the stages of its pipeline.
+// The OpenGL backend renders into a pbuffer of a surfaceless EGL display, as Mesa provides it.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+#include "AudioCommon/AudioCommon.h"
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/FileUtil.h"
+#include "Common/GL/GLInterfaceBase.h"
+
+#include "Core/BootManager.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/Host.h"
+#include "Core/FifoPlayer/FifoPlayer.h"
+#include "Core/PowerPC/PowerPC.h"
+
+#include "UICommon/UICommon.h"
+
+#include "VideoBackends/Software/SWStatistics.h"
+#include "VideoCommon/Fifo.h"
+#include "VideoCommon/VideoBackendBase.h"
+
+#if defined(HAVE_EGL) && HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+static const char* const STAGE_NAMES[SWTiming::NUM_STAGES] = {
+	"other", "opcode decode", "vertex loading", "texture decode", "rasterization",
+};
+
+struct FrameTiming
+{
+	u64 wall;
+	u64 stages[SWTiming::NUM_STAGES];
+};
+
+static Common::Event s_stopped;
+static u32 s_runs = 5;
+static u32 s_framesPerRun;
+static std::vector<FrameTiming> s_frames;
+static bool s_started;
+static bool s_software;
+static u64 s_lastTotals[SWTiming::NUM_STAGES];
+static std::chrono::steady_clock::time_point s_lastWall;
+
+void Host_NotifyMapLoaded() {}
+void Host_RefreshDSPDebuggerWindow() {}
+
+void Host_Message(int Id)
+{
+	if (Id == WM_USER_STOP)
+		s_stopped.Set();
+}
+
+void* Host_GetRenderHandle() { return nullptr; }
+void Host_UpdateTitle(const std::string&) {}
+void Host_UpdateDisasmDialog() {}
+void Host_UpdateMainFrame() {}
+void Host_RequestRenderWindowSize(int, int) {}
+void Host_RequestFullscreen(bool) {}
+
+void Host_SetStartupDebuggingParameters()
+{
+	SConfig& StartUp = SConfig::GetInstance();
+	StartUp.bEnableDebugging = false;
+	StartUp.bBootToPause = false;
+}
+
+bool Host_UIHasFocus() { return false; }
+bool Host_RendererHasFocus() { return false; }
+bool Host_RendererIsFullscreen() { return false; }
+void Host_ConnectWiimote(int, bool) {}
+void Host_SetWiiMoteConnectionState(int) {}
+void Host_ShowVideoConfig(void*, const std::string&, const std::string&) {}
+#if defined(HAVE_EGL) && HAVE_EGL
+// An OpenGL 3.3 core context on a pbuffer, without any window system
+class cInterfaceHeadlessEGL final : public cInterfaceBase
+{
+public:
+	bool Create(void* window_handle, bool core) override
+	{
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (!get_platform_display)
+			return false;
+		m_dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (m_dpy == EGL_NO_DISPLAY || !eglInitialize(m_dpy, nullptr, nullptr))
+		{
+			fprintf(stderr, "Could not open a surfaceless EGL display\n");
+			return false;
+		}
+
+		const EGLint config_attribs[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint num_configs;
+		if (!eglChooseConfig(m_dpy, config_attribs, &config, 1, &num_configs) || num_configs == 0)
+			return false;
+
+		const EGLint context_attribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		eglBindAPI(EGL_OPENGL_API);
+		m_ctx = eglCreateContext(m_dpy, config, EGL_NO_CONTEXT, context_attribs);
+
+		s_backbuffer_width = 640;
+		s_backbuffer_height = 528;
+		const EGLint pbuffer_attribs[] = { EGL_WIDTH, (EGLint)s_backbuffer_width, EGL_HEIGHT, (EGLint)s_backbuffer_height, EGL_NONE };
+		m_surf = eglCreatePbufferSurface(m_dpy, config, pbuffer_attribs);
+
+		s_opengl_mode = GLInterfaceMode::MODE_OPENGL;
+		return m_ctx != EGL_NO_CONTEXT && m_surf != EGL_NO_SURFACE;
+	}
+
+	void* GetFuncAddress(const std::string& name) override
+	{
+		return (void*)eglGetProcAddress(name.c_str());
+	}
+
+	void Swap() override { eglSwapBuffers(m_dpy, m_surf); }
+	bool MakeCurrent() override { return eglMakeCurrent(m_dpy, m_surf, m_surf, m_ctx); }
+	bool ClearCurrent() override { return eglMakeCurrent(m_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); }
+
+	void Shutdown() override
+	{
+		if (m_dpy == EGL_NO_DISPLAY)
+			return;
+		eglMakeCurrent(m_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_ctx != EGL_NO_CONTEXT)
+			eglDestroyContext(m_dpy, m_ctx);
+		if (m_surf != EGL_NO_SURFACE)
+			eglDestroySurface(m_dpy, m_surf);
+		eglTerminate(m_dpy);
+		m_dpy = EGL_NO_DISPLAY;
+	}
+
+private:
+	EGLDisplay m_dpy = EGL_NO_DISPLAY;
+	EGLContext m_ctx = EGL_NO_CONTEXT;
+	EGLSurface m_surf = EGL_NO_SURFACE;
+};
+
+cInterfaceBase* HostGL_CreateGLInterface() { return new cInterfaceHeadlessEGL; }
+#else
+cInterfaceBase* HostGL_CreateGLInterface() { return nullptr; }
+#endif
+
+static void OnStopped()
+{
+	s_stopped.Set();
+}
+
+// Called on the CPU thread before every frame of the log is written. As the GPU runs on the
+// same thread in single core mode, everything since the last call belongs to the last frame.
+// A GPU thread is waited for, so that the frames are timed the same way, and so that the
+// player can't overflow the FIFO, which nothing else keeps it from.
+static void FrameWritten()
+{
+	FlushGpu();
+	SyncGPU(SYNC_GPU_OTHER);
+
+	const auto now = std::chrono::steady_clock::now();
+	u64 totals[SWTiming::NUM_STAGES];
+	SWTiming::GetTotals(totals);
+
+	if (!s_started)
+	{
+		FifoPlayer& player = FifoPlayer::GetInstance();
+		s_framesPerRun = player.GetFrameRangeEnd() - player.GetFrameRangeStart();
+		s_frames.reserve(s_runs * s_framesPerRun);
+		s_started = true;
+	}
+	else if (s_frames.size() < s_runs * s_framesPerRun)
+	{
+		FrameTiming frame;
+		frame.wall = std::chrono::duration_cast<std::chrono::nanoseconds>(now - s_lastWall).count();
+		for (int i = 0; i < SWTiming::NUM_STAGES; i++)
+			frame.stages[i] = totals[i] - s_lastTotals[i];
+		s_frames.push_back(frame);
+
+		if (s_frames.size() == s_runs * s_framesPerRun)
+		{
+			PowerPC::Stop();
+			Host_Message(WM_USER_STOP);
+		}
+	}
+
+	std::copy(totals, totals + SWTiming::NUM_STAGES, s_lastTotals);
+	s_lastWall = std::chrono::steady_clock::now();
+}
+
+static void PrintSummary(const char* name, std::vector<u64> times, u32 frames)
+{
+	if (times.empty())
+		return;
+
+	u64 sum = 0;
+	for (u64 time : times)
+		sum += time;
+	std::sort(times.begin(), times.end());
+
+	printf("%-16s %10.3f %10.3f %10.3f %12.3f\n", name,
+		sum / 1e6 / times.size(), times[times.size() / 2] / 1e6, times.back() / 1e6,
+		sum / 1e6 / (times.size() / frames));
+}
+
+static void PrintResults(const char* csv_filename)
+{
+	if (s_framesPerRun == 0 || s_frames.empty())
+		return;
+
+	// The first run warms up the caches and the texture cache, so it is left out if possible
+	const u32 runs = (u32)s_frames.size() / s_framesPerRun;
+	const u32 first = runs > 1 ? s_framesPerRun : 0;
+
+	printf("%u frames per run, %u runs%s\n\n", s_framesPerRun, runs, first ? ", first run not counted" : "");
+	printf("%-16s %10s %10s %10s %12s\n", "ms per frame", "mean", "median", "max", "run total");
+
+	std::vector<u64> times;
+	if (s_software)
+	{
+		for (int stage = SWTiming::OPCODE_DECODE; stage < SWTiming::NUM_STAGES; stage++)
+		{
+			times.clear();
+			for (u32 i = first; i < runs * s_framesPerRun; i++)
+				times.push_back(s_frames[i].stages[stage]);
+			PrintSummary(STAGE_NAMES[stage], times, s_framesPerRun);
+		}
+		times.clear();
+		for (u32 i = first; i < runs * s_framesPerRun; i++)
+			times.push_back(s_frames[i].stages[SWTiming::NONE]);
+		PrintSummary(STAGE_NAMES[SWTiming::NONE], times, s_framesPerRun);
+	}
+	times.clear();
+	for (u32 i = first; i < runs * s_framesPerRun; i++)
+		times.push_back(s_frames[i].wall);
+	PrintSummary("wall", times, s_framesPerRun);
+
+	if (!csv_filename)
+		return;
+
+	File::IOFile csv(csv_filename, "w");
+	if (!csv)
+	{
+		fprintf(stderr, "Could not write %s\n", csv_filename);
+		return;
+	}
+
+	fprintf(csv.GetHandle(), "run,frame,wall_us,opcode_decode_us,vertex_loading_us,texture_decode_us,rasterization_us\n");
+	for (u32 i = 0; i < runs * s_framesPerRun; i++)
+	{
+		const FrameTiming& frame = s_frames[i];
+		fprintf(csv.GetHandle(), "%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n", i / s_framesPerRun, i % s_framesPerRun,
+			frame.wall / 1e3, frame.stages[SWTiming::OPCODE_DECODE] / 1e3, frame.stages[SWTiming::VERTEX_LOADING] / 1e3,
+			frame.stages[SWTiming::TEXTURE_DECODE] / 1e3, frame.stages[SWTiming::RASTERIZATION] / 1e3);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int ch, help = 0;
+	const char* csv_filename = nullptr;
+	std::string user_directory;
+	std::string video_backend = "Software Renderer";
+	std::string mode = "single";
+	bool convert_thread = false;
+	struct option longopts[] = {
+		{ "runs",    required_argument, nullptr, 'n' },
+		{ "csv",     required_argument, nullptr, 'o' },
+		{ "user",    required_argument, nullptr, 'u' },
+		{ "video",   required_argument, nullptr, 'v' },
+		{ "mode",    required_argument, nullptr, 'm' },
+		{ "convert", no_argument,       nullptr, 'c' },
+		{ "help",    no_argument,       nullptr, 'h' },
+		{ nullptr,   0,                 nullptr,  0  }
+	};
+
+	while ((ch = getopt_long(argc, argv, "n:o:u:v:m:ch?", longopts, 0)) != -1)
+	{
+		switch (ch)
+		{
+		case 'n':
+			s_runs = std::max(atoi(optarg), 1);
+			break;
+		case 'o':
+			csv_filename = optarg;
+			break;
+		case 'u':
+			user_directory = optarg;
+			break;
+		case 'v':
+			video_backend = optarg;
+			break;
+		case 'm':
+			mode = optarg;
+			if (mode != "single" && mode != "dual" && mode != "deterministic")
+				help = 1;
+			break;
+		case 'c':
+			convert_thread = true;
+			break;
+		case 'h':
+		case '?':
+			help = 1;
+			break;
+		}
+	}
+
+	if (help == 1 || argc != optind + 1)
+	{
+		fprintf(stderr, "Replays a FIFO log without any window and times the GPU pipeline\n\n");
+		fprintf(stderr, "Usage: %s [-n <runs>] [-o <file>] [-u <dir>] [-v <backend>] [-m <mode>] [-c] <file.dff>\n", argv[0]);
+		fprintf(stderr, "  -n, --runs     Number of times to play the log (default 5)\n");
+		fprintf(stderr, "  -o, --csv      Write the timings of every frame to a CSV file\n");
+		fprintf(stderr, "  -u, --user     User directory to use (default: a new temporary one)\n");
+		fprintf(stderr, "  -v, --video    Video backend, \"Software Renderer\" (default) or \"OGL\"\n");
+		fprintf(stderr, "  -m, --mode     single (default), dual or deterministic (dual core with a deterministic GPU thread)\n");
+		fprintf(stderr, "  -c, --convert  With a deterministic GPU thread, load vertices on a thread of their own\n");
+		fprintf(stderr, "  -h, --help     Show this help message\n");
+		return 1;
+	}
+
+	// Booting saves the settings, so the ones changed here must not end up in a real user directory
+	const bool temporary_user_directory = user_directory.empty();
+	if (temporary_user_directory)
+		user_directory = File::CreateTempDir();
+
+	UICommon::SetUserDirectory(user_directory);
+	UICommon::CreateDirectories();
+	UICommon::Init();
+
+	// In single core mode, the GPU runs on the thread which plays the log, and a GPU thread is
+	// waited for, so every frame has been processed completely when the next one is written.
+	SConfig& StartUp = SConfig::GetInstance();
+	StartUp.bCPUThread = mode != "single";
+	StartUp.m_strGPUDeterminismMode = mode == "deterministic" ? "fake-completion" : "none";
+	StartUp.bGPUConvertThread = convert_thread;
+	StartUp.bLoopFifoReplay = true;
+	StartUp.m_Framelimit = 0;
+	StartUp.sBackend = BACKEND_NULLSOUND;
+	StartUp.m_strVideoBackend = video_backend;
+	VideoBackend::ActivateBackend(StartUp.m_strVideoBackend);
+	s_software = video_backend == "Software Renderer";
+
+	FifoPlayer::GetInstance().SetFrameWrittenCallback(FrameWritten);
+	Core::SetOnStoppedCallback(OnStopped);
+
+	int result = 0;
+	if (g_video_backend->GetName() != video_backend)
+	{
+		fprintf(stderr, "Unknown video backend %s\n", video_backend.c_str());
+		result = 1;
+	}
+	else if (BootManager::BootCore(argv[optind]))
+	{
+		s_stopped.Wait();
+		Core::Stop();
+		Core::Shutdown();
+
+		if (s_frames.empty())
+		{
+			fprintf(stderr, "Could not play %s\n", argv[optind]);
+			result = 1;
+		}
+		PrintResults(csv_filename);
+	}
+	else
+	{
+		fprintf(stderr, "Could not boot %s\n", argv[optind]);
+		result = 1;
+	}
+
+	UICommon::Shutdown();
+
+	if (temporary_user_directory)
+		File::DeleteDirRecursively(user_directory);
+
+	return result;
+}
@@ -0,0 +1,59 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Decodes ten seconds of stereo sound to 5.1 in buffers of the size the mixer uses, once with
+// the DPL2 decoder and once with the one it replaced, which DPL2DecoderTest checks it against.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AudioCommon/DPL2Decoder.h"
+#include "Common/CommonTypes.h"
+
+#include "../UnitTests/Core/DPL2Reference.h"
+#include "MicroBench.h"
+
+namespace
+{
+const int SAMPLES = 48000 * 10;
+const int BUFFER_SIZE = 1024;
+
+void ConsumeOutput(const std::vector<float>& output)
+{
+	u32 bits;
+	memcpy(&bits, &output[3], sizeof(bits));
+	MicroBench::Consume(bits);
+}
+}
+
+namespace MicroBench
+{
+
+void DPL2(u32 runs)
+{
+	std::mt19937 rng;
+	const std::vector<float> input = DPL2Reference::MakeInput(SAMPLES, rng);
+	std::vector<float> output(BUFFER_SIZE * 6);
+
+	const double reference_time = Time(runs, [&] {
+		DPL2Reference::Decoder reference;
+		for (int pos = 0; pos + BUFFER_SIZE <= SAMPLES; pos += BUFFER_SIZE)
+			reference.Decode(&input[pos * 2], BUFFER_SIZE, output.data());
+	});
+	ConsumeOutput(output);
+
+	const double time = Time(runs, [&] {
+		DPL2Reset();
+		for (int pos = 0; pos + BUFFER_SIZE <= SAMPLES; pos += BUFFER_SIZE)
+			DPL2Decode(const_cast<float*>(&input[pos * 2]), BUFFER_SIZE, output.data());
+	});
+	ConsumeOutput(output);
+
+	printf("reference: %10.0f samples/s\n", SAMPLES / reference_time);
+	printf("decoder:   %10.0f samples/s (%.2fx)\n", SAMPLES / time, reference_time / time);
+}
+
+}
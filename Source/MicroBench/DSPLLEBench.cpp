@@ -0,0 +1,104 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Runs a small mixing loop on the DSP LLE cores in time slices, the way DSPLLE runs a ucode:
+// a BLOOP over the samples of each voice, a conditional jump to the next voice and a jump back
+// to the start of the frame. Without DSP ROMs, the ucode is assembled into IRAM.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
+#include "Common/MsgHandler.h"
+#include "Core/ConfigManager.h"
+#include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCodeUtil.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPTables.h"
+
+#include "MicroBench.h"
+
+namespace
+{
+const char UCODE[] =
+	"	clr $ACC0\n"
+	"	clr $ACC1\n"
+	"frame:\n"
+	"	lri $AR0, #0x0100\n"
+	"	lri $AC1.L, #0x0004\n"
+	"voice:\n"
+	"	bloopi #0x20, sample_end\n"
+	"	inc $ACC0\n"
+	"	addis $AC0.M, #1\n"
+	"sample_end:\n"
+	"	srri @$AR0, $AC0.L\n"
+	"	dec $ACC1\n"
+	"	jnz voice\n"
+	"	jmp frame\n";
+
+// DSPLLE runs the DSP for about this many cycles at a time
+const int SLICE = 1000;
+const int CYCLES_PER_RUN = 50000000;
+
+// There are no real DSP ROMs here, and the ucode doesn't use them
+bool IgnoreRomHashes(const char* caption, const char* text, bool yes_no, int style)
+{
+	return false;
+}
+
+// Returns the DSP cycles run per second
+double Run(const std::vector<u16>& code, DSPInitOptions::CoreType core_type, u32 runs)
+{
+	DSPInitOptions opts;
+	opts.irom_contents.fill(0);
+	opts.coef_contents.fill(0);
+	opts.core_type = core_type;
+	DSPCore_Init(opts);
+
+	UnWriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+	std::copy(code.begin(), code.end(), g_dsp.iram);
+	WriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+	DSPAnalyzer::Analyze();
+	g_dsp.pc = 0;
+	g_dsp.cr &= ~CR_HALT;
+
+	const double time = MicroBench::Time(runs, [] {
+		for (int cycles = 0; cycles < CYCLES_PER_RUN; cycles += SLICE)
+			DSPCore_RunCycles(SLICE);
+	});
+	MicroBench::Consume(g_dsp.r.ac[0].val);
+
+	DSPCore_Shutdown();
+	return CYCLES_PER_RUN / time;
+}
+}
+
+namespace MicroBench
+{
+
+void DSPLLE(u32 runs)
+{
+	SConfig::Init();
+	RegisterMsgAlertHandler(IgnoreRomHashes);
+	InitInstructionTable();
+
+	std::vector<u16> code;
+	if (!Assemble(UCODE, code))
+	{
+		printf("The ucode does not assemble\n");
+		return;
+	}
+
+	const double interpreter = Run(code, DSPInitOptions::CORE_INTERPRETER, runs);
+	const double jit = Run(code, DSPInitOptions::CORE_JIT, runs);
+	printf("interpreter: %7.1f M DSP cycles/s\n", interpreter / 1e6);
+	printf("JIT:         %7.1f M DSP cycles/s (%.2fx)\n", jit / 1e6, jit / interpreter);
+
+	RegisterMsgAlertHandler(nullptr);
+	SConfig::Shutdown();
+}
+
+}
@@ -0,0 +1,85 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Throughput of the functions GetHash64 can use for full texture hashes, over buffers
+// from a small texture to a large EFB copy.
+
+#include <cstdio>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Hash.h"
+#include "Common/Intrinsics.h"
+
+#include "MicroBench.h"
+
+namespace
+{
+// Bytes hashed per measurement, whatever the buffer size
+const size_t BYTES_PER_RUN = 256 << 20;
+
+struct HashFunction
+{
+	const char* name;
+	u64 (*hash)(const u8* src, u32 len, u32 samples);
+	bool available;
+};
+}
+
+namespace MicroBench
+{
+
+void Hash(u32 runs)
+{
+	SetHash64Function();
+
+	const HashFunction functions[] = {
+		{ "Murmur3", GetMurmurHash3, true },
+#if _M_SSE >= 0x402 || defined(_M_ARM_64)
+		{ "CRC32", GetCRC32, true },
+#endif
+		{ "wide", GetWideHash64, true },
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+		{ "wide AVX2", GetWideHash64AVX2, cpu_info.bAVX2 },
+#endif
+		{ "GetHash64", GetHash64, true },
+	};
+
+#if !(_M_SSE >= 0x402 || defined(_M_ARM_64))
+	printf("CRC32 is not built in, as this build does not target SSE4.2\n");
+#endif
+	printf("%-10s", "GB/s");
+	for (const HashFunction& function : functions)
+		printf(" %10s", function.name);
+	printf("\n");
+
+	for (u32 size : { 256, 1 << 10, 2 << 10, 4 << 10, 64 << 10, 1 << 20, 16 << 20 })
+	{
+		std::vector<u8> data(size);
+		for (u32 i = 0; i < size; i++)
+			data[i] = (u8)(i * 7 + (i >> 8));
+
+		printf("%-10u", size);
+		for (const HashFunction& function : functions)
+		{
+			if (!function.available)
+			{
+				printf(" %10s", "-");
+				continue;
+			}
+
+			u64 result = 0;
+			const double time = Time(runs, [&] {
+				for (size_t done = 0; done < BYTES_PER_RUN; done += size)
+					result += function.hash(data.data(), size, 0);
+			});
+			printf(" %10.2f", BYTES_PER_RUN / time / 1e9);
+			Consume(result);
+		}
+		printf("\n");
+	}
+}
+
+}
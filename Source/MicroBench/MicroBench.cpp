@@ -0,0 +1,106 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Times single components of the emulator on synthetic input, without booting anything.
+// Every benchmark compares the current implementation with the one it replaced or with
+// the other code paths available, so that the numbers can be reproduced on any machine.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iterator>
+
+#include "Common/CommonTypes.h"
+
+#include "MicroBench.h"
+
+struct Benchmark
+{
+	const char* name;
+	const char* description;
+	void (*run)(u32 runs);
+};
+
+static const Benchmark BENCHMARKS[] = {
+	{ "texcache", "Texture cache index lookups, against the multimaps it replaced", MicroBench::TextureCacheIndex },
+	{ "hash", "Full texture hash throughput over buffer sizes, for every hash function", MicroBench::Hash },
+	{ "swtexcache", "Software renderer texture binding over a batch of primitives, with and without lookups for each", MicroBench::SWTextureBinding },
+	{ "dpl2", "Dolby Pro Logic II decoding throughput, against the decoder it replaced", MicroBench::DPL2 },
+	{ "dsplle", "DSP LLE interpreter and JIT speed on a mixing loop, in time slices", MicroBench::DSPLLE },
+};
+
+static std::atomic<u64> s_sink;
+
+namespace MicroBench
+{
+
+void Consume(u64 value)
+{
+	s_sink.fetch_xor(value, std::memory_order_relaxed);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	int ch, help = 0;
+	u32 runs = 5;
+	struct option longopts[] = {
+		{ "runs",    required_argument, nullptr, 'n' },
+		{ "help",    no_argument,       nullptr, 'h' },
+		{ nullptr,   0,                 nullptr,  0  }
+	};
+
+	while ((ch = getopt_long(argc, argv, "n:h?", longopts, 0)) != -1)
+	{
+		switch (ch)
+		{
+		case 'n':
+			runs = std::max(atoi(optarg), 1);
+			break;
+		case 'h':
+		case '?':
+			help = 1;
+			break;
+		}
+	}
+
+	if (help == 1)
+	{
+		fprintf(stderr, "Times single components of the emulator on synthetic input\n\n");
+		fprintf(stderr, "Usage: %s [-n <runs>] [<benchmark>...]\n", argv[0]);
+		fprintf(stderr, "  -n, --runs     Number of times to run every measurement, the best one is kept (default 5)\n");
+		fprintf(stderr, "  -h, --help     Show this help message\n\n");
+		fprintf(stderr, "Benchmarks (all of them by default):\n");
+		for (const Benchmark& benchmark : BENCHMARKS)
+			fprintf(stderr, "  %-14s %s\n", benchmark.name, benchmark.description);
+		return 1;
+	}
+
+	for (int i = optind; i < argc; i++)
+	{
+		if (std::none_of(std::begin(BENCHMARKS), std::end(BENCHMARKS),
+		                 [&](const Benchmark& benchmark) { return !strcmp(benchmark.name, argv[i]); }))
+		{
+			fprintf(stderr, "Unknown benchmark %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (const Benchmark& benchmark : BENCHMARKS)
+	{
+		if (optind < argc && std::none_of(argv + optind, argv + argc,
+		                                   [&](const char* name) { return !strcmp(benchmark.name, name); }))
+			continue;
+
+		printf("%s: %s\n", benchmark.name, benchmark.description);
+		benchmark.run(runs);
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+#include "Common/CommonTypes.h"
+
+namespace MicroBench
+{
+
+// Runs func the given number of times, and returns the shortest time one run took, in seconds.
+// The shortest run is the one which was disturbed the least by the rest of the system.
+template <typename Func>
+double Time(u32 runs, Func func)
+{
+	double best = 0.0;
+	for (u32 run = 0; run < runs; run++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		func();
+		const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || time < best)
+			best = time;
+	}
+	return best;
+}
+
+// Keeps the compiler from optimizing away a computation whose result is otherwise unused
+void Consume(u64 value);
+
+// The benchmarks, see MicroBench.cpp for what they measure
+void TextureCacheIndex(u32 runs);
+void Hash(u32 runs);
+void SWTextureBinding(u32 runs);
+void DPL2(u32 runs);
+void DSPLLE(u32 runs);
+
+}
@@ -0,0 +1,79 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Binds the textures of a draw batch of many primitives on the software renderer, once looking
+// them up again for every primitive as it used to, and once only for the first primitive, as
+// happens while there are no BP writes in between.
+
+#include <cstdio>
+#include <cstring>
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/SWTextureCache.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+
+#include "MicroBench.h"
+
+namespace
+{
+const u32 PRIMITIVES_PER_BATCH = 1000;
+
+// An RGBA8 texture in TMEM, with its odd half in the upper bank
+void SetUpTexture(u32 size)
+{
+	for (u32 i = 0; i < TMEM_SIZE; i++)
+		texMem[i] = (u8)(i * 7 + (i >> 8));
+
+	memset(&bpmem, 0, sizeof(bpmem));
+	bpmem.tevorders[0].enable0 = 1;
+	bpmem.tevorders[0].texmap0 = 0;
+
+	FourTexUnits& texUnit = bpmem.tex[0];
+	texUnit.texImage0[0].width = size - 1;
+	texUnit.texImage0[0].height = size - 1;
+	texUnit.texImage0[0].format = GX_TF_RGBA8;
+	texUnit.texImage1[0].image_type = 1;
+	texUnit.texImage1[0].tmem_even = 0;
+	texUnit.texImage2[0].tmem_odd = (TMEM_SIZE / 2) / TMEM_LINE_SIZE;
+}
+}
+
+namespace MicroBench
+{
+
+void SWTextureBinding(u32 runs)
+{
+	printf("%-10s %14s %14s\n", "us/prim", "every prim", "once a batch");
+
+	for (u32 size : { 64, 256, 512 })
+	{
+		SWTextureCache::Init();
+		SetUpTexture(size);
+
+		// The texture is decoded once, every lookup after that only hashes it
+		SWTextureCache::BindTextures();
+
+		const double every = Time(runs, [] {
+			for (u32 i = 0; i < PRIMITIVES_PER_BATCH; i++)
+			{
+				SWTextureCache::InvalidateBindings();
+				SWTextureCache::BindTextures();
+			}
+		});
+		const double once = Time(runs, [] {
+			SWTextureCache::InvalidateBindings();
+			for (u32 i = 0; i < PRIMITIVES_PER_BATCH; i++)
+				SWTextureCache::BindTextures();
+		});
+		Consume((u64)(uintptr_t)SWTextureCache::GetLevel(0, 0));
+
+		char name[16];
+		snprintf(name, sizeof(name), "%ux%u", size, size);
+		printf("%-10s %14.3f %14.3f\n", name, every / PRIMITIVES_PER_BATCH * 1e6, once / PRIMITIVES_PER_BATCH * 1e6);
+		SWTextureCache::Shutdown();
+	}
+}
+
+}
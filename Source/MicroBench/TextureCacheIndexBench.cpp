@@ -0,0 +1,267 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Replays the lookups TextureCache::Load does over a few hundred frames, once on the
+// Common::HashIndex tables the texture cache uses and once on the std::multimap and
+// std::unordered_multimap ones it used before. Only the bookkeeping is timed, there
+// are no textures to hash, decode or upload.
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/HashIndex.h"
+
+#include "MicroBench.h"
+
+namespace
+{
+const u32 NUM_FRAMES = 300;
+const u32 LOOKUPS_PER_FRAME = 3000;
+const u32 NUM_CONFIGS = 8;
+
+struct Entry
+{
+	u32 addr;
+	u64 hash;
+	u64 config;
+	u32 frame;
+
+	Common::HashIndexLink<u64, Entry> address_link;
+	Common::HashIndexLink<u64, Entry> hash_link;
+	Common::HashIndexLink<u64, Entry> pool_link;
+
+	std::multimap<u64, Entry*>::iterator address_iter;
+	std::multimap<u64, Entry*>::iterator hash_iter;
+};
+
+struct Lookup
+{
+	u32 addr;
+	u64 hash;
+	u64 config;
+};
+
+class HashIndexCache
+{
+public:
+	// Looks for the texture at its address. Otherwise returns the least recently used entry
+	// there in oldest, unless it was used in this frame already.
+	Entry* FindByAddress(const Lookup& lookup, u32 frame, Entry** oldest)
+	{
+		for (Entry* entry = m_by_address.Find(lookup.addr); entry; entry = AddressIndex::Next(entry))
+		{
+			if (entry->hash == lookup.hash && entry->config == lookup.config)
+				return entry;
+			if (entry->frame != frame && (!*oldest || entry->frame < (*oldest)->frame))
+				*oldest = entry;
+		}
+		return nullptr;
+	}
+
+	Entry* FindByHash(const Lookup& lookup)
+	{
+		for (Entry* entry = m_by_hash.Find(lookup.hash); entry; entry = HashIndex::Next(entry))
+		{
+			if (entry->config == lookup.config)
+				return entry;
+		}
+		return nullptr;
+	}
+
+	Entry* Allocate(u64 config)
+	{
+		Entry* entry = m_pool.Find(config);
+		if (entry)
+			m_pool.Erase(entry);
+		return entry;
+	}
+
+	void Add(Entry* entry)
+	{
+		m_by_address.Insert(entry->addr, entry);
+		m_by_hash.Insert(entry->hash, entry);
+	}
+
+	void Free(Entry* entry)
+	{
+		m_by_hash.Erase(entry);
+		m_by_address.Erase(entry);
+		m_pool.Insert(entry->config, entry);
+	}
+
+private:
+	typedef Common::HashIndex<u64, Entry, &Entry::address_link> AddressIndex;
+	typedef Common::HashIndex<u64, Entry, &Entry::hash_link> HashIndex;
+	typedef Common::HashIndex<u64, Entry, &Entry::pool_link> PoolIndex;
+
+	AddressIndex m_by_address;
+	HashIndex m_by_hash;
+	PoolIndex m_pool;
+};
+
+// The tables of the texture cache before it used Common::HashIndex
+class MultimapCache
+{
+public:
+	Entry* FindByAddress(const Lookup& lookup, u32 frame, Entry** oldest)
+	{
+		auto range = m_by_address.equal_range(lookup.addr);
+		for (auto iter = range.first; iter != range.second; ++iter)
+		{
+			Entry* entry = iter->second;
+			if (entry->hash == lookup.hash && entry->config == lookup.config)
+				return entry;
+			if (entry->frame != frame && (!*oldest || entry->frame < (*oldest)->frame))
+				*oldest = entry;
+		}
+		return nullptr;
+	}
+
+	Entry* FindByHash(const Lookup& lookup)
+	{
+		auto range = m_by_hash.equal_range(lookup.hash);
+		for (auto iter = range.first; iter != range.second; ++iter)
+		{
+			if (iter->second->config == lookup.config)
+				return iter->second;
+		}
+		return nullptr;
+	}
+
+	Entry* Allocate(u64 config)
+	{
+		auto iter = m_pool.find(config);
+		if (iter == m_pool.end())
+			return nullptr;
+		Entry* entry = iter->second;
+		m_pool.erase(iter);
+		return entry;
+	}
+
+	void Add(Entry* entry)
+	{
+		entry->address_iter = m_by_address.emplace(entry->addr, entry);
+		entry->hash_iter = m_by_hash.emplace(entry->hash, entry);
+	}
+
+	void Free(Entry* entry)
+	{
+		m_by_hash.erase(entry->hash_iter);
+		m_by_address.erase(entry->address_iter);
+		m_pool.emplace(entry->config, entry);
+	}
+
+private:
+	std::multimap<u64, Entry*> m_by_address;
+	std::multimap<u64, Entry*> m_by_hash;
+	std::unordered_multimap<u64, Entry*> m_pool;
+};
+
+// Most lookups hit a small set of textures which are used every frame. Some textures
+// change their contents now and then, and some addresses hold two textures at once,
+// like fonts using different palettes.
+std::vector<Lookup> MakeTrace(u32 num_textures)
+{
+	std::mt19937 rng;
+	std::vector<u32> addresses(num_textures);
+	std::vector<u32> versions(num_textures);
+	std::vector<u64> configs(num_textures);
+	for (u32 i = 0; i < num_textures; i++)
+	{
+		addresses[i] = (rng() % 0x1800000) & ~31;
+		configs[i] = rng() % NUM_CONFIGS;
+	}
+
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::vector<Lookup> trace;
+	trace.reserve(NUM_FRAMES * LOOKUPS_PER_FRAME);
+	for (u32 frame = 0; frame < NUM_FRAMES; frame++)
+	{
+		for (u32 i = 0; i < LOOKUPS_PER_FRAME; i++)
+		{
+			const double u = uniform(rng);
+			const u32 texture = (u32)(u * u * num_textures);
+			if (rng() % 200 == 0)
+				versions[texture]++;
+
+			Lookup lookup;
+			lookup.addr = addresses[texture];
+			const u32 variant = texture % 10 == 0 ? rng() % 2 : 0;
+			lookup.hash = ((u64)addresses[texture] << 32) ^ ((u64)variant << 20) ^ versions[texture];
+			lookup.config = configs[texture];
+			trace.push_back(lookup);
+		}
+	}
+	return trace;
+}
+
+// Returns the number of lookups which found a texture, so that both caches can be checked
+// to have done the same work
+template <typename Cache>
+u32 Replay(const std::vector<Lookup>& trace)
+{
+	Cache cache;
+	std::vector<std::unique_ptr<Entry>> entries;
+	u32 hits = 0;
+	for (size_t i = 0; i < trace.size(); i++)
+	{
+		const Lookup& lookup = trace[i];
+		const u32 frame = (u32)(i / LOOKUPS_PER_FRAME);
+
+		Entry* oldest = nullptr;
+		Entry* entry = cache.FindByAddress(lookup, frame, &oldest);
+		if (!entry)
+			entry = cache.FindByHash(lookup);
+		if (entry)
+		{
+			entry->frame = frame;
+			hits++;
+			continue;
+		}
+
+		if (oldest)
+			cache.Free(oldest);
+		entry = cache.Allocate(lookup.config);
+		if (!entry)
+		{
+			entries.emplace_back(new Entry());
+			entry = entries.back().get();
+		}
+		entry->addr = lookup.addr;
+		entry->hash = lookup.hash;
+		entry->config = lookup.config;
+		entry->frame = frame;
+		cache.Add(entry);
+	}
+	return hits;
+}
+}
+
+namespace MicroBench
+{
+
+void TextureCacheIndex(u32 runs)
+{
+	printf("%-10s %18s %18s %8s\n", "textures", "HashIndex", "multimap", "speedup");
+	for (u32 num_textures : { 100, 1000, 10000 })
+	{
+		const std::vector<Lookup> trace = MakeTrace(num_textures);
+		u32 hash_index_hits = 0, multimap_hits = 0;
+		const double hash_index_time = Time(runs, [&] { hash_index_hits = Replay<HashIndexCache>(trace); });
+		const double multimap_time = Time(runs, [&] { multimap_hits = Replay<MultimapCache>(trace); });
+		if (hash_index_hits != multimap_hits)
+			printf("The caches found %u and %u textures, they should be the same\n", hash_index_hits, multimap_hits);
+
+		printf("%-10u %11.2f M/sec %11.2f M/sec %7.2fx\n", num_textures,
+			trace.size() / hash_index_time / 1e6, trace.size() / multimap_time / 1e6, multimap_time / hash_index_time);
+		Consume(hash_index_hits);
+	}
+}
+
+}
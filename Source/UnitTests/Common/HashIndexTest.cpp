@@ -0,0 +1,115 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/HashIndex.h"
+
+namespace
+{
+struct Item
+{
+	int value;
+	Common::HashIndexLink<u64, Item> link;
+};
+
+typedef Common::HashIndex<u64, Item, &Item::link> Index;
+
+std::vector<int> ValuesForKey(const Index& index, u64 key)
+{
+	std::vector<int> values;
+	for (Item* item = index.Find(key); item; item = Index::Next(item))
+		values.push_back(item->value);
+	return values;
+}
+}
+
+TEST(HashIndex, InsertionOrder)
+{
+	Index index;
+	std::vector<Item> items(4);
+	for (int i = 0; i < 4; ++i)
+	{
+		items[i].value = i;
+		index.Insert(i % 2 ? 0x80000020 : 0x80000000, &items[i]);
+	}
+
+	EXPECT_EQ(4u, index.Size());
+	EXPECT_EQ(std::vector<int>({0, 2}), ValuesForKey(index, 0x80000000));
+	EXPECT_EQ(std::vector<int>({1, 3}), ValuesForKey(index, 0x80000020));
+	EXPECT_EQ(nullptr, index.Find(0x80000040));
+
+	index.Erase(&items[0]);
+	EXPECT_FALSE(items[0].link.IsLinked());
+	EXPECT_EQ(std::vector<int>({2}), ValuesForKey(index, 0x80000000));
+
+	index.Erase(&items[2]);
+	EXPECT_EQ(nullptr, index.Find(0x80000000));
+
+	// A key that has been removed before can be inserted again
+	index.Insert(0x80000000, &items[0]);
+	EXPECT_EQ(std::vector<int>({0}), ValuesForKey(index, 0x80000000));
+	EXPECT_EQ(3u, index.Size());
+}
+
+TEST(HashIndex, Growth)
+{
+	const int count = 10000;
+	Index index;
+	std::vector<Item> items(count);
+	for (int i = 0; i < count; ++i)
+	{
+		items[i].value = i;
+		index.Insert((u64)i * 32, &items[i]);
+	}
+	EXPECT_EQ((size_t)count, index.Size());
+
+	for (int i = 0; i < count; ++i)
+	{
+		Item* item = index.Find((u64)i * 32);
+		ASSERT_NE(nullptr, item);
+		EXPECT_EQ(i, item->value);
+		EXPECT_EQ(nullptr, Index::Next(item));
+	}
+
+	// Churn through the table to make sure tombstones get recycled
+	for (int round = 0; round < 10; ++round)
+	{
+		for (int i = 0; i < count; i += 2)
+			index.Erase(&items[i]);
+		for (int i = 0; i < count; i += 2)
+			index.Insert((u64)i * 32, &items[i]);
+	}
+	for (int i = 0; i < count; ++i)
+		EXPECT_EQ(i, index.Find((u64)i * 32)->value);
+}
+
+TEST(HashIndex, ForEachErase)
+{
+	Index index;
+	std::vector<Item> items(100);
+	for (int i = 0; i < 100; ++i)
+	{
+		items[i].value = i;
+		index.Insert(i % 7, &items[i]);
+	}
+
+	int visited = 0;
+	index.ForEach([&](Item* item) {
+		++visited;
+		if (item->value % 3 == 0)
+			index.Erase(item);
+	});
+	EXPECT_EQ(100, visited);
+	EXPECT_EQ(66u, index.Size());
+
+	index.ForEach([&](Item* item) {
+		EXPECT_NE(0, item->value % 3);
+	});
+
+	index.Clear();
+	EXPECT_TRUE(index.Empty());
+	EXPECT_EQ(nullptr, index.Find(1));
+}
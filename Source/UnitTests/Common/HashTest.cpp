@@ -0,0 +1,63 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CPUDetect.h"
+#include "Common/Hash.h"
+
+static std::vector<u8> MakeTestData(size_t size)
+{
+	std::vector<u8> data(size);
+	u32 seed = 0x12345678;
+	for (u8& byte : data)
+	{
+		seed = seed * 1103515245 + 12345;
+		byte = (u8)(seed >> 16);
+	}
+	return data;
+}
+
+TEST(Hash, HiresTextureHashIsStable)
+{
+	// Custom texture and texture dump file names are built from this hash,
+	// so it must never change, no matter which GetHash64 implementation is used.
+	std::vector<u8> data = MakeTestData(4096 + 5);
+	EXPECT_EQ(0x831f5a2e71821a82ULL, GetHashHiresTexture(data.data(), 4096, 0));
+	EXPECT_EQ(0x48dde4c45cd86d2bULL, GetHashHiresTexture(data.data(), 4096 + 5, 0));
+	EXPECT_EQ(0xed916ff3bbee96e0ULL, GetHashHiresTexture(data.data(), 4096, 128));
+}
+
+TEST(Hash, WideHashDetectsChanges)
+{
+	std::vector<u8> data = MakeTestData(1000);
+	const u64 reference = GetWideHash64(data.data(), (u32)data.size(), 0);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] ^= 1;
+		EXPECT_NE(reference, GetWideHash64(data.data(), (u32)data.size(), 0)) << "byte " << i;
+		data[i] ^= 1;
+	}
+	EXPECT_NE(reference, GetWideHash64(data.data(), (u32)data.size() - 1, 0));
+}
+
+#if defined(_M_X86_64) && !defined(_M_GENERIC)
+TEST(Hash, WideHashAVX2MatchesGeneric)
+{
+	if (!cpu_info.bAVX2)
+		return;
+
+	std::vector<u8> data = MakeTestData(64 * 1024 + 3);
+	for (u32 samples : {0u, 1u, 7u, 128u})
+	{
+		for (u32 len = 0; len < 2100; ++len)
+			ASSERT_EQ(GetWideHash64(data.data(), len, samples), GetWideHash64AVX2(data.data(), len, samples));
+		ASSERT_EQ(GetWideHash64(data.data(), (u32)data.size(), samples),
+			GetWideHash64AVX2(data.data(), (u32)data.size(), samples));
+		// Unaligned input
+		ASSERT_EQ(GetWideHash64(data.data() + 3, 4096, samples), GetWideHash64AVX2(data.data() + 3, 4096, samples));
+	}
+}
+#endif
@@ -854,6 +854,25 @@ TWO_OP_SSE_TEST(PMINSW, "dqword")
 TWO_OP_SSE_TEST(PMINUB, "dqword")
 TWO_OP_SSE_TEST(PSHUFB, "dqword")
 
+#define SSE_SHIFT_IMM_TEST(Name) \
+	TEST_F(x64EmitterTest, Name) \
+	{ \
+		for (const auto& r : xmmnames) \
+		{ \
+			emitter->Name(r.reg, 7); \
+			ExpectDisassembly(#Name " " + r.name + ", 0x07"); \
+		} \
+	}
+
+SSE_SHIFT_IMM_TEST(PSRLW)
+SSE_SHIFT_IMM_TEST(PSRLD)
+SSE_SHIFT_IMM_TEST(PSRLQ)
+SSE_SHIFT_IMM_TEST(PSLLW)
+SSE_SHIFT_IMM_TEST(PSLLD)
+SSE_SHIFT_IMM_TEST(PSLLQ)
+SSE_SHIFT_IMM_TEST(PSRAW)
+SSE_SHIFT_IMM_TEST(PSRAD)
+
 // TODO: PEXT/INS/SHUF/MOVMSK
 
 TWO_OP_SSE_TEST(PMOVSXBW, "qword")
@@ -0,0 +1,195 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/DSPHLE.h"
+#include "Core/HW/DSPHLE/UCodes/AX.h"
+
+namespace
+{
+const u32 RAM_SIZE = 0x100000;
+const u32 MIX_BUFFER_SIZE = 32 * 5;
+
+// Gives access to the PB processing and the mix buffers
+class TestAXUCode : public AXUCode
+{
+public:
+	TestAXUCode(DSPHLE* dsphle, u32 num_threads) : AXUCode(dsphle, 0)
+	{
+		StopVoiceWorkers();
+		StartVoiceWorkers(num_threads);
+	}
+
+	using AXUCode::ProcessPBList;
+
+	// Fills the mix buffers with something other than zeroes, as voices are mixed into them
+	void FillMixBuffers()
+	{
+		for (int* buffer : GetMixBuffers())
+		{
+			for (u32 i = 0; i < MIX_BUFFER_SIZE; i++)
+				buffer[i] = i * 7;
+		}
+	}
+
+	std::vector<int> GetMixedSamples()
+	{
+		std::vector<int> samples;
+		for (int* buffer : GetMixBuffers())
+			samples.insert(samples.end(), buffer, buffer + MIX_BUFFER_SIZE);
+		return samples;
+	}
+
+private:
+	std::vector<int*> GetMixBuffers()
+	{
+		return {
+			m_samples_left, m_samples_right, m_samples_surround,
+			m_samples_auxA_left, m_samples_auxA_right, m_samples_auxA_surround,
+			m_samples_auxB_left, m_samples_auxB_right, m_samples_auxB_surround,
+		};
+	}
+};
+
+class AXUCodeTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		m_ram.resize(RAM_SIZE);
+		Memory::m_pRAM = m_ram.data();
+		SConfig::Init();
+		SConfig::GetInstance().bWii = false;
+		DSP::Init(true);
+		m_dsphle = static_cast<DSPHLE*>(DSP::GetDSPEmulator());
+		m_dsphle->Initialize(false, false);
+	}
+
+	void TearDown() override
+	{
+		DSP::Shutdown();
+		SConfig::Shutdown();
+		Memory::m_pRAM = nullptr;
+	}
+
+	void Write16(u32 address, u16 value)
+	{
+		*(u16*)&m_ram[address] = Common::swap16(value);
+	}
+
+	void Write32(u32 address, u32 value)
+	{
+		Write16(address, value >> 16);
+		Write16(address + 2, value & 0xFFFF);
+	}
+
+	// Writes a list of num_voices random PBs, with random updates, playing from random places
+	// in ARAM, and returns the address of the first one
+	u32 WritePBList(u32 num_voices)
+	{
+		for (u8& byte : m_ram)
+			byte = m_rng();
+		for (u32 i = 0; i < 0x10000; i++)
+			DSP::WriteARAM(m_rng(), i);
+
+		// Offsets of the PB fields, in bytes
+		AXPB pb;
+		const auto offset = [&pb](const void* field) {
+			return (u32)((const u8*)field - (const u8*)&pb);
+		};
+		const u32 updates_start = offset(&pb.updates) / 2;
+		const u32 updates_end = updates_start + sizeof(pb.updates) / 2;
+
+		for (u32 voice = 0; voice < num_voices; voice++)
+		{
+			const u32 address = 0x1000 + voice * 0x200;
+			for (u32 i = 0; i < sizeof(AXPB) / 2; i++)
+				Write16(address + i * 2, m_rng());
+
+			Write32(address + offset(&pb.next_pb_hi), voice + 1 < num_voices ? address + 0x200 : 0);
+			Write16(address + offset(&pb.src_type), m_rng() % 3);
+			Write16(address + offset(&pb.coef_select), m_rng() % 4);
+			Write16(address + offset(&pb.running), m_rng() % 8 != 0);
+			Write16(address + offset(&pb.initial_time_delay), 0);
+			Write16(address + offset(&pb.src.ratio_hi), m_rng() % 4);
+
+			// Updates of any field but the ones describing the updates
+			const u32 updates_address = 0x20000 + voice * 0x100;
+			u32 num_updates = 0;
+			for (int ms = 0; ms < 5; ms++)
+			{
+				const u16 count = m_rng() % 3;
+				Write16(address + offset(&pb.updates.num_updates[ms]), count);
+				num_updates += count;
+			}
+			Write32(address + offset(&pb.updates.data_hi), updates_address);
+			for (u32 i = 0; i < num_updates; i++)
+			{
+				u16 field = 9 + m_rng() % (sizeof(AXPB) / 2 - 9);
+				if (field >= updates_start && field < updates_end)
+					field = 8;
+				Write16(updates_address + i * 4, field);
+				Write16(updates_address + i * 4 + 2, m_rng() & 0x7FFF);
+			}
+
+			// ADPCM, PCM8 and PCM16
+			const u16 formats[] = { 0x00, 0x0A, 0x19 };
+			const u32 start = m_rng() % 0x40000;
+			const u32 end = start + m_rng() % 0x1000;
+			Write16(address + offset(&pb.audio_addr.sample_format), formats[m_rng() % 3]);
+			Write16(address + offset(&pb.audio_addr.looping), m_rng() & 1);
+			Write32(address + offset(&pb.audio_addr.loop_addr_hi), start);
+			Write32(address + offset(&pb.audio_addr.end_addr_hi), end);
+			Write32(address + offset(&pb.audio_addr.cur_addr_hi), start + m_rng() % 16);
+		}
+
+		return 0x1000;
+	}
+
+	std::vector<u8> m_ram;
+	DSPHLE* m_dsphle;
+	std::mt19937 m_rng;
+};
+}
+
+// Mixing the voices on several threads gives the same samples and PBs as mixing them one after
+// another
+TEST_F(AXUCodeTest, ParallelVoicesMatchSequential)
+{
+	for (int round = 0; round < 200; round++)
+	{
+		const u32 pb_list = WritePBList(1 + m_rng() % 64);
+		const std::vector<u8> initial_ram = m_ram;
+
+		std::vector<int> expected_samples;
+		std::vector<u8> expected_ram;
+		{
+			TestAXUCode ucode(m_dsphle, 1);
+			ucode.FillMixBuffers();
+			ucode.ProcessPBList(pb_list);
+			expected_samples = ucode.GetMixedSamples();
+			expected_ram = m_ram;
+		}
+
+		// Memory::m_pRAM points into m_ram, which must stay where it is
+		memcpy(m_ram.data(), initial_ram.data(), RAM_SIZE);
+		{
+			TestAXUCode ucode(m_dsphle, 4);
+			ucode.FillMixBuffers();
+			ucode.ProcessPBList(pb_list);
+			ASSERT_EQ(expected_samples, ucode.GetMixedSamples()) << "round " << round;
+			ASSERT_TRUE(expected_ram == m_ram) << "round " << round;
+		}
+	}
+}
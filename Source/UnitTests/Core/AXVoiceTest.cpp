@@ -0,0 +1,380 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/DSPHLE/DSPHLE.h"
+
+#define AX_WII
+#include "Core/HW/DSPHLE/UCodes/AXVoice.h"
+
+namespace
+{
+// An endless stream of input samples, which can be read again from any point
+s16 InputSample(u32 index)
+{
+	u32 hash = index * 2654435761u;
+	hash ^= hash >> 15;
+	// Some runs of extreme values, which saturate the arithmetic
+	if ((hash & 0x3F00) == 0)
+		return (hash & 1) ? 32767 : -32768;
+	return (s16)hash;
+}
+
+// The linear and nearest paths of the original scalar resampler, with the
+// samples read one at a time through a callback
+u32 ResampleReference(std::function<s16(u32)> input_callback, s16* output, u32 count,
+                      s16* last_samples, u32 curr_pos, u32 ratio, int srctype)
+{
+	int read_samples_count = 0;
+
+	if (srctype == SRCTYPE_LINEAR || srctype == SRCTYPE_POLYPHASE)
+	{
+		s16 temp[4];
+		u32 idx = 0;
+
+		temp[idx++ & 3] = last_samples[0];
+		temp[idx++ & 3] = last_samples[1];
+		temp[idx++ & 3] = last_samples[2];
+		temp[idx++ & 3] = last_samples[3];
+
+		for (u32 i = 0; i < count; ++i)
+		{
+			curr_pos += ratio;
+			while (curr_pos >= 0x10000)
+			{
+				temp[idx++ & 3] = input_callback(read_samples_count++);
+				curr_pos -= 0x10000;
+			}
+
+			u16 curr_frac = curr_pos & 0xFFFF;
+			u16 inv_curr_frac = -curr_frac;
+
+			s16 sample;
+			if (curr_frac)
+			{
+				s32 s0 = temp[idx++ & 3];
+				s32 s1 = temp[idx++ & 3];
+
+				sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
+				idx += 2;
+			}
+			else
+			{
+				sample = temp[idx++ & 3];
+				idx += 3;
+			}
+
+			output[i] = sample;
+		}
+
+		last_samples[3] = temp[--idx & 3];
+		last_samples[2] = temp[--idx & 3];
+		last_samples[1] = temp[--idx & 3];
+		last_samples[0] = temp[--idx & 3];
+	}
+	else
+	{
+		for (u32 i = 0; i < count; ++i)
+			output[i] = input_callback(i);
+
+		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
+	}
+
+	return curr_pos;
+}
+
+// The original scalar polyphase filter, which is disabled in ResampleAudio
+u32 ResamplePolyphaseReference(std::function<s16(u32)> input_callback, s16* output, u32 count,
+                               s16* last_samples, u32 curr_pos, u32 ratio, const s16* coeffs)
+{
+	int read_samples_count = 0;
+	s16 temp[4];
+	u32 idx = 0;
+
+	temp[idx++ & 3] = last_samples[0];
+	temp[idx++ & 3] = last_samples[1];
+	temp[idx++ & 3] = last_samples[2];
+	temp[idx++ & 3] = last_samples[3];
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		curr_pos += ratio;
+		while (curr_pos >= 0x10000)
+		{
+			temp[idx++ & 3] = input_callback(read_samples_count++);
+			curr_pos -= 0x10000;
+		}
+
+		u16 curr_pos_frac = ((curr_pos & 0xFFFF) >> 9) << 2;
+		const s16* c = &coeffs[curr_pos_frac];
+
+		s64 t0 = temp[idx++ & 3];
+		s64 t1 = temp[idx++ & 3];
+		s64 t2 = temp[idx++ & 3];
+		s64 t3 = temp[idx++ & 3];
+
+		s64 samp = (t0 * c[0] + t1 * c[1] + t2 * c[2] + t3 * c[3]) >> 15;
+
+		output[i] = (s16)samp;
+	}
+
+	last_samples[3] = temp[--idx & 3];
+	last_samples[2] = temp[--idx & 3];
+	last_samples[1] = temp[--idx & 3];
+	last_samples[0] = temp[--idx & 3];
+
+	return curr_pos;
+}
+
+// The original scalar mixing loop
+void MixAddReference(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	u16 volume_delta = pvol[1];
+
+	if (!ramp)
+		volume_delta = 0;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		s64 sample = input[i];
+		sample *= volume;
+		sample >>= 15;
+		sample = MathUtil::Clamp((s32)sample, -32767, 32767);
+
+		out[i] += (s16)sample;
+		volume += volume_delta;
+
+		*dpop = (s16)sample;
+	}
+}
+
+class AXVoiceTest : public testing::Test
+{
+protected:
+	// Mostly the ratios games use, with some which need more input samples
+	// than fit in the resampling buffer
+	u32 RandomRatio()
+	{
+		switch (m_rng() % 8)
+		{
+		case 0:
+			return 0x10000;
+		case 1:
+			return 0x55555;
+		case 2:
+			return m_rng() % 0x8000000;
+		case 3:
+			return m_rng() % 0x100;
+		default:
+			return m_rng() % 0x40000;
+		}
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// Reading the input in blocks and resampling it with the SIMD kernels gives
+// exactly the output of the original resampler
+TEST_F(AXVoiceTest, ResampleMatchesReference)
+{
+	static const u32 counts[] = { 6, 18, 32, 96 };
+
+	for (int round = 0; round < 20000; round++)
+	{
+		u32 count = counts[m_rng() % 4];
+		u32 ratio = RandomRatio();
+		// Now and then a ratio so large that the position wraps around
+		if (round % 100 == 0)
+		{
+			count = 6;
+			ratio = 0xFFFFFFFF - m_rng() % 0x20000;
+		}
+		const int srctype = m_rng() % 3;
+		const u32 curr_pos = m_rng() & 0xFFFF;
+		const u32 start = m_rng();
+
+		s16 expected_last[4], actual_last[4];
+		for (int i = 0; i < 4; i++)
+			expected_last[i] = actual_last[i] = InputSample(m_rng());
+
+		s16 expected[MAX_SAMPLES_PER_FRAME], actual[MAX_SAMPLES_PER_FRAME];
+		u32 expected_read = 0;
+		u32 expected_pos = ResampleReference(
+			[&](u32 i) { expected_read = i + 1; return InputSample(start + i); },
+			expected, count, expected_last, curr_pos, ratio, srctype);
+
+		u32 actual_read = 0;
+		u32 actual_pos = ResampleAudio(
+			[&](s16* input, u32 input_count) {
+				for (u32 i = 0; i < input_count; i++)
+					input[i] = InputSample(start + actual_read++);
+			},
+			actual, count, actual_last, curr_pos, ratio, srctype, nullptr);
+
+		ASSERT_EQ(expected_pos, actual_pos) << "round " << round << " ratio " << ratio;
+		ASSERT_EQ(expected_read, actual_read) << "round " << round << " ratio " << ratio;
+		ASSERT_EQ(0, memcmp(expected, actual, count * sizeof (s16))) << "round " << round << " ratio " << ratio;
+		ASSERT_EQ(0, memcmp(expected_last, actual_last, sizeof (expected_last))) << "round " << round << " ratio " << ratio;
+	}
+}
+
+// The SIMD polyphase kernel gives exactly the output of the original filter
+TEST_F(AXVoiceTest, ResamplePolyphaseMatchesReference)
+{
+	std::vector<s16> coeffs(0x200);
+
+	for (int round = 0; round < 20000; round++)
+	{
+		for (s16& coeff : coeffs)
+			coeff = (m_rng() & 1) ? InputSample(m_rng()) : (s16)(m_rng() % 0x1000);
+
+		const u32 count = 1 + m_rng() % MAX_SAMPLES_PER_FRAME;
+		const u32 ratio = m_rng() % 0x40000;
+		const u32 start = m_rng();
+		u32 curr_pos = m_rng() & 0xFFFF;
+
+		s16 last[4];
+		s16 input[4 + MAX_INPUT_SAMPLES];
+		for (int i = 0; i < 4; i++)
+			last[i] = input[i] = InputSample(m_rng());
+
+		s16 expected[MAX_SAMPLES_PER_FRAME], actual[MAX_SAMPLES_PER_FRAME];
+		ResamplePolyphaseReference([&](u32 i) { return InputSample(start + i); },
+		                           expected, count, last, curr_pos, ratio, coeffs.data());
+
+		u32 positions[MAX_SAMPLES_PER_FRAME];
+		u16 fracs[MAX_SAMPLES_PER_FRAME];
+		u32 read = 0;
+		for (u32 i = 0; i < count; i++)
+		{
+			curr_pos += ratio;
+			read += curr_pos >> 16;
+			curr_pos &= 0xFFFF;
+			positions[i] = read;
+			fracs[i] = curr_pos;
+		}
+		for (u32 i = 0; i < read; i++)
+			input[4 + i] = InputSample(start + i);
+		ResamplePolyphase(input, positions, fracs, actual, count, coeffs.data());
+
+		ASSERT_EQ(0, memcmp(expected, actual, count * sizeof (s16))) << "round " << round << " ratio " << ratio;
+		ASSERT_EQ(0, memcmp(last, input + read, sizeof (last))) << "round " << round << " ratio " << ratio;
+	}
+}
+
+// Mixing with the SIMD loop gives the same buffers, volumes and last samples
+TEST_F(AXVoiceTest, MixAddMatchesReference)
+{
+	for (int round = 0; round < 20000; round++)
+	{
+		const u32 count = m_rng() % (MAX_SAMPLES_PER_FRAME + 1);
+		const bool ramp = (m_rng() & 1) != 0;
+
+		s16 samples[MAX_SAMPLES_PER_FRAME];
+		const u32 start = m_rng();
+		for (u32 i = 0; i < count; i++)
+			samples[i] = InputSample(start + i);
+
+		int expected[MAX_SAMPLES_PER_FRAME], actual[MAX_SAMPLES_PER_FRAME];
+		for (u32 i = 0; i < MAX_SAMPLES_PER_FRAME; i++)
+			expected[i] = actual[i] = (int)m_rng() >> 8;
+
+		u16 expected_vol[2], actual_vol[2];
+		expected_vol[0] = actual_vol[0] = m_rng();
+		expected_vol[1] = actual_vol[1] = (m_rng() & 1) ? m_rng() : m_rng() % 0x100;
+		s16 expected_dpop, actual_dpop;
+		expected_dpop = actual_dpop = m_rng();
+
+		MixAddReference(expected, samples, count, expected_vol, &expected_dpop, ramp);
+		MixAdd(actual, samples, count, actual_vol, &actual_dpop, ramp);
+
+		ASSERT_EQ(0, memcmp(expected, actual, sizeof (expected))) << "round " << round << " count " << count;
+		ASSERT_EQ(expected_vol[0], actual_vol[0]) << "round " << round;
+		ASSERT_EQ(expected_vol[1], actual_vol[1]) << "round " << round;
+		ASSERT_EQ(expected_dpop, actual_dpop) << "round " << round;
+	}
+}
+
+// A voice whose PB lives in RAM is read, mixed from the PCM16 samples in ARAM
+// and written back, like the ucode does every frame
+TEST_F(AXVoiceTest, ProcessVoiceMixesPCM16)
+{
+	// Wii ARAM addresses with bit 28 set are in EXRAM
+	const u32 ARAM_START = 0x10000000;
+	const u32 PB_ADDRESS = 0x1000;
+	const u32 COUNT = MAX_SAMPLES_PER_FRAME;
+
+	std::vector<u8> ram(0x10000), exram(0x10000);
+	Memory::m_pRAM = ram.data();
+	Memory::m_pEXRAM = exram.data();
+	SConfig::Init();
+	SConfig::GetInstance().bWii = true;
+	DSP::Init(true);
+	DSP::GetDSPEmulator()->Initialize(true, false);
+
+	for (u32 i = 0; i < 0x1000; i++)
+	{
+		const s16 sample = InputSample(i);
+		exram[i * 2] = (u16)sample >> 8;
+		exram[i * 2 + 1] = sample & 0xFF;
+	}
+
+	AXPBWii pb;
+	memset(&pb, 0, sizeof (pb));
+	pb.running = 1;
+	pb.src_type = SRCTYPE_NEAREST;
+	pb.vol_env.cur_volume = 0x4000;
+	pb.mixer.left = 0x8000;
+	pb.audio_addr.sample_format = 0x0A;
+	const u32 start = ARAM_START / 2 + 0x10;
+	const u32 end = start + 0x800;
+	pb.audio_addr.cur_addr_hi = start >> 16;
+	pb.audio_addr.cur_addr_lo = start & 0xFFFF;
+	pb.audio_addr.end_addr_hi = end >> 16;
+	pb.audio_addr.end_addr_lo = end & 0xFFFF;
+	ASSERT_TRUE(WritePB(PB_ADDRESS, pb));
+	// PBs are stored big endian
+	ASSERT_EQ(Common::swap16(pb.audio_addr.end_addr_lo), *(u16*)&ram[PB_ADDRESS + offsetof(AXPBWii, audio_addr.end_addr_lo)]);
+
+	AXPBWii read_pb;
+	ASSERT_TRUE(ReadPB(PB_ADDRESS, read_pb));
+	ASSERT_EQ(0, memcmp(&pb, &read_pb, sizeof (pb)));
+
+	int samples[20][COUNT] = {};
+	AXBuffers buffers;
+	for (u32 i = 0; i < 20; i++)
+		buffers.ptrs[i] = samples[i];
+	ProcessVoice(read_pb, buffers, COUNT, MIX_L, nullptr);
+	ASSERT_TRUE(WritePB(PB_ADDRESS, read_pb));
+
+	// Half the volume from the envelope, full volume on the left channel only
+	for (u32 i = 0; i < COUNT; i++)
+		EXPECT_EQ(InputSample(0x10 + i) >> 1, samples[0][i]) << "sample " << i;
+	for (u32 i = 1; i < 20; i++)
+	{
+		for (u32 j = 0; j < COUNT; j++)
+			EXPECT_EQ(0, samples[i][j]) << "buffer " << i;
+	}
+
+	ASSERT_TRUE(ReadPB(PB_ADDRESS, read_pb));
+	EXPECT_EQ(start + COUNT, (u32)HILO_TO_32(read_pb.audio_addr.cur_addr));
+	EXPECT_EQ(1, read_pb.running);
+
+	DSP::Shutdown();
+	SConfig::Shutdown();
+	Memory::m_pRAM = nullptr;
+	Memory::m_pEXRAM = nullptr;
+}
@@ -0,0 +1,219 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// What DPL2DecoderTest checks the decoder against, also timed by dolphin-micro-bench.
+
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace DPL2Reference
+{
+const double PI = 3.14159265358979323846;
+const float SQRT1_2 = 0.70710678118654752440f;
+
+// The original decoder, which ran the LFE filter over a circular buffer for
+// every sample
+class Decoder
+{
+public:
+	Decoder()
+		: m_cyc_pos(DLBUFLEN - 1)
+		, m_l_fwr(0), m_r_fwr(0), m_lpr_fwr(0), m_lmr_fwr(0)
+		, m_adapt_l_gain(0), m_adapt_r_gain(0), m_adapt_lpr_gain(0), m_adapt_lmr_gain(0)
+		, m_fwrbuf_l(DLBUFLEN), m_fwrbuf_r(DLBUFLEN)
+		, m_lf(DLBUFLEN), m_rf(DLBUFLEN), m_lr(DLBUFLEN), m_rr(DLBUFLEN), m_cf(DLBUFLEN)
+		, m_lfe_buf(LEN125), m_lfe_pos(0)
+	{
+		DesignLowpass();
+	}
+
+	void Decode(const float* in, int numsamples, float* out)
+	{
+		for (int cur = 0; cur < numsamples * 6; cur += 6, in += 2)
+		{
+			const int k = m_cyc_pos;
+
+			const int fwr_pos = (k + DLBUFLEN) % DLBUFLEN;
+			m_l_fwr += fabs(in[0]) - fabs(m_fwrbuf_l[fwr_pos]);
+			m_r_fwr += fabs(in[1]) - fabs(m_fwrbuf_r[fwr_pos]);
+			m_lpr_fwr += fabs(in[0] + in[1]) - fabs(m_fwrbuf_l[fwr_pos] + m_fwrbuf_r[fwr_pos]);
+			m_lmr_fwr += fabs(in[0] - in[1]) - fabs(m_fwrbuf_l[fwr_pos] - m_fwrbuf_r[fwr_pos]);
+
+			m_fwrbuf_l[k] = in[0];
+			m_fwrbuf_r[k] = in[1];
+			MatrixDecode(in, k);
+
+			out[cur + 0] = m_lf[k];
+			out[cur + 1] = m_rf[k];
+			out[cur + 2] = m_cf[k];
+			m_lfe_buf[m_lfe_pos] = (m_lf[k] + m_rf[k] + 2.0f * m_cf[k] + m_lr[k] + m_rr[k]) / 2.0f;
+			out[cur + 3] = FIRFilter(m_lfe_pos);
+			m_lfe_pos = (m_lfe_pos + 1) % LEN125;
+			out[cur + 4] = m_lr[k];
+			out[cur + 5] = m_rr[k];
+
+			if (--m_cyc_pos < 0)
+				m_cyc_pos += DLBUFLEN;
+		}
+	}
+
+private:
+	enum
+	{
+		DLBUFLEN = 240,
+		LEN125 = 256,
+	};
+
+	static float DotProduct(int count, const float* buf, const float* coefficients)
+	{
+		int i;
+		float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+		for (i = 0; (i + 3) < count; i += 4)
+		{
+			sum0 += buf[i + 0] * coefficients[i + 0];
+			sum1 += buf[i + 1] * coefficients[i + 1];
+			sum2 += buf[i + 2] * coefficients[i + 2];
+			sum3 += buf[i + 3] * coefficients[i + 3];
+		}
+		for (; i < count; i++)
+			sum0 += buf[i] * coefficients[i];
+		return sum0 + sum1 + sum2 + sum3;
+	}
+
+	float FIRFilter(int pos) const
+	{
+		const int count1 = LEN125 - pos;
+		const float r1 = DotProduct(count1, &m_lfe_buf[pos], &m_coefs[0]);
+		const float r2 = DotProduct(pos, &m_lfe_buf[0], &m_coefs[count1]);
+		return r1 + r2;
+	}
+
+	// A 125 Hz low pass at 48 kHz, with a Hamming window
+	void DesignLowpass()
+	{
+		const float fc = (125.0f / (48000 / 2)) / 2;
+		const float k1 = 2 * float(PI) * fc;
+		const float hamming = float(2 * PI / (float)(LEN125 - 1));
+		const int end = LEN125 / 2;
+
+		m_coefs.resize(LEN125);
+		for (int i = 0; i < LEN125; i++)
+			m_coefs[i] = float(0.54 - 0.46 * cos(hamming * (float)i));
+
+		float g = 0.0f;
+		for (int i = 0; i < end; i++)
+		{
+			const float t1 = (float)(i + 1) - 0.5f;
+			m_coefs[end - i - 1] = m_coefs[LEN125 - end + i] = float(m_coefs[end - i - 1] * sin(k1 * t1) / (PI * t1));
+			g += 2 * m_coefs[end - i - 1];
+		}
+
+		g = 1 / g;
+		for (float& coef : m_coefs)
+			coef *= g;
+		for (float& coef : m_coefs)
+			coef *= 0.7071067812f;
+	}
+
+	static float PassiveLock(float x)
+	{
+		const float x1 = x - 1;
+		const float ax1s = fabs(x - 1) * (1.0f / 0.2f);
+		return x1 - x1 / (1 + ax1s * ax1s) + 1;
+	}
+
+	void MatrixDecode(const float* in, int k)
+	{
+		const float M9_03DB = 0.3535533906f;
+		const float MATAGCTRIG = 8.0f;
+		const float MATAGCDECAY = 1.0f;
+		const float MATCOMPGAIN = 0.37f;
+
+		const int kr = k % DLBUFLEN;
+		float l_gain = (m_l_fwr + m_r_fwr) / (1 + m_l_fwr + m_l_fwr);
+		float r_gain = (m_l_fwr + m_r_fwr) / (1 + m_r_fwr + m_r_fwr);
+		float lmr_lim_fwr = m_lmr_fwr > M9_03DB * m_lpr_fwr ? m_lmr_fwr : M9_03DB * m_lpr_fwr;
+		float lpr_gain = (m_lpr_fwr + lmr_lim_fwr) / (1 + m_lpr_fwr + m_lpr_fwr);
+		float lmr_gain = (m_lpr_fwr + lmr_lim_fwr) / (1 + lmr_lim_fwr + lmr_lim_fwr);
+		float lmr_unlim_gain = (m_lpr_fwr + m_lmr_fwr) / (1 + m_lmr_fwr + m_lmr_fwr);
+
+		float d_gain = (fabs(l_gain - m_adapt_l_gain) + fabs(r_gain - m_adapt_r_gain)) * 0.5f;
+		float f = d_gain * (1.0f / MATAGCTRIG);
+		f = MATAGCDECAY - MATAGCDECAY / (1 + f * f);
+		m_adapt_l_gain = (1 - f) * m_adapt_l_gain + f * l_gain;
+		m_adapt_r_gain = (1 - f) * m_adapt_r_gain + f * r_gain;
+		float l_agc = in[0] * PassiveLock(m_adapt_l_gain);
+		float r_agc = in[1] * PassiveLock(m_adapt_r_gain);
+		m_cf[k] = (l_agc + r_agc) * SQRT1_2;
+		m_lr[kr] = m_rr[kr] = (l_agc - r_agc) * SQRT1_2;
+		m_lr[kr] *= (m_l_fwr + m_l_fwr) / (1 + m_l_fwr + m_r_fwr);
+		m_rr[kr] *= (m_r_fwr + m_r_fwr) / (1 + m_l_fwr + m_r_fwr);
+
+		float lpr = (in[0] + in[1]) * SQRT1_2;
+		float lmr = (in[0] - in[1]) * SQRT1_2;
+		d_gain = fabs(lmr_unlim_gain - m_adapt_lmr_gain);
+		f = d_gain * (1.0f / MATAGCTRIG);
+		f = MATAGCDECAY - MATAGCDECAY / (1 + f * f);
+		m_adapt_lpr_gain = (1 - f) * m_adapt_lpr_gain + f * lpr_gain;
+		m_adapt_lmr_gain = (1 - f) * m_adapt_lmr_gain + f * lmr_gain;
+		float lpr_agc = lpr * PassiveLock(m_adapt_lpr_gain);
+		float lmr_agc = lmr * PassiveLock(m_adapt_lmr_gain);
+		m_lf[k] = (lpr_agc + lmr_agc) * SQRT1_2;
+		m_rf[k] = (lpr_agc - lmr_agc) * SQRT1_2;
+
+		float c_gain = 8 * (m_adapt_lpr_gain - 0.67677f);
+		c_gain = c_gain > 0 ? c_gain : 0;
+		c_gain = MATCOMPGAIN / (1 + c_gain * c_gain);
+		float c_agc_cfk = c_gain * m_cf[k];
+		m_lf[k] -= c_agc_cfk;
+		m_rf[k] -= c_agc_cfk;
+		m_cf[k] += c_agc_cfk + c_agc_cfk;
+	}
+
+	int m_cyc_pos;
+	float m_l_fwr, m_r_fwr, m_lpr_fwr, m_lmr_fwr;
+	float m_adapt_l_gain, m_adapt_r_gain, m_adapt_lpr_gain, m_adapt_lmr_gain;
+	std::vector<float> m_fwrbuf_l, m_fwrbuf_r;
+	std::vector<float> m_lf, m_rf, m_lr, m_rr, m_cf;
+	std::vector<float> m_lfe_buf;
+	int m_lfe_pos;
+	std::vector<float> m_coefs;
+};
+
+// Stereo input in the range the sound streams use, mixing tones which pan
+// around with noise, silence and full scale passages
+inline std::vector<float> MakeInput(int samples, std::mt19937& rng)
+{
+	std::vector<float> input(samples * 2);
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+	for (int i = 0; i < samples; i++)
+	{
+		float left, right;
+		switch ((i / 12000) % 4)
+		{
+		case 0:
+			left = 0.8f * sinf(i * 0.003f) * sinf(i * 0.0001f);
+			right = 0.8f * sinf(i * 0.003f) * cosf(i * 0.0001f);
+			break;
+		case 1:
+			left = noise(rng);
+			right = 0.5f * left + 0.5f * noise(rng);
+			break;
+		case 2:
+			left = right = 0.0f;
+			break;
+		default:
+			left = (i & 64) ? 1.0f : -1.0f;
+			right = -left * 0.9f;
+			break;
+		}
+		input[i * 2] = left;
+		input[i * 2 + 1] = right;
+	}
+	return input;
+}
+}
@@ -0,0 +1,218 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The JIT headers bring in the x64 emitter, which has a TEST of its own
+#define GTEST_DONT_DEFINE_TEST 1
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
+#include "Common/MsgHandler.h"
+#include "Core/ConfigManager.h"
+#include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCodeUtil.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPTables.h"
+
+namespace
+{
+// Enough DRAM for what the programs store
+const size_t DRAM_WORDS = 0x400;
+
+// Time slices the programs are run in. The short ones leave too few cycles for most links, so the
+// blocks go back to the dispatcher instead.
+const int SLICES[] = { 20, 300, 5000 };
+
+struct State
+{
+	DSP_Regs r;
+	u16 cr;
+	u8 reg_stack_ptr[4];
+	std::vector<u16> dram;
+};
+
+// There are no real DSP ROMs here, and the programs don't use them
+bool IgnoreRomHashes(const char* caption, const char* text, bool yes_no, int style)
+{
+	return false;
+}
+
+class DSPJitTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		RegisterMsgAlertHandler(IgnoreRomHashes);
+		InitInstructionTable();
+	}
+
+	void TearDown() override
+	{
+		RegisterMsgAlertHandler(nullptr);
+		SConfig::Shutdown();
+	}
+
+	// Runs the program from IRAM address 0 until it halts
+	static State Run(const std::vector<u16>& code, DSPInitOptions::CoreType core_type, int slice)
+	{
+		DSPInitOptions opts;
+		opts.irom_contents.fill(0);
+		opts.coef_contents.fill(0);
+		opts.core_type = core_type;
+		EXPECT_TRUE(DSPCore_Init(opts));
+
+		UnWriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+		std::copy(code.begin(), code.end(), g_dsp.iram);
+		WriteProtectMemory(g_dsp.iram, DSP_IRAM_BYTE_SIZE, false);
+		DSPAnalyzer::Analyze();
+
+		g_dsp.pc = 0;
+		g_dsp.cr &= ~CR_HALT;
+		for (int i = 0; i < 100000 && !(g_dsp.cr & CR_HALT); i++)
+			DSPCore_RunCycles(slice);
+		EXPECT_TRUE(g_dsp.cr & CR_HALT) << "the program did not halt";
+
+		State state;
+		state.r = g_dsp.r;
+		state.cr = g_dsp.cr;
+		std::copy(std::begin(g_dsp.reg_stack_ptr), std::end(g_dsp.reg_stack_ptr), state.reg_stack_ptr);
+		state.dram.assign(g_dsp.dram, g_dsp.dram + DRAM_WORDS);
+
+		DSPCore_Shutdown();
+		return state;
+	}
+
+	// The JIT leaves the DSP in the same state as the interpreter, however the run is sliced.
+	// HALT pops the call stack in the JIT, and the JIT only works out the flags which conditional
+	// branches need, so the pc, the call stack and $sr are not compared.
+	static void ExpectSameAsInterpreter(const std::string& text)
+	{
+		std::vector<u16> code;
+		ASSERT_TRUE(Assemble(text, code));
+
+		for (int slice : SLICES)
+		{
+			SCOPED_TRACE(testing::Message() << "slice " << slice);
+			const State expected = Run(code, DSPInitOptions::CORE_INTERPRETER, slice);
+			const State actual = Run(code, DSPInitOptions::CORE_JIT, slice);
+
+			EXPECT_EQ(expected.cr, actual.cr);
+			for (int i = 0; i < 4; i++)
+			{
+				EXPECT_EQ(expected.r.ar[i], actual.r.ar[i]) << "$ar" << i;
+				EXPECT_EQ(expected.r.ix[i], actual.r.ix[i]) << "$ix" << i;
+				EXPECT_EQ(expected.r.wr[i], actual.r.wr[i]) << "$wr" << i;
+			}
+			for (int i = DSP_STACK_D; i < 4; i++)
+			{
+				EXPECT_EQ(expected.r.st[i], actual.r.st[i]) << "$st" << i;
+				EXPECT_EQ(expected.reg_stack_ptr[i], actual.reg_stack_ptr[i]) << "stack " << i;
+			}
+			EXPECT_EQ(expected.r.cr, actual.r.cr);
+			EXPECT_EQ(expected.r.prod.l, actual.r.prod.l);
+			EXPECT_EQ(expected.r.prod.m, actual.r.prod.m);
+			EXPECT_EQ(expected.r.prod.h, actual.r.prod.h);
+			EXPECT_EQ(expected.r.prod.m2, actual.r.prod.m2);
+			for (int i = 0; i < 2; i++)
+			{
+				EXPECT_EQ(expected.r.ax[i].val, actual.r.ax[i].val) << "$ax" << i;
+				EXPECT_EQ(expected.r.ac[i].l, actual.r.ac[i].l) << "$ac" << i << ".l";
+				EXPECT_EQ(expected.r.ac[i].m, actual.r.ac[i].m) << "$ac" << i << ".m";
+				EXPECT_EQ(expected.r.ac[i].h, actual.r.ac[i].h) << "$ac" << i << ".h";
+			}
+			EXPECT_EQ(expected.dram, actual.dram);
+		}
+	}
+};
+}
+
+// The body of a BLOOP starts a block of its own after the first iteration, so the later ones
+// go round the loop back edge
+TEST_F(DSPJitTest, BloopBody)
+{
+	ExpectSameAsInterpreter(
+		"	clr $ACC0\n"
+		"	clr $ACC1\n"
+		"	lri $AR0, #0x0010\n"
+		"	lri $AX0.L, #0x00c8\n"
+		"	bloop $AX0.L, loop_end\n"
+		"	inc $ACC0\n"
+		"	addis $AC1.M, #3\n"
+		"	srri @$AR0, $AC0.L\n"
+		"loop_end:\n"
+		"	srri @$AR0, $AC1.M\n"
+		"	bloopi #0x40, single_end\n"
+		"single_end:\n"
+		"	dec $ACC1\n"
+		"	srri @$AR0, $AC1.L\n"
+		"	halt\n");
+}
+
+// LOOP repeats a single instruction, which is both the start and the end of the loop
+TEST_F(DSPJitTest, LoopBody)
+{
+	ExpectSameAsInterpreter(
+		"	clr $ACC0\n"
+		"	clr $ACC1\n"
+		"	lri $AR0, #0x0020\n"
+		"	lri $AX1.L, #0x0123\n"
+		"	loop $AX1.L\n"
+		"	inc $ACC0\n"
+		"	loopi #0x50\n"
+		"	srri @$AR0, $AC0.L\n"
+		"	inc $ACC1\n"
+		"	halt\n");
+}
+
+// JZ is only taken once the counter runs out, and JNZ until then. After that, JNZ falls
+// through and JZ goes forward over code which must not run. The loop starts with a block of
+// its own, so that JNZ can be linked to it.
+TEST_F(DSPJitTest, ConditionalJumps)
+{
+	ExpectSameAsInterpreter(
+		"	clr $ACC0\n"
+		"	clr $ACC1\n"
+		"	lri $AR0, #0x0040\n"
+		"	lri $AC0.L, #0x0064\n"
+		"loop:\n"
+		"	inc $ACC1\n"
+		"	jmp body\n"
+		"body:\n"
+		"	dec $ACC0\n"
+		"	jz done\n"
+		"	srri @$AR0, $AC0.L\n"
+		"	jnz loop\n"
+		"	addis $AC1.M, #0x40\n"
+		"done:\n"
+		"	clr $ACC0\n"
+		"	jnz skip\n"
+		"	jz skip\n"
+		"	addis $AC1.M, #0x40\n"
+		"skip:\n"
+		"	srri @$AR0, $AC1.L\n"
+		"	halt\n");
+}
+
+// Blocks are cut off after MAX_BLOCK_SIZE instructions and go on with the block which follows
+TEST_F(DSPJitTest, CutOffBlock)
+{
+	std::string text =
+		"	clr $ACC0\n"
+		"	clr $ACC1\n"
+		"	lri $AR0, #0x0080\n"
+		"	lri $AC0.L, #0x0010\n"
+		"loop:\n";
+	for (int i = 0; i < 600; i++)
+		text += i % 100 == 99 ? "	srri @$AR0, $AC1.L\n" : "	inc $ACC1\n";
+	text +=
+		"	dec $ACC0\n"
+		"	jnz loop\n"
+		"	halt\n";
+	ExpectSameAsInterpreter(text);
+}
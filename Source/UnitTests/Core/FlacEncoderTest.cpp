@@ -0,0 +1,543 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "AudioCommon/FlacEncoder.h"
+#include "Common/CommonTypes.h"
+
+namespace
+{
+const double PI = 3.14159265358979323846;
+const u32 SAMPLE_RATE = 48000;
+const u32 MAX_FIXED_ORDER = 4;
+
+enum SubframeType
+{
+	SUBFRAME_CONSTANT,
+	SUBFRAME_VERBATIM,
+	SUBFRAME_FIXED,
+	NUM_SUBFRAME_TYPES,
+};
+
+// CRC-8 of the frame headers, polynomial x^8 + x^2 + x + 1
+u8 ReferenceCRC8(const u8* data, size_t size)
+{
+	u8 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			const bool feedback = ((crc >> 7) ^ (data[i] >> bit)) & 1;
+			crc = (u8)(crc << 1) ^ (feedback ? 0x07 : 0);
+		}
+	}
+	return crc;
+}
+
+// CRC-16 of the frames, polynomial x^16 + x^15 + x^2 + 1
+u16 ReferenceCRC16(const u8* data, size_t size)
+{
+	u16 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			const bool feedback = ((crc >> 15) ^ (data[i] >> bit)) & 1;
+			crc = (u16)(crc << 1) ^ (feedback ? 0x8005 : 0);
+		}
+	}
+	return crc;
+}
+
+class BitReader
+{
+public:
+	BitReader(const std::vector<u8>& data, size_t position)
+		: m_data(data), m_bit(position * 8), m_max_quotient(0)
+	{
+	}
+
+	bool AtEnd() const { return m_bit >= m_data.size() * 8; }
+	// Position of the next whole byte
+	size_t GetPosition() const { return m_bit / 8; }
+	u32 GetMaxRiceQuotient() const { return m_max_quotient; }
+
+	// Reads bits (at most 32) most significant first, zeroes past the end
+	u32 Read(u32 bits)
+	{
+		u32 value = 0;
+		for (u32 i = 0; i < bits; i++, m_bit++)
+		{
+			const u8 byte = m_bit / 8 < m_data.size() ? m_data[m_bit / 8] : 0;
+			value = (value << 1) | ((byte >> (7 - m_bit % 8)) & 1);
+		}
+		return value;
+	}
+
+	s32 ReadSigned(u32 bits)
+	{
+		const u32 value = Read(bits);
+		return (s32)(value << (32 - bits)) >> (32 - bits);
+	}
+
+	s32 ReadRice(u32 parameter)
+	{
+		u32 quotient = 0;
+		while (!AtEnd() && !Read(1))
+			quotient++;
+		m_max_quotient = std::max(m_max_quotient, quotient);
+		const u32 folded = (quotient << parameter) | Read(parameter);
+		return (s32)(folded >> 1) ^ -(s32)(folded & 1);
+	}
+
+	void Align() { m_bit = (m_bit + 7) & ~7; }
+
+private:
+	const std::vector<u8>& m_data;
+	size_t m_bit;
+	u32 m_max_quotient;
+};
+
+struct StreamInfo
+{
+	u32 min_block_size;
+	u32 max_block_size;
+	u32 min_frame_size;
+	u32 max_frame_size;
+	u32 sample_rate;
+	u32 channels;
+	u32 bits_per_sample;
+	u64 total_samples;
+};
+
+// Decodes the subset of FLAC the encoder writes, checking the stream as it goes
+class ReferenceDecoder
+{
+public:
+	void Decode(const std::vector<u8>& stream, std::vector<s16>* samples)
+	{
+		ASSERT_GE(stream.size(), (size_t)FlacEncoder::HEADER_SIZE);
+		ASSERT_EQ(0, memcmp(stream.data(), "fLaC", 4));
+
+		BitReader reader(stream, 4);
+		// STREAMINFO, the last metadata block
+		EXPECT_EQ(1u, reader.Read(1));
+		EXPECT_EQ(0u, reader.Read(7));
+		EXPECT_EQ(34u, reader.Read(24));
+		m_info.min_block_size = reader.Read(16);
+		m_info.max_block_size = reader.Read(16);
+		m_info.min_frame_size = reader.Read(24);
+		m_info.max_frame_size = reader.Read(24);
+		m_info.sample_rate = reader.Read(20);
+		m_info.channels = reader.Read(3) + 1;
+		m_info.bits_per_sample = reader.Read(5) + 1;
+		m_info.total_samples = (u64)reader.Read(4) << 32;
+		m_info.total_samples |= reader.Read(32);
+		for (int i = 0; i < 4; i++)
+			EXPECT_EQ(0u, reader.Read(32)) << "MD5 signature";
+		ASSERT_EQ((size_t)FlacEncoder::HEADER_SIZE, reader.GetPosition());
+
+		samples->clear();
+		m_frame_sizes.clear();
+		std::fill(m_subframe_types, m_subframe_types + NUM_SUBFRAME_TYPES, 0);
+		std::fill(m_fixed_orders, m_fixed_orders + MAX_FIXED_ORDER + 1, 0);
+		m_max_rice_quotient = 0;
+		size_t position = FlacEncoder::HEADER_SIZE;
+		for (u32 frame = 0; position < stream.size(); frame++)
+		{
+			size_t end;
+			ASSERT_NO_FATAL_FAILURE(DecodeFrame(stream, position, frame, samples, &end)) << "frame " << frame;
+			m_frame_sizes.push_back((u32)(end - position));
+			position = end;
+		}
+	}
+
+	const StreamInfo& GetStreamInfo() const { return m_info; }
+	const std::vector<u32>& GetFrameSizes() const { return m_frame_sizes; }
+	u32 GetSubframeCount(SubframeType type) const { return m_subframe_types[type]; }
+	u32 GetFixedOrderCount(u32 order) const { return m_fixed_orders[order]; }
+	u32 GetMaxRiceQuotient() const { return m_max_rice_quotient; }
+
+private:
+	void DecodeFrame(const std::vector<u8>& stream, size_t start, u32 frame_number, std::vector<s16>* samples, size_t* end)
+	{
+		BitReader reader(stream, start);
+		ASSERT_EQ(0x3FFEu, reader.Read(14));
+		EXPECT_EQ(0u, reader.Read(1));
+		// Fixed block size
+		EXPECT_EQ(0u, reader.Read(1));
+		const u32 block_size_code = reader.Read(4);
+		// Sample rate of the stream information
+		EXPECT_EQ(0u, reader.Read(4));
+		const u32 assignment = reader.Read(4);
+		// 16 bits per sample
+		EXPECT_EQ(4u, reader.Read(3));
+		EXPECT_EQ(0u, reader.Read(1));
+
+		// The frame number, coded like UTF-8
+		const u32 first = reader.Read(8);
+		u32 number = first;
+		if (first & 0x80)
+		{
+			u32 length = 0;
+			while (first & (0x80 >> length))
+				length++;
+			ASSERT_GE(length, 2u);
+			number = first & (0x7F >> length);
+			for (u32 i = 1; i < length; i++)
+			{
+				const u32 byte = reader.Read(8);
+				EXPECT_EQ(0x80u, byte & 0xC0);
+				number = (number << 6) | (byte & 0x3F);
+			}
+		}
+		EXPECT_EQ(frame_number, number);
+
+		u32 block_size;
+		if (block_size_code == 6)
+			block_size = reader.Read(8) + 1;
+		else if (block_size_code == 7)
+			block_size = reader.Read(16) + 1;
+		else if (block_size_code >= 8)
+			block_size = 256 << (block_size_code - 8);
+		else
+			FAIL() << "block size code " << block_size_code;
+		ASSERT_LE(block_size, (u32)FlacEncoder::BLOCK_SIZE);
+
+		const u8 crc8 = ReferenceCRC8(&stream[start], reader.GetPosition() - start);
+		ASSERT_EQ(crc8, reader.Read(8)) << "header CRC";
+
+		// The side channel has an extra bit
+		std::vector<s32> first_channel, second_channel;
+		switch (assignment)
+		{
+		case 1:
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 16, &first_channel));
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 16, &second_channel));
+			break;
+		case 8:
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 16, &first_channel));
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 17, &second_channel));
+			break;
+		case 9:
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 17, &first_channel));
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 16, &second_channel));
+			break;
+		case 10:
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 16, &first_channel));
+			ASSERT_NO_FATAL_FAILURE(DecodeSubframe(&reader, block_size, 17, &second_channel));
+			break;
+		default:
+			FAIL() << "channel assignment " << assignment;
+		}
+
+		reader.Align();
+		ASSERT_LE(reader.GetPosition() + 2, stream.size());
+		const u16 crc16 = ReferenceCRC16(&stream[start], reader.GetPosition() - start);
+		ASSERT_EQ(crc16, reader.Read(16)) << "frame CRC";
+		*end = reader.GetPosition();
+		m_max_rice_quotient = std::max(m_max_rice_quotient, reader.GetMaxRiceQuotient());
+
+		for (u32 i = 0; i < block_size; i++)
+		{
+			s32 left = first_channel[i], right = second_channel[i];
+			if (assignment == 8)
+			{
+				right = left - second_channel[i];
+			}
+			else if (assignment == 9)
+			{
+				left = first_channel[i] + right;
+			}
+			else if (assignment == 10)
+			{
+				const s32 mid = ((s32)((u32)first_channel[i] << 1)) | (second_channel[i] & 1);
+				left = (mid + second_channel[i]) >> 1;
+				right = (mid - second_channel[i]) >> 1;
+			}
+			ASSERT_GE(left, -32768);
+			ASSERT_LE(left, 32767);
+			ASSERT_GE(right, -32768);
+			ASSERT_LE(right, 32767);
+			samples->push_back((s16)left);
+			samples->push_back((s16)right);
+		}
+	}
+
+	void DecodeSubframe(BitReader* reader, u32 n, u32 bps, std::vector<s32>* x)
+	{
+		EXPECT_EQ(0u, reader->Read(1));
+		const u32 type = reader->Read(6);
+		// No wasted bits
+		ASSERT_EQ(0u, reader->Read(1));
+
+		if (type == 0)
+		{
+			m_subframe_types[SUBFRAME_CONSTANT]++;
+			x->assign(n, reader->ReadSigned(bps));
+			return;
+		}
+
+		if (type == 1)
+		{
+			m_subframe_types[SUBFRAME_VERBATIM]++;
+			for (u32 i = 0; i < n; i++)
+				x->push_back(reader->ReadSigned(bps));
+			return;
+		}
+
+		ASSERT_TRUE(type >= 8 && type <= 8 + MAX_FIXED_ORDER) << "subframe type " << type;
+		const u32 order = type - 8;
+		m_subframe_types[SUBFRAME_FIXED]++;
+		m_fixed_orders[order]++;
+		ASSERT_LE(order, n);
+		for (u32 i = 0; i < order; i++)
+			x->push_back(reader->ReadSigned(bps));
+
+		// Partitioned Rice coding, with 4 or 5-bit parameters
+		const u32 method = reader->Read(2);
+		ASSERT_LE(method, 1u);
+		const u32 parameter_bits = method ? 5 : 4;
+		const u32 escape = (1 << parameter_bits) - 1;
+		const u32 partition_order = reader->Read(4);
+		ASSERT_EQ(n, (n >> partition_order) << partition_order);
+		std::vector<s32> residual;
+		for (u32 partition = 0; partition < (1u << partition_order); partition++)
+		{
+			const u32 count = (n >> partition_order) - (partition ? 0 : order);
+			const u32 parameter = reader->Read(parameter_bits);
+			if (parameter == escape)
+			{
+				const u32 bits = reader->Read(5);
+				for (u32 i = 0; i < count; i++)
+					residual.push_back(bits ? reader->ReadSigned(bits) : 0);
+			}
+			else
+			{
+				for (u32 i = 0; i < count; i++)
+					residual.push_back(reader->ReadRice(parameter));
+			}
+		}
+		ASSERT_FALSE(reader->AtEnd());
+
+		for (u32 i = order; i < n; i++)
+		{
+			const s32 r = residual[i - order];
+			const s32* p = x->data() + i;
+			switch (order)
+			{
+			case 0: x->push_back(r); break;
+			case 1: x->push_back(r + p[-1]); break;
+			case 2: x->push_back(r + 2 * p[-1] - p[-2]); break;
+			case 3: x->push_back(r + 3 * p[-1] - 3 * p[-2] + p[-3]); break;
+			case 4: x->push_back(r + 4 * p[-1] - 6 * p[-2] + 4 * p[-3] - p[-4]); break;
+			}
+		}
+	}
+
+	StreamInfo m_info;
+	std::vector<u32> m_frame_sizes;
+	u32 m_subframe_types[NUM_SUBFRAME_TYPES];
+	u32 m_fixed_orders[MAX_FIXED_ORDER + 1];
+	u32 m_max_rice_quotient;
+};
+
+class FlacEncoderTest : public testing::Test
+{
+protected:
+	// Encodes sample pairs in blocks like the wave file writer, and puts the final
+	// header over the first one
+	std::vector<u8> Encode(const std::vector<s16>& samples)
+	{
+		FlacEncoder encoder(SAMPLE_RATE);
+		std::vector<u8> stream = encoder.GetHeader();
+		const u32 count = (u32)samples.size() / 2;
+		for (u32 i = 0; i < count; i += FlacEncoder::BLOCK_SIZE)
+		{
+			const u32 block_count = std::min<u32>(count - i, FlacEncoder::BLOCK_SIZE);
+			encoder.EncodeFrame(&samples[i * 2], block_count, &stream);
+		}
+		EXPECT_EQ(count, encoder.GetSampleCount());
+
+		const std::vector<u8> header = encoder.GetHeader();
+		EXPECT_EQ((size_t)FlacEncoder::HEADER_SIZE, header.size());
+		std::copy(header.begin(), header.end(), stream.begin());
+		return stream;
+	}
+
+	void RoundTrip(const std::vector<s16>& samples)
+	{
+		const std::vector<u8> stream = Encode(samples);
+		std::vector<s16> decoded;
+		ASSERT_NO_FATAL_FAILURE(m_decoder.Decode(stream, &decoded));
+		EXPECT_EQ(samples.size() / 2, m_decoder.GetStreamInfo().total_samples);
+		ASSERT_EQ(samples.size(), decoded.size());
+		for (size_t i = 0; i < samples.size(); i++)
+			ASSERT_EQ(samples[i], decoded[i]) << "sample " << i / 2 << " channel " << i % 2;
+	}
+
+	// Sine waves with a bit of noise, which the fixed predictors code well
+	std::vector<s16> SmoothSamples(u32 count, double left_amplitude, double right_amplitude)
+	{
+		std::uniform_int_distribution<int> noise(-8, 8);
+		std::vector<s16> samples;
+		for (u32 i = 0; i < count; i++)
+		{
+			samples.push_back((s16)(left_amplitude * sin(2.0 * PI * 440.0 * i / SAMPLE_RATE) + noise(m_rng)));
+			samples.push_back((s16)(right_amplitude * sin(2.0 * PI * 660.0 * i / SAMPLE_RATE) + noise(m_rng)));
+		}
+		return samples;
+	}
+
+	std::vector<s16> NoiseSamples(u32 count)
+	{
+		std::uniform_int_distribution<int> noise(-32768, 32767);
+		std::vector<s16> samples;
+		for (u32 i = 0; i < count * 2; i++)
+			samples.push_back((s16)noise(m_rng));
+		return samples;
+	}
+
+	ReferenceDecoder m_decoder;
+	std::mt19937 m_rng;
+};
+}
+
+// The reference CRCs give the check values of their FLAC polynomials
+TEST_F(FlacEncoderTest, ReferenceCRCs)
+{
+	const u8 check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	EXPECT_EQ(0xF4, ReferenceCRC8(check, sizeof(check)));
+	EXPECT_EQ(0xFEE8, ReferenceCRC16(check, sizeof(check)));
+}
+
+TEST_F(FlacEncoderTest, StreamInfo)
+{
+	const std::vector<u8> empty_header = FlacEncoder(SAMPLE_RATE).GetHeader();
+	ASSERT_EQ((size_t)FlacEncoder::HEADER_SIZE, empty_header.size());
+	std::vector<s16> decoded;
+	ASSERT_NO_FATAL_FAILURE(m_decoder.Decode(empty_header, &decoded));
+	EXPECT_EQ(0u, m_decoder.GetStreamInfo().total_samples);
+	EXPECT_TRUE(decoded.empty());
+
+	const u32 count = FlacEncoder::BLOCK_SIZE * 3 + 1000;
+	ASSERT_NO_FATAL_FAILURE(RoundTrip(SmoothSamples(count, 10000.0, 3000.0)));
+
+	const StreamInfo& info = m_decoder.GetStreamInfo();
+	EXPECT_EQ((u32)FlacEncoder::BLOCK_SIZE, info.min_block_size);
+	EXPECT_EQ((u32)FlacEncoder::BLOCK_SIZE, info.max_block_size);
+	EXPECT_EQ(SAMPLE_RATE, info.sample_rate);
+	EXPECT_EQ(2u, info.channels);
+	EXPECT_EQ(16u, info.bits_per_sample);
+	EXPECT_EQ(count, info.total_samples);
+
+	const std::vector<u32>& frame_sizes = m_decoder.GetFrameSizes();
+	ASSERT_EQ(4u, frame_sizes.size());
+	EXPECT_EQ(*std::min_element(frame_sizes.begin(), frame_sizes.end()), info.min_frame_size);
+	EXPECT_EQ(*std::max_element(frame_sizes.begin(), frame_sizes.end()), info.max_frame_size);
+}
+
+// Silence and other constant channels, over enough frames for two-byte frame numbers
+TEST_F(FlacEncoderTest, ConstantSubframes)
+{
+	std::vector<s16> samples(FlacEncoder::BLOCK_SIZE * 2 * 130, 0);
+	ASSERT_NO_FATAL_FAILURE(RoundTrip(samples));
+	EXPECT_EQ(130u * 2, m_decoder.GetSubframeCount(SUBFRAME_CONSTANT));
+
+	for (size_t i = 0; i < samples.size(); i += 2)
+	{
+		samples[i] = 32767;
+		samples[i + 1] = -32768;
+	}
+	ASSERT_NO_FATAL_FAILURE(RoundTrip(samples));
+}
+
+TEST_F(FlacEncoderTest, VerbatimSubframes)
+{
+	ASSERT_NO_FATAL_FAILURE(RoundTrip(NoiseSamples(FlacEncoder::BLOCK_SIZE * 2)));
+	EXPECT_EQ(4u, m_decoder.GetSubframeCount(SUBFRAME_VERBATIM));
+}
+
+TEST_F(FlacEncoderTest, FixedSubframes)
+{
+	for (int round = 0; round < 20; round++)
+	{
+		std::uniform_real_distribution<double> amplitude(0.0, 32000.0);
+		std::vector<s16> samples = SmoothSamples(FlacEncoder::BLOCK_SIZE * 2, amplitude(m_rng), amplitude(m_rng));
+
+		// Every stereo mode: the same signal in both channels, one channel
+		// silent, or a full scale square wave against the other channel
+		const int mode = round % 4;
+		for (size_t i = 0; i < samples.size(); i += 2)
+		{
+			if (mode == 1)
+				samples[i + 1] = samples[i];
+			else if (mode == 2)
+				samples[i] = 0;
+			else if (mode == 3)
+				samples[i] = (i / 64) % 2 ? 32767 : -32768;
+		}
+
+		ASSERT_NO_FATAL_FAILURE(RoundTrip(samples)) << "round " << round;
+		EXPECT_GT(m_decoder.GetSubframeCount(SUBFRAME_FIXED), 0u) << "round " << round;
+	}
+}
+
+// Polynomials of degree order - 1 are predicted best by the fixed predictor of
+// that order. The lowest orders need a bit of noise not to be constant.
+TEST_F(FlacEncoderTest, FixedOrders)
+{
+	const u32 count = 64;
+	for (u32 order = 0; order <= MAX_FIXED_ORDER; order++)
+	{
+		std::uniform_int_distribution<int> noise(order < 2 ? -1 : 0, order < 2 ? 1 : 0);
+		std::vector<s16> samples;
+		for (u32 i = 0; i < count; i++)
+		{
+			const double t = (i - count / 2.0) / (count / 2.0);
+			const double polynomial = order ? 30000.0 * pow(t, order - 1) : 0.0;
+			samples.push_back((s16)(floor(polynomial) + noise(m_rng)));
+			samples.push_back(0);
+		}
+
+		ASSERT_NO_FATAL_FAILURE(RoundTrip(samples)) << "order " << order;
+		EXPECT_EQ(1u, m_decoder.GetFixedOrderCount(order)) << "order " << order;
+	}
+}
+
+// Rare full scale spikes in silence leave a few residuals far above the Rice
+// parameters. An odd block size can't be partitioned, so the spikes share the
+// parameter of the whole block and their quotients take more than 32 bits.
+TEST_F(FlacEncoderTest, LongRiceQuotients)
+{
+	std::vector<s16> samples(1001 * 2, 0);
+	for (size_t i = 0; i < samples.size(); i += 256)
+		samples[i] = i % 512 ? 32767 : -32768;
+
+	ASSERT_NO_FATAL_FAILURE(RoundTrip(samples));
+	EXPECT_EQ(1u, m_decoder.GetSubframeCount(SUBFRAME_FIXED));
+	EXPECT_GT(m_decoder.GetMaxRiceQuotient(), 64u);
+}
+
+// The last block holds whatever is left, down to a single sample pair
+TEST_F(FlacEncoderTest, ShortLastBlock)
+{
+	const u32 counts[] = { 1, 4, 5, 100, FlacEncoder::BLOCK_SIZE - 1, FlacEncoder::BLOCK_SIZE + 1, FlacEncoder::BLOCK_SIZE * 2 + 777 };
+	for (u32 count : counts)
+	{
+		ASSERT_NO_FATAL_FAILURE(RoundTrip(SmoothSamples(count, 20000.0, 5000.0))) << "count " << count;
+		ASSERT_NO_FATAL_FAILURE(RoundTrip(NoiseSamples(count))) << "count " << count;
+
+		const u32 frames = (count + FlacEncoder::BLOCK_SIZE - 1) / FlacEncoder::BLOCK_SIZE;
+		EXPECT_EQ(frames, m_decoder.GetFrameSizes().size()) << "count " << count;
+		EXPECT_EQ((u32)FlacEncoder::BLOCK_SIZE, m_decoder.GetStreamInfo().max_block_size);
+	}
+}
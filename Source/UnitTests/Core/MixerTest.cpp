@@ -0,0 +1,174 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "AudioCommon/Mixer.h"
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+
+namespace
+{
+const double PI = 3.14159265358979323846;
+
+// The output sample of the filter lies between these two input pairs
+const int SINC_CENTER = SINC_TAPS / 2 - 1;
+
+// Gives access to the DMA fifo alone, without the check for a running CPU in CMixer::Mix
+class TestMixer : public CMixer
+{
+public:
+	TestMixer() : CMixer(32000) {}
+
+	// Takes host order samples
+	void PushDMA(const std::vector<short>& samples)
+	{
+		std::vector<short> swapped(samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+			swapped[i] = Common::swap16(samples[i]);
+		PushSamples(swapped.data(), (u32)samples.size() / 2);
+	}
+
+	// Returns right, left pairs, like CMixer::Mix
+	std::vector<short> MixDMA(u32 num_samples)
+	{
+		std::vector<short> samples(num_samples * 2);
+		m_dma_mixer.Mix(samples.data(), num_samples, false);
+		return samples;
+	}
+};
+
+class MixerTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		SConfig::GetInstance().m_SincResampling = true;
+	}
+
+	void TearDown() override
+	{
+		SConfig::Shutdown();
+	}
+
+	// Interleaved pairs of a tone, with the right channel a quarter period ahead
+	static std::vector<short> MakeTone(u32 pairs, double period, double amplitude)
+	{
+		std::vector<short> samples(pairs * 2);
+		for (u32 i = 0; i < pairs; i++)
+		{
+			samples[i * 2] = (short)lround(amplitude * sin(2 * PI * i / period));
+			samples[i * 2 + 1] = (short)lround(amplitude * cos(2 * PI * i / period));
+		}
+		return samples;
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// The SSE version gives exactly what the one for other architectures gives
+TEST_F(MixerTest, SincMatchesGeneric)
+{
+	// Sets up the coefficients
+	TestMixer mixer;
+	std::uniform_int_distribution<int> sample(-32768, 32767);
+	short src[SINC_TAPS * 2];
+	for (int i = 0; i < 10000; i++)
+	{
+		for (short& s : src)
+			s = (short)sample(m_rng);
+		const u32 frac = m_rng() & 0xffff;
+
+		int left, right, generic_left, generic_right;
+		SincInterpolate(src, frac, &left, &right);
+		SincInterpolateGeneric(src, frac, &generic_left, &generic_right);
+		ASSERT_EQ(generic_left, left) << "at " << frac;
+		ASSERT_EQ(generic_right, right) << "at " << frac;
+	}
+}
+
+// Constant signals are passed unchanged, whatever the resampling ratio
+TEST_F(MixerTest, SincPassesDC)
+{
+	for (u32 rate : { 32000, 48000, 22050 })
+	{
+		TestMixer mixer;
+		mixer.SetDMAInputSampleRate(rate);
+		mixer.PushDMA(std::vector<short>(1000 * 2, 0));
+		for (u32 i = 0; i < 1000; i++)
+			mixer.PushDMA({ 12345, -23456 });
+
+		// Skip the step from the silence, at the slowest the rate control can go
+		mixer.MixDMA(1050 * 32000 / (rate - 200) + 1);
+		const std::vector<short> output = mixer.MixDMA(500);
+		for (size_t i = 0; i < output.size(); i += 2)
+		{
+			ASSERT_EQ(-23456, output[i]) << "rate " << rate << " sample " << i / 2;
+			ASSERT_EQ(12345, output[i + 1]) << "rate " << rate << " sample " << i / 2;
+		}
+	}
+}
+
+// A tone well below the cutoff comes out at every fractional position with its amplitude and
+// phase unchanged
+TEST_F(MixerTest, SincPassesTone)
+{
+	// Sets up the coefficients
+	TestMixer mixer;
+	const double period = 32.0; // 1 kHz at 32 kHz
+	const double amplitude = 16384.0;
+	const std::vector<short> tone = MakeTone(256, period, amplitude);
+
+	for (u32 i = 0; i + SINC_TAPS <= 256; i += 3)
+	{
+		for (u32 frac = 0; frac < 0x10000; frac += 0x100)
+		{
+			int left, right;
+			SincInterpolate(&tone[i * 2], frac, &left, &right);
+
+			const double position = i + SINC_CENTER + frac / 65536.0;
+			EXPECT_NEAR(amplitude * sin(2 * PI * position / period), left, amplitude * 0.001)
+				<< "at " << i << " + " << frac;
+			EXPECT_NEAR(amplitude * cos(2 * PI * position / period), right, amplitude * 0.001)
+				<< "at " << i << " + " << frac;
+		}
+	}
+}
+
+// Once the fifo runs dry, the rest of the output repeats the last pair the filter gave,
+// instead of jumping ahead to the input pair before its read position
+TEST_F(MixerTest, SincPadsUnderrunWithLastOutput)
+{
+	TestMixer mixer;
+	const u32 pairs = 200;
+	const std::vector<short> input = MakeTone(pairs, 50.0, 8000.0);
+	mixer.PushDMA(input);
+
+	// With this few pairs buffered, the rate control lowers the input rate by its maximum of
+	// 200 Hz, so the resampling ratio is exactly 1
+	mixer.SetDMAInputSampleRate(32200);
+	const std::vector<short> output = mixer.MixDMA(pairs * 2);
+
+	// The filter needs SINC_TAPS pairs ahead of its position
+	const u32 filtered = pairs - SINC_TAPS + 1;
+	int left = 0, right = 0;
+	for (u32 i = 0; i < filtered; i++)
+	{
+		SincInterpolate(&input[i * 2], 0, &left, &right);
+		ASSERT_EQ(right, output[i * 2]) << "sample " << i;
+		ASSERT_EQ(left, output[i * 2 + 1]) << "sample " << i;
+	}
+	for (u32 i = filtered; i < pairs * 2; i++)
+	{
+		ASSERT_EQ(right, output[i * 2]) << "sample " << i;
+		ASSERT_EQ(left, output[i * 2 + 1]) << "sample " << i;
+	}
+}
@@ -0,0 +1,218 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/DSPHLE/UCodes/Zelda.h"
+
+namespace
+{
+typedef ZeldaAudioRenderer::MixingBuffer MixingBuffer;
+
+// The original scalar loops of the renderer
+
+template <size_t N, size_t B>
+void ApplyVolumeInPlaceReference(std::array<s16, N>* buf, u16 vol)
+{
+	for (size_t i = 0; i < N; ++i)
+	{
+		s32 tmp = (u32)(*buf)[i] * (u32)vol;
+		tmp >>= 16 - B;
+
+		(*buf)[i] = (s16)MathUtil::Clamp(tmp, -0x8000, 0x7FFF);
+	}
+}
+
+template <size_t N>
+s32 AddBuffersWithVolumeRampReference(std::array<s16, N>* dst, const std::array<s16, N>& src,
+                                      s32 vol, s32 step)
+{
+	if (!vol && !step)
+		return vol;
+
+	for (size_t i = 0; i < N; ++i)
+	{
+		(*dst)[i] += ((vol >> 16) * src[i]) >> 16;
+		vol += step;
+	}
+
+	return vol;
+}
+
+void AddBuffersWithVolumeReference(s16* dst, const s16* src, size_t count, u16 vol)
+{
+	while (count--)
+	{
+		s32 vol_src = ((s32)*src++ * (s32)vol) >> 15;
+		*dst++ += MathUtil::Clamp(vol_src, -0x8000, 0x7FFF);
+	}
+}
+
+void ApplyReverbFilterReference(std::array<s16, 0x58>* buffer, const s16* coeffs)
+{
+	for (u16 i = 0; i < 0x50; ++i)
+	{
+		s32 sample = 0;
+		for (u16 j = 0; j < 8; ++j)
+			sample += (s32)(*buffer)[i + j] * coeffs[j];
+		sample >>= 15;
+		(*buffer)[i] = MathUtil::Clamp(sample, -0x8000, 0x7FFF);
+	}
+}
+
+class ZeldaAudioRendererTest : public testing::Test
+{
+protected:
+	// Mostly ordinary samples, with some runs of extreme values which
+	// saturate the arithmetic
+	s16 RandomSample()
+	{
+		switch (m_rng() % 8)
+		{
+		case 0:
+			return -0x8000;
+		case 1:
+			return 0x7FFF;
+		default:
+			return (s16)m_rng();
+		}
+	}
+
+	template <size_t N>
+	void FillBuffer(std::array<s16, N>* buffer)
+	{
+		for (s16& sample : *buffer)
+			sample = RandomSample();
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// Applying a volume with the SIMD loop gives the same samples, in both formats
+TEST_F(ZeldaAudioRendererTest, ApplyVolumeMatchesReference)
+{
+	for (int round = 0; round < 20000; round++)
+	{
+		MixingBuffer expected;
+		FillBuffer(&expected);
+		MixingBuffer actual = expected;
+		const u16 vol = (m_rng() & 1) ? (u16)m_rng() : 0x6784;
+
+		if (round & 1)
+		{
+			ApplyVolumeInPlaceReference<0x50, 1>(&expected, vol);
+			ZeldaAudioRenderer::ApplyVolumeInPlace_1_15(&actual, vol);
+		}
+		else
+		{
+			ApplyVolumeInPlaceReference<0x50, 4>(&expected, vol);
+			ZeldaAudioRenderer::ApplyVolumeInPlace_4_12(&actual, vol);
+		}
+
+		ASSERT_EQ(expected, actual) << "round " << round << " volume " << vol;
+	}
+}
+
+// Mixing a voice with a volume ramp gives the same buffer and final volume
+TEST_F(ZeldaAudioRendererTest, AddBuffersWithVolumeRampMatchesReference)
+{
+	for (int round = 0; round < 20000; round++)
+	{
+		MixingBuffer src, expected;
+		FillBuffer(&src);
+		FillBuffer(&expected);
+		MixingBuffer actual = expected;
+
+		// Ramps computed the way AddVoice does, and some which are not
+		const s16 current = (s16)m_rng();
+		const s16 target = (m_rng() & 1) ? (s16)m_rng() : current / 2;
+		s32 vol = current << 16;
+		s32 step = ((target - current) << 16) / (s32)src.size();
+		if (round % 10 == 0)
+			step = (s32)m_rng() % 0x100000;
+		if (round % 100 == 0)
+			vol = step = 0;
+
+		const s32 expected_vol = AddBuffersWithVolumeRampReference(&expected, src, vol, step);
+		const s32 actual_vol = ZeldaAudioRenderer::AddBuffersWithVolumeRamp(&actual, src, vol, step);
+
+		ASSERT_EQ(expected, actual) << "round " << round;
+		ASSERT_EQ(expected_vol, actual_vol) << "round " << round;
+	}
+}
+
+// Mixing partial buffers with a constant volume gives the same samples
+TEST_F(ZeldaAudioRendererTest, AddBuffersWithVolumeMatchesReference)
+{
+	static const u16 volumes[] = { 0x7FFF, 0xB820 };
+
+	for (int round = 0; round < 20000; round++)
+	{
+		MixingBuffer src, expected;
+		FillBuffer(&src);
+		FillBuffer(&expected);
+		MixingBuffer actual = expected;
+
+		const size_t offset = m_rng() % 0x50;
+		const size_t count = m_rng() % (0x50 - offset + 1);
+		const u16 vol = (m_rng() & 1) ? volumes[m_rng() % 2] : (u16)m_rng();
+
+		AddBuffersWithVolumeReference(expected.data() + offset, src.data(), count, vol);
+		ZeldaAudioRenderer::AddBuffersWithVolume(actual.data() + offset, src.data(), count, vol);
+
+		ASSERT_EQ(expected, actual) << "round " << round << " count " << count << " volume " << vol;
+	}
+}
+
+// Replaying random reverb parameter blocks over several frames, the way
+// ApplyReverb does, gives the same reverb and destination buffers
+TEST_F(ZeldaAudioRendererTest, ReverbMatchesReference)
+{
+	for (int round = 0; round < 2000; round++)
+	{
+		const u16 enabled = 1 + m_rng() % 3;
+		s16 coeffs[8];
+		for (s16& coeff : coeffs)
+			coeff = (m_rng() % 4) ? (s16)(m_rng() % 0x2000 - 0x1000) : RandomSample();
+		const u16 dest_volume = (u16)m_rng();
+
+		std::array<s16, 8> expected_last8{}, actual_last8{};
+		MixingBuffer expected_dest{}, actual_dest{};
+		for (int frame = 0; frame < 8; frame++)
+		{
+			MixingBuffer mram;
+			FillBuffer(&mram);
+
+			std::array<s16, 0x58> expected, actual;
+			std::copy(expected_last8.begin(), expected_last8.end(), expected.begin());
+			std::copy(actual_last8.begin(), actual_last8.end(), actual.begin());
+			std::copy(mram.begin(), mram.end(), expected.begin() + 8);
+			std::copy(mram.begin(), mram.end(), actual.begin() + 8);
+			std::copy(expected.begin() + 0x50, expected.end(), expected_last8.begin());
+			std::copy(actual.begin() + 0x50, actual.end(), actual_last8.begin());
+
+			if (enabled & 1)
+				ApplyReverbFilterReference(&expected, coeffs);
+			AddBuffersWithVolumeReference(expected_dest.data(), expected.data(), 0x50, dest_volume);
+			if (enabled & 2)
+				ApplyReverbFilterReference(&expected, coeffs);
+
+			if (enabled & 1)
+				ZeldaAudioRenderer::ApplyReverbFilter(&actual, coeffs);
+			ZeldaAudioRenderer::AddBuffersWithVolume(actual_dest.data(), actual.data(), 0x50, dest_volume);
+			if (enabled & 2)
+				ZeldaAudioRenderer::ApplyReverbFilter(&actual, coeffs);
+
+			ASSERT_EQ(expected, actual) << "round " << round << " frame " << frame;
+			ASSERT_EQ(expected_dest, actual_dest) << "round " << round << " frame " << frame;
+		}
+	}
+}
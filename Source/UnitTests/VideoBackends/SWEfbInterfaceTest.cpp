@@ -0,0 +1,177 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/VideoCommon.h"
+
+namespace
+{
+class SWEfbInterfaceTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+		bpmem.blendmode.colorupdate = 1;
+		bpmem.blendmode.alphaupdate = 1;
+		bpmem.zmode.updateenable = 1;
+	}
+
+	// Mostly values close to each other, so the compares go both ways
+	u32 RandomDepth()
+	{
+		return (m_rng() & 1) ? 0x800000 + m_rng() % 4 : m_rng() & 0xffffff;
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// The quad depth test gives the same results as testing every pixel on its own
+TEST_F(SWEfbInterfaceTest, ZCompareQuadMatchesZCompare)
+{
+	for (int round = 0; round < 20000; round++)
+	{
+		const u16 x = (m_rng() % EFB_WIDTH) & ~1;
+		const u16 y = (m_rng() % EFB_HEIGHT) & ~1;
+
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+		bpmem.zmode.updateenable = 1;
+		u32 depth[4];
+		for (int i = 0; i < 4; i++)
+		{
+			depth[i] = RandomDepth();
+			EfbInterface::SetDepth(x + (i & 1), y + (i >> 1), depth[i]);
+		}
+
+		s32 z[4];
+		for (s32& value : z)
+			value = RandomDepth();
+		const u32 coverage = m_rng() & 15;
+
+		// Y8 has no depth buffer at all
+		bpmem.zcontrol.pixel_format = (m_rng() % 8) ? (PEControl::PixelFormat)(m_rng() % 4) : PEControl::Y8;
+		bpmem.zmode.func = (ZMode::CompareMode)(m_rng() % 8);
+		bpmem.zmode.updateenable = m_rng() & 1;
+
+		u32 expected = 0;
+		u32 expectedDepth[4];
+		for (int i = 0; i < 4; i++)
+		{
+			if ((coverage & (1 << i)) && EfbInterface::ZCompare(x + (i & 1), y + (i >> 1), z[i]))
+				expected |= 1 << i;
+			expectedDepth[i] = EfbInterface::GetDepth(x + (i & 1), y + (i >> 1));
+		}
+
+		const PEControl::PixelFormat pixelFormat = bpmem.zcontrol.pixel_format;
+		const u32 updateEnable = bpmem.zmode.updateenable;
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+		bpmem.zmode.updateenable = 1;
+		for (int i = 0; i < 4; i++)
+			EfbInterface::SetDepth(x + (i & 1), y + (i >> 1), depth[i]);
+		bpmem.zcontrol.pixel_format = pixelFormat;
+		bpmem.zmode.updateenable = updateEnable;
+
+		ASSERT_EQ(expected, EfbInterface::ZCompareQuad(x, y, z, coverage)) << "round " << round;
+		for (int i = 0; i < 4; i++)
+			ASSERT_EQ(expectedDepth[i], EfbInterface::GetDepth(x + (i & 1), y + (i >> 1))) << "round " << round;
+	}
+}
+
+// Packed copies of the buffers hold the same 24 bits as the pixels read one at a time
+TEST_F(SWEfbInterfaceTest, PackRectMatchesPixels)
+{
+	for (u16 y = 0; y < EFB_HEIGHT; y++)
+	{
+		for (u16 x = 0; x < EFB_WIDTH; x++)
+		{
+			u32 color = m_rng();
+			EfbInterface::SetColor(x, y, (u8*)&color);
+			EfbInterface::SetDepth(x, y, m_rng());
+		}
+	}
+
+	for (int round = 0; round < 100; round++)
+	{
+		const bool depth = (m_rng() & 1) != 0;
+		const int left = m_rng() % EFB_WIDTH;
+		const int top = m_rng() % EFB_HEIGHT;
+		const int right = left + 1 + m_rng() % (EFB_WIDTH - left);
+		const int bottom = top + 1 + m_rng() % (EFB_HEIGHT - top);
+
+		const u8* packed = EfbInterface::PackRect(EFBRectangle(left, top, right, bottom), depth);
+		for (int y = top; y < bottom; y++)
+		{
+			for (int x = left; x < right; x++)
+			{
+				const u8* pixel = packed + ((x - left) + (y - top) * EFB_WIDTH) * 3;
+				u32 value = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+
+				u32 expected;
+				if (depth)
+				{
+					expected = EfbInterface::GetDepth(x, y);
+				}
+				else
+				{
+					u8 color[4];
+					EfbInterface::GetColor(x, y, color);
+					expected = color[EfbInterface::BLU_C] | (color[EfbInterface::GRN_C] << 8) | (color[EfbInterface::RED_C] << 16);
+				}
+				ASSERT_EQ(expected, value) << "at " << x << ", " << y;
+			}
+		}
+	}
+}
+
+// Reads past the edges of the packed color buffer see the same pixels as in the linear layout of
+// the real EFB, the next row past the right edge and the depth buffer past the bottom
+TEST_F(SWEfbInterfaceTest, PackRectPastEdges)
+{
+	for (u16 y = 0; y < EFB_HEIGHT; y++)
+	{
+		for (u16 x = 0; x < EFB_WIDTH; x++)
+		{
+			u32 color = m_rng();
+			EfbInterface::SetColor(x, y, (u8*)&color);
+			EfbInterface::SetDepth(x, y, m_rng());
+		}
+	}
+
+	const int left = EFB_WIDTH - 8;
+	const int top = EFB_HEIGHT - 8;
+	const u8* packed = EfbInterface::PackRect(EFBRectangle(left, top, left + 24, top + 24), false);
+	for (int y = top; y < top + 24; y++)
+	{
+		for (int x = left; x < left + 24; x++)
+		{
+			const u8* pixel = packed + ((x - left) + (y - top) * EFB_WIDTH) * 3;
+			u32 value = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+
+			// Where the pixel is in the linear layout
+			const int linear_x = x % EFB_WIDTH;
+			const int linear_y = y + x / EFB_WIDTH;
+			u32 expected;
+			if (linear_y < EFB_HEIGHT)
+			{
+				u8 color[4];
+				EfbInterface::GetColor(linear_x, linear_y, color);
+				expected = color[EfbInterface::BLU_C] | (color[EfbInterface::GRN_C] << 8) | (color[EfbInterface::RED_C] << 16);
+			}
+			else
+			{
+				expected = EfbInterface::GetDepth(linear_x, linear_y - EFB_HEIGHT);
+			}
+			ASSERT_EQ(expected, value) << "at " << x << ", " << y;
+		}
+	}
+}
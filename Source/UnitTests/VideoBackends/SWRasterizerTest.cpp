@@ -0,0 +1,207 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/Tev.h"
+#include "VideoCommon/BPMemory.h"
+
+namespace
+{
+struct Triangle
+{
+	float x[3];
+	float y[3];
+};
+
+int IRound(float x)
+{
+	int t = (int)x;
+	if ((x - t) >= 0.5)
+		return t + 1;
+	return t;
+}
+
+class SWRasterizerTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+		bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+		bpmem.blendmode.colorupdate = 1;
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+
+		// Every triangle is drawn in the constant color K0
+		bpmem.combiners[0].colorC.a = TEVCOLORARG_ZERO;
+		bpmem.combiners[0].colorC.b = TEVCOLORARG_ZERO;
+		bpmem.combiners[0].colorC.c = TEVCOLORARG_ZERO;
+		bpmem.combiners[0].colorC.d = TEVCOLORARG_KONST;
+		bpmem.combiners[0].colorC.clamp = 1;
+		bpmem.tevksel[0].kcsel0 = 12; // K0
+
+		Rasterizer::Init();
+
+		u8 black[4] = {};
+		for (u16 y = 0; y < EFB_HEIGHT; y++)
+		{
+			for (u16 x = 0; x < EFB_WIDTH; x++)
+				EfbInterface::SetColor(x, y, black);
+		}
+		m_owner.assign(EFB_WIDTH * EFB_HEIGHT, 0);
+	}
+
+	void TearDown() override
+	{
+		Rasterizer::Shutdown();
+	}
+
+	void SetScissor(int left, int top, int right, int bottom)
+	{
+		Rasterizer::Flush();
+		bpmem.scissorOffset.hex = 0;
+		bpmem.scissorTL.x = left;
+		bpmem.scissorTL.y = top;
+		bpmem.scissorBR.x = right - 1;
+		bpmem.scissorBR.y = bottom - 1;
+		Rasterizer::SetScissor();
+		m_scissor[0] = left;
+		m_scissor[1] = top;
+		m_scissor[2] = right;
+		m_scissor[3] = bottom;
+	}
+
+	// Draws the triangle with the rasterizer, in a color made from its number
+	void Draw(const Triangle& tri, int id)
+	{
+		Rasterizer::Flush();
+		Rasterizer::SetTevReg(0, Tev::RED_C, true, id & 0xff);
+		Rasterizer::SetTevReg(0, Tev::GRN_C, true, id >> 8);
+		Rasterizer::SetTevReg(0, Tev::BLU_C, true, 0xff);
+		Tev::InvalidateStageConfig(); // done by SWLoadBPReg() for real register writes
+
+		OutputVertexData vertices[3];
+		memset(vertices, 0, sizeof(vertices));
+		for (int i = 0; i < 3; i++)
+		{
+			vertices[i].screenPosition.x = tri.x[i];
+			vertices[i].screenPosition.y = tri.y[i];
+			vertices[i].projectedPosition.w = 1.0f;
+		}
+		Rasterizer::DrawTriangleFrontFace(&vertices[0], &vertices[1], &vertices[2]);
+	}
+
+	// The coverage rules of the original rasterizer, evaluated for every single pixel.
+	// Like the original, this works on 2x2 blocks, so it may touch one more row and column.
+	void DrawReference(const Triangle& tri, int id)
+	{
+		const s32 X1 = IRound(16.0f * tri.x[0]) - 9;
+		const s32 X2 = IRound(16.0f * tri.x[1]) - 9;
+		const s32 X3 = IRound(16.0f * tri.x[2]) - 9;
+		const s32 Y1 = IRound(16.0f * tri.y[0]) - 9;
+		const s32 Y2 = IRound(16.0f * tri.y[1]) - 9;
+		const s32 Y3 = IRound(16.0f * tri.y[2]) - 9;
+
+		const s32 DX12 = X1 - X2, DX23 = X2 - X3, DX31 = X3 - X1;
+		const s32 DY12 = Y1 - Y2, DY23 = Y2 - Y3, DY31 = Y3 - Y1;
+
+		s32 minx = std::max((std::min(std::min(X1, X2), X3) + 0xF) >> 4, m_scissor[0]);
+		s32 maxx = std::min((std::max(std::max(X1, X2), X3) + 0xF) >> 4, m_scissor[2]);
+		s32 miny = std::max((std::min(std::min(Y1, Y2), Y3) + 0xF) >> 4, m_scissor[1]);
+		s32 maxy = std::min((std::max(std::max(Y1, Y2), Y3) + 0xF) >> 4, m_scissor[3]);
+		if (minx >= maxx || miny >= maxy)
+			return;
+
+		s32 C1 = DY12 * X1 - DX12 * Y1;
+		s32 C2 = DY23 * X2 - DX23 * Y2;
+		s32 C3 = DY31 * X3 - DX31 * Y3;
+		if (DY12 < 0 || (DY12 == 0 && DX12 > 0)) C1++;
+		if (DY23 < 0 || (DY23 == 0 && DX23 > 0)) C2++;
+		if (DY31 < 0 || (DY31 == 0 && DX31 > 0)) C3++;
+
+		minx &= ~1;
+		miny &= ~1;
+		maxx = (maxx + 1) & ~1;
+		maxy = (maxy + 1) & ~1;
+
+		for (s32 y = miny; y < maxy; y++)
+		{
+			for (s32 x = minx; x < maxx; x++)
+			{
+				if (C1 + DX12 * (y << 4) - DY12 * (x << 4) > 0 &&
+				    C2 + DX23 * (y << 4) - DY23 * (x << 4) > 0 &&
+				    C3 + DX31 * (y << 4) - DY31 * (x << 4) > 0)
+				{
+					m_owner[y * EFB_WIDTH + x] = id;
+				}
+			}
+		}
+	}
+
+	void Compare()
+	{
+		Rasterizer::Flush();
+		for (int y = 0; y < EFB_HEIGHT; y++)
+		{
+			for (int x = 0; x < EFB_WIDTH; x++)
+			{
+				u8 color[4];
+				EfbInterface::GetColor(x, y, color);
+				int id = color[EfbInterface::RED_C] | (color[EfbInterface::GRN_C] << 8);
+				ASSERT_EQ(m_owner[y * EFB_WIDTH + x], id) << "at " << x << ", " << y;
+			}
+		}
+	}
+
+	float RandomCoord(float range)
+	{
+		return std::uniform_real_distribution<float>(-16.0f, range + 16.0f)(m_rng);
+	}
+
+	std::vector<int> m_owner;
+	s32 m_scissor[4];
+	std::mt19937 m_rng;
+};
+}
+
+TEST_F(SWRasterizerTest, CoverageMatchesEdgeFunctions)
+{
+	for (int round = 0; round < 8; round++)
+	{
+		if (round & 1)
+			SetScissor(m_rng() % 200, m_rng() % 200, 300 + m_rng() % 341, 300 + m_rng() % 229);
+		else
+			SetScissor(0, 0, EFB_WIDTH, EFB_HEIGHT);
+
+		for (int id = 1; id <= 500; id++)
+		{
+			Triangle tri;
+			// Mostly small triangles, with some which cover large parts of the screen
+			float size = (id % 10) ? 40.0f : (float)EFB_WIDTH;
+			float x = RandomCoord(EFB_WIDTH);
+			float y = RandomCoord(EFB_HEIGHT);
+			for (int i = 0; i < 3; i++)
+			{
+				tri.x[i] = x + std::uniform_real_distribution<float>(0.0f, size)(m_rng);
+				tri.y[i] = y + std::uniform_real_distribution<float>(0.0f, size)(m_rng);
+			}
+			Draw(tri, round * 500 + id);
+			DrawReference(tri, round * 500 + id);
+		}
+
+		Compare();
+		if (HasFailure())
+			break;
+	}
+}
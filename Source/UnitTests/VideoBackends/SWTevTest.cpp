@@ -0,0 +1,160 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/Tev.h"
+#ifdef _M_X86_64
+#include "VideoBackends/Software/TevJitX64.h"
+#endif
+#include "VideoCommon/BPMemory.h"
+
+namespace
+{
+class SWTevTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		bpmem.alpha_test.comp0 = AlphaTest::ALWAYS;
+		bpmem.alpha_test.comp1 = AlphaTest::ALWAYS;
+		bpmem.blendmode.colorupdate = 1;
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+
+		m_tev = std::make_unique<Tev>();
+		m_tev->Init();
+	}
+
+	void TearDown() override
+	{
+		g_SWVideoConfig.bJitTev = true;
+	}
+
+	void RandomizeStages(int numStages)
+	{
+		for (int i = 0; i < numStages; i++)
+		{
+			bpmem.combiners[i].colorC.hex = m_rng() & 0xffffff;
+			bpmem.combiners[i].alphaC.hex = m_rng() & 0xffffff;
+		}
+
+		// no texture lookups
+		for (TwoTevStageOrders& order : bpmem.tevorders)
+			order.hex = m_rng() & 0xfbffbf;
+
+		for (TevKSel& ksel : bpmem.tevksel)
+			ksel.hex = m_rng() & 0xffffff;
+
+		for (int reg = 0; reg < 4; reg++)
+		{
+			for (int comp = 0; comp < 4; comp++)
+			{
+				m_tev->SetRegColor(reg, comp, false, (s16)(m_rng() % 2048) - 1024);
+				m_tev->SetRegColor(reg, comp, true, (s16)(m_rng() % 2048) - 1024);
+			}
+		}
+
+		bpmem.genMode.numtevstages = numStages - 1;
+	}
+
+	// Draws a random quad with both paths, the quad to line 0 and one pixel at
+	// a time to line 1, and checks that they produced the same colors.
+	void DrawAndCompare()
+	{
+		Tev::InvalidateStageConfig();
+
+		int numPixels = m_rng() % 4 + 1;
+		for (int i = 0; i < numPixels; i++)
+		{
+			Tev::QuadPixel& pixel = m_tev->Quad[i];
+			pixel.Position[0] = i;
+			pixel.Position[1] = 0;
+			pixel.Position[2] = 0;
+			for (auto& color : pixel.Color)
+			{
+				for (u8& comp : color)
+					comp = m_rng() & 0xff;
+			}
+		}
+
+		for (int i = 0; i < numPixels; i++)
+		{
+			m_tev->Position[0] = i;
+			m_tev->Position[1] = 1;
+			m_tev->Position[2] = 0;
+			memcpy(m_tev->Color, m_tev->Quad[i].Color, sizeof(m_tev->Color));
+			memcpy(m_tev->Uv, m_tev->Quad[i].Uv, sizeof(m_tev->Uv));
+			m_tev->Draw();
+		}
+
+		m_tev->DrawQuad(numPixels);
+
+		for (int i = 0; i < numPixels; i++)
+		{
+			u8 quad[4];
+			u8 scalar[4];
+			EfbInterface::GetColor(i, 0, quad);
+			EfbInterface::GetColor(i, 1, scalar);
+			EXPECT_EQ(scalar[Tev::RED_C], quad[Tev::RED_C]);
+			EXPECT_EQ(scalar[Tev::GRN_C], quad[Tev::GRN_C]);
+			EXPECT_EQ(scalar[Tev::BLU_C], quad[Tev::BLU_C]);
+		}
+	}
+
+	void DrawRandomConfigs()
+	{
+		for (int i = 0; i < 20000; i++)
+		{
+			int numStages = m_rng() % 15 + 1;
+			RandomizeStages(numStages);
+			DrawAndCompare();
+
+			// The EFB doesn't store alpha in this format, so add a stage which
+			// copies the output alpha (as 8 bits) to the color channels.
+			u32 alphaDest = bpmem.combiners[numStages - 1].alphaC.dest;
+			TevStageCombiner& copy = bpmem.combiners[numStages];
+			copy.colorC.hex = 0;
+			copy.colorC.a = copy.colorC.b = copy.colorC.c = 15; // zero
+			copy.colorC.d = alphaDest * 2 + 1; // reg.aaa
+			copy.alphaC.hex = 0;
+			copy.alphaC.a = copy.alphaC.b = copy.alphaC.c = 7; // zero
+			copy.alphaC.d = alphaDest;
+			bpmem.genMode.numtevstages = numStages;
+			DrawAndCompare();
+
+			if (HasFailure())
+				break;
+
+#ifdef _M_X86_64
+			// Each configuration gets its own routine, start over before the code space runs out
+			if (i % 500 == 499)
+				TevJitX64::Shutdown();
+#endif
+		}
+	}
+
+	std::unique_ptr<Tev> m_tev;
+	std::mt19937 m_rng;
+};
+}
+
+TEST_F(SWTevTest, QuadMatchesScalar)
+{
+	g_SWVideoConfig.bJitTev = false;
+	DrawRandomConfigs();
+}
+
+TEST_F(SWTevTest, JitMatchesScalar)
+{
+	g_SWVideoConfig.bJitTev = true;
+	DrawRandomConfigs();
+}
@@ -0,0 +1,178 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/SWTextureCache.h"
+#include "VideoBackends/Software/TextureSampler.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureDecoder.h"
+
+namespace
+{
+class SWTextureCacheTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		bpmem.tevorders[0].enable0 = 1;
+		bpmem.tevorders[0].texmap0 = 0;
+		SWTextureCache::Init();
+	}
+
+	void TearDown() override
+	{
+		SWTextureCache::Shutdown();
+	}
+
+	// Sets up texmap 0 to read a texture from TMEM, filled with random data
+	void RandomizeTexture(int format)
+	{
+		// Only the texture itself, its odd TMEM bank and the palette are of interest
+		for (u32 offset : { 0u, TMEM_SIZE / 4u, TMEM_SIZE / 2u })
+		{
+			for (u32 i = 0; i < 0x10000; i++)
+				texMem[offset + i] = (u8)m_rng();
+		}
+
+		FourTexUnits& texUnit = bpmem.tex[0];
+		texUnit.texImage0[0].hex = 0;
+		texUnit.texImage0[0].width = 63;
+		texUnit.texImage0[0].height = 31;
+		texUnit.texImage0[0].format = format;
+		texUnit.texImage1[0].hex = 0;
+		texUnit.texImage1[0].image_type = 1;
+		texUnit.texImage1[0].tmem_even = 0;
+		texUnit.texImage2[0].hex = 0;
+		texUnit.texImage2[0].tmem_odd = (TMEM_SIZE / 2) / TMEM_LINE_SIZE;
+		texUnit.texTlut[0].hex = 0;
+		texUnit.texTlut[0].tmem_offset = (TMEM_SIZE / 4) >> 9;
+		texUnit.texTlut[0].tlut_format = m_rng() % 3;
+
+		texUnit.texMode0[0].hex = 0;
+		texUnit.texMode0[0].wrap_s = m_rng() % 3;
+		texUnit.texMode0[0].wrap_t = m_rng() % 3;
+		texUnit.texMode0[0].min_filter = m_rng() % 8;
+		texUnit.texMode1[0].hex = 0;
+		texUnit.texMode1[0].max_lod = 6 << 4;
+	}
+
+	void Sample(s32 s, s32 t, s32 lod, bool linear, u8* sample)
+	{
+		TextureSampler::Sample(s, t, lod, linear, 0, sample);
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// Sampling the decoded texture gives exactly what decoding the texels on the fly gives
+TEST_F(SWTextureCacheTest, MatchesDirectDecode)
+{
+	static const int formats[] = {
+		GX_TF_I4, GX_TF_I8, GX_TF_IA4, GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3,
+		GX_TF_RGBA8, GX_TF_C4, GX_TF_C8, GX_TF_C14X2, GX_TF_CMPR,
+	};
+
+	for (int format : formats)
+	{
+		for (int setup = 0; setup < 8; setup++)
+		{
+			RandomizeTexture(format);
+
+			// Without a bound texture, the sampler decodes every texel it needs
+			bpmem.tevorders[0].enable0 = 0;
+			SWTextureCache::InvalidateBindings();
+			SWTextureCache::BindTextures();
+			ASSERT_EQ(nullptr, SWTextureCache::GetLevel(0, 0));
+
+			struct Fetch
+			{
+				s32 s, t, lod;
+				bool linear;
+				u8 texel[4];
+			};
+			Fetch fetches[256];
+			for (Fetch& fetch : fetches)
+			{
+				fetch.s = (s32)(m_rng() % (256 << 7)) - (64 << 7);
+				fetch.t = (s32)(m_rng() % (128 << 7)) - (32 << 7);
+				fetch.lod = m_rng() % (7 << 4);
+				fetch.linear = (m_rng() & 1) != 0;
+				Sample(fetch.s, fetch.t, fetch.lod, fetch.linear, fetch.texel);
+			}
+
+			bpmem.tevorders[0].enable0 = 1;
+			SWTextureCache::InvalidateBindings();
+			SWTextureCache::BindTextures();
+			ASSERT_NE(nullptr, SWTextureCache::GetLevel(0, 0));
+
+			for (const Fetch& fetch : fetches)
+			{
+				u8 texel[4];
+				Sample(fetch.s, fetch.t, fetch.lod, fetch.linear, texel);
+				ASSERT_EQ(0, memcmp(fetch.texel, texel, 4)) << "format " << format << " at "
+					<< fetch.s << ", " << fetch.t << " lod " << fetch.lod;
+			}
+		}
+	}
+}
+
+TEST_F(SWTextureCacheTest, PicksUpChangedData)
+{
+	RandomizeTexture(GX_TF_C8);
+	bpmem.tex[0].texMode0[0].min_filter = 0;
+	SWTextureCache::BindTextures();
+
+	const SWTextureCache::Level* level = SWTextureCache::GetLevel(0, 0);
+	ASSERT_NE(nullptr, level);
+	EXPECT_EQ(64u, level->width);
+	EXPECT_EQ(32u, level->height);
+	EXPECT_EQ(nullptr, SWTextureCache::GetLevel(0, 1));
+	EXPECT_EQ(nullptr, SWTextureCache::GetLevel(1, 0));
+
+	// Palette changes have to be noticed as well as changes to the texture itself
+	const u32 tlutOffset = bpmem.tex[0].texTlut[0].tmem_offset << 9;
+	texMem[tlutOffset + texMem[0] * 2] ^= 0xff;
+	SWTextureCache::InvalidateBindings();
+	SWTextureCache::BindTextures();
+	level = SWTextureCache::GetLevel(0, 0);
+
+	u8 expected[4];
+	TexDecoder_DecodeTexel(expected, texMem, 0, 0, 63, GX_TF_C8, &texMem[tlutOffset],
+		(TlutFormat)bpmem.tex[0].texTlut[0].tlut_format);
+	EXPECT_EQ(0, memcmp(expected, level->texels.data(), 4));
+
+	// Unused texture maps aren't bound
+	bpmem.tevorders[0].enable0 = 0;
+	SWTextureCache::InvalidateBindings();
+	SWTextureCache::BindTextures();
+	EXPECT_EQ(nullptr, SWTextureCache::GetLevel(0, 0));
+}
+
+// Within a draw batch, the textures aren't looked up again until there is a BP write
+TEST_F(SWTextureCacheTest, KeepsBindingsUntilInvalidated)
+{
+	RandomizeTexture(GX_TF_I8);
+	bpmem.tex[0].texMode0[0].min_filter = 0;
+	SWTextureCache::BindTextures();
+	const SWTextureCache::Level* level = SWTextureCache::GetLevel(0, 0);
+	ASSERT_NE(nullptr, level);
+	const u32 texel = level->texels[0];
+
+	texMem[0] ^= 0xff;
+	SWTextureCache::BindTextures();
+	EXPECT_EQ(level, SWTextureCache::GetLevel(0, 0));
+	EXPECT_EQ(texel, SWTextureCache::GetLevel(0, 0)->texels[0]);
+
+	SWTextureCache::InvalidateBindings();
+	SWTextureCache::BindTextures();
+	ASSERT_NE(nullptr, SWTextureCache::GetLevel(0, 0));
+	EXPECT_NE(texel, SWTextureCache::GetLevel(0, 0)->texels[0]);
+}
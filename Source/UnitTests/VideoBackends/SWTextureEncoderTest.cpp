@@ -0,0 +1,106 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/EfbInterface.h"
+#include "VideoBackends/Software/Rasterizer.h"
+#include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TextureEncoder.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/VideoCommon.h"
+
+namespace
+{
+// Enough for the widest copy in the largest format, which is 161 blocks of 64 bytes per row
+const u32 STRIDE_CHANNELS = 322;
+const u32 DEST_SIZE = STRIDE_CHANNELS * 32 * (EFB_HEIGHT / 4 + 1);
+
+class SWTextureEncoderTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		g_SWVideoConfig.numRasterizerThreads = 4;
+		Rasterizer::Init();
+
+		// In this format, all 24 bits of the color and depth buffer are written as they are
+		bpmem.zcontrol.pixel_format = PEControl::RGB8_Z24;
+		bpmem.blendmode.colorupdate = 1;
+		bpmem.blendmode.alphaupdate = 1;
+		bpmem.zmode.updateenable = 1;
+		for (u16 y = 0; y < EFB_HEIGHT; y++)
+		{
+			for (u16 x = 0; x < EFB_WIDTH; x++)
+			{
+				u32 color = m_rng();
+				EfbInterface::SetColor(x, y, (u8*)&color);
+				EfbInterface::SetDepth(x, y, m_rng());
+			}
+		}
+	}
+
+	void TearDown() override
+	{
+		Rasterizer::Shutdown();
+		g_SWVideoConfig.numRasterizerThreads = 0;
+	}
+
+	// Picks a copy rectangle which leaves room for the blocks to extend past it
+	void RandomizeCopy()
+	{
+		static const PEControl::PixelFormat pixelFormats[] = {
+			PEControl::RGBA6_Z24, PEControl::RGB8_Z24, PEControl::RGB565_Z16, PEControl::Z24,
+		};
+		bpmem.zcontrol.pixel_format = pixelFormats[m_rng() % 4];
+		bpmem.triggerEFBCopy.Hex = 0;
+		bpmem.triggerEFBCopy.target_pixel_format = m_rng() % 16;
+		bpmem.triggerEFBCopy.intensity_fmt = m_rng() & 1;
+		bpmem.triggerEFBCopy.half_scale = m_rng() & 1;
+		bpmem.copyMipMapStrideChannels = STRIDE_CHANNELS;
+
+		// Mostly large copies, which are split between the threads
+		u32 width = (m_rng() & 1) ? 1 + m_rng() % 64 : 128 + m_rng() % (EFB_WIDTH - 144);
+		u32 height = (m_rng() & 1) ? 1 + m_rng() % 64 : 128 + m_rng() % (EFB_HEIGHT - 144);
+		bpmem.copyTexSrcXY.x = m_rng() % (EFB_WIDTH - 16 - width);
+		bpmem.copyTexSrcXY.y = m_rng() % (EFB_HEIGHT - 16 - height);
+		bpmem.copyTexSrcWH.x = width - 1;
+		bpmem.copyTexSrcWH.y = height - 1;
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// Encoding in parallel and with the SIMD fast paths gives exactly the same texture
+TEST_F(SWTextureEncoderTest, MatchesReference)
+{
+	std::vector<u8> expected(DEST_SIZE);
+	std::vector<u8> actual(DEST_SIZE);
+
+	for (int round = 0; round < 400; round++)
+	{
+		RandomizeCopy();
+
+		u8 fill = (u8)m_rng();
+		memset(expected.data(), fill, DEST_SIZE);
+		memset(actual.data(), fill, DEST_SIZE);
+
+		TextureEncoder::EncodeReference(expected.data());
+		TextureEncoder::Encode(actual.data());
+
+		ASSERT_EQ(0, memcmp(expected.data(), actual.data(), DEST_SIZE))
+			<< "round " << round << " pixel format " << (int)bpmem.zcontrol.pixel_format
+			<< " target format " << bpmem.triggerEFBCopy.target_pixel_format
+			<< " intensity " << bpmem.triggerEFBCopy.intensity_fmt
+			<< " half scale " << bpmem.triggerEFBCopy.half_scale
+			<< " size " << bpmem.copyTexSrcWH.x + 1 << "x" << bpmem.copyTexSrcWH.y + 1;
+	}
+}
@@ -0,0 +1,151 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+
+#include <gtest/gtest.h>  // NOLINT
+
+#include "Common/CommonTypes.h"
+#include "VideoBackends/Software/NativeVertexFormat.h"
+#include "VideoBackends/Software/TransformUnit.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace
+{
+class SWTransformUnitTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		memset(&bpmem, 0, sizeof(bpmem));
+		memset(&xfmem, 0, sizeof(xfmem));
+	}
+
+	float RandomFloat(float range)
+	{
+		return std::uniform_real_distribution<float>(-range, range)(m_rng);
+	}
+
+	void RandomizeFloats(float* values, int count, float range)
+	{
+		for (int i = 0; i < count; i++)
+			values[i] = RandomFloat(range);
+	}
+
+	void RandomizeState()
+	{
+		RandomizeFloats(xfmem.posMatrices, 256, 2.0f);
+		RandomizeFloats(xfmem.normalMatrices, 96, 2.0f);
+		RandomizeFloats(xfmem.postMatrices, 256, 2.0f);
+
+		xfmem.projection.type = (m_rng() & 1) ? GX_PERSPECTIVE : GX_ORTHOGRAPHIC;
+		RandomizeFloats(xfmem.projection.rawProjection, 6, 2.0f);
+
+		for (Light& light : xfmem.lights)
+		{
+			for (u8& component : light.color)
+				component = (u8)m_rng();
+			RandomizeFloats(light.cosatt, 3, 2.0f);
+			RandomizeFloats(light.distatt, 3, 2.0f);
+			RandomizeFloats(light.dpos, 3, 10.0f);
+			RandomizeFloats(light.ddir, 3, 1.0f);
+
+			// Divisions by zero have their own rules
+			if ((m_rng() & 3) == 0)
+				light.distatt[0] = light.distatt[1] = light.distatt[2] = 0.0f;
+		}
+
+		xfmem.numChan.numColorChans = m_rng() % 3;
+		for (int chan = 0; chan < 2; chan++)
+		{
+			xfmem.color[chan].hex = m_rng();
+			xfmem.color[chan].diffusefunc = m_rng() % 3;
+			xfmem.alpha[chan].hex = m_rng();
+			xfmem.alpha[chan].diffusefunc = m_rng() % 3;
+			xfmem.ambColor[chan] = m_rng();
+			xfmem.matColor[chan] = m_rng();
+		}
+
+		xfmem.numTexGen.numTexGens = m_rng() % 9;
+		xfmem.dualTexTrans.enabled = m_rng() & 1;
+		for (int i = 0; i < 8; i++)
+		{
+			static const u32 sources[] = {
+				XF_SRCGEOM_INROW, XF_SRCNORMAL_INROW, XF_SRCBINORMAL_T_INROW, XF_SRCBINORMAL_B_INROW,
+				XF_SRCTEX0_INROW, XF_SRCTEX3_INROW,
+			};
+			xfmem.texMtxInfo[i].hex = 0;
+			xfmem.texMtxInfo[i].projection = m_rng() & 1;
+			xfmem.texMtxInfo[i].inputform = m_rng() & 1;
+			xfmem.texMtxInfo[i].texgentype = XF_TEXGEN_REGULAR;
+			xfmem.texMtxInfo[i].sourcerow = sources[m_rng() % 6];
+			xfmem.postMtxInfo[i].hex = 0;
+			xfmem.postMtxInfo[i].index = m_rng() % 60;
+			xfmem.postMtxInfo[i].normalize = m_rng() & 1;
+			bpmem.texcoords[i].s.scale_minus_1 = m_rng() % 1024;
+			bpmem.texcoords[i].t.scale_minus_1 = m_rng() % 1024;
+		}
+	}
+
+	void RandomizeVertex(InputVertexData* vertex, bool sameMatrix)
+	{
+		vertex->posMtx = sameMatrix ? 0 : 3 * (m_rng() % 10);
+		for (u8& texMtx : vertex->texMtx)
+			texMtx = 3 * (m_rng() % 10);
+		RandomizeFloats(&vertex->position.x, 3, 10.0f);
+		for (Vec3& normal : vertex->normal)
+			RandomizeFloats(&normal.x, 3, 1.0f);
+		for (auto& color : vertex->color)
+		{
+			for (u8& component : color)
+				component = (u8)m_rng();
+		}
+		for (auto& texCoord : vertex->texCoords)
+			RandomizeFloats(texCoord, 2, 4.0f);
+	}
+
+	std::mt19937 m_rng;
+};
+}
+
+// The batch transform gives bit-identical results to transforming every vertex on its own
+TEST_F(SWTransformUnitTest, BatchMatchesSingleVertices)
+{
+	for (int round = 0; round < 500; round++)
+	{
+		RandomizeState();
+
+		const int count = 1 + m_rng() % TransformUnit::MAX_BATCH_SIZE;
+		const bool hasNormal = (m_rng() & 3) != 0;
+		const bool nbt = (m_rng() & 1) != 0;
+		const bool sameMatrix = (m_rng() & 1) != 0;
+
+		InputVertexData inputs[TransformUnit::MAX_BATCH_SIZE];
+		for (int i = 0; i < count; i++)
+			RandomizeVertex(&inputs[i], sameMatrix);
+
+		OutputVertexData expected[TransformUnit::MAX_BATCH_SIZE];
+		OutputVertexData actual[TransformUnit::MAX_BATCH_SIZE];
+		memset(expected, 0, sizeof(expected));
+		memset(actual, 0, sizeof(actual));
+
+		for (int i = 0; i < count; i++)
+		{
+			TransformUnit::TransformPosition(&inputs[i], &expected[i]);
+			if (hasNormal)
+				TransformUnit::TransformNormal(&inputs[i], nbt, &expected[i]);
+			TransformUnit::TransformColor(&inputs[i], &expected[i]);
+			TransformUnit::TransformTexCoord(&inputs[i], &expected[i], false);
+		}
+		TransformUnit::TransformVertices(inputs, actual, count, hasNormal, nbt, false);
+
+		for (int i = 0; i < count; i++)
+		{
+			ASSERT_EQ(0, memcmp(&expected[i], &actual[i], sizeof(OutputVertexData)))
+				<< "round " << round << " vertex " << i;
+		}
+	}
+}
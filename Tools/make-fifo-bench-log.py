@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+# Writes a synthetic FIFO log for dolphin-fifo-bench, which stresses the GPU front end
+# the way a busy game frame does: many draws of directly sent vertices, each with its own
+# position matrix and a handful of BP writes, most of which don't change anything.
+#
+# Everything is transformed to a single point, so that the frames cost next to nothing to
+# rasterize and the replay mostly times command decoding, vertex loading and draw calls.
+#
+# Usage: make-fifo-bench-log.py <output.dff> [<draws per frame>] [<vertices per draw>]
+
+import struct
+import sys
+
+FILE_ID = 0x0d01f1f0
+NUM_FRAMES = 3
+FIFO_START = 0x00100000
+FIFO_END = FIFO_START + 0x400000 - 32
+
+# Position (float xyz), color 0 (RGBA8888) and texture coordinate 0 (float st), all direct
+VCD_LO = (1 << 9) | (1 << 13)
+VCD_HI = 1 << 0
+VAT_A = 1 | (4 << 1) | (1 << 13) | (5 << 14) | (1 << 21) | (4 << 22) | (1 << 30)
+VERTEX_SIZE = 12 + 4 + 8
+
+# BP writes sent before every draw. Only the blend mode changes from one draw to the next.
+GENMODE = 0x00, 0x000011
+STEADY_BP_WRITES = [(0x40, 0x000017), (0x42, 0x000000), (0xc0, 0x08fff0), (0xc1, 0x08fff0),
+                    (0xf3, 0x3f0000), (0x28, 0x03c040)]
+BLEND_MODES = [0x0000a0, 0x0064a3]
+
+
+def cp(reg, value):
+    return struct.pack('>BBI', 0x08, reg, value)
+
+
+def bp(reg, value):
+    return struct.pack('>BI', 0x61, (reg << 24) | value)
+
+
+def xf(address, values):
+    data = struct.pack('>BI', 0x10, ((len(values) - 1) << 16) | address)
+    return data + b''.join(struct.pack('>f', v) for v in values)
+
+
+def draw(num_vertices, seed):
+    data = bytearray(struct.pack('>BH', 0x90, num_vertices))
+    for i in range(num_vertices):
+        x = ((seed * 31 + i * 7) % 640) / 640.0
+        y = ((seed * 17 + i * 13) % 480) / 480.0
+        data += struct.pack('>fffIff', x, y, 0.5, 0xff8040ff ^ (i * 0x010101), x, y)
+    return bytes(data)
+
+
+def frame(draws, vertices, frame_number):
+    data = bytearray()
+    data += cp(0x50, VCD_LO) + cp(0x60, VCD_HI) + cp(0x70, VAT_A)
+    data += bp(*GENMODE)
+    for i in range(draws):
+        # Every other draw loads the same position matrix as the one before it
+        matrix = [0.0] * 12
+        matrix[3] = float(frame_number * draws + i - (i & 1))
+        data += xf(0, matrix)
+        for reg, value in STEADY_BP_WRITES:
+            data += bp(reg, value)
+        data += bp(0x41, BLEND_MODES[i & 1])
+        data += draw(vertices, i)
+    # The player needs whole gather pipe bursts
+    data += bytes(-len(data) % 32)
+    return bytes(data)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit("Usage: make-fifo-bench-log.py <output.dff> [<draws per frame>] [<vertices per draw>]")
+    draws = int(sys.argv[2]) if len(sys.argv) > 2 else 200
+    vertices = int(sys.argv[3]) if len(sys.argv) > 3 else 240
+
+    frames = [frame(draws, vertices, i) for i in range(NUM_FRAMES)]
+
+    header_size = 128
+    frame_list = header_size
+    bp_mem = frame_list + 64 * NUM_FRAMES
+    cp_mem = bp_mem + 256 * 4
+    xf_mem = cp_mem + 256 * 4
+    xf_regs = xf_mem + 4096 * 4
+    end = xf_regs + 96 * 4
+
+    out = bytearray(end)
+    out[0:header_size] = struct.pack('<IIIQIQIQIQIQII', FILE_ID, 2, 1, bp_mem, 256, cp_mem, 256,
+                                     xf_mem, 4096, xf_regs, 96, frame_list, NUM_FRAMES, 0).ljust(header_size, b'\0')
+
+    bp_regs = [0] * 256
+    bp_regs[0xfe] = 0xffffff
+    bp_regs[GENMODE[0]] = GENMODE[1]
+    out[bp_mem:bp_mem + 256 * 4] = struct.pack('<256I', *bp_regs)
+
+    # The player needs the vertex format up front to find the objects in the frames
+    cp_regs = [0] * 256
+    cp_regs[0x50] = VCD_LO
+    cp_regs[0x60] = VCD_HI
+    cp_regs[0x70] = VAT_A
+    out[cp_mem:cp_mem + 256 * 4] = struct.pack('<256I', *cp_regs)
+
+    for i, data in enumerate(frames):
+        offset = len(out)
+        out += data
+        info = struct.pack('<QIIIQI', offset, len(data), FIFO_START, FIFO_END, len(out), 0)
+        out[frame_list + 64 * i:frame_list + 64 * i + len(info)] = info
+
+    with open(sys.argv[1], 'wb') as f:
+        f.write(out)
+
+
+if __name__ == '__main__':
+    main()